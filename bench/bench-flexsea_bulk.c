@@ -0,0 +1,110 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../inc/flexsea_bulk.h"
+#include "../inc/flexsea_comm.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_BULK_LEN				(64UL << 20)
+#define BENCH_BULK_CORRUPT_EVERY	8
+
+static struct bulk_s benchBulk;
+static uint64_t benchBulkRx = 0;
+
+static void benchBulkCallback(struct bulk_s *b, struct bulk_frame_s *f)
+{
+	(void)b;
+	benchBulkRx += f->payloadLen;
+}
+
+//Frames back to back, some corrupted, a few bytes of noise between them
+static uint8_t *bench_bulk_stream(uint64_t len)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t *buf = (uint8_t *)malloc(len);
+	uint64_t pos = 0;
+	uint32_t i = 0;
+	uint8_t n = 0, j = 0;
+
+	if(buf == NULL)
+	{
+		return NULL;
+	}
+
+	memset(payload, 0, sizeof(payload));
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	while(pos < len)
+	{
+		for(j = 0; j < 24; j++)
+		{
+			payload[P_DATA1 + j] = (uint8_t)(i + j);
+		}
+		n = comm_gen_str(payload, str, P_DATA1 + 24) + 1;
+		if((i % BENCH_BULK_CORRUPT_EVERY) == 0)
+		{
+			str[n / 2]++;
+			str[n++] = (uint8_t)i;
+		}
+		n = (uint8_t)MIN(n, len - pos);
+		memcpy(&buf[pos], str, n);
+		pos += n;
+		i++;
+	}
+
+	return buf;
+}
+
+#endif	//__linux__
+
+//Decoding a large stream with 1 to 8 threads
+void bench_flexsea_bulk(FILE *out)
+{
+	#ifdef __linux__
+	uint8_t threads[4] = {1, 2, 4, 8};
+	uint8_t *buf = bench_bulk_stream(BENCH_BULK_LEN);
+	char params[64];
+	uint8_t i = 0;
+
+	if(buf == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < sizeof(threads); i++)
+	{
+		if(bulk_init(&benchBulk, threads[i], BULK_CHUNK_DEFAULT) < 0)
+		{
+			break;
+		}
+		benchBulk.callback = &benchBulkCallback;
+		benchBulkRx = 0;
+		if(bulk_decode(&benchBulk, buf, BENCH_BULK_LEN) == 0)
+		{
+			snprintf(params, sizeof(params), "threads=%u,fixups=%llu", threads[i], \
+						(unsigned long long)benchBulk.fixups);
+			bench_report(out, "bulk_decode", params, benchBulk.frames, \
+							benchBulk.bytes, benchBulk.ns);
+		}
+		bulk_free(&benchBulk);
+	}
+
+	free(buf);
+	#else
+	(void)out;
+	#endif	//__linux__
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,91 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+
+#ifdef __linux__
+
+#include <string.h>
+#include <unistd.h>
+#include "../inc/flexsea_columns.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_COLUMNS_ROWS		4000000
+#define BENCH_COLUMNS_CMD		42
+
+static struct columns_s benchColumns;
+
+//Typical motor telemetry: 4 x 32 bits, 6 x 16 bits, 2 x 8 bits
+static const struct columns_field_s benchColumnsFields[12] =
+{
+	{"enc_motor", P_DATA1, COLUMNS_I32},
+	{"enc_joint", P_DATA1 + 4, COLUMNS_I32},
+	{"ticks", P_DATA1 + 8, COLUMNS_U32},
+	{"ctrl", P_DATA1 + 12, COLUMNS_I32},
+	{"current", P_DATA1 + 16, COLUMNS_I16},
+	{"v_batt", P_DATA1 + 18, COLUMNS_U16},
+	{"v_int", P_DATA1 + 20, COLUMNS_U16},
+	{"temp", P_DATA1 + 22, COLUMNS_I16},
+	{"gyro", P_DATA1 + 24, COLUMNS_I16},
+	{"accel", P_DATA1 + 26, COLUMNS_I16},
+	{"status1", P_DATA1 + 28, COLUMNS_U8},
+	{"status2", P_DATA1 + 29, COLUMNS_U8}
+};
+
+#endif	//__linux__
+
+//Payloads to columns, then to a file
+void bench_flexsea_columns(FILE *out)
+{
+	#ifdef __linux__
+	uint8_t payload[PACKAGED_PAYLOAD_LEN];
+	uint64_t t0 = 0, t1 = 0;
+	uint32_t n = 0;
+	char path[64];
+	uint8_t i = 0;
+
+	columns_init(&benchColumns);
+	if(columns_add_schema(&benchColumns, BENCH_COLUMNS_CMD, benchColumnsFields, 12) < 0)
+	{
+		return;
+	}
+
+	memset(payload, 0, sizeof(payload));
+	payload[P_XID] = FLEXSEA_EXECUTE_1;
+	payload[P_RID] = FLEXSEA_PLAN_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(BENCH_COLUMNS_CMD);
+
+	t0 = bench_now_ns();
+	for(n = 0; n < BENCH_COLUMNS_ROWS; n++)
+	{
+		for(i = 0; i < 8; i++)
+		{
+			payload[P_DATA1 + i * 4 + (n & 3)] = (uint8_t)(n + i);
+		}
+		columns_add(&benchColumns, payload, P_DATA1 + 30, n);
+	}
+	columns_finish(&benchColumns);
+	t1 = bench_now_ns();
+	bench_report(out, "columns_add", "fields=12", benchColumns.rows, \
+					(uint64_t)benchColumns.rows * (P_DATA1 + 30), t1 - t0);
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-bench-%d.fxcol", (int)getpid());
+	t0 = bench_now_ns();
+	if(columns_write(&benchColumns, path) == 0)
+	{
+		t1 = bench_now_ns();
+		bench_report(out, "columns_write", "fields=12", benchColumns.rows, \
+						(uint64_t)benchColumns.rows * (8 + 1 + 30), t1 - t0);
+	}
+	unlink(path);
+	columns_free(&benchColumns);
+	#else
+	(void)out;
+	#endif	//__linux__
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,538 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include "flexsea-comm_bench-all.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_buffers.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_stats.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_COMM_FRAMES			200000
+#define BENCH_COMM_STREAM_FRAMES	64		//Frames in a stream, replayed
+#define BENCH_COMM_CORRUPT_EVERY	4		//Corrupted stream: 1 bad frame in 4
+#define BENCH_COMM_SPLIT_LOOPS		2000000
+#define BENCH_COMM_POLL_BYTES		8		//Bytes per poll, bench_comm_rx_poll()
+#define BENCH_COMM_RESYNC_TRIALS	20000	//Noise bursts, bench_comm_resync()
+
+//Between two frames of a corrupted stream: a lone HEADER, a length that
+//goes past the end, a stray FOOTER
+static const uint8_t benchCommJunk[] = {HEADER, 0x20, 0x55, FOOTER, 0x00};
+
+static const uint8_t benchCommSizes[] = {4, 8, 16, 24, 32};
+static const uint8_t benchCommEscapes[] = {0, 10, 25, 50, 100};
+static const uint16_t benchCommNoise[] = {8, 32, 128, 512};
+
+static uint8_t benchCommStream[BENCH_COMM_STREAM_FRAMES * \
+								(COMM_STR_BUF_LEN + sizeof(benchCommJunk))];
+static uint16_t benchCommChunk[BENCH_COMM_STREAM_FRAMES];	//Bytes per frame + junk
+static volatile uint32_t benchCommSink = 0;
+static uint32_t benchCommParsed = 0;
+
+//'escapePct' % of the bytes need an ESCAPE, spread over the payload
+static void benchCommPayload(uint8_t *payload, uint8_t bytes, uint8_t escapePct)
+{
+	static const uint8_t special[3] = {HEADER, FOOTER, ESCAPE};
+	uint16_t acc = 0;
+	uint8_t i = 0;
+
+	for(i = 0; i < bytes; i++)
+	{
+		acc += escapePct;
+		if(acc >= 100)
+		{
+			acc -= 100;
+			payload[i] = special[i % 3];
+		}
+		else
+		{
+			payload[i] = (uint8_t)(0x10 + (i & 0x3F));
+		}
+	}
+}
+
+//Frames that can't fit in a comm_str are never sent
+static uint8_t benchCommFits(uint8_t bytes, uint8_t escapePct)
+{
+	return ((bytes + (bytes * escapePct) / 100) < (COMM_STR_BUF_LEN - 4));
+}
+
+//BENCH_COMM_STREAM_FRAMES frames, back to back or corrupted. Returns the
+//stream length.
+static uint32_t benchCommBuildStream(uint8_t bytes, uint8_t escapePct, \
+										uint8_t corrupt)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint32_t len = 0, frameLen = 0;
+	uint8_t i = 0;
+
+	benchCommPayload(payload, bytes, escapePct);
+	for(i = 0; i < BENCH_COMM_STREAM_FRAMES; i++)
+	{
+		frameLen = comm_gen_str(payload, str, bytes) + 1;
+		if(corrupt && ((i % BENCH_COMM_CORRUPT_EVERY) == 0))
+		{
+			str[frameLen / 2]++;
+		}
+
+		memcpy(&benchCommStream[len], str, frameLen);
+		benchCommChunk[i] = (uint16_t)frameLen;
+		if(corrupt)
+		{
+			memcpy(&benchCommStream[len + frameLen], benchCommJunk, sizeof(benchCommJunk));
+			benchCommChunk[i] += sizeof(benchCommJunk);
+		}
+		len += benchCommChunk[i];
+	}
+
+	return len;
+}
+
+//comm_gen_str(): payload in, escaped frame out
+static void bench_comm_gen_str(FILE *out, uint8_t bytes, uint8_t escapePct)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint64_t t0 = 0, t1 = 0, total = 0;
+	char params[64];
+	uint32_t i = 0;
+
+	benchCommPayload(payload, bytes, escapePct);
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_FRAMES; i++)
+	{
+		payload[bytes - 1] = (uint8_t)i & 0x7F;
+		total += comm_gen_str(payload, str, bytes) + 1;
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "payload=%u,escape_pct=%u", bytes, escapePct);
+	bench_report(out, "comm_gen_str", params, BENCH_COMM_FRAMES, total, t1 - t0);
+}
+
+#ifdef ENABLE_FLEXSEA_BUF_1
+
+//Receive path: update_rx_buf_array_1() (or _byte_1(), byte by byte) with
+//every frame, then unpack_payload_1(). frames = payloads decoded.
+static void bench_comm_rx(FILE *out, uint8_t bytes, uint8_t escapePct, \
+							uint8_t corrupt, uint8_t byteByByte)
+{
+	uint64_t t0 = 0, t1 = 0, total = 0, frames = 0;
+	uint32_t len = 0, off = 0, i = 0, j = 0, loops = 0;
+	char params[96];
+	int8_t ret = 0;
+
+	len = benchCommBuildStream(bytes, escapePct, corrupt);
+	loops = BENCH_COMM_FRAMES / BENCH_COMM_STREAM_FRAMES;
+	memset(rx_buf_1, 0, RX_BUF_LEN);
+
+	t0 = bench_now_ns();
+	for(i = 0; i < loops; i++)
+	{
+		off = 0;
+		for(j = 0; j < BENCH_COMM_STREAM_FRAMES; j++)
+		{
+			if(byteByByte)
+			{
+				for(len = off + benchCommChunk[j]; off < len; off++)
+				{
+					update_rx_buf_byte_1(benchCommStream[off]);
+				}
+			}
+			else
+			{
+				update_rx_buf_array_1(&benchCommStream[off], benchCommChunk[j]);
+				off += benchCommChunk[j];
+			}
+
+			ret = unpack_payload_1();
+			if(ret > 0)
+			{
+				frames += (uint64_t)ret;
+			}
+		}
+		total += off;
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "payload=%u,escape_pct=%u,stream=%s,update=%s", \
+				bytes, escapePct, corrupt ? "corrupted" : "clean", \
+				byteByByte ? "byte" : "array");
+	bench_report(out, "comm_rx_unpack", params, frames, total, t1 - t0);
+}
+
+#endif	//ENABLE_FLEXSEA_BUF_1
+
+//Polled UART: BENCH_COMM_POLL_BYTES bytes at a time, unpack_payload_rx()
+//after each of them. Most calls see the start of a frame only.
+static void bench_comm_rx_poll(FILE *out, uint8_t bytes, uint8_t escapePct)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint64_t t0 = 0, t1 = 0, total = 0, frames = 0;
+	uint32_t len = 0, off = 0, n = 0, i = 0, loops = 0;
+	struct rx_buf_s rb;
+	char params[64];
+	int8_t ret = 0;
+
+	len = benchCommBuildStream(bytes, escapePct, 0);
+	loops = BENCH_COMM_FRAMES / BENCH_COMM_STREAM_FRAMES;
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_USB;
+
+	t0 = bench_now_ns();
+	for(i = 0; i < loops; i++)
+	{
+		for(off = 0; off < len; off += n)
+		{
+			n = MIN(BENCH_COMM_POLL_BYTES, len - off);
+			update_rx_buf_array_s(&rb, &benchCommStream[off], n);
+			ret = unpack_payload_rx(&rb, rx_cmd);
+			if(ret > 0)
+			{
+				frames += (uint64_t)ret;
+			}
+		}
+		total += len;
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "payload=%u,escape_pct=%u,poll=%u", bytes, \
+				escapePct, BENCH_COMM_POLL_BYTES);
+	bench_report(out, "comm_rx_poll", params, frames, total, t1 - t0);
+}
+
+//Line noise: a burst of 'noise' random bytes, then a good frame, received
+//BENCH_COMM_POLL_BYTES at a time. ns / frame is the time it takes to get
+//the frame after a glitch. lost = frames that were never decoded.
+static void bench_comm_resync(FILE *out, uint16_t noise)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN], burst[512];
+	uint64_t t0 = 0, t1 = 0, total = 0, frames = 0;
+	uint32_t len = 0, off = 0, n = 0, i = 0, seed = 0x2545F491;
+	struct rx_buf_s rb;
+	char params[64];
+	int8_t ret = 0;
+
+	benchCommPayload(payload, 16, 10);
+	len = comm_gen_str(payload, str, 16) + 1;
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_USB;
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_RESYNC_TRIALS; i++)
+	{
+		for(off = 0; off < noise; off++)
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			burst[off] = (uint8_t)seed;
+		}
+
+		for(off = 0; off < (noise + len); off += n)
+		{
+			if(off < noise)
+			{
+				n = MIN(BENCH_COMM_POLL_BYTES, noise - off);
+				update_rx_buf_array_s(&rb, &burst[off], n);
+			}
+			else
+			{
+				n = MIN(BENCH_COMM_POLL_BYTES, noise + len - off);
+				update_rx_buf_array_s(&rb, &str[off - noise], n);
+			}
+
+			ret = unpack_payload_rx(&rb, rx_cmd);
+			if(ret > 0)
+			{
+				frames += (uint64_t)ret;
+			}
+		}
+		total += noise + len;
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "noise=%u,poll=%u,lost=%llu", noise, \
+				BENCH_COMM_POLL_BYTES, \
+				(unsigned long long)(BENCH_COMM_RESYNC_TRIALS - MIN(frames, \
+				BENCH_COMM_RESYNC_TRIALS)));
+	bench_report(out, "comm_resync", params, frames, total, t1 - t0);
+}
+
+//unpack_payload() alone: one frame in a RX_BUF_LEN window (the copy of
+//the window is part of the measurement)
+static void bench_comm_unpack(FILE *out, uint8_t bytes, uint8_t escapePct)
+{
+	uint8_t window[RX_BUF_LEN], buf[RX_BUF_LEN];
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint64_t t0 = 0, t1 = 0, frames = 0;
+	char params[64];
+	uint32_t i = 0;
+
+	benchCommBuildStream(bytes, escapePct, 0);
+	memset(window, 0, sizeof(window));
+	memcpy(&window[RX_BUF_LEN - benchCommChunk[0]], benchCommStream, benchCommChunk[0]);
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_FRAMES; i++)
+	{
+		memcpy(buf, window, RX_BUF_LEN);
+		if(unpack_payload_buf(buf, rx_cmd) > 0)
+		{
+			frames++;
+		}
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "payload=%u,escape_pct=%u", bytes, escapePct);
+	bench_report(out, "unpack_payload", params, frames, \
+					frames * benchCommChunk[0], t1 - t0);
+}
+
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+
+//Shared RS-485 bus: 'boards' boards, each frame for the next one, 1 of them
+//is this board. Every frame goes through unpack_payload_rx(), with or
+//without the RID filter. frames = frames seen on the bus.
+static void bench_comm_bus(FILE *out, uint8_t boards, uint8_t filter)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	struct comm_stats_s s;
+	struct rx_buf_s rb;
+	uint64_t t0 = 0, t1 = 0, total = 0;
+	uint32_t len = 0, off = 0, i = 0, j = 0, loops = 0;
+	char params[64];
+
+	benchCommPayload(payload, 24, 10);
+	payload[P_XID] = board_up_id;
+	for(i = 0; i < BENCH_COMM_STREAM_FRAMES; i++)
+	{
+		payload[P_RID] = (uint8_t)((i % boards) ? (100 + i % boards) : board_id);
+		benchCommChunk[i] = (uint16_t)(comm_gen_str(payload, str, 24) + 1);
+		memcpy(&benchCommStream[len], str, benchCommChunk[i]);
+		len += benchCommChunk[i];
+	}
+
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_485_1;
+	comm_set_rid_filter(PORT_485_1, filter);
+	comm_stats_reset(PORT_485_1);
+	loops = BENCH_COMM_FRAMES / BENCH_COMM_STREAM_FRAMES;
+
+	t0 = bench_now_ns();
+	for(i = 0; i < loops; i++)
+	{
+		off = 0;
+		for(j = 0; j < BENCH_COMM_STREAM_FRAMES; j++)
+		{
+			update_rx_buf_array_s(&rb, &benchCommStream[off], benchCommChunk[j]);
+			off += benchCommChunk[j];
+			unpack_payload_rx(&rb, rx_cmd);
+		}
+		total += off;
+	}
+	t1 = bench_now_ns();
+	comm_set_rid_filter(PORT_485_1, 0);
+
+	comm_stats_snapshot(PORT_485_1, &s);
+	snprintf(params, sizeof(params), "boards=%u,rid_filter=%u,decoded=%llu", boards, \
+				filter, (unsigned long long)s.framesDecoded);
+	bench_report(out, "comm_rx_bus", params, s.framesDecoded + s.filtered, total, t1 - t0);
+}
+
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+//SPLIT_x() then REBUILD_x(): 4x 16-bit and 4x 32-bit values per frame
+static void bench_comm_split(FILE *out)
+{
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint64_t t0 = 0, t1 = 0;
+	uint32_t i = 0, sum = 0;
+	uint16_t idx = 0;
+	uint8_t j = 0;
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_SPLIT_LOOPS; i++)
+	{
+		idx = 0;
+		for(j = 0; j < 4; j++)
+		{
+			SPLIT_16((uint16_t)(i + j), buf, &idx);
+			SPLIT_32(i * j, buf, &idx);
+		}
+
+		idx = 0;
+		for(j = 0; j < 4; j++)
+		{
+			sum += REBUILD_UINT16(buf, &idx);
+			sum += REBUILD_UINT32(buf, &idx);
+		}
+	}
+	t1 = bench_now_ns();
+	benchCommSink = sum;
+
+	bench_report(out, "split_rebuild", "values=8,payload=24", BENCH_COMM_SPLIT_LOOPS, \
+					(uint64_t)BENCH_COMM_SPLIT_LOOPS * 24, t1 - t0);
+}
+
+//Same values in the native layout: field by field, then as one struct
+static void bench_comm_split_native(FILE *out)
+{
+	struct
+	{
+		uint32_t v32[4];
+		uint16_t v16[4];
+	} in, back;
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint8_t info[2] = {PORT_SPI, 0};
+	struct link_caps_s caps;
+	uint64_t t0 = 0, t1 = 0;
+	uint32_t i = 0, sum = 0;
+	uint16_t idx = 0;
+	uint8_t j = 0;
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_SPLIT_LOOPS; i++)
+	{
+		idx = 0;
+		for(j = 0; j < 4; j++)
+		{
+			SPLIT_32_NATIVE(i * j, buf, &idx);
+		}
+		for(j = 0; j < 4; j++)
+		{
+			SPLIT_16_NATIVE((uint16_t)(i + j), buf, &idx);
+		}
+
+		idx = 0;
+		for(j = 0; j < 4; j++)
+		{
+			sum += REBUILD_UINT32_NATIVE(buf, &idx);
+		}
+		for(j = 0; j < 4; j++)
+		{
+			sum += REBUILD_UINT16_NATIVE(buf, &idx);
+		}
+	}
+	t1 = bench_now_ns();
+	benchCommSink = sum;
+
+	bench_report(out, "split_rebuild_native", "values=8,payload=24", \
+					BENCH_COMM_SPLIT_LOOPS, (uint64_t)BENCH_COMM_SPLIT_LOOPS * 24, t1 - t0);
+
+	//Negotiated with the other end of PORT_SPI:
+	init_flexsea_link();
+	caps = commLink[PORT_SPI].local;
+	caps.features |= LINK_FEAT_NATIVE;
+	link_set_local_caps(PORT_SPI, &caps);
+	tx_cmd_link_caps(buf, FLEXSEA_MANAGE_1, FLEXSEA_PLAN_1, WRITE, &caps);
+	rx_cmd_link_caps_rr(buf, info);
+
+	prepare_empty_payload(FLEXSEA_EXECUTE_1, FLEXSEA_PLAN_1, buf, PAYLOAD_BUF_LEN);
+	payload_set_native(CMD_TEST, 1);
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_SPLIT_LOOPS; i++)
+	{
+		for(j = 0; j < 4; j++)
+		{
+			in.v32[j] = i * j;
+			in.v16[j] = (uint16_t)(i + j);
+		}
+		payload_pack_native(PORT_SPI, buf, CMD_W(CMD_TEST), &in, sizeof(in));
+		payload_unpack_native(buf, &back, sizeof(back));
+		for(j = 0; j < 4; j++)
+		{
+			sum += back.v32[j] + back.v16[j];
+		}
+	}
+	t1 = bench_now_ns();
+	benchCommSink = sum;
+	payload_set_native(CMD_TEST, 0);
+	link_reset(PORT_SPI);
+	caps.features &= ~LINK_FEAT_NATIVE;
+	link_set_local_caps(PORT_SPI, &caps);
+
+	bench_report(out, "pack_native", "values=8,payload=24", BENCH_COMM_SPLIT_LOOPS, \
+					(uint64_t)BENCH_COMM_SPLIT_LOOPS * 24, t1 - t0);
+}
+
+static void benchCommHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+	benchCommParsed++;
+}
+
+//payload_parse_str(): dispatch of a Read addressed to this board, to an
+//empty handler
+static void bench_comm_parse(FILE *out)
+{
+	void (*saved)(uint8_t *, uint8_t *) = flexsea_payload_ptr[CMD_TEST][RX_PTYPE_READ];
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_USB, 0};
+	uint64_t t0 = 0, t1 = 0;
+	uint32_t i = 0;
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_READ] = &benchCommHandler;
+	benchCommParsed = 0;
+	prepare_empty_payload(board_up_id, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_TEST);
+
+	t0 = bench_now_ns();
+	for(i = 0; i < BENCH_COMM_FRAMES; i++)
+	{
+		payload_parse_str(payload, info);
+	}
+	t1 = bench_now_ns();
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_READ] = saved;
+
+	bench_report(out, "payload_parse_str", "cmd=CMD_TEST,ptype=read", benchCommParsed, \
+					(uint64_t)benchCommParsed * PAYLOAD_BUF_LEN, t1 - t0);
+}
+
+void bench_flexsea_comm(FILE *out)
+{
+	uint8_t i = 0, j = 0;
+
+	for(i = 0; i < sizeof(benchCommSizes); i++)
+	{
+		for(j = 0; j < sizeof(benchCommEscapes); j++)
+		{
+			if(!benchCommFits(benchCommSizes[i], benchCommEscapes[j]))
+			{
+				continue;
+			}
+
+			bench_comm_gen_str(out, benchCommSizes[i], benchCommEscapes[j]);
+			bench_comm_unpack(out, benchCommSizes[i], benchCommEscapes[j]);
+			bench_comm_rx_poll(out, benchCommSizes[i], benchCommEscapes[j]);
+			#ifdef ENABLE_FLEXSEA_BUF_1
+			bench_comm_rx(out, benchCommSizes[i], benchCommEscapes[j], 0, 0);
+			bench_comm_rx(out, benchCommSizes[i], benchCommEscapes[j], 1, 0);
+			bench_comm_rx(out, benchCommSizes[i], benchCommEscapes[j], 0, 1);
+			#endif	//ENABLE_FLEXSEA_BUF_1
+		}
+	}
+
+	for(i = 0; i < sizeof(benchCommNoise) / sizeof(benchCommNoise[0]); i++)
+	{
+		bench_comm_resync(out, benchCommNoise[i]);
+	}
+
+	#ifdef ENABLE_FLEXSEA_RID_FILTER
+	bench_comm_bus(out, 8, 0);
+	bench_comm_bus(out, 8, 1);
+	#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+	bench_comm_split(out);
+	bench_comm_split_native(out);
+	bench_comm_parse(out);
+}
+
+#ifdef __cplusplus
+}
+#endif
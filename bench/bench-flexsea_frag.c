@@ -0,0 +1,195 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include "flexsea-comm_bench-all.h"
+#include "../inc/flexsea_frag.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_buffers.h"
+
+//Definitions and variables used by this bench:
+//A (PORT_485_1) sends a message to B (PORT_485_2) over a simulated full
+//duplex serial link: 10 bits per byte, plus a fixed latency each way (USB
+//adapters, drivers). Ticks are us.
+#define BENCH_FRAG_LEN				16384
+#define BENCH_FRAG_QUEUE			64
+#define BENCH_FRAG_RTO_US			20000
+
+struct bench_frag_line_s
+{
+	uint8_t data[BENCH_FRAG_QUEUE][COMM_STR_BUF_LEN];
+	uint8_t len[BENCH_FRAG_QUEUE];
+	uint64_t at[BENCH_FRAG_QUEUE];	//Last byte received, ns
+	uint8_t head, cnt;
+	uint64_t free;					//Line idle from that time
+	uint8_t dstPort;
+	struct rx_buf_s rx;
+};
+
+static struct bench_frag_line_s benchFragToA, benchFragToB;
+static uint8_t benchFragMsg[BENCH_FRAG_LEN], benchFragBuf[BENCH_FRAG_LEN];
+static uint64_t benchFragNow = 0;
+static uint32_t benchFragBaud = 0, benchFragLatency = 0, benchFragLossPpm = 0;
+static uint32_t benchFragRng = 1;
+static uint8_t benchFragDone = 0;
+
+static void bench_frag_line_push(struct bench_frag_line_s *l, uint8_t *str, uint16_t len)
+{
+	uint8_t i = 0;
+
+	if(l->cnt >= BENCH_FRAG_QUEUE)
+	{
+		return;
+	}
+
+	//Line time is used even if the frame is lost:
+	l->free = MAX(l->free, benchFragNow) + \
+				((uint64_t)len * 10 * 1000000000ULL) / benchFragBaud;
+
+	benchFragRng ^= benchFragRng << 13;
+	benchFragRng ^= benchFragRng >> 17;
+	benchFragRng ^= benchFragRng << 5;
+	if((benchFragRng % 1000000) < benchFragLossPpm)
+	{
+		return;
+	}
+
+	i = (uint8_t)((l->head + l->cnt) % BENCH_FRAG_QUEUE);
+	memcpy(l->data[i], str, len);
+	l->len[i] = (uint8_t)len;
+	l->at[i] = l->free + benchFragLatency;
+	l->cnt++;
+}
+
+static void benchFragSendA(uint8_t *str, uint16_t len)
+{
+	bench_frag_line_push(&benchFragToB, str, len);
+}
+
+static void benchFragSendB(uint8_t *str, uint16_t len)
+{
+	bench_frag_line_push(&benchFragToA, str, len);
+}
+
+static void benchFragTxDone(uint8_t port, uint8_t state)
+{
+	(void)port;
+	(void)state;
+	benchFragDone = 1;
+}
+
+//Delivers the oldest frame of 'l' to its port, through the real decoder
+static void bench_frag_deliver(struct bench_frag_line_s *l)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t info[2] = {l->dstPort, 0};
+	int8_t n = 0, i = 0;
+
+	update_rx_buf_array_s(&l->rx, l->data[l->head], l->len[l->head]);
+	l->head = (uint8_t)((l->head + 1) % BENCH_FRAG_QUEUE);
+	l->cnt--;
+
+	n = unpack_payload_rx(&l->rx, rx_cmd);
+	for(i = 0; i < n; i++)
+	{
+		rx_cmd_frag(rx_cmd[i], info);
+	}
+}
+
+//One BENCH_FRAG_LEN transfer. link_pct: message bytes vs what the line
+//could carry in that time. ns is the wall clock time of the simulation.
+static void bench_frag_transfer(FILE *out, uint32_t baud, uint32_t latencyUs, \
+								uint8_t window, uint32_t lossPpm)
+{
+	uint64_t t0 = 0, t1 = 0, next = 0, limit = 0;
+	struct bench_frag_line_s *l = NULL;
+	char params[160];
+	uint32_t i = 0;
+
+	memset(&benchFragToA, 0, sizeof(benchFragToA));
+	memset(&benchFragToB, 0, sizeof(benchFragToB));
+	benchFragToA.dstPort = PORT_485_1;
+	benchFragToA.rx.port = PORT_485_1;
+	benchFragToB.dstPort = PORT_485_2;
+	benchFragToB.rx.port = PORT_485_2;
+	for(i = 0; i < BENCH_FRAG_LEN; i++)
+	{
+		benchFragMsg[i] = (uint8_t)(i * 13);
+	}
+	benchFragBaud = baud;
+	benchFragLatency = latencyUs * 1000;
+	benchFragLossPpm = lossPpm;
+	benchFragRng = 1;
+	benchFragNow = 0;
+	benchFragDone = 0;
+
+	init_flexsea_frag();
+	frag_config(PORT_485_1, BENCH_FRAG_RTO_US, window);
+	frag_config(PORT_485_2, BENCH_FRAG_RTO_US, window);
+	flexsea_port_send_ptr[PORT_485_1] = &benchFragSendA;
+	flexsea_port_send_ptr[PORT_485_2] = &benchFragSendB;
+	frag_receive_into(PORT_485_2, benchFragBuf, sizeof(benchFragBuf), NULL);
+
+	//Way more than it should take:
+	limit = ((uint64_t)BENCH_FRAG_LEN * 100 * 1000000000ULL) / baud;
+
+	t0 = bench_now_ns();
+	frag_send(PORT_485_1, FLEXSEA_EXECUTE_1, benchFragMsg, BENCH_FRAG_LEN, \
+				&benchFragTxDone, 0);
+	while(!benchFragDone && (benchFragNow < limit))
+	{
+		//Next frame received, or the next tick if the line is quiet:
+		next = benchFragNow + 1000;
+		l = NULL;
+		if(benchFragToA.cnt && (benchFragToA.at[benchFragToA.head] <= next))
+		{
+			l = &benchFragToA;
+			next = l->at[l->head];
+		}
+		if(benchFragToB.cnt && (benchFragToB.at[benchFragToB.head] <= next))
+		{
+			l = &benchFragToB;
+			next = l->at[l->head];
+		}
+
+		benchFragNow = MAX(benchFragNow, next);
+		if(l)
+		{
+			bench_frag_deliver(l);
+		}
+		frag_poll(PORT_485_1, (uint32_t)(benchFragNow / 1000));
+		frag_poll(PORT_485_2, (uint32_t)(benchFragNow / 1000));
+	}
+	t1 = bench_now_ns();
+
+	flexsea_port_send_ptr[PORT_485_1] = NULL;
+	flexsea_port_send_ptr[PORT_485_2] = NULL;
+
+	snprintf(params, sizeof(params), "len=%u,baud=%u,latency_us=%u,window=%u," \
+				"loss_ppm=%u,state=%u,ok=%u,resent=%u,link_pct=%.1f", BENCH_FRAG_LEN, \
+				baud, latencyUs, window, lossPpm, commFrag[PORT_485_1].tx.state, \
+				(commFrag[PORT_485_2].rx.state == FRAG_DONE) && \
+				!memcmp(benchFragMsg, benchFragBuf, BENCH_FRAG_LEN), \
+				commFrag[PORT_485_1].tx.resent, \
+				benchFragNow ? (100.0 * BENCH_FRAG_LEN * 10 * 1e9) / \
+				((double)benchFragNow * baud) : 0.0);
+	bench_report(out, "frag_transfer", params, commFrag[PORT_485_1].tx.sent, \
+					BENCH_FRAG_LEN, t1 - t0);
+}
+
+//Stop-and-wait (window = 1, one fragment round trip at a time) vs windows
+void bench_flexsea_frag(FILE *out)
+{
+	bench_frag_transfer(out, 1000000, 100, 1, 0);
+	bench_frag_transfer(out, 1000000, 100, 4, 0);
+	bench_frag_transfer(out, 1000000, 100, FRAG_WINDOW, 0);
+	bench_frag_transfer(out, 1000000, 1000, 1, 0);
+	bench_frag_transfer(out, 1000000, 1000, FRAG_WINDOW, 0);
+	bench_frag_transfer(out, 1000000, 100, FRAG_WINDOW, 1000);
+	bench_frag_transfer(out, 1000000, 100, FRAG_WINDOW, 20000);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,156 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../inc/flexsea_replay.h"
+#include "../inc/flexsea_capture.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_transport.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_REPLAY_FRAMES			200000
+#define BENCH_REPLAY_CORRUPT_EVERY	8
+
+static struct replay_s benchReplay;
+static uint64_t benchReplayRx = 0;
+
+static void benchReplayCallback(uint8_t port, uint8_t *payload)
+{
+	(void)port;
+	(void)payload;
+	benchReplayRx++;
+}
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+
+static struct capture_s benchCapture;
+
+//Records a session on two ports, fed and decoded like transport_rx() does
+static int bench_replay_record(const char *path)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	struct capture_file_s f;
+	struct rx_buf_s rb[2];
+	uint32_t i = 0;
+	uint8_t len = 0, j = 0, p = 0;
+
+	capture_init(&benchCapture, &capture_clock_ns, 1000000000);
+	if(capture_file_open(&f, &benchCapture, path) < 0)
+	{
+		return -1;
+	}
+
+	memset(rb, 0, sizeof(rb));
+	rb[0].port = PORT_485_1;
+	rb[1].port = PORT_USB;
+	memset(payload, 0, sizeof(payload));
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+
+	captureTap = &benchCapture;
+	for(i = 0; i < BENCH_REPLAY_FRAMES; i++)
+	{
+		p = (uint8_t)((i >> 4) & 1);
+		for(j = 0; j < 16; j++)
+		{
+			payload[P_DATA1 + j] = (uint8_t)(i + j);
+		}
+		len = comm_gen_str(payload, str, P_DATA1 + 16) + 1;
+		if((i % BENCH_REPLAY_CORRUPT_EVERY) == 0)
+		{
+			str[len / 2]++;
+		}
+
+		update_rx_buf_array_s(&rb[p], str, MIN(len, TRANSPORT_SLICE));
+		while(unpack_payload_rx(&rb[p], rx_cmd) == PAYLOAD_BUFFERS)
+		{
+			//rx_cmd was full, decode again
+		}
+		if(len > TRANSPORT_SLICE)
+		{
+			update_rx_buf_array_s(&rb[p], &str[TRANSPORT_SLICE], len - TRANSPORT_SLICE);
+			while(unpack_payload_rx(&rb[p], rx_cmd) == PAYLOAD_BUFFERS)
+			{
+				//rx_cmd was full, decode again
+			}
+		}
+
+		if((i & 0x3F) == 0)
+		{
+			capture_file_flush(&f);
+		}
+	}
+	captureTap = NULL;
+
+	return capture_file_close(&f);
+}
+
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+static void bench_replay_file(FILE *out, const char *name, const char *path, \
+								uint8_t dispatch)
+{
+	char params[160];
+
+	replay_init(&benchReplay, REPLAY_FAST);
+	benchReplay.dispatch = dispatch;
+	benchReplay.rx_callback = &benchReplayCallback;
+	benchReplayRx = 0;
+	if(replay_file(&benchReplay, path) < 0)
+	{
+		return;
+	}
+
+	snprintf(params, sizeof(params), "dispatch=%u,records=%llu,expected=%llu," \
+				"divergences=%llu", dispatch, \
+				(unsigned long long)benchReplay.report.records, \
+				(unsigned long long)benchReplay.report.expected, \
+				(unsigned long long)benchReplay.report.divergences);
+	bench_report(out, name, params, benchReplay.report.frames, \
+					benchReplay.report.bytes, benchReplay.report.ns);
+}
+
+#endif	//__linux__
+
+//Replays a synthetic capture, and FLEXSEA_BENCH_CAPTURE (a field capture)
+//if it's set
+void bench_flexsea_replay(FILE *out)
+{
+	#ifdef __linux__
+	const char *field = getenv("FLEXSEA_BENCH_CAPTURE");
+
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	char path[64];
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-bench-%d.fxc", (int)getpid());
+	unlink(path);
+	if(bench_replay_record(path) == 0)
+	{
+		bench_replay_file(out, "replay_fast", path, 0);
+		bench_replay_file(out, "replay_fast", path, 1);
+	}
+	unlink(path);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	if(field)
+	{
+		bench_replay_file(out, "replay_field", field, 1);
+	}
+	#else
+	(void)out;
+	#endif	//__linux__
+}
+
+#ifdef __cplusplus
+}
+#endif
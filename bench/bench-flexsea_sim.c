@@ -0,0 +1,126 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+#include "../inc/flexsea_sim.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_tdma.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_SIM_DURATION_NS		1000000000ULL	//1 s of bus time
+
+static struct sim_s benchSim;
+static struct tdma_s benchTdma;
+
+//Capacity planning: 'buses' buses of 'boards' slaves each. Reports the
+//simulated poll rate and latency, and how fast the simulator itself runs
+//(frames = replies, ns = wall clock).
+static void bench_sim_layout(FILE *out, uint8_t buses, uint8_t boards, \
+								uint32_t baud, uint32_t computeNs, uint32_t errorPpm, \
+								uint8_t window)
+{
+	uint64_t t0 = 0, t1 = 0, bytes = 0;
+	char params[256];
+	int bus = 0, i = 0, j = 0;
+
+	if(flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] == NULL)
+	{
+		flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &flexsea_payload_catchall;
+	}
+
+	sim_init(&benchSim, 1);
+	benchSim.window = window;
+	for(i = 0; i < buses; i++)
+	{
+		bus = sim_add_bus(&benchSim, baud, 5000, errorPpm, PORT_RS485_1);
+		for(j = 0; j < boards; j++)
+		{
+			sim_add_board(&benchSim, bus, (uint8_t)(FLEXSEA_EXECUTE_1 + j), computeNs);
+		}
+	}
+
+	t0 = bench_now_ns();
+	sim_run(&benchSim, BENCH_SIM_DURATION_NS);
+	t1 = bench_now_ns();
+
+	for(i = 0; i < buses; i++)
+	{
+		bytes += benchSim.bus[i].bytes;
+	}
+
+	snprintf(params, sizeof(params), "buses=%u,boards=%u,baud=%u,compute_ns=%u," \
+				"error_ppm=%u,window=%u,poll_hz=%.0f,timeouts=%llu,lat_p50_ns=%u," \
+				"lat_p99_ns=%u,lat_max_ns=%u,bus_util=%.3f", buses, \
+				buses * boards, baud, computeNs, errorPpm, window, \
+				(double)benchSim.replies * 1e9 / BENCH_SIM_DURATION_NS, \
+				(unsigned long long)benchSim.timeouts, \
+				sim_latency_percentile(&benchSim, 50), \
+				sim_latency_percentile(&benchSim, 99), benchSim.latMax, \
+				(double)benchSim.bus[0].busyNs / BENCH_SIM_DURATION_NS);
+	bench_report(out, "sim_layout", params, benchSim.replies, bytes, t1 - t0);
+}
+
+//Same, one bus polled by a flexsea_tdma schedule: every board at rateHz.
+//plan_util is what the schedule reserves, bus_util what the frames used.
+static void bench_sim_tdma(FILE *out, uint8_t boards, uint32_t baud, \
+							uint32_t computeNs, uint16_t rateHz, uint8_t escapePct)
+{
+	uint64_t t0 = 0, t1 = 0;
+	char params[256];
+	int8_t plan = 0;
+	int bus = 0, j = 0;
+
+	if(flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] == NULL)
+	{
+		flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &flexsea_payload_catchall;
+	}
+
+	sim_init(&benchSim, 1);
+	bus = sim_add_bus(&benchSim, baud, 5000, 0, PORT_RS485_1);
+	tdma_init(&benchTdma, PORT_RS485_1, baud, 5);
+	benchTdma.escapePct = escapePct;
+	for(j = 0; j < boards; j++)
+	{
+		sim_add_board(&benchSim, bus, (uint8_t)(FLEXSEA_EXECUTE_1 + j), computeNs);
+		tdma_add(&benchTdma, (uint8_t)(FLEXSEA_EXECUTE_1 + j), CMD_TEST, rateHz, \
+					0, 8, (computeNs + 999) / 1000);
+	}
+	plan = tdma_plan(&benchTdma);
+	benchSim.bus[bus].tdma = &benchTdma;
+
+	t0 = bench_now_ns();
+	sim_run(&benchSim, BENCH_SIM_DURATION_NS);
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "boards=%u,baud=%u,compute_ns=%u,rate_hz=%u," \
+				"escape_pct=%u,plan=%d,plan_util=%.3f,poll_hz=%.0f,misses=%u," \
+				"no_reply=%u,collisions=%u,bus_util=%.3f", boards, baud, computeNs, \
+				rateHz, escapePct, plan, tdma_utilization(&benchTdma) / 1000.0, \
+				(double)benchSim.replies * 1e9 / BENCH_SIM_DURATION_NS, \
+				benchTdma.misses, benchTdma.noReply, benchSim.bus[bus].collisions, \
+				(double)benchSim.bus[bus].busyNs / BENCH_SIM_DURATION_NS);
+	bench_report(out, "sim_tdma", params, benchSim.replies, benchSim.bus[bus].bytes, \
+					t1 - t0);
+}
+
+void bench_flexsea_sim(FILE *out)
+{
+	bench_sim_layout(out, 1, 8, 1000000, 50000, 0, 1);
+	bench_sim_layout(out, 1, 8, 1000000, 50000, 100, 1);
+	bench_sim_layout(out, 4, 100, 2000000, 50000, 0, 1);
+	bench_sim_layout(out, 8, 64, 3000000, 20000, 10, 1);
+
+	//Serial vs pipelined master, slaves that take a while to reply:
+	bench_sim_layout(out, 1, 8, 1000000, 500000, 0, 1);
+	bench_sim_layout(out, 1, 8, 1000000, 500000, 0, 4);
+	bench_sim_layout(out, 1, 8, 1000000, 500000, 0, 8);
+
+	//Scheduled: worst case escapes, then a quarter of the bytes:
+	bench_sim_tdma(out, 8, 3000000, 20000, 500, 100);
+	bench_sim_tdma(out, 8, 3000000, 20000, 1000, 25);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,234 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include "flexsea-comm_bench-all.h"
+#include "../inc/flexsea_stream.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_buffers.h"
+
+//Definitions and variables used by this bench:
+//A (PORT_485_1) streams an image to B (PORT_485_2) over a simulated full
+//duplex serial link: 10 bits per byte, a fixed latency each way, and
+//random byte errors. Every transmit call is delivered in one piece when
+//its last byte is received. Ticks are us.
+#define BENCH_STREAM_LEN			65536
+#define BENCH_STREAM_QUEUE			64
+#define BENCH_STREAM_CHUNK			STREAM_BLOCK_MAX
+#define BENCH_STREAM_STEP_NS		10000
+
+struct bench_stream_line_s
+{
+	uint8_t data[BENCH_STREAM_QUEUE][BENCH_STREAM_CHUNK];
+	uint16_t len[BENCH_STREAM_QUEUE];
+	uint64_t at[BENCH_STREAM_QUEUE];	//Last byte received, ns
+	uint8_t head, cnt;
+	uint64_t free;						//Line idle from that time
+	uint8_t dstPort;
+	struct rx_buf_s rx;
+};
+
+static struct bench_stream_line_s benchStreamToA, benchStreamToB;
+static uint8_t benchStreamMsg[BENCH_STREAM_LEN], benchStreamOut[BENCH_STREAM_LEN];
+static uint8_t benchStreamBlock[STREAM_BLOCK_MAX];
+static uint64_t benchStreamNow = 0;
+static uint32_t benchStreamBaud = 0, benchStreamLatency = 0, benchStreamErrPpm = 0;
+static uint32_t benchStreamRng = 1;
+static uint8_t benchStreamDone = 0;
+
+static void bench_stream_line_push(struct bench_stream_line_s *l, uint8_t *str, uint16_t len)
+{
+	uint8_t i = 0;
+	uint16_t j = 0;
+
+	if((l->cnt >= BENCH_STREAM_QUEUE) || (len > BENCH_STREAM_CHUNK))
+	{
+		return;
+	}
+
+	i = (uint8_t)((l->head + l->cnt) % BENCH_STREAM_QUEUE);
+	memcpy(l->data[i], str, len);
+	for(j = 0; benchStreamErrPpm && (j < len); j++)
+	{
+		benchStreamRng ^= benchStreamRng << 13;
+		benchStreamRng ^= benchStreamRng >> 17;
+		benchStreamRng ^= benchStreamRng << 5;
+		if((benchStreamRng % 1000000) < benchStreamErrPpm)
+		{
+			l->data[i][j] ^= 0x04;
+		}
+	}
+
+	l->free = MAX(l->free, benchStreamNow) + \
+				((uint64_t)len * 10 * 1000000000ULL) / benchStreamBaud;
+	l->len[i] = len;
+	l->at[i] = l->free + benchStreamLatency;
+	l->cnt++;
+}
+
+static void benchStreamSendA(uint8_t *str, uint16_t len)
+{
+	bench_stream_line_push(&benchStreamToB, str, len);
+}
+
+static void benchStreamSendB(uint8_t *str, uint16_t len)
+{
+	bench_stream_line_push(&benchStreamToA, str, len);
+}
+
+static void benchStreamTxDone(uint8_t port, uint8_t state)
+{
+	(void)port;
+	(void)state;
+	benchStreamDone = 1;
+}
+
+static void benchStreamWrite(uint8_t port, uint32_t offset, uint8_t *data, uint16_t len)
+{
+	(void)port;
+	memcpy(&benchStreamOut[offset], data, len);
+}
+
+//Delivers the oldest piece of 'l' to its port: bulk mode bytes go to
+//stream_rx(), the others to the real decoder (like transport_rx())
+static void bench_stream_deliver(struct bench_stream_line_s *l)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t info[2] = {l->dstPort, 0};
+	uint8_t *data = l->data[l->head];
+	uint16_t len = l->len[l->head], slice = 0;
+	int8_t n = 0, i = 0;
+
+	l->head = (uint8_t)((l->head + 1) % BENCH_STREAM_QUEUE);
+	l->cnt--;
+
+	if(stream_active(l->dstPort))
+	{
+		stream_rx(l->dstPort, data, len);
+		return;
+	}
+
+	while(len)
+	{
+		slice = (uint16_t)MIN(len, RX_BUF_LEN - COMM_STR_BUF_LEN);
+		update_rx_buf_array_s(&l->rx, data, slice);
+		data += slice;
+		len -= slice;
+		n = unpack_payload_rx(&l->rx, rx_cmd);
+		for(i = 0; i < n; i++)
+		{
+			if(rx_cmd[i][P_CMD1] == CMD_W(CMD_STREAM))
+			{
+				rx_cmd_stream(rx_cmd[i], info);
+			}
+		}
+	}
+}
+
+//One BENCH_STREAM_LEN session, request to the last ACK. link_pct: image
+//bytes vs what the line could carry in that time. ns is the wall clock time
+//of the simulation.
+static void bench_stream_transfer(FILE *out, uint32_t baud, uint32_t latencyUs, \
+									uint16_t block, uint8_t window, uint32_t errPpm)
+{
+	uint64_t t0 = 0, t1 = 0, next = 0, limit = 0;
+	struct bench_stream_line_s *l = NULL;
+	uint32_t i = 0, rto = 0;
+	char params[192];
+
+	memset(&benchStreamToA, 0, sizeof(benchStreamToA));
+	memset(&benchStreamToB, 0, sizeof(benchStreamToB));
+	benchStreamToA.dstPort = PORT_485_1;
+	benchStreamToA.rx.port = PORT_485_1;
+	benchStreamToB.dstPort = PORT_485_2;
+	benchStreamToB.rx.port = PORT_485_2;
+	for(i = 0; i < BENCH_STREAM_LEN; i++)
+	{
+		benchStreamMsg[i] = (uint8_t)((i * 7) ^ (i >> 9));
+	}
+	memset(benchStreamOut, 0, sizeof(benchStreamOut));
+	benchStreamBaud = baud;
+	benchStreamLatency = latencyUs * 1000;
+	benchStreamErrPpm = errPpm;
+	benchStreamRng = 1;
+	benchStreamNow = 0;
+	benchStreamDone = 0;
+
+	//Two windows on the line (after a NAK, the new blocks wait for the old
+	//ones), the round trip, and some margin:
+	rto = (uint32_t)(((uint64_t)2 * window * (block + 16) * 10 * 1000000) / baud) + \
+			2 * latencyUs + 5000;
+
+	init_flexsea_stream();
+	stream_config(PORT_485_1, rto, window, block);
+	stream_config(PORT_485_2, rto, window, block);
+	flexsea_port_send_ptr[PORT_485_1] = &benchStreamSendA;
+	flexsea_port_send_ptr[PORT_485_2] = &benchStreamSendB;
+	stream_receive(PORT_485_2, benchStreamBlock, sizeof(benchStreamBlock), \
+					&benchStreamWrite, NULL);
+
+	//Way more than it should take:
+	limit = ((uint64_t)BENCH_STREAM_LEN * 100 * 1000000000ULL) / baud;
+
+	t0 = bench_now_ns();
+	stream_send(PORT_485_1, FLEXSEA_EXECUTE_1, benchStreamMsg, BENCH_STREAM_LEN, \
+				&benchStreamTxDone, 0);
+	while(!benchStreamDone && (benchStreamNow < limit))
+	{
+		//Next piece received, or the next step if the line is quiet:
+		next = benchStreamNow + BENCH_STREAM_STEP_NS;
+		l = NULL;
+		if(benchStreamToA.cnt && (benchStreamToA.at[benchStreamToA.head] <= next))
+		{
+			l = &benchStreamToA;
+			next = l->at[l->head];
+		}
+		if(benchStreamToB.cnt && (benchStreamToB.at[benchStreamToB.head] <= next))
+		{
+			l = &benchStreamToB;
+			next = l->at[l->head];
+		}
+
+		benchStreamNow = MAX(benchStreamNow, next);
+		if(l)
+		{
+			bench_stream_deliver(l);
+		}
+		stream_poll(PORT_485_1, (uint32_t)(benchStreamNow / 1000));
+		stream_poll(PORT_485_2, (uint32_t)(benchStreamNow / 1000));
+	}
+	t1 = bench_now_ns();
+
+	flexsea_port_send_ptr[PORT_485_1] = NULL;
+	flexsea_port_send_ptr[PORT_485_2] = NULL;
+
+	snprintf(params, sizeof(params), "len=%u,baud=%u,latency_us=%u,block=%u," \
+				"window=%u,err_ppm=%u,state=%u,ok=%u,resent=%u,bad_crc=%u," \
+				"link_pct=%.1f", BENCH_STREAM_LEN, baud, latencyUs, block, window, \
+				errPpm, commStream[PORT_485_1].tx.state, \
+				!memcmp(benchStreamMsg, benchStreamOut, BENCH_STREAM_LEN), \
+				commStream[PORT_485_1].tx.resent, \
+				commStream[PORT_485_2].parser.badCrcs, \
+				benchStreamNow ? (100.0 * BENCH_STREAM_LEN * 10 * 1e9) / \
+				((double)benchStreamNow * baud) : 0.0);
+	bench_report(out, "stream_transfer", params, commStream[PORT_485_1].tx.sent, \
+					BENCH_STREAM_LEN, t1 - t0);
+}
+
+//Block size and window, on a clean line and on a noisy one (a bad byte
+//costs a whole block, and what was sent after it)
+void bench_flexsea_stream(FILE *out)
+{
+	bench_stream_transfer(out, 1000000, 100, 256, 4, 0);
+	bench_stream_transfer(out, 1000000, 100, 1024, 1, 0);
+	bench_stream_transfer(out, 1000000, 100, 1024, 4, 0);
+	bench_stream_transfer(out, 1000000, 1000, 1024, 4, 0);
+	bench_stream_transfer(out, 115200, 1000, 1024, 4, 0);
+	bench_stream_transfer(out, 1000000, 100, 1024, 4, 100);
+	bench_stream_transfer(out, 1000000, 100, 256, 4, 100);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,288 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		//posix_openpt(), ptsname()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "../inc/flexsea_transport.h"
+
+//Definitions and variables used by this bench:
+#define BENCH_TRANSPORT_FRAMES		50000
+#define BENCH_TRANSPORT_BURST		64
+#define BENCH_TRANSPORT_PORTS		24
+#define BENCH_TRANSPORT_PORT_BURST	8
+
+static struct transport_s benchTransport;
+static uint64_t benchTransportRx = 0;
+
+static void benchTransportCallback(uint8_t port, uint8_t *payload)
+{
+	(void)port;
+	(void)payload;
+	benchTransportRx++;
+}
+
+//End to end: frames written on a pty master, read by the transport on the
+//slave, decoded and dispatched.
+static void bench_transport_pty(FILE *out, uint8_t payloadBytes)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint8_t burst[BENCH_TRANSPORT_BURST * COMM_STR_BUF_LEN];
+	uint32_t burstLen = 0, off = 0;
+	uint64_t sent = 0, bytes = 0, t0 = 0, t1 = 0, syscalls = 0;
+	char params[64];
+	int ptm = -1, i = 0;
+	ssize_t ret = 0;
+
+	ptm = posix_openpt(O_RDWR | O_NOCTTY);
+	if((ptm < 0) || grantpt(ptm) || unlockpt(ptm) || transport_init(&benchTransport))
+	{
+		return;
+	}
+	if(transport_open_tty(&benchTransport, ptsname(ptm), 0, PORT_USB) < 0)
+	{
+		close(ptm);
+		return;
+	}
+	fcntl(ptm, F_SETFL, fcntl(ptm, F_GETFL) | O_NONBLOCK);
+	benchTransport.rx_callback = &benchTransportCallback;
+	benchTransportRx = 0;
+
+	//One burst of frames, reused:
+	memset(payload, 0x55, sizeof(payload));
+	for(i = 0; i < BENCH_TRANSPORT_BURST; i++)
+	{
+		burstLen += comm_gen_str(payload, &burst[burstLen], payloadBytes) + 1;
+	}
+
+	t0 = bench_now_ns();
+	while(benchTransportRx < BENCH_TRANSPORT_FRAMES)
+	{
+		if(sent < BENCH_TRANSPORT_FRAMES)
+		{
+			ret = write(ptm, &burst[off], burstLen - off);
+			if(ret > 0)
+			{
+				off += (uint32_t)ret;
+				bytes += (uint64_t)ret;
+				if(off == burstLen)
+				{
+					off = 0;
+					sent += BENCH_TRANSPORT_BURST;
+				}
+			}
+		}
+
+		transport_poll(&benchTransport, (sent < BENCH_TRANSPORT_FRAMES) ? 0 : 10);
+	}
+	t1 = bench_now_ns();
+
+	syscalls = benchTransport.syscalls;
+	snprintf(params, sizeof(params), "payload=%u,syscalls_per_frame=%.3f", \
+				payloadBytes, (double)syscalls / benchTransportRx);
+	bench_report(out, "transport_epoll_pty", params, benchTransportRx, bytes, t1 - t0);
+
+	transport_close(&benchTransport);
+	close(ptm);
+}
+
+static uint64_t bench_cpu_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+//Many ports: BENCH_TRANSPORT_PORTS socketpairs, a few frames per port per
+//round. useUring = 0: epoll + read(), 1: io_uring. The reported ns are CPU
+//time (writer included), syscalls_per_frame only counts the reader.
+static void bench_transport_many(FILE *out, uint8_t useUring)
+{
+	static uint8_t burst[BENCH_TRANSPORT_PORT_BURST * COMM_STR_BUF_LEN];
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint32_t burstLen = 0;
+	uint64_t sent = 0, bytes = 0, t0 = 0, t1 = 0, syscalls = 0;
+	int sv[BENCH_TRANSPORT_PORTS][2];
+	char params[96];
+	int i = 0, n = 0;
+	#ifdef ENABLE_FLEXSEA_IO_URING
+	static struct transport_uring_s u;
+	#endif	//ENABLE_FLEXSEA_IO_URING
+
+	#ifndef ENABLE_FLEXSEA_IO_URING
+	if(useUring)
+	{
+		return;
+	}
+	#endif	//ENABLE_FLEXSEA_IO_URING
+
+	if(transport_init(&benchTransport))
+	{
+		return;
+	}
+	for(i = 0; i < BENCH_TRANSPORT_PORTS; i++)
+	{
+		if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv[i]) < 0)
+		{
+			break;
+		}
+		transport_add_fd(&benchTransport, sv[i][0], PORT_USB);
+	}
+	n = i;
+	benchTransport.rx_callback = &benchTransportCallback;
+	benchTransportRx = 0;
+
+	#ifdef ENABLE_FLEXSEA_IO_URING
+	if(useUring && transport_uring_init(&u, &benchTransport))
+	{
+		useUring = 2;	//Not supported by this kernel
+	}
+	#endif	//ENABLE_FLEXSEA_IO_URING
+
+	memset(payload, 0x55, sizeof(payload));
+	for(i = 0; i < BENCH_TRANSPORT_PORT_BURST; i++)
+	{
+		burstLen += comm_gen_str(payload, &burst[burstLen], 16) + 1;
+	}
+
+	t0 = bench_cpu_ns();
+	while((useUring != 2) && (benchTransportRx < BENCH_TRANSPORT_FRAMES))
+	{
+		if(sent < BENCH_TRANSPORT_FRAMES)
+		{
+			for(i = 0; i < n; i++)
+			{
+				if(write(sv[i][1], burst, burstLen) == (ssize_t)burstLen)
+				{
+					sent += BENCH_TRANSPORT_PORT_BURST;
+					bytes += burstLen;
+				}
+			}
+		}
+
+		#ifdef ENABLE_FLEXSEA_IO_URING
+		if(useUring)
+		{
+			transport_uring_poll(&u, (sent < BENCH_TRANSPORT_FRAMES) ? 0 : 10);
+			continue;
+		}
+		#endif	//ENABLE_FLEXSEA_IO_URING
+
+		transport_poll(&benchTransport, (sent < BENCH_TRANSPORT_FRAMES) ? 0 : 10);
+	}
+	t1 = bench_cpu_ns();
+
+	if(useUring != 2)
+	{
+		syscalls = benchTransport.syscalls;
+		snprintf(params, sizeof(params), "ports=%d,payload=16,syscalls_per_frame=%.3f", \
+					n, (double)syscalls / benchTransportRx);
+		bench_report(out, useUring ? "transport_uring_many" : "transport_epoll_many", \
+					params, benchTransportRx, bytes, t1 - t0);
+	}
+
+	#ifdef ENABLE_FLEXSEA_IO_URING
+	if(useUring == 1)
+	{
+		transport_uring_close(&u);
+	}
+	#endif	//ENABLE_FLEXSEA_IO_URING
+
+	transport_close(&benchTransport);
+	for(i = 0; i < n; i++)
+	{
+		close(sv[i][1]);
+	}
+}
+
+static void benchDgramCallback(int peer, uint8_t *payload)
+{
+	(void)peer;
+	(void)payload;
+	benchTransportRx++;
+}
+
+//Unix datagrams. Flushing after every frame gives one frame per datagram
+//and per sendmmsg(); flushing after 'perFlush' frames lets them share
+//datagrams. Sender and receiver are in the same thread, syscalls of both
+//sides are counted.
+static void bench_transport_dgram(FILE *out, uint16_t perFlush)
+{
+	static struct transport_dgram_s tx, rx;
+	uint8_t payload[PAYLOAD_BUF_LEN], cstr[COMM_STR_BUF_LEN];
+	uint64_t sent = 0, bytes = 0, t0 = 0, t1 = 0;
+	char pathTx[64], pathRx[64], params[128];
+	uint8_t len = 0;
+	int peer = 0, i = 0;
+
+	snprintf(pathTx, sizeof(pathTx), "/tmp/fx_bench_tx_%d", (int)getpid());
+	snprintf(pathRx, sizeof(pathRx), "/tmp/fx_bench_rx_%d", (int)getpid());
+	if(transport_dgram_open_unix(&tx, pathTx) || transport_dgram_open_unix(&rx, pathRx))
+	{
+		return;
+	}
+	peer = transport_dgram_add_peer(&tx, pathRx, 0, PORT_USB);
+	rx.rx_callback = &benchDgramCallback;
+	benchTransportRx = 0;
+
+	memset(payload, 0x55, sizeof(payload));
+	len = comm_gen_str(payload, cstr, 16) + 1;
+
+	t0 = bench_now_ns();
+	while(benchTransportRx < BENCH_TRANSPORT_FRAMES)
+	{
+		for(i = 0; (i < perFlush) && (sent < BENCH_TRANSPORT_FRAMES); i++)
+		{
+			if(transport_dgram_send(&tx, peer, cstr, len) == 0)
+			{
+				sent++;
+				bytes += len;
+			}
+		}
+
+		transport_dgram_flush(&tx);
+		transport_dgram_poll(&rx, (sent < BENCH_TRANSPORT_FRAMES) ? 0 : 10);
+	}
+	t1 = bench_now_ns();
+
+	snprintf(params, sizeof(params), "frames_per_flush=%u,frames_per_dgram=%.1f," \
+				"syscalls_per_frame=%.3f", perFlush, \
+				(double)benchTransportRx / rx.dgramIn, \
+				(double)(tx.syscalls + rx.syscalls) / benchTransportRx);
+	bench_report(out, "transport_dgram_unix", params, benchTransportRx, bytes, t1 - t0);
+
+	transport_dgram_close(&tx);
+	transport_dgram_close(&rx);
+}
+
+#endif	//__linux__
+
+void bench_flexsea_transport(FILE *out)
+{
+	#ifdef __linux__
+	bench_transport_pty(out, 4);
+	bench_transport_pty(out, 32);
+	bench_transport_many(out, 0);
+	bench_transport_many(out, 1);
+	bench_transport_dgram(out, 1);
+	bench_transport_dgram(out, 256);
+	#else
+	(void)out;
+	#endif	//__linux__
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,54 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_bench-all.h"
+
+//****************************************************************************
+// Helper function(s):
+//****************************************************************************
+
+//One line per measurement: frames/s, bytes/s and ns/frame
+void bench_report(FILE *out, const char *name, const char *params, \
+					uint64_t frames, uint64_t bytes, uint64_t ns)
+{
+	double s = (double)ns / 1e9;
+
+	if(ns == 0)
+	{
+		ns = 1;
+		s = 1e-9;
+	}
+
+	fprintf(out, "{\"bench\":\"%s\",\"params\":\"%s\",\"frames\":%llu," \
+			"\"bytes\":%llu,\"ns\":%llu,\"frames_per_s\":%.1f," \
+			"\"bytes_per_s\":%.1f,\"ns_per_frame\":%.2f}\n", \
+			name, params, (unsigned long long)frames, \
+			(unsigned long long)bytes, (unsigned long long)ns, \
+			frames / s, bytes / s, frames ? ((double)ns / frames) : 0.0);
+	fflush(out);
+}
+
+//****************************************************************************
+// Main bench function:
+//****************************************************************************
+
+//Call this function to benchmark the 'flexsea-comm' stack:
+int flexsea_comm_bench(FILE *out)
+{
+	//One call per file here:
+	bench_flexsea_comm(out);
+	bench_flexsea_transport(out);
+	bench_flexsea_sim(out);
+	bench_flexsea_frag(out);
+	bench_flexsea_stream(out);
+	bench_flexsea_replay(out);
+	bench_flexsea_bulk(out);
+	bench_flexsea_columns(out);
+
+	return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
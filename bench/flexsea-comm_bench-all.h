@@ -0,0 +1,40 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BENCH_ALL_FX_COMM_H
+#define BENCH_ALL_FX_COMM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "../inc/flexsea.h"
+
+//Results are written one JSON object per line (bench_output.txt)
+int flexsea_comm_bench(FILE *out);
+void bench_report(FILE *out, const char *name, const char *params, \
+					uint64_t frames, uint64_t bytes, uint64_t ns);
+
+//Monotonic clock, in ns
+static inline uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+//Prototypes for public functions defined in individual bench files:
+void bench_flexsea_comm(FILE *out);
+void bench_flexsea_transport(FILE *out);
+void bench_flexsea_sim(FILE *out);
+void bench_flexsea_frag(FILE *out);
+void bench_flexsea_stream(FILE *out);
+void bench_flexsea_replay(FILE *out);
+void bench_flexsea_bulk(FILE *out);
+void bench_flexsea_columns(FILE *out);
+
+#endif	//BENCH_ALL_FX_COMM_H
+
+#ifdef __cplusplus
+}
+#endif
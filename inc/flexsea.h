@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include <stdint.h>
+#include <string.h>
 
 //#define USE_DEBUG_PRINTF			//Enable this to debug with the terminal
 
@@ -83,6 +84,7 @@ uint32_t REBUILD_UINT32(uint8_t *buf, uint16_t *index);
 #define PORT_USB						3
 #define PORT_SUB1						PORT_485_1
 #define PORT_SUB2						PORT_485_2
+#define NUMBER_OF_PORTS					4
 
 //Communication protocol payload fields:
 #define P_XID							0		//Emitter ID
@@ -91,6 +93,10 @@ uint32_t REBUILD_UINT32(uint8_t *buf, uint16_t *index);
 #define P_CMD1							3		//First command
 #define P_DATA1							4		//First data
 
+//P_CMDS flag: the data uses the native layout (see payload_set_native())
+#define P_CMDS_NATIVE					0x80
+#define P_CMDS_COUNT(x)					((x) & 0x7F)
+
 //Parser definitions:
 #define PARSE_DEFAULT					0
 #define PARSE_ID_NO_MATCH				1
@@ -133,6 +139,21 @@ extern void (*flexsea_payload_ptr[MAX_CMD_CODE][RX_PTYPE_MAX_INDEX+1]) \
 #define BYTES_TO_UINT16(b0,b1)			(((uint16_t)b0 << 8) + \
 										((uint16_t)b1))
 
+//Native layout: little endian values, aligned on their size (from the
+//start of the payload). Only used between little endian hosts, where
+//SPLIT_x_NATIVE()/REBUILD_x_NATIVE() are plain stores and loads.
+#define NATIVE_ALIGN(index, n)			(((index) + (n) - 1) & ~((n) - 1))
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	#define NATIVE_IS_LE				0
+	#define NATIVE_16(x)				__builtin_bswap16(x)
+	#define NATIVE_32(x)				__builtin_bswap32(x)
+#else
+	#define NATIVE_IS_LE				1
+	#define NATIVE_16(x)				(x)
+	#define NATIVE_32(x)				(x)
+#endif
+
 //Macros to deal with the 7 bits addresses and the R/W bit
 #define CMD_W(x)		(x << 1)			//LSB = 0
 #define CMD_R(x)		((x << 1) | 1)		//LSB = 1
@@ -157,6 +178,50 @@ extern void (*flexsea_payload_ptr[MAX_CMD_CODE][RX_PTYPE_MAX_INDEX+1]) \
 	#define _USE_PRINTF(...) do {} while (0)
 #endif	//USE__PRINTF
 
+//****************************************************************************
+// Inline function(s): native layout
+//****************************************************************************
+
+//Aligns index, stores 1 uint16 in buf[index] and increments index
+static inline void SPLIT_16_NATIVE(uint16_t var, uint8_t *buf, uint16_t *index)
+{
+	*index = NATIVE_ALIGN(*index, 2);
+	var = NATIVE_16(var);
+	memcpy(&buf[*index], &var, 2);
+	(*index) += 2;
+}
+
+//Inverse of SPLIT_16_NATIVE()
+static inline uint16_t REBUILD_UINT16_NATIVE(uint8_t *buf, uint16_t *index)
+{
+	uint16_t tmp = 0;
+
+	*index = NATIVE_ALIGN(*index, 2);
+	memcpy(&tmp, &buf[*index], 2);
+	(*index) += 2;
+	return NATIVE_16(tmp);
+}
+
+//Aligns index, stores 1 uint32 in buf[index] and increments index
+static inline void SPLIT_32_NATIVE(uint32_t var, uint8_t *buf, uint16_t *index)
+{
+	*index = NATIVE_ALIGN(*index, 4);
+	var = NATIVE_32(var);
+	memcpy(&buf[*index], &var, 4);
+	(*index) += 4;
+}
+
+//Inverse of SPLIT_32_NATIVE()
+static inline uint32_t REBUILD_UINT32_NATIVE(uint8_t *buf, uint16_t *index)
+{
+	uint32_t tmp = 0;
+
+	*index = NATIVE_ALIGN(*index, 4);
+	memcpy(&tmp, &buf[*index], 4);
+	(*index) += 4;
+	return NATIVE_32(tmp);
+}
+
 //****************************************************************************
 // Include(s) - at the end to make sure that the included files can access
 // all the project wide #define.
@@ -167,6 +232,10 @@ extern void (*flexsea_payload_ptr[MAX_CMD_CODE][RX_PTYPE_MAX_INDEX+1]) \
 #include "flexsea_buffers.h"
 #include "flexsea_comm.h"
 #include "flexsea_payload.h"
+#include "flexsea_link.h"
+#include "flexsea_arq.h"
+#include "flexsea_frag.h"
+#include "flexsea_stream.h"
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,162 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_arq: optional reliability sublayer (sequence numbers,
+	ACK/NAK and retransmissions)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_ARQ_H
+#define INC_FX_ARQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef ARQ_WINDOW
+#define ARQ_WINDOW				4		//Frames in flight, per peer
+#endif	//ARQ_WINDOW
+
+#ifndef ARQ_PEERS
+#define ARQ_PEERS				4		//Slaves per bus port (1 on the others)
+#endif	//ARQ_PEERS
+
+#ifndef ARQ_DEFAULT_RTO
+#define ARQ_DEFAULT_RTO			10		//Retransmission timeout, in ticks
+#endif	//ARQ_DEFAULT_RTO
+
+#define ARQ_MAX_RETRIES			5
+
+//Multi-drop bus ports (RS-485): one state per slave, and the slaves only
+//talk when the master sent them something (see flexsea_arq.c)
+#define ARQ_BUS_PORT(p)			(((p) == PORT_485_1) || ((p) == PORT_485_2))
+
+//ARQ header, in front of the payload: [SEQ][ACK][FLAGS][ADDR]
+#define ARQ_HEADER_LEN			4
+#define ARQ_SEQ					0
+#define ARQ_ACK					1
+#define ARQ_FLAGS				2
+#define ARQ_ADDR				3		//Bus ports: ID of the slave end, 0 otherwise
+#define ARQ_PAYLOAD_BYTES		(PAYLOAD_BUF_LEN - ARQ_HEADER_LEN)
+
+//Flags:
+#define ARQ_FLAG_DATA			0x01	//SEQ is valid, a payload follows
+#define ARQ_FLAG_ACK			0x02	//Every frame before ACK was received
+#define ARQ_FLAG_NAK			0x04	//Frame ACK is missing, resend it now
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct arq_tx_slot_s
+{
+	uint8_t used;
+	uint8_t seq;
+	uint8_t retries;
+	uint16_t len;
+	uint32_t sentAt;
+	uint8_t str[COMM_STR_BUF_LEN];	//Framed, ready to be resent
+};
+
+struct arq_rx_slot_s
+{
+	uint8_t used;
+	uint8_t payload[PACKAGED_PAYLOAD_LEN - ARQ_HEADER_LEN];
+};
+
+//Sequence numbers and windows shared with one peer
+struct arq_peer_s
+{
+	uint8_t used;
+	uint8_t addr;			//ARQ_ADDR of its frames
+
+	//Transmission:
+	uint8_t txNext;			//Next sequence number
+	uint8_t txBase;			//Oldest frame not acknowledged
+	struct arq_tx_slot_s tx[ARQ_WINDOW];
+
+	//Reception:
+	uint8_t rxNext;			//Next sequence number expected
+	uint8_t ackPending;
+	uint8_t nakPending;
+	uint8_t nakSent;		//Only one NAK per missing frame
+	uint32_t ackSince;
+	uint32_t gapSince;
+	uint8_t info[2];		//Last 'info', used when a gap is skipped
+	struct arq_rx_slot_s rx[ARQ_WINDOW];
+};
+
+struct arq_s
+{
+	uint8_t enabled;
+	uint32_t rto;
+	struct arq_peer_s peer[ARQ_PEERS];
+
+	//Statistics (all peers):
+	uint32_t retransmits;
+	uint32_t duplicates;
+	uint32_t outOfOrder;
+	uint32_t dropped;		//Gave up after ARQ_MAX_RETRIES
+	uint32_t ignored;		//For another slave, or no room for a new peer
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct arq_s commArq[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+uint8_t arq_enable(uint8_t port, uint32_t rto);
+void arq_disable(uint8_t port);
+uint8_t arq_is_enabled(uint8_t port);
+void arq_restart(uint8_t port, uint8_t addr);
+uint8_t arq_send(uint8_t port, uint8_t *payload, uint8_t bytes, uint32_t now);
+uint8_t arq_receive(uint8_t port, uint8_t *str, uint8_t *info, uint32_t now);
+void arq_rx_error(uint8_t port, uint32_t now);
+void arq_poll(uint8_t port, uint32_t now);
+uint8_t arq_in_flight(uint8_t port);
+uint8_t arq_peer_in_flight(uint8_t port, uint8_t addr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_ARQ_H
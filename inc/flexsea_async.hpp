@@ -0,0 +1,494 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_async: C++20 coroutine front end (host side)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Request/response without state machines, for host applications:
+//
+//	flexsea::Task poll_joint(flexsea::Port &port)
+//	{
+//		flexsea::Reply r = co_await port.read(FLEXSEA_EXECUTE_1, CMD_READ_ALL);
+//		if(r.status == flexsea::Status::Ok) { ...r.payload... }
+//	}
+//
+// 1) flexsea::EventLoop loop; loop.bind(transport) (flexsea_transport, or
+//    nothing: comm_port_send(), and corr_receive(loop.corr(), ...,
+//    loop.ticks()) from your own RX path)
+// 2) flexsea::Port port(loop, PORT_USB); start Tasks (they run until their
+//    first co_await)
+// 3) loop.run() (or loop.run_once() in your own loop)
+//
+//A read sends the request, suspends, and resumes when a reply with the
+//same port, slave (XID) and command comes back, or when it times out.
+//The matching is flexsea_corr's: the loop has its own table (fifo, so
+//several reads with the same key are answered in order), or shares the
+//one given to the constructor with flexsea_pipeline or flexsea_tdma. A
+//table has one time base: everything that uses it takes the loop's
+//ticks() as 'now', in the unit given to the constructor (1 us for
+//flexsea_tdma, whose slots and timeouts are in us). Replies also go to
+//payload_parse_str(), like before. Coroutines are resumed from the loop,
+//never from inside corr_receive(). Single threaded.
+
+#ifndef INC_FX_ASYNC_HPP
+#define INC_FX_ASYNC_HPP
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <vector>
+#include "flexsea.h"
+#include "flexsea_comm.h"
+#include "flexsea_corr.h"
+#include "flexsea_payload.h"
+#ifdef __linux__
+#include "flexsea_transport.h"
+#endif	//__linux__
+
+namespace flexsea
+{
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+using Clock = std::chrono::steady_clock;
+
+enum class Status
+{
+	Ok,
+	Timeout,
+	SendError,
+	Cancelled				//The loop was destroyed first
+};
+
+struct Reply
+{
+	Status status = Status::Cancelled;
+	uint8_t payload[PACKAGED_PAYLOAD_LEN] = {};
+	std::chrono::microseconds rtt{0};
+};
+
+//Fire and forget coroutine: starts right away, frees itself at the end
+struct Task
+{
+	struct promise_type
+	{
+		Task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+class EventLoop;
+
+//One outstanding read, lives in the coroutine frame while it's suspended
+struct Pending
+{
+	EventLoop *loop = nullptr;
+	struct corr_req_s *req = nullptr;	//While it's in the loop's table
+	Clock::time_point sentAt;
+	std::coroutine_handle<> handle;
+	Reply reply;
+};
+
+//****************************************************************************
+// Event loop
+//****************************************************************************
+
+class EventLoop
+{
+public:
+	//Sends a comm_str. Default: comm_port_send(), or the bound transport
+	using Sender = std::function<bool(uint8_t port, uint8_t *str, uint16_t len)>;
+
+	static constexpr uint16_t DefaultCapacity = 4096;
+
+	//Own table, for up to 'capacity' reads in flight
+	explicit EventLoop(uint16_t capacity = DefaultCapacity) : pool(capacity)
+	{
+		corr_init_pool(&own, pool.data(), capacity, 1, nullptr);
+		own.fifo = 1;
+		table = &own;
+	}
+
+	//Reads go in 'c', shared with the other masters of the port. Its
+	//ticks have to be ticks(), 'tick' long (the other users' unit).
+	explicit EventLoop(struct corr_s *c, \
+						std::chrono::nanoseconds tick = std::chrono::milliseconds(1)) : \
+		unit(tick), table(c) {}
+
+	EventLoop(const EventLoop &) = delete;
+	EventLoop &operator=(const EventLoop &) = delete;
+
+	~EventLoop()
+	{
+		//Whatever is still waiting resumes with Status::Cancelled (new
+		//reads fail with Status::SendError):
+		closing = true;
+		while(!ready.empty())
+		{
+			std::coroutine_handle<> h = ready.front();
+			ready.pop_front();
+			h.resume();
+		}
+		for(uint16_t i = 0; (i < table->size) && outstanding; i++)
+		{
+			struct corr_req_s *r = &table->req[i];
+			if((r->state == CORR_PENDING) && (r->done == &EventLoop::corr_done) && \
+				(static_cast<Pending *>(r->user)->loop == this))
+			{
+				Pending *p = static_cast<Pending *>(r->user);
+				corr_remove(table, r);
+				p->req = nullptr;
+				outstanding--;
+				p->reply.status = Status::Cancelled;
+				p->handle.resume();
+			}
+		}
+		#ifdef __linux__
+		if(bound == this)
+		{
+			bound = nullptr;
+		}
+		#endif	//__linux__
+	}
+
+	void set_sender(Sender s) { sender = std::move(s); }
+	void set_timeout(std::chrono::milliseconds t) { timeout = t; }
+	std::chrono::milliseconds get_timeout() const { return timeout; }
+	size_t pending() const { return outstanding; }
+	size_t ready_count() const { return ready.size(); }
+
+	//The table replies are matched in: give it what comes back, with
+	//corr_receive(loop.corr(), payload, info, loop.ticks())
+	struct corr_s *corr() const { return table; }
+
+	//Loop time, in table ticks since the loop was created (ms, or the
+	//constructor's 'tick')
+	uint32_t ticks(Clock::time_point t) const
+	{
+		return (uint32_t)((t - epoch) / unit);
+	}
+	uint32_t ticks() const { return ticks(now()); }
+
+	//Registers a request and sends it. False if it couldn't be sent.
+	bool submit(Pending *p, uint8_t port, uint8_t *payload, uint8_t bytes, \
+				std::chrono::milliseconds t)
+	{
+		uint8_t str[COMM_STR_BUF_LEN];
+		uint16_t len = 0;
+
+		len = comm_gen_str_port(port, payload, str, bytes);
+		if(closing || (len == 0))
+		{
+			return false;
+		}
+
+		//In the table first, the reply can't beat it:
+		p->loop = this;
+		p->sentAt = now();
+		p->req = corr_insert(table, port, payload[P_RID], CMD_7BITS(payload[P_CMD1]), \
+							ticks(p->sentAt), (uint32_t)std::max<int64_t>\
+							((t + unit - std::chrono::nanoseconds(1)) / unit, 1));
+		if(p->req == nullptr)
+		{
+			return false;
+		}
+		p->req->done = &EventLoop::corr_done;
+		p->req->user = p;
+		outstanding++;
+
+		if(!send(port, str, (uint16_t)(len + 1)))
+		{
+			if(p->req == nullptr)
+			{
+				return true;		//Answered from inside send()
+			}
+			corr_remove(table, p->req);
+			p->req = nullptr;
+			outstanding--;
+			return false;
+		}
+
+		sent++;
+		return true;
+	}
+
+	//Times out what's late, then resumes the coroutines that can go on.
+	//Returns how many were resumed.
+	size_t poll(Clock::time_point t)
+	{
+		size_t cnt = 0;
+
+		clock = t;
+		corr_advance(table, ticks(t));
+
+		//(Coroutines can add to it)
+		while(!ready.empty())
+		{
+			std::coroutine_handle<> h = ready.front();
+			ready.pop_front();
+			h.resume();
+			cnt++;
+		}
+
+		return cnt;
+	}
+
+	#ifdef __linux__
+
+	//Replies come from that transport, requests go out through it
+	void bind(struct transport_s *t)
+	{
+		transport = t;
+		bound = this;
+		t->rx_callback = &EventLoop::transport_rx;
+	}
+
+	//One round: waits for data (at most until the next timeout, and
+	//'maxWait'), decodes it, then poll(). Returns -1 on a transport error.
+	int run_once(std::chrono::milliseconds maxWait = std::chrono::milliseconds(100))
+	{
+		auto wait = maxWait;
+		uint32_t tick = 0;
+		int ret = 0;
+
+		if(!ready.empty())
+		{
+			wait = std::chrono::milliseconds(0);
+		}
+		else if(corr_next(table, &tick))
+		{
+			auto untilNext = std::chrono::ceil<std::chrono::milliseconds>\
+								(unit * (int32_t)(tick - ticks(Clock::now())));
+			wait = std::max(std::chrono::milliseconds(0), std::min(wait, untilNext));
+		}
+
+		if(transport)
+		{
+			ret = transport_poll(transport, (int)wait.count());
+		}
+
+		poll(Clock::now());
+		return ((ret < 0) ? -1 : 0);
+	}
+
+	//Until every read is done
+	int run()
+	{
+		while(outstanding || !ready.empty())
+		{
+			if(run_once() < 0)
+			{
+				return -1;
+			}
+		}
+		return 0;
+	}
+
+	#endif	//__linux__
+
+	//Statistics:
+	uint64_t sent = 0;
+	uint64_t replies = 0;
+	uint64_t timeouts = 0;
+
+private:
+	//Replied or timed out: resumed by the next poll()
+	static void corr_done(struct corr_s *c, struct corr_req_s *r, uint8_t *payload)
+	{
+		Pending *p = static_cast<Pending *>(r->user);
+		EventLoop *l = p->loop;
+
+		(void)c;
+		if(r->state == CORR_DONE)
+		{
+			memcpy(p->reply.payload, payload, PACKAGED_PAYLOAD_LEN);
+			p->reply.status = Status::Ok;
+			p->reply.rtt = std::chrono::duration_cast<std::chrono::microseconds>\
+							(l->now() - p->sentAt);
+			l->replies++;
+		}
+		else
+		{
+			p->reply.status = Status::Timeout;
+			l->timeouts++;
+		}
+
+		p->req = nullptr;
+		l->outstanding--;
+		l->ready.push_back(p->handle);
+	}
+
+	Clock::time_point now() const
+	{
+		return ((clock == Clock::time_point{}) ? Clock::now() : clock);
+	}
+
+	bool send(uint8_t port, uint8_t *str, uint16_t len)
+	{
+		if(sender)
+		{
+			return sender(port, str, len);
+		}
+
+		#ifdef __linux__
+		if(transport)
+		{
+			for(int i = 0; i < transport->cnt; i++)
+			{
+				if(transport->port[i].port == port)
+				{
+					return (transport_send(transport, i, str, len) == 0);
+				}
+			}
+			return false;
+		}
+		#endif	//__linux__
+
+		return (comm_port_send(port, str, len) != 0);
+	}
+
+	#ifdef __linux__
+	static void transport_rx(uint8_t port, uint8_t *payload)
+	{
+		uint8_t info[2] = {port, 0};
+
+		if(bound)
+		{
+			corr_receive(bound->table, payload, info, bound->ticks());
+		}
+		else
+		{
+			payload_parse_str(payload, info);
+		}
+	}
+
+	struct transport_s *transport = nullptr;
+	static inline EventLoop *bound = nullptr;
+	#endif	//__linux__
+
+	Sender sender;
+	std::chrono::milliseconds timeout{100};
+	bool closing = false;
+	Clock::time_point clock{};	//Set by poll(). Default: steady_clock
+	Clock::time_point epoch = Clock::now();
+	std::chrono::nanoseconds unit = std::chrono::milliseconds(1);	//One tick
+	std::vector<struct corr_req_s> pool;
+	struct corr_s own;
+	struct corr_s *table = nullptr;
+	size_t outstanding = 0;
+	std::deque<std::coroutine_handle<>> ready;
+};
+
+//****************************************************************************
+// Awaitable read
+//****************************************************************************
+
+class ReadAwaiter
+{
+public:
+	ReadAwaiter(EventLoop &l, uint8_t port, uint8_t slave, uint8_t cmd, \
+				const uint8_t *data, uint8_t len, std::chrono::milliseconds t) :
+		loop(l), port(port), timeout(t)
+	{
+		len = (uint8_t)std::min<int>(len, PAYLOAD_BUF_LEN - P_DATA1);
+		prepare_empty_payload(board_id, slave, payload, PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_R(cmd);
+		if(data && len)
+		{
+			memcpy(&payload[P_DATA1], data, len);
+		}
+		bytes = P_DATA1 + len;
+	}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool await_suspend(std::coroutine_handle<> h)
+	{
+		p.handle = h;
+		if(!loop.submit(&p, port, payload, bytes, timeout))
+		{
+			p.reply.status = Status::SendError;
+			return false;		//Resumes right away
+		}
+		return true;
+	}
+
+	Reply await_resume() { return p.reply; }
+
+private:
+	EventLoop &loop;
+	uint8_t port;
+	std::chrono::milliseconds timeout;
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint8_t bytes = 0;
+	Pending p;
+};
+
+//A FlexSEA port of the loop
+class Port
+{
+public:
+	Port(EventLoop &l, uint8_t port) : loop(l), port(port) {}
+
+	//co_await port.read(slave, CMD_x) => Reply. Optional data bytes.
+	ReadAwaiter read(uint8_t slave, uint8_t cmd, const uint8_t *data = nullptr, \
+					uint8_t len = 0)
+	{
+		return ReadAwaiter(loop, port, slave, cmd, data, len, loop.get_timeout());
+	}
+
+	ReadAwaiter read(uint8_t slave, uint8_t cmd, std::chrono::milliseconds t, \
+					const uint8_t *data = nullptr, uint8_t len = 0)
+	{
+		return ReadAwaiter(loop, port, slave, cmd, data, len, t);
+	}
+
+	uint8_t id() const { return port; }
+
+private:
+	EventLoop &loop;
+	uint8_t port;
+};
+
+}	//namespace flexsea
+
+#endif	//INC_FX_ASYNC_HPP
@@ -43,6 +43,19 @@ extern "C" {
 #include "flexsea.h"
 #include "flexsea_board.h"
 
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+//Generic reception buffer, for code that needs more than the fixed buffers
+//below (ex.: a host transport with many ports)
+struct rx_buf_s
+{
+	uint8_t buf[RX_BUF_LEN];
+	uint32_t idx;
+	uint8_t port;			//Statistics, COMM_STATS_NO_PORT if there is none
+};
+
 //****************************************************************************
 // Shared variable(s)
 //****************************************************************************
@@ -96,6 +109,10 @@ void update_rx_buf_byte_5(uint8_t new_byte);
 void update_rx_buf_array_5(uint8_t *new_array, uint32_t len);
 #endif	//ENABLE_FLEXSEA_BUF_5
 
+void update_rx_buf_byte_s(struct rx_buf_s *rb, uint8_t new_byte);
+void update_rx_buf_array_s(struct rx_buf_s *rb, uint8_t *new_array, uint32_t len);
+void discard_rx_buf_s(struct rx_buf_s *rb, uint32_t len);
+
 uint8_t unwrap_buffer(uint8_t *array, uint8_t *new_array, uint32_t len);
 
 #ifdef ENABLE_COMM_MANUAL_TEST_FCT
@@ -0,0 +1,131 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_bulk: parallel decode of large byte streams
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_BULK_H
+#define INC_FX_BULK_H
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include <pthread.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef BULK_MAX_THREADS
+#define BULK_MAX_THREADS		32
+#endif	//BULK_MAX_THREADS
+
+#define BULK_CHUNK_DEFAULT		(1UL << 20)	//Bytes per thread and per pass
+#define BULK_MIN_FRAME			4			//HEADER, 0, checksum, FOOTER
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+//A decoded frame, given to the callback in stream order
+struct bulk_frame_s
+{
+	uint64_t offset;		//Of its HEADER in the stream
+	uint16_t len;			//Frame bytes
+	uint8_t payloadLen;		//De-escaped, PACKAGED_PAYLOAD_LEN at most
+	uint8_t *payload;		//Only valid during the callback
+};
+
+//Private: the frames one thread found in its chunk
+struct bulk_found_s
+{
+	uint64_t offset;
+	uint32_t payloadIdx;
+	uint16_t len;
+	uint8_t payloadLen;
+};
+
+struct bulk_chunk_s
+{
+	uint8_t *buf;			//Whole stream
+	uint64_t len;
+	uint64_t start;			//Frames that start in [start, end)
+	uint64_t end;
+	uint64_t stop;			//Where the scan stopped (>= end)
+
+	struct bulk_found_s *found;
+	uint32_t cnt;
+	uint8_t *payload;		//De-escaped payloads, back to back
+
+	pthread_t thread;
+};
+
+struct bulk_s
+{
+	uint8_t threads;		//1: serial
+	uint32_t chunk;
+
+	//Called for every frame, in order, from the calling thread:
+	void (*callback)(struct bulk_s *b, struct bulk_frame_s *f);
+	void *ctx;				//For the callback
+
+	//Results:
+	uint64_t frames;
+	uint64_t bytes;
+	uint64_t fixups;		//Frames decoded again at chunk edges
+	uint64_t ns;
+
+	//Private:
+	struct bulk_chunk_s c[BULK_MAX_THREADS];
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+int bulk_init(struct bulk_s *b, uint8_t threads, uint32_t chunk);
+void bulk_free(struct bulk_s *b);
+int bulk_decode(struct bulk_s *b, uint8_t *buf, uint64_t len);
+int bulk_decode_file(struct bulk_s *b, const char *path);
+uint16_t bulk_frame_at(uint8_t *buf, uint64_t len, uint64_t pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
+
+#endif	//INC_FX_BULK_H
@@ -0,0 +1,188 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_capture: wire capture ring and trace files
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_CAPTURE_H
+#define INC_FX_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef CAPTURE_RING_LEN
+#define CAPTURE_RING_LEN		65536	//Bytes. Power of 2.
+#endif	//CAPTURE_RING_LEN
+
+#if (CAPTURE_RING_LEN & (CAPTURE_RING_LEN - 1)) != 0
+#error "CAPTURE_RING_LEN has to be a power of 2"
+#endif
+
+//Record types:
+#define CAPTURE_END				0	//Not a record: end of the data
+#define CAPTURE_RX_BYTES		1	//Raw bytes, as received (update_rx_buf_array)
+#define CAPTURE_RX_FRAME		2	//Frame found by the decoder, see 'status'
+#define CAPTURE_TX_FRAME		3	//Frame built by comm_gen_str()
+#define CAPTURE_PAD				4	//Ring only: skip to the end of the ring
+
+#define CAPTURE_MAX_BYTES		2048	//Longer RX chunks are split
+
+//Records start on 8 bytes boundaries:
+#define CAPTURE_ALIGN			8
+#define CAPTURE_REC_LEN(n)		((sizeof(struct capture_rec_s) + (n) + \
+								CAPTURE_ALIGN - 1) & ~(CAPTURE_ALIGN - 1))
+#define CAPTURE_DATA(r)			((uint8_t *)(r) + sizeof(struct capture_rec_s))
+
+#ifdef __GNUC__
+#define CAPTURE_ALIGNED			__attribute__((aligned(CAPTURE_ALIGN)))
+#else
+#define CAPTURE_ALIGNED
+#endif
+
+//Capture files:
+#define CAPTURE_MAGIC			0x50435846	//"FXCP"
+#define CAPTURE_VERSION			1
+#define CAPTURE_FILE_CHUNK		(1UL << 20)	//Grown and mapped by 1 MiB
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+//Record header, followed by 'len' bytes of data and padding
+struct capture_rec_s
+{
+	uint64_t time;			//Ticks of the capture clock
+	uint16_t len;			//Data bytes
+	uint8_t type;			//CAPTURE_x
+	uint8_t port;			//COMM_STATS_NO_PORT when it isn't known
+	int8_t status;			//CAPTURE_RX_FRAME: 1 (valid) or UNPACK_ERR_x
+	uint8_t reserved[3];
+};
+
+//Start of a capture file, followed by the records
+struct capture_file_hdr_s
+{
+	uint32_t magic;			//CAPTURE_MAGIC, byte swapped if the endianness differs
+	uint16_t version;
+	uint16_t recHdrLen;		//sizeof(struct capture_rec_s)
+	uint32_t tickHz;		//Capture clock
+	uint32_t reserved;
+};
+
+//Single producer, single consumer ring. The producer only writes 'head',
+//the consumer only writes 'tail'.
+struct capture_s
+{
+	uint32_t head;
+	uint32_t records;
+	uint32_t dropped;		//Ring full, the record was lost
+	uint64_t (*clock)(void);
+	uint32_t tickHz;
+
+	uint8_t ring[CAPTURE_RING_LEN] CAPTURE_ALIGNED;
+
+	uint32_t tail;
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void capture_init(struct capture_s *c, uint64_t (*clock)(void), uint32_t tickHz);
+uint8_t capture_write(struct capture_s *c, uint8_t type, uint8_t port, \
+						int8_t status, uint8_t *data, uint16_t len);
+uint8_t capture_write_bytes(struct capture_s *c, uint8_t port, uint8_t *data, \
+							uint32_t len);
+uint32_t capture_drain(struct capture_s *c, \
+						void (*sink)(void *ctx, uint8_t *rec, uint32_t len), void *ctx);
+struct capture_rec_s *capture_next(uint8_t *buf, uint64_t len, uint64_t *pos);
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+//Tap used by the stack. Nothing is captured while it's NULL.
+#define CAPTURE_TAP(type, port, status, data, len)	\
+	do { if(captureTap) { capture_write(captureTap, (type), (port), \
+							(status), (data), (len)); } } while(0)
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+#ifdef __linux__
+
+#include <pthread.h>
+
+//Append-only capture file, written through a memory mapped window
+struct capture_file_s
+{
+	int fd;
+	struct capture_s *c;
+	uint8_t *map;			//CAPTURE_FILE_CHUNK bytes at 'mapOff'
+	uint64_t mapOff;
+	uint64_t size;			//Allocated
+	uint64_t len;			//Written
+	int err;				//Last errno, 0 if all is well
+
+	pthread_t thread;
+	uint8_t running;
+	uint32_t periodUs;
+};
+
+int capture_file_open(struct capture_file_s *f, struct capture_s *c, \
+						const char *path);
+uint32_t capture_file_flush(struct capture_file_s *f);
+int capture_file_start(struct capture_file_s *f, uint32_t periodUs);
+void capture_file_stop(struct capture_file_s *f);
+int capture_file_close(struct capture_file_s *f);
+uint8_t *capture_file_map(const char *path, uint64_t *len, uint32_t *tickHz);
+void capture_file_unmap(uint8_t *map, uint64_t len);
+uint64_t capture_clock_ns(void);
+
+#endif	//__linux__
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+extern struct capture_s *captureTap;
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_CAPTURE_H
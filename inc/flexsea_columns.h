@@ -0,0 +1,179 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_columns: decoded telemetry as columns
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_COLUMNS_H
+#define INC_FX_COLUMNS_H
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_bulk.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef COLUMNS_MAX_TABLES
+#define COLUMNS_MAX_TABLES		16		//Commands
+#endif	//COLUMNS_MAX_TABLES
+
+#ifndef COLUMNS_MAX_FIELDS
+#define COLUMNS_MAX_FIELDS		32		//Per command
+#endif	//COLUMNS_MAX_FIELDS
+
+#define COLUMNS_NAME_LEN		24
+#define COLUMNS_BATCH			1024	//Rows converted at once
+#define COLUMNS_ROWS_MIN		4096	//First allocation
+
+//Field types: size in bytes, MSB set if signed
+#define COLUMNS_U8				0x01
+#define COLUMNS_I8				0x81
+#define COLUMNS_U16				0x02
+#define COLUMNS_I16				0x82
+#define COLUMNS_U32				0x04
+#define COLUMNS_I32				0x84
+#define COLUMNS_U64				0x08	//'key' column only
+#define COLUMNS_SIZE(type)		((type) & 0x0F)
+#define COLUMNS_SIGNED(type)	(((type) & 0x80) ? 1 : 0)
+
+//Columns every table has, before its fields:
+#define COLUMNS_KEY				"key"	//U64: stream offset, time...
+#define COLUMNS_XID				"xid"	//U8: P_XID, who sent it
+#define COLUMNS_NO_OFFSET		0xFF
+
+//Files:
+#define COLUMNS_MAGIC			0x4C435846	//"FXCL"
+#define COLUMNS_VERSION			1
+#define COLUMNS_DATA_ALIGN		64
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+//One field of a payload, as read by REBUILD_UINT16()/REBUILD_UINT32()
+struct columns_field_s
+{
+	const char *name;
+	uint8_t offset;			//In the payload (P_DATA1 + ...)
+	uint8_t type;			//COLUMNS_x
+};
+
+//The rows of one command. Column i holds field i, one value per row.
+struct columns_table_s
+{
+	uint8_t cmd;			//7 bits, CMD_7BITS(payload[P_CMD1])
+	uint8_t fields;
+	char name[COLUMNS_MAX_FIELDS][COLUMNS_NAME_LEN];
+	uint8_t offset[COLUMNS_MAX_FIELDS];
+	uint8_t type[COLUMNS_MAX_FIELDS];
+	uint8_t minLen;			//Shorter payloads are skipped
+
+	uint64_t rows;
+	uint64_t cap;
+	uint64_t converted;		//Rows in native byte order
+	uint64_t *key;
+	uint8_t *xid;
+	void *col[COLUMNS_MAX_FIELDS];
+};
+
+struct columns_s
+{
+	uint8_t tables;
+	struct columns_table_s t[COLUMNS_MAX_TABLES];
+	uint8_t lookup[128];	//Command: table + 1, 0 if it isn't exported
+
+	uint64_t rows;
+	uint64_t skipped;		//Too short, or out of memory
+	uint64_t unknown;		//No schema for this command
+	uint64_t native;		//Native layout payloads, not exported
+};
+
+//Start of a columns file, followed by the tables
+struct columns_file_hdr_s
+{
+	uint32_t magic;			//COLUMNS_MAGIC, byte swapped if the endianness differs
+	uint16_t version;
+	uint16_t tables;
+	uint64_t reserved;
+};
+
+//A table, followed by its columns
+struct columns_table_hdr_s
+{
+	uint8_t cmd;
+	uint8_t columns;		//Key, xid and the fields
+	uint8_t reserved[6];
+	uint64_t rows;
+};
+
+struct columns_col_hdr_s
+{
+	char name[COLUMNS_NAME_LEN];
+	uint8_t type;
+	uint8_t offset;			//In the payload, COLUMNS_NO_OFFSET for key and xid
+	uint8_t reserved[6];
+	uint64_t data;			//File offset of the values, COLUMNS_DATA_ALIGN
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void columns_init(struct columns_s *c);
+int columns_add_schema(struct columns_s *c, uint8_t cmd, \
+						const struct columns_field_s *fields, uint8_t n);
+uint8_t columns_add(struct columns_s *c, uint8_t *payload, uint8_t len, uint64_t key);
+void columns_bulk_callback(struct bulk_s *b, struct bulk_frame_s *f);
+struct columns_table_s *columns_table(struct columns_s *c, uint8_t cmd);
+void columns_finish(struct columns_s *c);
+int columns_write(struct columns_s *c, const char *path);
+void columns_free(struct columns_s *c);
+
+uint8_t *columns_map(const char *path, uint64_t *len);
+void columns_unmap(uint8_t *map, uint64_t len);
+const void *columns_find(uint8_t *map, uint64_t len, uint8_t cmd, \
+						const char *name, uint8_t *type, uint64_t *rows);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
+
+#endif	//INC_FX_COLUMNS_H
@@ -43,11 +43,16 @@ extern "C" {
 #include "flexsea_board.h"
 #include "flexsea_system.h"
 
+struct rx_buf_s;
+
 //****************************************************************************
 // Public Function Prototype(s):
 //****************************************************************************
 
 uint8_t comm_gen_str(uint8_t payload[], uint8_t *cstr, uint8_t bytes);
+uint16_t comm_gen_str_fast(uint8_t payload[], uint8_t *cstr, uint16_t bytes);
+uint16_t comm_gen_str_port(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+							uint16_t bytes);
 
 #ifdef ENABLE_FLEXSEA_BUF_1
 int8_t unpack_payload_1(void);
@@ -61,7 +66,28 @@ int8_t unpack_payload_3(void);
 #ifdef ENABLE_FLEXSEA_BUF_4
 int8_t unpack_payload_4(void);
 #endif	//ENABLE_FLEXSEA_BUF_4
+int8_t unpack_payload_buf(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN]);
 int8_t unpack_payload_test(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN]);
+int16_t unpack_payload_fast(uint8_t *buf, uint16_t len, uint8_t **payload);
+int16_t unpack_payload_frame(uint8_t *buf, uint16_t len, uint8_t *payload);
+int8_t unpack_payload_port(uint8_t port, uint8_t *buf, uint16_t len, \
+							uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN]);
+int8_t unpack_payload_rx(struct rx_buf_s *rb, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN]);
+
+//Framing mode, per port:
+void comm_set_framing(uint8_t port, uint8_t framing);
+uint8_t comm_get_framing(uint8_t port);
+void comm_set_framing_next(uint8_t port, uint8_t framing);
+uint8_t comm_get_framing_next(uint8_t port);
+
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+//Skips the frames addressed to other boards, per port:
+void comm_set_rid_filter(uint8_t port, uint8_t on);
+uint8_t comm_get_rid_filter(uint8_t port);
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+uint8_t comm_port_send(uint8_t port, uint8_t *str, uint16_t len);
+uint8_t comm_crc8(uint8_t *buf, uint32_t len);
 
 //Random numbers and arrays:
 void initRandomGenerator(int seed);
@@ -77,6 +103,19 @@ void generateRandomUint8Array(uint8_t *arr, uint8_t size);
 #define FOOTER  				0xEE	//238d
 #define ESCAPE  				0xE9	//233d
 
+//Framing modes (selected per port, see comm_set_framing()):
+#define FRAMING_ESCAPED			0	//Default. [HEADER][BYTES][DATA][CHECKSUM][FOOTER]
+#define FRAMING_FAST			1	//[SYNC_H][SYNC_L][LEN_H][LEN_L][HCRC][DATA]
+
+//Fast framing. Only use it on links that preserve transfer boundaries
+//(SPI, USB bulk): there is no escaping, so it can't resync on a byte stream.
+#define FAST_SYNC_H				0xFA
+#define FAST_SYNC_L				0x5E
+#define FAST_HEADER_LEN			5		//Sync word, 16-bit length, header CRC
+#ifndef FAST_FRAME_MAX_LEN
+#define FAST_FRAME_MAX_LEN		COMM_STR_BUF_LEN	//Can be overloaded by the board
+#endif	//FAST_FRAME_MAX_LEN
+
 //Return codes:
 #define UNPACK_ERR_HEADER		-1
 #define UNPACK_ERR_FOOTER		-2
@@ -106,6 +145,8 @@ void generateRandomUint8Array(uint8_t *arr, uint8_t size);
 // Structure(s):
 //****************************************************************************
 
+//Deprecated, will be removed in the next release: flexsea_stats has the
+//per port counters. Still updated by every escaped frame encoded.
 struct commSpy_s
 {
 	uint8_t counter;
@@ -187,7 +228,11 @@ extern uint8_t rx_command_5[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
 extern struct comm_s slaveComm[COMM_SLAVE_BUS];
 extern struct comm_s masterComm[COMM_MASTERS];
 
-extern struct commSpy_s commSpy1;
+extern struct commSpy_s commSpy1;		//Deprecated, see flexsea_stats
+
+//Transmit function for each port, provided by the board (NULL if the port
+//can't be used by the stack itself, ex.: to reply to a link command):
+extern void (*flexsea_port_send_ptr[NUMBER_OF_PORTS])(uint8_t *str, uint16_t len);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,161 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_corr: request correlation & timeouts
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_CORR_H
+#define INC_FX_CORR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef CORR_MAX_PENDING
+#define CORR_MAX_PENDING		64		//Requests tracked at once (corr_init())
+#endif	//CORR_MAX_PENDING
+
+#define CORR_HASH_BITS			7		//128 buckets
+#define CORR_WHEEL_BITS			8		//256 ticks per turn
+#define CORR_HASH_SIZE			(1 << CORR_HASH_BITS)
+#define CORR_WHEEL_SIZE			(1 << CORR_WHEEL_BITS)
+#define CORR_NONE				0xFFFF	//End of a list
+
+#if (CORR_MAX_PENDING >= CORR_NONE)
+#error "CORR_MAX_PENDING is too large"
+#endif
+
+#define CORR_MAX_POOL			(CORR_NONE - 1)	//corr_init_pool()
+
+//corr_req_s.state:
+#define CORR_FREE				0
+#define CORR_PENDING			1
+#define CORR_DONE				2		//Replied, in the callback
+#define CORR_TIMEOUT			3		//Timed out, in the callback
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct corr_s;
+struct corr_req_s;
+
+//Called once per request, with state CORR_DONE ('payload' is the reply)
+//or CORR_TIMEOUT ('payload' is NULL). 'r' is freed on return.
+typedef void (*corr_cb_t)(struct corr_s *c, struct corr_req_s *r, uint8_t *payload);
+
+struct corr_req_s
+{
+	uint8_t port;
+	uint8_t rid;			//Slave
+	uint8_t cmd;			//7-bit command code; the reply uses the same
+	uint8_t state;			//CORR_x
+	uint32_t sentAt;
+	uint32_t expires;		//Tick
+	uint32_t rtt;			//Set when state is CORR_DONE
+	corr_cb_t done;			//Owner's callback, NULL: corr_s.callback
+	void *user;				//For the owner
+
+	//Lists (indexes in corr_s.req[]):
+	uint16_t hnext, hprev;	//Hash bucket, or free list
+	uint16_t wnext, wprev;	//Wheel slot
+};
+
+//Per slave:
+struct corr_rtt_s
+{
+	uint32_t replies;
+	uint32_t timeouts;
+	uint32_t last;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+};
+
+struct corr_s
+{
+	uint32_t timeout;		//In ticks, default for corr_insert()
+	uint32_t tick;			//Last tick corr_advance() went through
+	corr_cb_t callback;		//For the requests without their own
+	uint8_t fifo;			//1: more than one request per key, oldest first
+
+	struct corr_req_s *req;	//'pool', or the one given to corr_init_pool()
+	uint16_t size;
+	uint16_t freeList;
+	uint16_t pending;
+	uint16_t bucket[CORR_HASH_SIZE];
+	uint16_t wheel[CORR_WHEEL_SIZE];
+
+	//Statistics:
+	struct corr_rtt_s slave[256];
+	uint32_t inserted;
+	uint32_t completed;
+	uint32_t timeouts;
+	uint32_t unmatched;		//Late, duplicated or unexpected replies
+	uint32_t refused;		//Full, or already pending
+
+	struct corr_req_s pool[CORR_MAX_PENDING];
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void corr_init(struct corr_s *c, uint32_t timeout, corr_cb_t callback);
+void corr_init_pool(struct corr_s *c, struct corr_req_s *pool, uint16_t size, \
+					uint32_t timeout, corr_cb_t callback);
+struct corr_req_s *corr_insert(struct corr_s *c, uint8_t port, uint8_t rid, \
+								uint8_t cmd, uint32_t now, uint32_t timeout);
+struct corr_req_s *corr_track(struct corr_s *c, uint8_t port, uint8_t *payload, \
+								uint32_t now);
+struct corr_req_s *corr_find(struct corr_s *c, uint8_t port, uint8_t rid, \
+								uint8_t cmd);
+uint8_t corr_cancel(struct corr_s *c, uint8_t port, uint8_t rid, uint8_t cmd);
+uint8_t corr_remove(struct corr_s *c, struct corr_req_s *r);
+uint8_t corr_reply(struct corr_s *c, uint8_t port, uint8_t *payload, uint32_t now);
+uint16_t corr_advance(struct corr_s *c, uint32_t now);
+uint8_t corr_next(struct corr_s *c, uint32_t *tick);
+uint8_t corr_receive(struct corr_s *c, uint8_t *payload, uint8_t *info, \
+						uint32_t now);
+uint32_t corr_rtt_mean(struct corr_s *c, uint8_t rid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_CORR_H
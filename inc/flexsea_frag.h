@@ -0,0 +1,171 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_frag: fragmentation and reassembly of messages larger
+	than one payload (sliding window, NAKs)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_FRAG_H
+#define INC_FX_FRAG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Command code used by the fragments and their acknowledgments. Can be
+//overloaded by the board if it collides with a system command.
+#ifndef CMD_FRAG
+#define CMD_FRAG				(MAX_CMD_CODE - 2)
+#endif	//CMD_FRAG
+
+#ifndef FRAG_WINDOW
+#define FRAG_WINDOW				16		//Fragments in flight, 32 max
+#endif	//FRAG_WINDOW
+
+#ifndef FRAG_DEFAULT_RTO
+#define FRAG_DEFAULT_RTO		10		//Retransmission timeout, in ticks
+#endif	//FRAG_DEFAULT_RTO
+
+#define FRAG_MAX_RETRIES		5
+#define FRAG_MAX_FRAGMENTS		0xFFFF
+
+//Fragment header, in P_DATA1: [TYPE][MSG][SEQ_H][SEQ_L][LEN]
+#define FRAG_HEADER_LEN			5
+#define FRAG_TYPE				0
+#define FRAG_MSG				1
+#define FRAG_SEQ				2		//ACK/NAK: next fragment expected
+#define FRAG_LEN				4		//ACK/NAK: number of SEQ in the NAK list
+//Every byte of a fragment can need an ESCAPE: sized so that the worst case
+//still fits in a comm. string (with its 4 framing bytes)
+#define FRAG_PAYLOAD_MAX		((COMM_STR_BUF_LEN - 4) / 2)
+#define FRAG_DATA_BYTES			(FRAG_PAYLOAD_MAX - P_DATA1 - FRAG_HEADER_LEN)
+#define FRAG_NAK_MAX			(FRAG_DATA_BYTES / 2)
+#define FRAG_MAX_LEN			((uint32_t)FRAG_MAX_FRAGMENTS * FRAG_DATA_BYTES)
+
+//Types:
+#define FRAG_TYPE_DATA			1
+#define FRAG_TYPE_LAST			2		//Data, last fragment of the message
+#define FRAG_TYPE_ACK			3		//Every fragment before SEQ was received
+#define FRAG_TYPE_NAK			4		//Same, and the ones listed are missing
+
+//States:
+#define FRAG_IDLE				0
+#define FRAG_BUSY				1
+#define FRAG_DONE				2
+#define FRAG_FAILED				3		//Sender gave up, or too long for the receiver
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct frag_tx_s
+{
+	uint8_t state;
+	uint8_t msg;			//Message number, changes with every message
+	uint8_t rid;
+	uint8_t *data;			//Owned by the caller until done() is called
+	uint32_t len;
+	uint16_t count;			//Fragments
+	uint16_t base;			//Oldest fragment not acknowledged
+	uint16_t next;			//Next fragment sent for the first time
+	uint8_t retries;
+	uint32_t ackAt;
+	void (*done)(uint8_t port, uint8_t state);
+
+	//Statistics:
+	uint32_t sent;
+	uint32_t resent;
+};
+
+struct frag_rx_s
+{
+	uint8_t state;
+	uint8_t msg;
+	uint8_t xid;
+	uint8_t *buf;			//Preallocated by the caller, see frag_receive_into()
+	uint32_t size;
+	uint32_t len;
+	uint16_t next;			//Next fragment expected
+	uint16_t count;			//0 until the last fragment is received
+	uint32_t mask;			//Received, bit i is fragment next + i
+	uint8_t nakSent;		//Only one NAK per gap
+	uint8_t sinceAck;
+	uint8_t ackPending;
+	uint32_t ackSince;
+	void (*done)(uint8_t port, uint8_t *buf, uint32_t len);
+
+	//Statistics:
+	uint32_t duplicates;
+	uint32_t naks;
+	uint32_t dropped;		//Outside of the window
+};
+
+struct frag_s
+{
+	uint32_t rto;
+	uint8_t window;
+	uint32_t now;			//Last 'now', for the received fragments
+	struct frag_tx_s tx;
+	struct frag_rx_s rx;
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct frag_s commFrag[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void init_flexsea_frag(void);
+void frag_config(uint8_t port, uint32_t rto, uint8_t window);
+uint8_t frag_send(uint8_t port, uint8_t rid, uint8_t *data, uint32_t len, \
+					void (*done)(uint8_t port, uint8_t state), uint32_t now);
+void frag_receive_into(uint8_t port, uint8_t *buf, uint32_t size, \
+						void (*done)(uint8_t port, uint8_t *buf, uint32_t len));
+void frag_poll(uint8_t port, uint32_t now);
+
+void rx_cmd_frag(uint8_t *buf, uint8_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_FRAG_H
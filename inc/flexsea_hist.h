@@ -0,0 +1,112 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_hist: latency histograms
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_HIST_H
+#define INC_FX_HIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Log-linear buckets: exact below 2^HIST_SUB_BITS, then HIST_SUB buckets
+//per power of 2 (worst case error: 1/HIST_SUB of the value)
+#ifndef HIST_SUB_BITS
+#define HIST_SUB_BITS			3
+#endif	//HIST_SUB_BITS
+#define HIST_SUB				(1 << HIST_SUB_BITS)
+#define HIST_BUCKETS			((33 - HIST_SUB_BITS) * HIST_SUB)
+
+//Latency stages:
+#define HIST_STAGE_RX			0	//First byte in => frame decoded
+#define HIST_STAGE_DISPATCH		1	//Frame decoded => handler called
+#define HIST_STAGE_RTT			2	//Request sent => reply received
+#define HIST_STAGES				3
+
+#ifndef HIST_MAX_CMDS
+#define HIST_MAX_CMDS			8	//Commands with their own histograms
+#endif	//HIST_MAX_CMDS
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct hist_s
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t bucket[HIST_BUCKETS];
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void hist_init(struct hist_s *h);
+void hist_record(struct hist_s *h, uint32_t value);
+void hist_merge(struct hist_s *dst, struct hist_s *src);
+uint32_t hist_percentile(struct hist_s *h, uint16_t permille);
+uint32_t hist_mean(struct hist_s *h);
+uint16_t hist_bucket(uint32_t value);
+uint32_t hist_bucket_low(uint16_t bucket);
+uint32_t hist_bucket_high(uint16_t bucket);
+
+#ifdef ENABLE_FLEXSEA_HIST
+//Latency instrumentation, per port and per tracked command:
+void hist_set_clock(uint32_t (*clock)(void));
+uint8_t hist_track_cmd(uint8_t cmd);
+void hist_latency(uint8_t stage, uint8_t port, uint8_t cmd, uint32_t ticks);
+void hist_rx_byte(uint8_t port);
+void hist_rx_frame(uint8_t port, uint8_t cmd);
+void hist_dispatch(uint8_t port, uint8_t cmd);
+uint8_t hist_snapshot_port(uint8_t port, uint8_t stage, struct hist_s *out, \
+							uint8_t reset);
+uint8_t hist_snapshot_cmd(uint8_t cmd, uint8_t stage, struct hist_s *out, \
+							uint8_t reset);
+void hist_reset_all(void);
+#endif	//ENABLE_FLEXSEA_HIST
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_HIST_H
@@ -0,0 +1,124 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_link: link capability negotiation
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_LINK_H
+#define INC_FX_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Command code used by the capability exchange. Can be overloaded by the
+//board if it collides with a system command.
+#ifndef CMD_LINK_CAPS
+#define CMD_LINK_CAPS			(MAX_CMD_CODE - 1)
+#endif	//CMD_LINK_CAPS
+
+#define LINK_CAPS_VERSION		1
+#define LINK_CAPS_BYTES			(P_DATA1 + 7)	//Payload length
+
+//Frame versions (bitmask, the highest common bit wins):
+#define LINK_FRAME_ESCAPED		(1 << FRAMING_ESCAPED)
+#define LINK_FRAME_FAST			(1 << FRAMING_FAST)
+
+//Checksum types (bitmask):
+#define LINK_CHK_SUM8			0x01	//Escaped framing
+#define LINK_CHK_CRC8			0x02	//Fast framing header
+
+//Optional features (bitmask):
+#define LINK_FEAT_NONE			0x00
+#define LINK_FEAT_ARQ			0x01	//Sequence numbers & retransmissions
+#define LINK_FEAT_NATIVE		0x02	//Decodes P_CMDS_NATIVE payloads
+
+//Link states:
+#define LINK_LEGACY				0		//Default, never negotiated
+#define LINK_PENDING			1		//Request sent, no reply (yet)
+#define LINK_NEGOTIATED			2		//Using the common capabilities
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct link_caps_s
+{
+	uint8_t frames;			//LINK_FRAME_x
+	uint16_t maxFrameLen;	//Bytes, framing included
+	uint8_t checksums;		//LINK_CHK_x
+	uint8_t maxCmds;		//Commands per payload
+	uint8_t features;		//LINK_FEAT_x
+};
+
+struct link_s
+{
+	uint8_t state;
+	struct link_caps_s local;	//What this board supports on that port
+	struct link_caps_s peer;	//What the other end advertised
+	struct link_caps_s active;	//What we are using
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct link_s commLink[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void init_flexsea_link(void);
+void link_set_local_caps(uint8_t port, struct link_caps_s *caps);
+void link_reset(uint8_t port);
+uint8_t link_request_caps(uint8_t port, uint8_t rid);
+void link_common_caps(struct link_caps_s *a, struct link_caps_s *b, \
+						struct link_caps_s *common);
+uint8_t link_peer_native(uint8_t port);
+
+uint8_t tx_cmd_link_caps(uint8_t *buf, uint8_t xid, uint8_t rid, \
+						uint8_t rw, struct link_caps_s *caps);
+void rx_cmd_link_caps_rw(uint8_t *buf, uint8_t *info);
+void rx_cmd_link_caps_rr(uint8_t *buf, uint8_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_LINK_H
@@ -56,8 +56,15 @@ extern uint8_t payload_str[PAYLOAD_BUF_LEN];
 uint8_t payload_parse_str(uint8_t *cp_str, uint8_t *info);
 uint8_t sent_from_a_slave(uint8_t *buf);
 uint8_t packetType(uint8_t *buf);
+uint8_t payload_rid_match(uint8_t cp_rid);
 void prepare_empty_payload(uint8_t from, uint8_t to, uint8_t *buf, uint32_t len);
 void flexsea_payload_catchall(uint8_t *buf, uint8_t *info);
+uint8_t payload_set_native(uint8_t cmd_7bits, uint8_t native);
+uint8_t payload_get_native(uint8_t cmd_7bits);
+uint8_t payload_is_native(uint8_t *buf);
+uint8_t payload_pack_native(uint8_t port, uint8_t *buf, uint8_t cmd, const void *data, \
+							uint8_t len);
+uint8_t payload_unpack_native(uint8_t *buf, void *data, uint8_t len);
 
 //****************************************************************************
 // Definition(s):
@@ -0,0 +1,93 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_pipeline: several requests in flight per slave bus
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_PIPELINE_H
+#define INC_FX_PIPELINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_corr.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef PIPE_MAX_WINDOW
+#define PIPE_MAX_WINDOW			16		//Requests in flight, per bus
+#endif	//PIPE_MAX_WINDOW
+
+#define PIPE_MAX_PER_SLAVE		1		//Default for pipe_s.maxPerSlave
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct pipe_s
+{
+	struct corr_s *corr;	//Where the requests are matched, same ticks
+	uint8_t port;
+	uint8_t window;			//Max requests in flight (<= PIPE_MAX_WINDOW)
+	uint8_t maxPerSlave;	//Max requests in flight to the same slave
+	uint32_t timeout;		//In ticks, 0: the corr_s default
+
+	uint8_t inFlight;
+	uint8_t perSlave[256];	//Requests in flight, by slave ID
+
+	//Statistics:
+	uint32_t issued;
+	uint32_t matched;
+	uint32_t timeouts;
+	uint32_t rttMax;
+	uint64_t rttSum;
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void pipe_init(struct pipe_s *p, struct corr_s *c, uint8_t port, uint8_t window, \
+				uint32_t timeout);
+uint8_t pipe_can_issue(struct pipe_s *p, uint8_t rid, uint8_t cmd);
+struct corr_req_s *pipe_issue(struct pipe_s *p, uint8_t *payload, uint32_t now);
+uint8_t pipe_send(struct pipe_s *p, uint8_t *payload, uint8_t bytes, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_PIPELINE_H
@@ -0,0 +1,120 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_replay: capture replay through the decoder
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_REPLAY_H
+#define INC_FX_REPLAY_H
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_buffers.h"
+#include "flexsea_capture.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Modes:
+#define REPLAY_FAST				0	//As fast as possible
+#define REPLAY_TIMED			1	//Original timing (scaled by 'speed')
+
+#define REPLAY_PORTS			(NUMBER_OF_PORTS + 1)	//+ COMM_STATS_NO_PORT
+#define REPLAY_SPIN_NS			50000	//REPLAY_TIMED: busy wait, not sleep, that close
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct replay_report_s
+{
+	uint64_t records;		//CAPTURE_RX_BYTES records fed to the decoder
+	uint64_t bytes;
+	uint64_t frames;		//Payloads decoded
+	uint64_t expected;		//Valid frames in the capture, on the ports replayed
+	uint64_t divergences;	//Frames decoded differently than when recorded
+	uint64_t firstDivergence;	//Capture offset, 0 if there is none
+	uint64_t ns;			//Wall clock
+	uint64_t lateNs;		//REPLAY_TIMED: worst lateness
+};
+
+struct replay_s
+{
+	uint8_t mode;
+	uint16_t speed;			//REPLAY_TIMED, in %. 100: original timing.
+	uint8_t dispatch;		//0: decode only
+	uint8_t defaultPort;	//info[0] for the data captured without a port
+
+	//Called for every decoded payload. NULL: payload_parse_str()
+	void (*rx_callback)(uint8_t port, uint8_t *payload);
+	//Called for every divergence. One of them is NULL for a missing frame,
+	//both without ENABLE_FLEXSEA_CAPTURE (the totals differ).
+	void (*diverge)(struct capture_rec_s *expected, struct capture_rec_s *got);
+
+	struct replay_report_s report;
+
+	//Private:
+	struct rx_buf_s rx[REPLAY_PORTS];
+	uint8_t rxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t *buf;
+	uint64_t len;
+	uint64_t pos;
+	uint64_t expect[REPLAY_PORTS];	//Next recorded frame of each port
+	uint8_t fed[REPLAY_PORTS];
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	struct capture_s observed;		//What the decoder finds now
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void replay_init(struct replay_s *r, uint8_t mode);
+int replay_buf(struct replay_s *r, uint8_t *buf, uint64_t len, uint64_t start, \
+				uint32_t tickHz);
+int replay_file(struct replay_s *r, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
+
+#endif	//INC_FX_REPLAY_H
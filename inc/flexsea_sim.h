@@ -0,0 +1,213 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_sim: virtual RS-485 buses and slave boards
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_SIM_H
+#define INC_FX_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_buffers.h"
+#include "flexsea_pipeline.h"
+#include "flexsea_tdma.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef SIM_MAX_BOARDS
+#define SIM_MAX_BOARDS			512
+#endif	//SIM_MAX_BOARDS
+
+#ifndef SIM_MAX_BUSES
+#define SIM_MAX_BUSES			16
+#endif	//SIM_MAX_BUSES
+
+#define SIM_MAX_BOARDS_PER_BUS	255		//IDs are unique per bus only
+#define SIM_BUS_QUEUE			64		//Frames waiting for the bus
+#define SIM_MAX_EVENTS			(SIM_MAX_BOARDS + 2 * SIM_MAX_BUSES)
+
+//Latency histogram: SIM_LAT_BUCKETS buckets of SIM_LAT_RES_NS. The last
+//one also counts everything longer.
+#define SIM_LAT_BUCKETS			1024
+#define SIM_LAT_RES_NS			10000
+
+//Event types:
+#define SIM_EV_TX_DONE			0		//Last byte of a frame is on the bus
+#define SIM_EV_REPLY_READY		1		//A slave is done computing its reply
+#define SIM_EV_TIMEOUT			2		//The master gives up on a request
+#define SIM_EV_TDMA				3		//Next slot of a scheduled bus
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct sim_board_s;
+
+//Reply generator: builds the reply payload to request 'rx' in 'tx'.
+//Returns the number of bytes to frame, 0 for no reply.
+typedef uint8_t (*sim_reply_t)(struct sim_board_s *b, uint8_t *rx, uint8_t *tx);
+
+struct sim_board_s
+{
+	uint8_t id;				//board_id while this board is running
+	uint8_t bus;
+	uint32_t computeNs;		//From request received to reply ready
+	uint8_t replyLen;		//Data bytes in sim_reply_default()'s replies
+
+	//Handlers, by command code (can be shared by many boards). NULL, or a
+	//NULL entry: 'reply'
+	const sim_reply_t *handlers;
+	sim_reply_t reply;
+	void *user;
+
+	//Reception (real decoder):
+	struct rx_buf_s rx;
+	uint8_t rxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+
+	//Reply being computed:
+	uint8_t txBuf[COMM_STR_BUF_LEN];
+	uint8_t txLen;
+	uint64_t reqAt;			//Last request from the master
+
+	//Statistics:
+	uint32_t requests;
+	uint32_t replies;
+};
+
+struct sim_frame_s
+{
+	uint8_t data[COMM_STR_BUF_LEN];
+	uint8_t len;
+	uint8_t fromSlave;
+	uint16_t board;			//Target (master frames) or source (replies)
+};
+
+struct sim_bus_s
+{
+	//Configuration:
+	uint32_t baud;
+	uint32_t turnaroundNs;	//Dead time when the bus changes direction
+	uint32_t errorPpm;		//Probability that a byte is corrupted
+	uint32_t timeoutNs;		//Master gives up on a reply after this
+	uint8_t port;			//Passed to the handlers in info[0]
+
+	uint16_t board[SIM_MAX_BOARDS_PER_BUS];
+	uint16_t cnt;
+	uint16_t byId[256];		//Board index + 1, by ID
+
+	//Medium:
+	uint8_t busy;
+	uint8_t lastFromSlave;
+	uint64_t idleSince;
+	struct sim_frame_s cur;
+	struct sim_frame_s queue[SIM_BUS_QUEUE];
+	uint8_t qHead, qCnt;
+
+	//Master (round robin, up to sim_s.window requests in flight):
+	struct rx_buf_s rx;
+	uint8_t rxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	struct corr_s corr;		//Matches the replies, ticks are us
+	struct pipe_s pipe;
+	uint16_t next;
+	uint8_t timerArmed;		//Only one SIM_EV_TIMEOUT per bus in the queue
+
+	//Or, when not NULL, that (planned) schedule polls the bus:
+	struct tdma_s *tdma;
+
+	//Statistics:
+	uint64_t busyNs;
+	uint64_t bytes;
+	uint32_t corrupted;		//Frames with at least one bad byte
+	uint32_t dropped;		//Queue full
+	uint32_t collisions;	//Frame waiting for another talker to be done
+};
+
+struct sim_event_s
+{
+	uint64_t t;
+	uint8_t type;
+	uint8_t bus;
+	uint16_t board;
+};
+
+struct sim_s
+{
+	struct sim_board_s board[SIM_MAX_BOARDS];
+	uint16_t boardCnt;
+	struct sim_bus_s bus[SIM_MAX_BUSES];
+	uint8_t busCnt;
+
+	//Requests sent by the master:
+	uint8_t masterId;		//board_id when sim_run() is called
+	uint8_t cmd;			//Read command (default: CMD_TEST)
+	uint8_t reqLen;			//Data bytes
+	uint8_t window;			//Requests in flight per bus. Set it before sim_add_bus()
+	uint8_t fastDelivery;	//1: only the addressed board decodes requests
+
+	//Event queue (binary heap), virtual time in ns:
+	uint64_t now;
+	struct sim_event_s ev[SIM_MAX_EVENTS];
+	uint32_t evCnt;
+	uint32_t rng;
+
+	//Statistics:
+	uint64_t requests;
+	uint64_t replies;
+	uint64_t timeouts;
+	uint64_t latSum;
+	uint32_t latMin, latMax;
+	uint32_t lat[SIM_LAT_BUCKETS];
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void sim_init(struct sim_s *s, uint32_t seed);
+int sim_add_bus(struct sim_s *s, uint32_t baud, uint32_t turnaroundNs, \
+				uint32_t errorPpm, uint8_t port);
+int sim_add_board(struct sim_s *s, uint8_t bus, uint8_t id, uint32_t computeNs);
+void sim_run(struct sim_s *s, uint64_t durationNs);
+uint32_t sim_latency_percentile(struct sim_s *s, uint8_t percent);
+uint8_t sim_reply_default(struct sim_board_s *b, uint8_t *rx, uint8_t *tx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_SIM_H
@@ -0,0 +1,123 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_stats: per port link statistics
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_STATS_H
+#define INC_FX_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//One set of counters per port, plus one for the calls that don't know
+//their port (comm_gen_str(), unpack_payload_N(), ...):
+#define COMM_STATS_NO_PORT		NUMBER_OF_PORTS
+#define COMM_STATS_PORTS		(NUMBER_OF_PORTS + 1)
+#define COMM_STATS_IDX(port)	(((port) < NUMBER_OF_PORTS) ? (port) : COMM_STATS_NO_PORT)
+
+#define COMM_STATS_LINE			64		//Cache line, one writer per line
+
+#ifdef __GNUC__
+#define COMM_STATS_ALIGNED		__attribute__((aligned(COMM_STATS_LINE)))
+#else
+#define COMM_STATS_ALIGNED
+#endif
+
+//Relaxed atomic increments where 64-bit atomics are lock-free (hosts).
+//Elsewhere (Cortex-M) it's a plain add: read the counters from the
+//context that updates them, or with the interrupts off.
+#if defined(__GNUC__) && defined(__GCC_ATOMIC_LLONG_LOCK_FREE) && \
+	(__GCC_ATOMIC_LLONG_LOCK_FREE == 2)
+#define COMM_STAT_ADD(port, field, n)	\
+	__atomic_fetch_add(&commStats[COMM_STATS_IDX(port)].s.field, \
+						(uint64_t)(n), __ATOMIC_RELAXED)
+#define COMM_STAT_LOAD(x)				__atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define COMM_STAT_STORE(x, v)			__atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define COMM_STAT_ADD(port, field, n)	\
+	(commStats[COMM_STATS_IDX(port)].s.field += (uint64_t)(n))
+#define COMM_STAT_LOAD(x)				(x)
+#define COMM_STAT_STORE(x, v)			((x) = (v))
+#endif
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct comm_stats_s
+{
+	uint64_t framesEncoded;
+	uint64_t framesDecoded;
+	uint64_t bytesIn;		//Fed to the reception buffers
+	uint64_t bytesOut;		//Given to comm_port_send()
+	uint64_t escapes;		//ESCAPE bytes in the encoded frames
+	uint64_t badChecksum;
+	uint64_t badFooter;
+	uint64_t badLength;
+	uint64_t discarded;		//RX bytes that never were part of a valid frame
+	uint64_t overruns;		//Frames too long for their buffer
+	uint64_t filtered;		//Frames for other boards, skipped (RID filter)
+	uint64_t txDropped;		//Frames refused by a full TX queue (flexsea_txq)
+};
+
+struct comm_stats_line_s
+{
+	struct comm_stats_s s;
+} COMM_STATS_ALIGNED;
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void comm_stats_snapshot(uint8_t port, struct comm_stats_s *out);
+void comm_stats_total(struct comm_stats_s *out);
+void comm_stats_reset(uint8_t port);
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct comm_stats_line_s commStats[COMM_STATS_PORTS];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_STATS_H
@@ -0,0 +1,210 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_stream: bulk-stream sessions (firmware images, log dumps)
+	in large CRC-32 blocks, outside of the command framing
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_STREAM_H
+#define INC_FX_STREAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Command code used to open a session. Can be overloaded by the board if it
+//collides with a system command.
+#ifndef CMD_STREAM
+#define CMD_STREAM				(MAX_CMD_CODE - 3)
+#endif	//CMD_STREAM
+
+#ifndef STREAM_BLOCK_MAX
+#define STREAM_BLOCK_MAX		1024	//Data bytes per block, 0xFFFF max
+#endif	//STREAM_BLOCK_MAX
+
+#ifndef STREAM_WINDOW
+#define STREAM_WINDOW			4		//Blocks in flight
+#endif	//STREAM_WINDOW
+
+#ifndef STREAM_DEFAULT_RTO
+#define STREAM_DEFAULT_RTO		50		//Retransmission timeout, in ticks
+#endif	//STREAM_DEFAULT_RTO
+
+#define STREAM_MAX_RETRIES		5
+#define STREAM_LINGER			3		//Idle RTOs before a receiver leaves
+#define STREAM_MAX_BLOCKS		0xFFFF
+
+//Session request, in P_DATA1: [OP][SID][LEN (4)][BLOCK_H][BLOCK_L][WINDOW]
+#define STREAM_OPEN_BYTES		9
+#define STREAM_OP_OPEN			1
+#define STREAM_OP_ACCEPT		2		//Same fields, what the receiver can take
+#define STREAM_OP_REFUSE		3
+
+//Block, in bulk mode: [SYNC][TYPE][SID][SEQ_H][SEQ_L][LEN_H][LEN_L][HCRC]
+//followed by LEN data bytes and their CRC-32 (none if LEN = 0)
+#define STREAM_SYNC				0xB5
+#define STREAM_HEADER_LEN		8
+#define STREAM_CRC_LEN			4
+
+//Block types:
+#define STREAM_BLK_DATA			1
+#define STREAM_BLK_ACK			2		//Every block before SEQ was received
+#define STREAM_BLK_NAK			3		//Same, resend from SEQ
+
+//Port modes:
+#define STREAM_MODE_COMMAND		0		//Default: FlexSEA frames
+#define STREAM_MODE_BULK		1		//Blocks only, see stream_rx()
+
+//States:
+#define STREAM_IDLE				0
+#define STREAM_OPENING			1		//Session requested, no reply yet
+#define STREAM_BUSY				2
+#define STREAM_DONE				3
+#define STREAM_FAILED			4		//Refused, timed out or abandoned
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct stream_tx_s
+{
+	uint8_t state;
+	uint8_t sid;			//Session number, changes with every session
+	uint8_t rid;
+	uint8_t *data;			//Owned by the caller until done() is called
+	uint32_t len;
+	uint16_t block;			//Accepted by the receiver
+	uint8_t window;			//Same
+	uint16_t count;			//Blocks
+	uint16_t base;			//Oldest block not acknowledged
+	uint16_t next;			//Next block sent
+	uint16_t high;			//Blocks sent at least once
+	uint8_t retries;
+	uint32_t ackAt;
+	void (*done)(uint8_t port, uint8_t state);
+
+	//Statistics:
+	uint32_t sent;
+	uint32_t resent;
+};
+
+struct stream_rx_s
+{
+	uint8_t state;
+	uint8_t sid;
+	uint8_t xid;
+	uint8_t *buf;			//One block, preallocated by the caller
+	uint16_t size;
+	uint32_t len;
+	uint16_t block;
+	uint8_t window;
+	uint16_t count;
+	uint16_t next;			//Next block expected
+	uint8_t nakSent;		//Only one NAK per gap
+	uint8_t sinceAck;
+	uint8_t ackPending;
+	uint32_t ackSince;
+	void (*write)(uint8_t port, uint32_t offset, uint8_t *data, uint16_t len);
+	void (*done)(uint8_t port, uint8_t state, uint32_t len);
+
+	//Statistics:
+	uint32_t blocks;
+	uint32_t duplicates;
+	uint32_t outOfOrder;
+	uint32_t naks;
+};
+
+//Bulk mode byte stream parser
+struct stream_parser_s
+{
+	uint8_t hdr[STREAM_HEADER_LEN];
+	uint8_t hdrLen;
+	uint8_t crc[STREAM_CRC_LEN];
+	uint16_t len;			//Data bytes in the current block
+	uint32_t got;			//Data and CRC bytes received
+
+	//Statistics:
+	uint32_t badHeaders;
+	uint32_t badCrcs;
+	uint32_t skipped;		//Bytes that weren't part of a block
+};
+
+struct stream_s
+{
+	uint8_t mode;			//STREAM_MODE_x
+	uint32_t rto;
+	uint8_t window;
+	uint16_t block;			//Largest block requested by stream_send()
+	uint32_t now;			//Last 'now', for the blocks received
+	uint8_t heard;			//Valid block (or new mode) since the last poll
+	uint32_t heardAt;		//Poll that saw it
+	struct stream_tx_s tx;
+	struct stream_rx_s rx;
+	struct stream_parser_s parser;
+};
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+extern struct stream_s commStream[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void init_flexsea_stream(void);
+void stream_config(uint8_t port, uint32_t rto, uint8_t window, uint16_t block);
+uint8_t stream_send(uint8_t port, uint8_t rid, uint8_t *data, uint32_t len, \
+					void (*done)(uint8_t port, uint8_t state), uint32_t now);
+void stream_receive(uint8_t port, uint8_t *buf, uint16_t size, \
+					void (*write)(uint8_t port, uint32_t offset, uint8_t *data, \
+					uint16_t len), void (*done)(uint8_t port, uint8_t state, \
+					uint32_t len));
+uint8_t stream_active(uint8_t port);
+uint32_t stream_rx(uint8_t port, uint8_t *data, uint32_t len);
+void stream_poll(uint8_t port, uint32_t now);
+uint32_t stream_crc32(uint8_t *buf, uint32_t len);
+
+void rx_cmd_stream(uint8_t *buf, uint8_t *info);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_STREAM_H
@@ -0,0 +1,163 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_tdma: time-slotted polling of the slave buses
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_TDMA_H
+#define INC_FX_TDMA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_corr.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef TDMA_MAX_ENTRIES
+#define TDMA_MAX_ENTRIES		32		//Rate table size, per bus
+#endif	//TDMA_MAX_ENTRIES
+
+#ifndef TDMA_MAX_SLOTS
+#define TDMA_MAX_SLOTS			512		//Slots in a major frame
+#endif	//TDMA_MAX_SLOTS
+
+#define TDMA_MAX_MINOR			128		//Minor frames in a major frame
+
+#define TDMA_ESCAPE_PCT			100		//Default: every byte can be escaped
+
+//tdma_plan() return values:
+#define TDMA_PLAN_OK			0
+#define TDMA_PLAN_ERR_EMPTY		-1		//No entry
+#define TDMA_PLAN_ERR_LOAD		-2		//A minor frame is over budget
+#define TDMA_PLAN_ERR_SLOTS		-3		//More than TDMA_MAX_SLOTS slots
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct tdma_entry_s;
+
+//Request builder: fills 'payload' with the Read for that entry. Returns
+//the number of bytes (P_DATA1 + reqBytes at most).
+typedef uint8_t (*tdma_build_t)(struct tdma_entry_s *e, uint8_t *payload);
+
+struct tdma_entry_s
+{
+	//Rate table:
+	uint8_t rid;			//Slave
+	uint8_t cmd;			//7-bit command code
+	uint16_t rateHz;
+	uint8_t reqBytes;		//Data bytes in the request
+	uint8_t replyBytes;		//Data bytes in the reply
+	uint32_t computeUs;		//Slave, from request received to reply ready
+
+	//Plan:
+	uint16_t every;			//Polled every 'every' minor frames...
+	uint16_t offset;		//...starting with this one
+	uint32_t slotUs;
+
+	//Statistics:
+	uint32_t polls;
+	uint32_t replies;
+	uint32_t misses;		//Slots skipped because we were late
+	uint32_t noReply;		//Slot over, reply never came
+};
+
+struct tdma_slot_s
+{
+	uint8_t entry;
+	uint32_t start;			//From the start of the major frame, in us
+};
+
+struct tdma_s
+{
+	//Configuration:
+	uint8_t port;
+	uint32_t baud;
+	uint32_t turnaroundUs;	//Dead time when the bus changes direction
+	uint32_t guardUs;		//Slack per slot, also the tolerated lateness
+	uint8_t escapePct;		//Escaped bytes to plan for, % of the payload
+	tdma_build_t build;		//NULL: empty Read of 'cmd'
+	struct corr_s *corr;	//Replies are matched there (us ticks). NULL: not tracked
+
+	struct tdma_entry_s entry[TDMA_MAX_ENTRIES];
+	uint8_t entryCnt;
+
+	//Plan:
+	struct tdma_slot_s slot[TDMA_MAX_SLOTS];
+	uint16_t slotCnt;
+	uint32_t minorUs;
+	uint16_t minorCnt;
+	uint32_t majorUs;
+	uint32_t busyUs;		//Slot time in a major frame
+	uint32_t maxLoadUs;		//Busiest minor frame
+
+	//Schedule:
+	uint8_t running;
+	uint32_t epoch;			//Start of the current major frame
+	uint16_t next;			//Next slot
+	int16_t waiting;		//Entry whose reply we expect, -1: none
+	struct corr_req_s *req;	//Its request in 'corr'
+
+	//Statistics:
+	uint32_t cycles;		//Major frames
+	uint32_t polls;
+	uint32_t replies;
+	uint32_t misses;
+	uint32_t noReply;
+	uint32_t rttMax;
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void tdma_init(struct tdma_s *t, uint8_t port, uint32_t baud, uint32_t turnaroundUs);
+int tdma_add(struct tdma_s *t, uint8_t rid, uint8_t cmd, uint16_t rateHz, \
+				uint8_t reqBytes, uint8_t replyBytes, uint32_t computeUs);
+int8_t tdma_plan(struct tdma_s *t);
+uint32_t tdma_frame_us(struct tdma_s *t, uint8_t bytes);
+uint16_t tdma_utilization(struct tdma_s *t);
+uint8_t tdma_next(struct tdma_s *t, uint32_t now, uint8_t *payload);
+uint32_t tdma_due(struct tdma_s *t);
+uint8_t tdma_poll(struct tdma_s *t, uint32_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_TDMA_H
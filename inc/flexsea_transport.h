@@ -0,0 +1,242 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_transport: Linux host transport (tty/pty with epoll
+	or io_uring, UDP and Unix datagram sockets)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_TRANSPORT_H
+#define INC_FX_TRANSPORT_H
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include <sys/socket.h>
+#include "flexsea.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#ifndef TRANSPORT_MAX_PORTS
+#define TRANSPORT_MAX_PORTS		32
+#endif	//TRANSPORT_MAX_PORTS
+
+#define TRANSPORT_CHUNK			4096	//Bytes per read()
+#define TRANSPORT_TX_BUF_LEN	4096	//Bytes the driver couldn't take yet
+
+//The decoder works on a RX_BUF_LEN window. Feeding it at most this many
+//bytes between two decodes guarantees that every comm_str is entirely in
+//the window at least once:
+#define TRANSPORT_SLICE			(RX_BUF_LEN - COMM_STR_BUF_LEN)
+
+//io_uring backend (optional, enable it in flexsea_board.h):
+#define TRANSPORT_URING_ENTRIES		256
+#define TRANSPORT_URING_TX_SLOTS	64
+#define TRANSPORT_URING_TX_LEN		256
+
+//Datagram sockets (UDP, Unix). One or more comm_str per datagram:
+#ifndef TRANSPORT_DGRAM_MAX_PEERS
+#define TRANSPORT_DGRAM_MAX_PEERS	256
+#endif	//TRANSPORT_DGRAM_MAX_PEERS
+#define TRANSPORT_DGRAM_BATCH		32		//Datagrams per recvmmsg()/sendmmsg()
+#define TRANSPORT_DGRAM_MTU			1472	//Fits in one Ethernet frame (UDP/IPv4)
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct transport_port_s
+{
+	int fd;
+	uint8_t port;			//FlexSEA port, passed to the handlers in info[0]
+
+	//Reception:
+	struct rx_buf_s rx;
+	uint8_t rxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+
+	//Transmission:
+	uint8_t txBuf[TRANSPORT_TX_BUF_LEN];
+	uint32_t txLen;
+
+	//Statistics:
+	uint64_t bytesIn;
+	uint64_t bytesOut;
+	uint64_t frames;
+	uint64_t decodes;
+};
+
+struct transport_s
+{
+	int epfd;
+	uint8_t cnt;
+	struct transport_port_s port[TRANSPORT_MAX_PORTS];
+
+	//Called for every decoded payload. NULL: payload_parse_str()
+	void (*rx_callback)(uint8_t port, uint8_t *payload);
+
+	uint64_t syscalls;		//read(), write(), epoll_wait(), ...
+	uint8_t chunk[TRANSPORT_CHUNK];
+};
+
+#ifdef ENABLE_FLEXSEA_IO_URING
+
+//io_uring backend. Uses the ports of an existing transport_s.
+struct transport_uring_s
+{
+	struct transport_s *t;
+	int fd;
+	uint32_t features;
+
+	//Rings (kernel shared memory):
+	void *sqRing, *cqRing, *sqes;
+	uint32_t sqRingSize, cqRingSize, sqesSize;
+	uint32_t *sqHead, *sqTail, *sqMask, *sqArray, sqEntries;
+	uint32_t *cqHead, *cqTail, *cqMask;
+	void *cqes;
+	uint32_t sqLocalTail;
+	uint32_t toSubmit;
+
+	//Registered buffers: one read buffer per port, then the TX slots
+	uint8_t rxBuf[TRANSPORT_MAX_PORTS][TRANSPORT_CHUNK];
+	uint8_t txBuf[TRANSPORT_URING_TX_SLOTS][TRANSPORT_URING_TX_LEN];
+	uint16_t txSent[TRANSPORT_URING_TX_SLOTS];
+	uint16_t txLen[TRANSPORT_URING_TX_SLOTS];
+	uint8_t txFree[TRANSPORT_URING_TX_SLOTS];
+	uint8_t txFreeCnt;
+
+	//TX slots waiting, per port (FIFO, linked by txNext). Only the first one
+	//is in flight:
+	uint8_t txNext[TRANSPORT_URING_TX_SLOTS];
+	uint8_t txHead[TRANSPORT_MAX_PORTS];
+	uint8_t txTail[TRANSPORT_MAX_PORTS];
+	uint8_t txBusy[TRANSPORT_MAX_PORTS];
+	uint8_t rxRetry[TRANSPORT_MAX_PORTS];	//No read in flight (no SQE left)
+
+	//Statistics:
+	uint64_t enters;		//io_uring_enter() calls
+	uint64_t completions;
+	uint64_t txErrors;		//Frames dropped after a failed write
+};
+
+#endif	//ENABLE_FLEXSEA_IO_URING
+
+struct transport_dgram_peer_s
+{
+	struct sockaddr_storage addr;
+	socklen_t addrLen;
+	uint8_t port;			//FlexSEA port, passed to the handlers in info[0]
+
+	//Statistics:
+	uint64_t dgramIn;
+	uint64_t frames;
+	uint64_t badFrames;
+};
+
+struct transport_dgram_s
+{
+	int fd;
+	int family;				//AF_INET, AF_INET6 or AF_UNIX
+	char unixPath[108];		//Unlinked by transport_dgram_close()
+
+	struct transport_dgram_peer_s peer[TRANSPORT_DGRAM_MAX_PEERS];
+	uint16_t peerCnt;
+	uint16_t lastPeer;
+
+	//Unknown senders are added with this port. 0xFF: ignore them
+	uint8_t learnPort;
+
+	//Called for every decoded payload. NULL: payload_parse_str()
+	void (*rx_callback)(int peer, uint8_t *payload);
+
+	//Reception:
+	uint8_t rxBuf[TRANSPORT_DGRAM_BATCH][TRANSPORT_DGRAM_MTU];
+	struct sockaddr_storage rxAddr[TRANSPORT_DGRAM_BATCH];
+	uint8_t rxCmd[PACKAGED_PAYLOAD_LEN];
+
+	//Transmission: frames to the same peer share a datagram
+	uint8_t txBuf[TRANSPORT_DGRAM_BATCH][TRANSPORT_DGRAM_MTU];
+	uint16_t txLen[TRANSPORT_DGRAM_BATCH];
+	uint16_t txPeer[TRANSPORT_DGRAM_BATCH];
+	uint8_t txCnt;
+
+	//Statistics:
+	uint64_t dgramIn;
+	uint64_t dgramOut;
+	uint64_t dgramDropped;	//Unknown sender, or the socket was full
+	uint64_t syscalls;
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+int transport_init(struct transport_s *t);
+void transport_close(struct transport_s *t);
+int transport_open_tty(struct transport_s *t, const char *path, uint32_t baud, \
+						uint8_t port);
+int transport_add_fd(struct transport_s *t, int fd, uint8_t port);
+int transport_poll(struct transport_s *t, int timeout_ms);
+int transport_send(struct transport_s *t, int handle, uint8_t *str, uint32_t len);
+int transport_rx(struct transport_s *t, int handle, uint8_t *data, uint32_t len);
+int transport_set_raw(int fd, uint32_t baud);
+
+#ifdef ENABLE_FLEXSEA_IO_URING
+int transport_uring_init(struct transport_uring_s *u, struct transport_s *t);
+void transport_uring_close(struct transport_uring_s *u);
+int transport_uring_send(struct transport_uring_s *u, int handle, uint8_t *str, \
+							uint32_t len);
+int transport_uring_poll(struct transport_uring_s *u, int timeout_ms);
+#endif	//ENABLE_FLEXSEA_IO_URING
+
+int transport_dgram_open_udp(struct transport_dgram_s *d, const char *addr, \
+								uint16_t udpPort);
+int transport_dgram_open_unix(struct transport_dgram_s *d, const char *path);
+void transport_dgram_close(struct transport_dgram_s *d);
+int transport_dgram_add_peer(struct transport_dgram_s *d, const char *addr, \
+								uint16_t udpPort, uint8_t port);
+int transport_dgram_send(struct transport_dgram_s *d, int peer, uint8_t *str, \
+								uint32_t len);
+int transport_dgram_flush(struct transport_dgram_s *d);
+int transport_dgram_poll(struct transport_dgram_s *d, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
+
+#endif	//INC_FX_TRANSPORT_H
@@ -0,0 +1,134 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_txq: priority transmit queues
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifndef INC_FX_TXQ_H
+#define INC_FX_TXQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdint.h>
+#include "flexsea.h"
+#include "flexsea_comm.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//Priority levels, highest first:
+#define TXQ_CONTROL				0		//Writes (setpoints, commands)
+#define TXQ_REPLY				1		//Replies to Reads
+#define TXQ_TELEMETRY			2		//Reads
+#define TXQ_BULK				3		//Large/streamed data, see txq_set_cmd_level()
+#define TXQ_LEVELS				4
+#define TXQ_AUTO				0xFF	//txq_set_cmd_level(): from the R/W bit
+
+#ifndef TXQ_DEPTH
+#define TXQ_DEPTH				8		//Frames per level. Power of 2.
+#endif	//TXQ_DEPTH
+
+#if ((TXQ_DEPTH & (TXQ_DEPTH - 1)) != 0) || (TXQ_DEPTH > 128)
+#error "TXQ_DEPTH has to be a power of 2, 128 at most"
+#endif
+
+//What happens to a frame pushed on a full level:
+#define TXQ_POLICY_DEFAULT		0		//Control & telemetry: oldest, others: newest
+#define TXQ_DROP_NEWEST			1		//Refused, the caller knows
+#define TXQ_DROP_OLDEST			2		//Replaces the oldest one (fresh data wins)
+
+//****************************************************************************
+// Structure(s):
+//****************************************************************************
+
+struct txq_slot_s
+{
+	uint8_t data[COMM_STR_BUF_LEN];
+	uint8_t len;
+	uint8_t cmd;			//Command byte (with R/W), for the driver
+};
+
+struct txq_level_s
+{
+	struct txq_slot_s slot[TXQ_DEPTH];
+	uint8_t head;
+	uint8_t cnt;
+	uint8_t policy;			//TXQ_DROP_x, or TXQ_POLICY_DEFAULT
+
+	//Statistics:
+	uint32_t pushed;
+	uint32_t popped;
+	uint32_t dropped;
+	uint8_t highWater;
+};
+
+struct txq_s
+{
+	struct txq_level_s level[TXQ_LEVELS];
+	uint8_t pending;		//Bit n: level n isn't empty
+	uint8_t out;			//Level of the frame txq_front() handed out + 1,
+							//0 if none. It's never evicted.
+};
+
+//****************************************************************************
+// Public Function Prototype(s):
+//****************************************************************************
+
+void txq_init(struct txq_s *q);
+void txq_set_policy(struct txq_s *q, uint8_t level, uint8_t policy);
+void txq_set_cmd_level(uint8_t cmd, uint8_t level);
+uint8_t txq_level(uint8_t cmd);
+uint8_t txq_push(struct txq_s *q, uint8_t level, uint8_t *str, uint16_t len, \
+					uint8_t cmd);
+struct txq_slot_s *txq_front(struct txq_s *q);
+void txq_release(struct txq_s *q);
+uint16_t txq_pop(struct txq_s *q, uint8_t *str, uint8_t *cmd);
+uint8_t txq_count(struct txq_s *q);
+uint8_t txq_send(struct txq_s *q, uint8_t port);
+uint8_t txq_fill_tx(struct txq_s *q, struct comm_tx_s *tx);
+
+//****************************************************************************
+// Shared variable(s)
+//****************************************************************************
+
+#ifdef ENABLE_FLEXSEA_TXQ
+//Frames routed to the slave buses (route_to_slave()), feeding slaveComm[].tx:
+extern struct txq_s slaveTxq[COMM_SLAVE_BUS];
+#endif	//ENABLE_FLEXSEA_TXQ
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//INC_FX_TXQ_H
@@ -0,0 +1,598 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_arq: optional reliability sublayer (sequence numbers,
+	ACK/NAK and retransmissions)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//How to use it:
+//==============
+// - Enabled per port, by arq_enable() or by the link negotiation
+//   (LINK_FEAT_ARQ). Both ends have to use it.
+// - Point-to-point ports (SPI, USB) have one peer. On a bus port (RS-485,
+//   ARQ_BUS_PORT()) every slave has its own sequence numbers, found with
+//   ARQ_ADDR: the ID of the slave end of the link. The master writes the
+//   RID of the payload (one of its slaves), a slave its own ID. Frames for
+//   the other slaves are ignored.
+// - On a bus only the master starts an exchange. A slave's ACK/NAK ride on
+//   its replies; what it has to send again (NAKed or timed out), and a
+//   standalone ACK/NAK when its handlers didn't reply, go out right after
+//   the next frame from the master (in arq_receive()). A slave calls
+//   arq_send() from its handlers only, in reply.
+// - Send payloads with arq_send() instead of comm_gen_str() + your driver.
+//   The framed string is kept until the peer acknowledges it.
+// - Pass every decoded payload to arq_receive() instead of
+//   payload_parse_str(). It delivers them in order, without duplicates.
+// - Call arq_rx_error() when unpack_payload_N() reports a bad checksum on
+//   a point-to-point port: the peer is asked to resend the missing frame
+//   right away. On a bus the sender is unknown, the gap is NAKed when its
+//   next frame arrives.
+// - Call arq_poll() periodically (timeouts, standalone ACK/NAK).
+//'now' is any free running tick counter, 'rto' uses the same unit.
+//ARQ_WINDOW has to be a power of 2.
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_arq.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct arq_s commArq[NUMBER_OF_PORTS];
+
+//Slave end of a bus link: only talks after a frame from the master
+#define ARQ_SLAVE(port, p)		(ARQ_BUS_PORT(port) && ((p)->addr == board_id))
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static struct arq_peer_s *arq_peer(uint8_t port, uint8_t addr, uint8_t create);
+static uint8_t arq_tx_addr(uint8_t port, uint8_t *payload);
+static uint8_t arq_rx_addr(uint8_t port, uint8_t addr);
+static uint8_t arq_rx(uint8_t port, struct arq_peer_s *p, uint8_t *str, \
+						uint8_t *info, uint32_t now);
+static void arq_header(struct arq_peer_s *p, uint8_t *buf, uint8_t flags, uint8_t seq);
+static void arq_send_control(uint8_t port, struct arq_peer_s *p);
+static void arq_retransmit(uint8_t port, struct arq_peer_s *p, uint32_t now);
+static void arq_release(struct arq_peer_s *p, uint8_t ack);
+static void arq_resend(uint8_t port, struct arq_peer_s *p, uint8_t seq, uint32_t now);
+static uint8_t arq_deliver(struct arq_peer_s *p, uint8_t *info, uint32_t now);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Starts with fresh sequence numbers on 'port'. rto = 0: ARQ_DEFAULT_RTO.
+//Already enabled: only the timeout changes, the peers keep their sequence
+//numbers (see arq_restart()). Returns 0 if 'port' isn't valid.
+uint8_t arq_enable(uint8_t port, uint32_t rto)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return 0;
+	}
+
+	if(!commArq[port].enabled)
+	{
+		memset(&commArq[port], 0, sizeof(struct arq_s));
+		commArq[port].enabled = 1;
+	}
+	commArq[port].rto = (rto ? rto : ARQ_DEFAULT_RTO);
+	return 1;
+}
+
+void arq_disable(uint8_t port)
+{
+	if(port < NUMBER_OF_PORTS)
+	{
+		commArq[port].enabled = 0;
+	}
+}
+
+uint8_t arq_is_enabled(uint8_t port)
+{
+	return ((port < NUMBER_OF_PORTS) ? commArq[port].enabled : 0);
+}
+
+//Fresh sequence numbers with one peer: the slave 'addr' on a bus port (see
+//ARQ_ADDR), the only peer on the others. Its frames in flight are dropped.
+void arq_restart(uint8_t port, uint8_t addr)
+{
+	struct arq_peer_s *p = NULL;
+
+	if(!arq_is_enabled(port))
+	{
+		return;
+	}
+
+	p = arq_peer(port, addr, 0);
+	if(p)
+	{
+		memset(p, 0, sizeof(struct arq_peer_s));
+	}
+}
+
+//Frames 'payload' with an ARQ header, keeps a copy and sends it. Returns 0
+//if the window is full (try again after the next ACK) or if it doesn't fit.
+uint8_t arq_send(uint8_t port, uint8_t *payload, uint8_t bytes, uint32_t now)
+{
+	uint8_t tmp[PAYLOAD_BUF_LEN];
+	struct arq_peer_s *p = NULL;
+	struct arq_tx_slot_s *slot = NULL;
+	uint16_t last = 0;
+
+	if(!arq_is_enabled(port) || (bytes > ARQ_PAYLOAD_BYTES))
+	{
+		return 0;
+	}
+
+	p = arq_peer(port, arq_tx_addr(port, payload), 1);
+	if((p == NULL) || ((uint8_t)(p->txNext - p->txBase) >= ARQ_WINDOW))
+	{
+		return 0;
+	}
+
+	slot = &p->tx[p->txNext & (ARQ_WINDOW - 1)];
+
+	arq_header(p, tmp, ARQ_FLAG_DATA, p->txNext);
+	memcpy(&tmp[ARQ_HEADER_LEN], payload, bytes);
+	last = comm_gen_str_port(port, tmp, slot->str, bytes + ARQ_HEADER_LEN);
+	if(last == 0)
+	{
+		return 0;
+	}
+
+	slot->used = 1;
+	slot->seq = p->txNext;
+	slot->retries = 0;
+	slot->len = last + 1;
+	slot->sentAt = now;
+	p->txNext++;
+
+	comm_port_send(port, slot->str, slot->len);
+	return 1;
+}
+
+//Processes a decoded payload (starting with the ARQ header). In-order
+//payloads are passed to payload_parse_str(). Returns how many were.
+uint8_t arq_receive(uint8_t port, uint8_t *str, uint8_t *info, uint32_t now)
+{
+	struct arq_peer_s *p = NULL;
+	uint8_t cnt = 0;
+
+	if(!arq_is_enabled(port))
+	{
+		return 0;
+	}
+
+	p = arq_rx_addr(port, str[ARQ_ADDR]) ? arq_peer(port, str[ARQ_ADDR], 1) : NULL;
+	if(p == NULL)
+	{
+		commArq[port].ignored++;
+		return 0;
+	}
+
+	cnt = arq_rx(port, p, str, info, now);
+
+	if(ARQ_SLAVE(port, p))
+	{
+		//Our turn to talk: what the master is missing, then the ACK/NAK if
+		//no reply carried it
+		arq_retransmit(port, p, now);
+		if(p->ackPending || p->nakPending)
+		{
+			arq_send_control(port, p);
+		}
+	}
+
+	return cnt;
+}
+
+//unpack_payload_N() found a corrupted frame on 'port': NAK it now instead
+//of waiting for the sender's timeout. Point-to-point ports only, on a bus
+//we can't tell who sent it.
+void arq_rx_error(uint8_t port, uint32_t now)
+{
+	struct arq_peer_s *p = NULL;
+
+	(void)now;
+	if(!arq_is_enabled(port) || ARQ_BUS_PORT(port))
+	{
+		return;
+	}
+
+	p = arq_peer(port, 0, 1);
+	p->nakPending = 1;
+	arq_send_control(port, p);
+}
+
+//Retransmits the frames that timed out and sends standalone ACK/NAK when
+//there was nothing to piggyback them on. The slave end of a bus waits for
+//the master instead (arq_receive()).
+void arq_poll(uint8_t port, uint32_t now)
+{
+	struct arq_s *a = NULL;
+	struct arq_peer_s *p = NULL;
+	uint8_t i = 0, j = 0;
+
+	if(!arq_is_enabled(port))
+	{
+		return;
+	}
+
+	a = &commArq[port];
+	for(j = 0; j < ARQ_PEERS; j++)
+	{
+		p = &a->peer[j];
+		if(!p->used)
+		{
+			continue;
+		}
+
+		if(!ARQ_SLAVE(port, p))
+		{
+			arq_retransmit(port, p, now);
+		}
+
+		//Reception: the sender gave up on a missing frame, skip it.
+		if(p->nakSent && ((now - p->gapSince) > (a->rto * (ARQ_MAX_RETRIES + 1))))
+		{
+			p->nakSent = 0;
+			for(i = 0; (i < ARQ_WINDOW) && !p->rx[p->rxNext & (ARQ_WINDOW - 1)].used; i++)
+			{
+				p->rxNext++;
+			}
+			arq_deliver(p, p->info, now);
+		}
+
+		if(!ARQ_SLAVE(port, p) && (p->nakPending || \
+			(p->ackPending && ((now - p->ackSince) >= (a->rto / 2)))))
+		{
+			arq_send_control(port, p);
+		}
+	}
+}
+
+//Number of frames waiting for an ACK, all peers
+uint8_t arq_in_flight(uint8_t port)
+{
+	uint8_t j = 0, n = 0;
+
+	if(!arq_is_enabled(port))
+	{
+		return 0;
+	}
+
+	for(j = 0; j < ARQ_PEERS; j++)
+	{
+		n += (uint8_t)(commArq[port].peer[j].txNext - commArq[port].peer[j].txBase);
+	}
+
+	return n;
+}
+
+//Same, for one peer (see ARQ_ADDR)
+uint8_t arq_peer_in_flight(uint8_t port, uint8_t addr)
+{
+	struct arq_peer_s *p = NULL;
+
+	if(!arq_is_enabled(port))
+	{
+		return 0;
+	}
+
+	p = arq_peer(port, addr, 0);
+	return (p ? (uint8_t)(p->txNext - p->txBase) : 0);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//State shared with 'addr' (the only peer of a point-to-point port). A new
+//one is started if 'create' is set and there is room. NULL otherwise.
+static struct arq_peer_s *arq_peer(uint8_t port, uint8_t addr, uint8_t create)
+{
+	struct arq_s *a = &commArq[port];
+	struct arq_peer_s *spare = NULL;
+	uint8_t j = 0;
+
+	if(!ARQ_BUS_PORT(port))
+	{
+		addr = 0;
+	}
+
+	for(j = 0; j < ARQ_PEERS; j++)
+	{
+		if(a->peer[j].used && (a->peer[j].addr == addr))
+		{
+			return &a->peer[j];
+		}
+		if(!a->peer[j].used && (spare == NULL))
+		{
+			spare = &a->peer[j];
+		}
+	}
+
+	if(!create || (spare == NULL))
+	{
+		return NULL;
+	}
+
+	memset(spare, 0, sizeof(struct arq_peer_s));
+	spare->used = 1;
+	spare->addr = addr;
+	return spare;
+}
+
+//ARQ_ADDR of a payload we send: the slave it goes to, or our own ID when
+//it goes up to our master
+static uint8_t arq_tx_addr(uint8_t port, uint8_t *payload)
+{
+	uint8_t id = 0;
+
+	if(!ARQ_BUS_PORT(port))
+	{
+		return 0;
+	}
+
+	id = payload_rid_match(payload[P_RID]);
+	return (((id == ID_SUB1_MATCH) || (id == ID_SUB2_MATCH)) ? \
+			payload[P_RID] : board_id);
+}
+
+//1 if a frame with that ARQ_ADDR is for us: we are that slave, or it's one
+//of ours
+static uint8_t arq_rx_addr(uint8_t port, uint8_t addr)
+{
+	uint8_t id = 0;
+
+	if(!ARQ_BUS_PORT(port) || (addr == board_id))
+	{
+		return 1;
+	}
+
+	id = payload_rid_match(addr);
+	return ((id == ID_SUB1_MATCH) || (id == ID_SUB2_MATCH));
+}
+
+//Body of arq_receive(), once the peer is known
+static uint8_t arq_rx(uint8_t port, struct arq_peer_s *p, uint8_t *str, \
+						uint8_t *info, uint32_t now)
+{
+	struct arq_s *a = &commArq[port];
+	uint8_t flags = str[ARQ_FLAGS], seq = 0, offset = 0;
+
+	p->info[0] = info[0];
+	p->info[1] = info[1];
+
+	//Piggybacked acknowledgments:
+	if(flags & (ARQ_FLAG_ACK | ARQ_FLAG_NAK))
+	{
+		arq_release(p, str[ARQ_ACK]);
+	}
+	if(flags & ARQ_FLAG_NAK)
+	{
+		arq_resend(port, p, str[ARQ_ACK], now);
+	}
+
+	if(!(flags & ARQ_FLAG_DATA))
+	{
+		return 0;
+	}
+
+	seq = str[ARQ_SEQ];
+	offset = (uint8_t)(seq - p->rxNext);
+
+	if(!p->ackPending)
+	{
+		p->ackSince = now;
+	}
+	p->ackPending = 1;
+
+	if(offset >= ARQ_WINDOW)
+	{
+		//Already received (our ACK was lost), or way out of the window:
+		a->duplicates++;
+		return 0;
+	}
+
+	//Keep it, in order:
+	if(!p->rx[seq & (ARQ_WINDOW - 1)].used)
+	{
+		memcpy(p->rx[seq & (ARQ_WINDOW - 1)].payload, &str[ARQ_HEADER_LEN], \
+				PACKAGED_PAYLOAD_LEN - ARQ_HEADER_LEN);
+		p->rx[seq & (ARQ_WINDOW - 1)].used = 1;
+	}
+	else
+	{
+		a->duplicates++;
+	}
+
+	if(offset != 0)
+	{
+		//A frame is missing. Ask for it once, with the next frame we send
+		//or from arq_poll():
+		a->outOfOrder++;
+		if(!p->nakSent)
+		{
+			p->nakPending = 1;
+			p->nakSent = 1;
+			p->gapSince = now;
+		}
+		return 0;
+	}
+
+	return arq_deliver(p, info, now);
+}
+
+//Writes the ARQ header, with our cumulative ACK (and NAK) piggybacked
+static void arq_header(struct arq_peer_s *p, uint8_t *buf, uint8_t flags, uint8_t seq)
+{
+	flags |= ARQ_FLAG_ACK;
+	if(p->nakPending)
+	{
+		flags |= ARQ_FLAG_NAK;
+	}
+
+	buf[ARQ_SEQ] = seq;
+	buf[ARQ_ACK] = p->rxNext;
+	buf[ARQ_FLAGS] = flags;
+	buf[ARQ_ADDR] = p->addr;
+
+	p->ackPending = 0;
+	p->nakPending = 0;
+}
+
+//Header only frame (no payload)
+static void arq_send_control(uint8_t port, struct arq_peer_s *p)
+{
+	uint8_t tmp[ARQ_HEADER_LEN];
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	uint16_t last = 0;
+
+	arq_header(p, tmp, 0, 0);
+	last = comm_gen_str_port(port, tmp, cstr, ARQ_HEADER_LEN);
+	if(last)
+	{
+		comm_port_send(port, cstr, last + 1);
+	}
+}
+
+//Frames not acknowledged after 'rto', oldest first. Gives up after
+//ARQ_MAX_RETRIES.
+static void arq_retransmit(uint8_t port, struct arq_peer_s *p, uint32_t now)
+{
+	struct arq_s *a = &commArq[port];
+	struct arq_tx_slot_s *slot = NULL;
+	uint8_t seq = 0;
+
+	for(seq = p->txBase; seq != p->txNext; seq++)
+	{
+		slot = &p->tx[seq & (ARQ_WINDOW - 1)];
+		if(!slot->used || ((now - slot->sentAt) < a->rto))
+		{
+			continue;
+		}
+
+		if(slot->retries >= ARQ_MAX_RETRIES)
+		{
+			//Give up. The receiver will skip it (see arq_poll()).
+			slot->used = 0;
+			a->dropped++;
+			continue;
+		}
+
+		slot->retries++;
+		slot->sentAt = now;
+		a->retransmits++;
+		comm_port_send(port, slot->str, slot->len);
+	}
+
+	//Discard the frames we gave up on:
+	while((p->txBase != p->txNext) && !p->tx[p->txBase & (ARQ_WINDOW - 1)].used)
+	{
+		p->txBase++;
+	}
+}
+
+//Every frame before 'ack' was received
+static void arq_release(struct arq_peer_s *p, uint8_t ack)
+{
+	if((uint8_t)(ack - p->txBase) > (uint8_t)(p->txNext - p->txBase))
+	{
+		//Not a frame we sent, ignore
+		return;
+	}
+
+	while(p->txBase != ack)
+	{
+		p->tx[p->txBase & (ARQ_WINDOW - 1)].used = 0;
+		p->txBase++;
+	}
+}
+
+static void arq_resend(uint8_t port, struct arq_peer_s *p, uint8_t seq, uint32_t now)
+{
+	struct arq_tx_slot_s *slot = &p->tx[seq & (ARQ_WINDOW - 1)];
+
+	if(((uint8_t)(seq - p->txBase) >= (uint8_t)(p->txNext - p->txBase)) || \
+		!slot->used || (slot->seq != seq))
+	{
+		return;
+	}
+
+	slot->sentAt = now;
+	commArq[port].retransmits++;
+	comm_port_send(port, slot->str, slot->len);
+}
+
+//Passes every consecutive payload we have to payload_parse_str()
+static uint8_t arq_deliver(struct arq_peer_s *p, uint8_t *info, uint32_t now)
+{
+	struct arq_rx_slot_s *slot = &p->rx[p->rxNext & (ARQ_WINDOW - 1)];
+	uint8_t cnt = 0, i = 0;
+
+	while(slot->used)
+	{
+		slot->used = 0;
+		p->rxNext++;
+		p->nakSent = 0;
+		cnt++;
+		payload_parse_str(slot->payload, info);
+		slot = &p->rx[p->rxNext & (ARQ_WINDOW - 1)];
+	}
+
+	//Still holding frames: there is another gap
+	for(i = 0; i < ARQ_WINDOW; i++)
+	{
+		if(p->rx[i].used && !p->nakSent)
+		{
+			p->nakPending = 1;
+			p->nakSent = 1;
+			p->gapSince = now;
+		}
+	}
+
+	return cnt;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -43,7 +43,10 @@ extern "C" {
 // Include(s)
 //****************************************************************************
 
+#include <string.h>
 #include "../inc/flexsea.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_capture.h"
 #include "flexsea_system.h"
 #include "flexsea_board.h"
 
@@ -78,9 +81,11 @@ uint8_t rx_buf_5[RX_BUF_LEN];
 //****************************************************************************
 
 //For all the buffers:
-static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte);
+static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte, \
+								uint8_t port);
 static void update_rx_buf_array(uint8_t *buf, uint32_t *idx, \
-								uint8_t *new_data, uint32_t len);
+								uint8_t *new_data, uint32_t len, uint8_t port);
+static uint32_t count_lost_bytes(uint8_t *buf, uint32_t len);
 
 //Specific:
 #ifdef ENABLE_FLEXSEA_BUF_1
@@ -193,6 +198,36 @@ void update_rx_buf_array_5(uint8_t *new_array, uint32_t len)
 
 #endif	//ENABLE_FLEXSEA_BUF_5
 
+//Generic buffers: same as above, the caller owns the buffer and its index
+
+//Add one byte to 'rb'
+void update_rx_buf_byte_s(struct rx_buf_s *rb, uint8_t new_byte)
+{
+	update_rx_buf_byte(rb->buf, &rb->idx, new_byte, rb->port);
+}
+
+//Add an array of bytes to 'rb'
+void update_rx_buf_array_s(struct rx_buf_s *rb, uint8_t *new_array, uint32_t len)
+{
+	update_rx_buf_array(rb->buf, &rb->idx, new_array, len, rb->port);
+}
+
+//Drops the 'len' oldest bytes of 'rb' (the ones that were decoded are
+//already cleared, the others are counted as discarded)
+void discard_rx_buf_s(struct rx_buf_s *rb, uint32_t len)
+{
+	if(len == 0)
+	{
+		return;
+	}
+
+	len = MIN(len, rb->idx);
+	COMM_STAT_ADD(rb->port, discarded, count_lost_bytes(rb->buf, len));
+	memmove(rb->buf, &rb->buf[len], rb->idx - len);
+	memset(&rb->buf[rb->idx - len], 0, len);
+	rb->idx -= len;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -204,10 +239,13 @@ void update_rx_buf_array_5(uint8_t *new_array, uint32_t len)
 //Add one byte to the FIFO buffer
 //Do not call that function directly, call update_rx_buf_byte_n() where n is
 //your communication port/buffer name
-static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte)
+static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte, \
+								uint8_t port)
 {
 	uint32_t i = 0;
 
+	COMM_STAT_ADD(port, bytesIn, 1);
+
 	if((*idx) < RX_BUF_LEN)
 	{
 		//Buffer isn't full yet, no need to discard "old" bytes
@@ -217,6 +255,10 @@ static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte)
 	else
 	{
 		//Shift buffer to clear one spot
+		if(buf[0])
+		{
+			COMM_STAT_ADD(port, discarded, 1);
+		}
 		for(i = 1; i < RX_BUF_LEN; i++)
 		{
 			buf[i-1] = buf[i];
@@ -232,55 +274,55 @@ static void update_rx_buf_byte(uint8_t *buf, uint32_t *idx, uint8_t new_byte)
 //Do not call that function directly, call update_rx_buf_array_n() where n is
 //your communication port/buffer name
 static void update_rx_buf_array(uint8_t *buf, uint32_t *idx, \
-								uint8_t *new_data, uint32_t len)
+								uint8_t *new_data, uint32_t len, uint8_t port)
 {
-	uint32_t i = 0, cnt = 0, remaining = 0;
+	uint32_t shift = 0;
 
-	if((*idx) < RX_BUF_LEN)
-	{
-		//Buffer isn't full yet, no need to discard "old" bytes yet
-
-		while(((*idx) + len) < RX_BUF_LEN)
-		{
-			//As long as we did not over fill it we keep adding bytes and
-			//increasing the index
-			buf[(*idx)] = new_data[cnt];
-			(*idx)++;
-			cnt++;	//Number of bytes we could add before shifting old data
-		}
+	COMM_STAT_ADD(port, bytesIn, len);
 
-		if((cnt + 1) == len)
-		{
-			//All the bytes were added without requiring shifting, exit
-			return;
-		}
-		else
-		{
-			//We need to shift and add 'remaining' bytes:
-			remaining = len - (cnt + 1);
-		}
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	if(captureTap)
+	{
+		capture_write_bytes(captureTap, port, new_data, len);
 	}
-	else
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	if(len >= RX_BUF_LEN)
 	{
-		//Buffer was already full when we started
-		remaining = len;
+		//Only the last RX_BUF_LEN bytes will fit
+		COMM_STAT_ADD(port, discarded, count_lost_bytes(buf, (*idx)) + \
+						count_lost_bytes(new_data, len - RX_BUF_LEN));
+		memcpy(buf, &new_data[len - RX_BUF_LEN], RX_BUF_LEN);
+		(*idx) = RX_BUF_LEN;
+		return;
 	}
 
-	if(remaining != 0)
+	if(((*idx) + len) > RX_BUF_LEN)
 	{
-		//Shift buffer to clear 'remaining' spots
-		for(i = remaining; i < (RX_BUF_LEN) ; i++)
-		{
-			buf[i-remaining] = buf[i];
-		}
+		//Shift buffer to discard the 'shift' oldest bytes
+		shift = (*idx) + len - RX_BUF_LEN;
+		COMM_STAT_ADD(port, discarded, count_lost_bytes(buf, shift));
+		memmove(buf, &buf[shift], (*idx) - shift);
+		(*idx) -= shift;
+	}
 
-		//Then add the new data bytes at the end of the buffer:
-		for(i = (RX_BUF_LEN - remaining); i < RX_BUF_LEN; i++)
-		{
-			buf[i] = new_data[cnt];
-			cnt++;
-		}
+	//Then add the new data bytes at the end of the buffer:
+	memcpy(&buf[(*idx)], new_data, len);
+	(*idx) += len;
+}
+
+//Bytes pushed out of a buffer that were never decoded (the decoder clears
+//the frames it finds)
+static uint32_t count_lost_bytes(uint8_t *buf, uint32_t len)
+{
+	uint32_t i = 0, cnt = 0;
+
+	for(i = 0; i < len; i++)
+	{
+		cnt += (buf[i] != 0);
 	}
+
+	return cnt;
 }
 
 #ifdef ENABLE_FLEXSEA_BUF_1
@@ -296,12 +338,12 @@ static void update_rx_buf_1(uint8_t byte_array, uint8_t new_byte, \
 	if(byte_array == UPDATE_BYTE)
 	{
 		//Updating buffer with one byte
-		update_rx_buf_byte(rx_buf_1, &idx_1, new_byte);
+		update_rx_buf_byte(rx_buf_1, &idx_1, new_byte, COMM_STATS_NO_PORT);
 	}
 	else if(byte_array == UPDATE_ARRAY)
 	{
 		//Updating buffer with an array
-		update_rx_buf_array(rx_buf_1, &idx_1, new_array, len);
+		update_rx_buf_array(rx_buf_1, &idx_1, new_array, len, COMM_STATS_NO_PORT);
 	}
 	else
 	{
@@ -323,12 +365,12 @@ static void update_rx_buf_2(uint8_t byte_array, uint8_t new_byte, \
 	if(byte_array == UPDATE_BYTE)
 	{
 		//Updating buffer with one byte
-		update_rx_buf_byte(rx_buf_2, &idx_2, new_byte);
+		update_rx_buf_byte(rx_buf_2, &idx_2, new_byte, COMM_STATS_NO_PORT);
 	}
 	else if(byte_array == UPDATE_ARRAY)
 	{
 		//Updating buffer with an array
-		update_rx_buf_array(rx_buf_2, &idx_2, new_array, len);
+		update_rx_buf_array(rx_buf_2, &idx_2, new_array, len, COMM_STATS_NO_PORT);
 	}
 	else
 	{
@@ -350,12 +392,12 @@ static void update_rx_buf_3(uint8_t byte_array, uint8_t new_byte, \
 	if(byte_array == UPDATE_BYTE)
 	{
 		//Updating buffer with one byte
-		update_rx_buf_byte(rx_buf_3, &idx_3, new_byte);
+		update_rx_buf_byte(rx_buf_3, &idx_3, new_byte, COMM_STATS_NO_PORT);
 	}
 	else if(byte_array == UPDATE_ARRAY)
 	{
 		//Updating buffer with an array
-		update_rx_buf_array(rx_buf_3, &idx_3, new_array, len);
+		update_rx_buf_array(rx_buf_3, &idx_3, new_array, len, COMM_STATS_NO_PORT);
 	}
 	else
 	{
@@ -377,12 +419,12 @@ static void update_rx_buf_4(uint8_t byte_array, uint8_t new_byte, \
 	if(byte_array == UPDATE_BYTE)
 	{
 		//Updating buffer with one byte
-		update_rx_buf_byte(rx_buf_4, &idx_4, new_byte);
+		update_rx_buf_byte(rx_buf_4, &idx_4, new_byte, COMM_STATS_NO_PORT);
 	}
 	else if(byte_array == UPDATE_ARRAY)
 	{
 		//Updating buffer with an array
-		update_rx_buf_array(rx_buf_4, &idx_4, new_array, len);
+		update_rx_buf_array(rx_buf_4, &idx_4, new_array, len, COMM_STATS_NO_PORT);
 	}
 	else
 	{
@@ -404,12 +446,12 @@ static void update_rx_buf_5(uint8_t byte_array, uint8_t new_byte, \
 	if(byte_array == UPDATE_BYTE)
 	{
 		//Updating buffer with one byte
-		update_rx_buf_byte(rx_buf_5, &idx_5, new_byte);
+		update_rx_buf_byte(rx_buf_5, &idx_5, new_byte, COMM_STATS_NO_PORT);
 	}
 	else if(byte_array == UPDATE_ARRAY)
 	{
 		//Updating buffer with an array
-		update_rx_buf_array(rx_buf_5, &idx_5, new_array, len);
+		update_rx_buf_array(rx_buf_5, &idx_5, new_array, len, COMM_STATS_NO_PORT);
 	}
 	else
 	{
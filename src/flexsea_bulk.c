@@ -0,0 +1,454 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_bulk: parallel decode of large byte streams
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Offline decoding of long recordings (raw byte streams, GB of logs): the
+//stream is cut in chunks decoded in parallel, and the frames come out in
+//stream order. The result is exactly the one of a serial decode:
+// 1) bulk_init(&b, threads, BULK_CHUNK_DEFAULT), b.callback = ...
+// 2) bulk_decode_file(&b, "log.bin"), or bulk_decode(&b, buf, len)
+// 3) bulk_free(&b)
+//Serial decode: at every HEADER, a frame is accepted if its length, FOOTER
+//and checksum are right (same rules as unpack_payload_frame()). Decoding
+//then continues after that frame, or at the next byte.
+//A chunk doesn't know if it starts inside a frame, so each thread decodes
+//from the start of its chunk, resyncing on the first frame it finds. While
+//merging, the decoding of the previous chunk goes on past its end until it
+//reaches a position the next chunk's decoding also went through. From
+//there both decodings are the same. It's a few bytes in a clean stream.
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_bulk.h"
+#include "../inc/flexsea_comm.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void *bulk_thread(void *arg);
+static void bulk_scan(struct bulk_chunk_s *c);
+static uint64_t bulk_merge(struct bulk_s *b, struct bulk_chunk_s *c, uint64_t pos);
+static uint8_t bulk_inside(struct bulk_chunk_s *c, uint64_t pos);
+static void bulk_emit(struct bulk_s *b, uint8_t *buf, uint64_t pos, uint16_t n);
+static uint8_t bulk_unescape(uint8_t *frame, uint16_t n, uint8_t *payload);
+static uint64_t bulk_now_ns(void);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Returns 0, or -1 if the buffers can't be allocated (errno)
+int bulk_init(struct bulk_s *b, uint8_t threads, uint32_t chunk)
+{
+	uint8_t i = 0;
+
+	memset(b, 0, sizeof(struct bulk_s));
+	if((threads == 0) || (threads > BULK_MAX_THREADS) || (chunk == 0))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	b->threads = threads;
+	b->chunk = chunk;
+	for(i = 0; (i < threads) && (threads > 1); i++)
+	{
+		//Frames don't overlap. The last one can go past the end.
+		b->c[i].found = (struct bulk_found_s *)malloc(((chunk / BULK_MIN_FRAME) \
+						+ 1) * sizeof(struct bulk_found_s));
+		b->c[i].payload = (uint8_t *)malloc(chunk + 0xFF + PACKAGED_PAYLOAD_LEN);
+		if((b->c[i].found == NULL) || (b->c[i].payload == NULL))
+		{
+			bulk_free(b);
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+void bulk_free(struct bulk_s *b)
+{
+	uint8_t i = 0;
+
+	for(i = 0; i < BULK_MAX_THREADS; i++)
+	{
+		free(b->c[i].found);
+		free(b->c[i].payload);
+		b->c[i].found = NULL;
+		b->c[i].payload = NULL;
+	}
+}
+
+//Decodes 'buf'. Returns 0, -1 if a thread can't be started.
+int bulk_decode(struct bulk_s *b, uint8_t *buf, uint64_t len)
+{
+	struct bulk_chunk_s *c = NULL;
+	uint64_t t0 = bulk_now_ns(), seg = 0, pos = 0;
+	uint8_t i = 0, n = 0;
+	int ret = 0;
+
+	b->frames = 0;
+	b->fixups = 0;
+	b->bytes = len;
+
+	if(b->threads <= 1)
+	{
+		while(pos < len)
+		{
+			c = &b->c[0];
+			c->buf = buf;
+			c->len = len;
+			pos = bulk_merge(b, c, pos);
+		}
+		b->ns = bulk_now_ns() - t0;
+		return 0;
+	}
+
+	for(seg = 0; (seg < len) && (ret == 0); seg += (uint64_t)b->threads * b->chunk)
+	{
+		for(n = 0; (n < b->threads) && ((seg + (uint64_t)n * b->chunk) < len); n++)
+		{
+			c = &b->c[n];
+			c->buf = buf;
+			c->len = len;
+			c->start = seg + (uint64_t)n * b->chunk;
+			c->end = MIN(c->start + b->chunk, len);
+		}
+
+		//Chunk 0 is decoded by this thread:
+		for(i = 1; i < n; i++)
+		{
+			if(pthread_create(&b->c[i].thread, NULL, &bulk_thread, &b->c[i]) != 0)
+			{
+				ret = -1;
+				n = i;
+				break;
+			}
+		}
+		bulk_scan(&b->c[0]);
+		for(i = 1; i < n; i++)
+		{
+			pthread_join(b->c[i].thread, NULL);
+		}
+
+		for(i = 0; (i < n) && (ret == 0); i++)
+		{
+			pos = bulk_merge(b, &b->c[i], pos);
+		}
+	}
+
+	b->ns = bulk_now_ns() - t0;
+	return ret;
+}
+
+//Maps a file and decodes it. Returns 0, or -1 (errno).
+int bulk_decode_file(struct bulk_s *b, const char *path)
+{
+	struct stat st;
+	void *map = NULL;
+	int fd = open(path, O_RDONLY | O_CLOEXEC), ret = 0;
+
+	if(fd < 0)
+	{
+		return -1;
+	}
+
+	if(fstat(fd, &st) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	if(st.st_size == 0)
+	{
+		close(fd);
+		return bulk_decode(b, NULL, 0);
+	}
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	madvise(map, (size_t)st.st_size, MADV_WILLNEED);
+	ret = bulk_decode(b, (uint8_t *)map, (uint64_t)st.st_size);
+	munmap(map, (size_t)st.st_size);
+
+	return ret;
+}
+
+//Length of the valid frame that starts at 'pos', 0 if there is none
+uint16_t bulk_frame_at(uint8_t *buf, uint64_t len, uint64_t pos)
+{
+	uint16_t bytes = 0, i = 0;
+	uint8_t checksum = 0;
+
+	if(((pos + BULK_MIN_FRAME) > len) || (buf[pos] != HEADER))
+	{
+		return 0;
+	}
+
+	bytes = buf[pos + 1];
+	if(((pos + bytes + 4) > len) || (buf[pos + bytes + 3] != FOOTER))
+	{
+		return 0;
+	}
+
+	for(i = 0; i < bytes; i++)
+	{
+		checksum += buf[pos + 2 + i];
+	}
+
+	return ((checksum == buf[pos + 2 + bytes]) ? (bytes + 4) : 0);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static void *bulk_thread(void *arg)
+{
+	bulk_scan((struct bulk_chunk_s *)arg);
+	return NULL;
+}
+
+//Serial decode of the frames that start in the chunk
+static void bulk_scan(struct bulk_chunk_s *c)
+{
+	struct bulk_found_s *f = NULL;
+	uint8_t *h = NULL;
+	uint64_t pos = c->start;
+	uint32_t used = 0;
+	uint16_t n = 0;
+
+	c->cnt = 0;
+	while(pos < c->end)
+	{
+		h = (uint8_t *)memchr(&c->buf[pos], HEADER, c->end - pos);
+		if(h == NULL)
+		{
+			pos = c->end;
+			break;
+		}
+
+		pos = (uint64_t)(h - c->buf);
+		n = bulk_frame_at(c->buf, c->len, pos);
+		if(n == 0)
+		{
+			pos++;
+			continue;
+		}
+
+		f = &c->found[c->cnt++];
+		f->offset = pos;
+		f->len = n;
+		f->payloadIdx = used;
+		f->payloadLen = bulk_unescape(h, n, &c->payload[used]);
+		used += f->payloadLen;
+		pos += n;
+	}
+
+	c->stop = pos;
+}
+
+//Gives the frames of the chunk to the callback, from 'pos' (where the
+//decoding of the previous chunk is). Returns where the decoding stops.
+//b->threads == 1: decodes from 'pos' to the end.
+static uint64_t bulk_merge(struct bulk_s *b, struct bulk_chunk_s *c, uint64_t pos)
+{
+	struct bulk_frame_s f;
+	uint8_t *h = NULL;
+	uint32_t lo = 0, hi = 0, mid = 0;
+	uint16_t n = 0;
+
+	if(b->threads <= 1)
+	{
+		while((pos < c->len) && \
+			((h = (uint8_t *)memchr(&c->buf[pos], HEADER, c->len - pos)) != NULL))
+		{
+			pos = (uint64_t)(h - c->buf);
+			n = bulk_frame_at(c->buf, c->len, pos);
+			if(n)
+			{
+				bulk_emit(b, c->buf, pos, n);
+			}
+			pos += (n ? n : 1);
+		}
+		return c->len;
+	}
+
+	//Serial decode until we're on the path of this chunk:
+	while((pos < c->end) && bulk_inside(c, pos))
+	{
+		n = bulk_frame_at(c->buf, c->len, pos);
+		if(n)
+		{
+			bulk_emit(b, c->buf, pos, n);
+			b->fixups++;
+		}
+		pos += (n ? n : 1);
+	}
+
+	if(pos >= c->end)
+	{
+		return pos;
+	}
+
+	//First frame at or after 'pos':
+	lo = 0;
+	hi = c->cnt;
+	while(lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if(c->found[mid].offset < pos)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	for(; lo < c->cnt; lo++)
+	{
+		f.offset = c->found[lo].offset;
+		f.len = c->found[lo].len;
+		f.payloadLen = c->found[lo].payloadLen;
+		f.payload = &c->payload[c->found[lo].payloadIdx];
+		b->frames++;
+		if(b->callback)
+		{
+			b->callback(b, &f);
+		}
+	}
+
+	return c->stop;
+}
+
+//1 if 'pos' is inside (not at the start of) a frame of the chunk
+static uint8_t bulk_inside(struct bulk_chunk_s *c, uint64_t pos)
+{
+	uint32_t lo = 0, hi = c->cnt, mid = 0;
+
+	//Last frame that starts before 'pos':
+	while(lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if(c->found[mid].offset < pos)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+
+	return ((lo > 0) && (pos < (c->found[lo - 1].offset + c->found[lo - 1].len)));
+}
+
+//Frame decoded by this thread, straight to the callback
+static void bulk_emit(struct bulk_s *b, uint8_t *buf, uint64_t pos, uint16_t n)
+{
+	uint8_t payload[PACKAGED_PAYLOAD_LEN];
+	struct bulk_frame_s f;
+
+	f.offset = pos;
+	f.len = n;
+	f.payloadLen = bulk_unescape(&buf[pos], n, payload);
+	f.payload = payload;
+	b->frames++;
+	if(b->callback)
+	{
+		b->callback(b, &f);
+	}
+}
+
+//Same as unpack_payload_frame(). Returns the payload length.
+static uint8_t bulk_unescape(uint8_t *frame, uint16_t n, uint8_t *payload)
+{
+	uint16_t i = 0;
+	uint8_t idx = 0, skip = 0;
+
+	for(i = 2; i < (n - 2); i++)
+	{
+		if(((frame[i] == HEADER) || (frame[i] == FOOTER) || (frame[i] == ESCAPE)) && \
+			skip == 0)
+		{
+			skip = 1;
+		}
+		else
+		{
+			skip = 0;
+			if(idx < PACKAGED_PAYLOAD_LEN)
+			{
+				payload[idx++] = frame[i];
+			}
+		}
+	}
+
+	return idx;
+}
+
+static uint64_t bulk_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
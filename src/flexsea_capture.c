@@ -0,0 +1,504 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_capture: wire capture ring and trace files
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Records what goes on the wire, for post-mortems. The stack writes
+//timestamped records in a ring (no locks, no system calls), and a
+//background thread moves them to an append-only file:
+// 1) capture_init(&c, &capture_clock_ns, 1000000000)
+// 2) capture_file_open(&f, &c, "/var/log/flexsea.fxc") then
+//    capture_file_start(&f, 1000): flushed every ms
+// 3) captureTap = &c (ENABLE_FLEXSEA_CAPTURE). The taps are:
+//    - CAPTURE_RX_BYTES: update_rx_buf_array_N() (not the byte by byte
+//      version: its frames are still in the CAPTURE_RX_FRAME records)
+//    - CAPTURE_RX_FRAME: every frame unpack_payload_N() finds, with its
+//      status (valid, bad checksum)
+//    - CAPTURE_TX_FRAME: comm_gen_str()
+// 4) capture_file_close(&f)
+//The taps have to be called from one thread (the one that owns the
+//ports). A full ring drops the new record and counts it in 'dropped'.
+//Without a file (MCU), capture_drain() hands the records to any sink.
+//File: struct capture_file_hdr_s, then the records back to back (native
+//endianness). Zeros after the last record (CAPTURE_END) are normal after
+//a crash: the file grows by CAPTURE_FILE_CHUNK. Reopening a file appends
+//to it.
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#endif	//__linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_capture.h"
+#include "flexsea_board.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif	//__linux__
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+struct capture_s *captureTap = NULL;
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+#define CAPTURE_HDR_LEN			sizeof(struct capture_rec_s)
+#define CAPTURE_MASK			(CAPTURE_RING_LEN - 1)
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+#ifdef __linux__
+static void capture_file_put(void *ctx, uint8_t *data, uint32_t len);
+static int capture_file_window(struct capture_file_s *f);
+static void *capture_file_thread(void *arg);
+#endif	//__linux__
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//'clock' can be NULL: all the records will have time = 0
+void capture_init(struct capture_s *c, uint64_t (*clock)(void), uint32_t tickHz)
+{
+	memset(c, 0, sizeof(struct capture_s));
+	c->clock = clock;
+	c->tickHz = tickHz;
+}
+
+//Producer side. Returns 1 if the record is in the ring, 0 if it was dropped.
+uint8_t capture_write(struct capture_s *c, uint8_t type, uint8_t port, \
+						int8_t status, uint8_t *data, uint16_t len)
+{
+	uint32_t need = CAPTURE_REC_LEN(len), head = c->head;
+	uint32_t used = head - __atomic_load_n(&c->tail, __ATOMIC_ACQUIRE);
+	uint32_t pos = head & CAPTURE_MASK, room = CAPTURE_RING_LEN - pos;
+	struct capture_rec_s *r = NULL;
+
+	if(need > room)
+	{
+		//Doesn't fit before the end of the ring: pad, and start over at 0
+		if((used + room + need) > CAPTURE_RING_LEN)
+		{
+			c->dropped++;
+			return 0;
+		}
+
+		if(room >= CAPTURE_HDR_LEN)
+		{
+			r = (struct capture_rec_s *)&c->ring[pos];
+			r->type = CAPTURE_PAD;
+			r->len = 0;
+		}
+		head += room;
+		pos = 0;
+	}
+	else if((used + need) > CAPTURE_RING_LEN)
+	{
+		c->dropped++;
+		return 0;
+	}
+
+	r = (struct capture_rec_s *)&c->ring[pos];
+	r->time = (c->clock ? c->clock() : 0);
+	r->len = len;
+	r->type = type;
+	r->port = port;
+	r->status = status;
+	memcpy(CAPTURE_DATA(r), data, len);
+
+	c->records++;
+	__atomic_store_n(&c->head, head + need, __ATOMIC_RELEASE);
+	return 1;
+}
+
+//CAPTURE_RX_BYTES record(s). Returns 0 if something was dropped.
+uint8_t capture_write_bytes(struct capture_s *c, uint8_t port, uint8_t *data, \
+							uint32_t len)
+{
+	uint16_t n = 0;
+	uint8_t ret = 1;
+
+	while(len)
+	{
+		n = (uint16_t)MIN(len, CAPTURE_MAX_BYTES);
+		ret &= capture_write(c, CAPTURE_RX_BYTES, port, 0, data, n);
+		data += n;
+		len -= n;
+	}
+
+	return ret;
+}
+
+//Consumer side: hands everything that's in the ring to 'sink', in
+//contiguous runs of whole records. Returns the number of bytes.
+uint32_t capture_drain(struct capture_s *c, \
+						void (*sink)(void *ctx, uint8_t *rec, uint32_t len), void *ctx)
+{
+	uint32_t head = __atomic_load_n(&c->head, __ATOMIC_ACQUIRE), tail = c->tail;
+	uint32_t pos = 0, room = 0, run = 0, total = 0;
+	struct capture_rec_s *r = NULL;
+
+	while(tail != head)
+	{
+		pos = tail & CAPTURE_MASK;
+		room = CAPTURE_RING_LEN - pos;
+
+		//Records up to the head, the end of the ring or a CAPTURE_PAD:
+		for(run = 0; (run < (head - tail)) && (run < room); \
+			run += CAPTURE_REC_LEN(r->len))
+		{
+			if((room - run) < CAPTURE_HDR_LEN)
+			{
+				break;
+			}
+			r = (struct capture_rec_s *)&c->ring[pos + run];
+			if(r->type == CAPTURE_PAD)
+			{
+				break;
+			}
+		}
+
+		if(run)
+		{
+			sink(ctx, &c->ring[pos], run);
+			total += run;
+			tail += run;
+		}
+		if((run < room) && (tail != head))
+		{
+			//Padding:
+			tail += room - run;
+		}
+	}
+
+	__atomic_store_n(&c->tail, tail, __ATOMIC_RELEASE);
+	return total;
+}
+
+//Walks the records of a drained buffer or of a capture file (start with
+//*pos = sizeof(struct capture_file_hdr_s)). NULL at the end.
+struct capture_rec_s *capture_next(uint8_t *buf, uint64_t len, uint64_t *pos)
+{
+	struct capture_rec_s *r = NULL;
+
+	if((*pos + CAPTURE_HDR_LEN) > len)
+	{
+		return NULL;
+	}
+
+	r = (struct capture_rec_s *)&buf[*pos];
+	if((r->type == CAPTURE_END) || ((*pos + CAPTURE_REC_LEN(r->len)) > len))
+	{
+		return NULL;
+	}
+
+	*pos += CAPTURE_REC_LEN(r->len);
+	return r;
+}
+
+#ifdef __linux__
+
+//Opens or creates 'path'. Returns 0 on success, -1 otherwise (errno).
+int capture_file_open(struct capture_file_s *f, struct capture_s *c, \
+						const char *path)
+{
+	struct capture_file_hdr_s hdr;
+	uint8_t *map = NULL;
+	uint64_t len = 0, pos = sizeof(hdr);
+	struct stat st;
+
+	memset(f, 0, sizeof(struct capture_file_s));
+	f->c = c;
+	f->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if((f->fd < 0) || (fstat(f->fd, &st) < 0))
+	{
+		goto fail;
+	}
+
+	if(st.st_size == 0)
+	{
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.magic = CAPTURE_MAGIC;
+		hdr.version = CAPTURE_VERSION;
+		hdr.recHdrLen = CAPTURE_HDR_LEN;
+		hdr.tickHz = c->tickHz;
+		if(pwrite(f->fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+		{
+			goto fail;
+		}
+		f->len = f->size = sizeof(hdr);
+		return 0;
+	}
+
+	//Appending: after the last valid record
+	map = capture_file_map(path, &len, NULL);
+	if(map == NULL)
+	{
+		goto fail;
+	}
+	while(capture_next(map, len, &pos) != NULL)
+	{
+		//Skip the records
+	}
+	capture_file_unmap(map, len);
+
+	f->len = pos;
+	f->size = (uint64_t)st.st_size;
+	return 0;
+
+	fail:
+	if(f->fd >= 0)
+	{
+		close(f->fd);
+	}
+	f->fd = -1;
+	return -1;
+}
+
+//Moves the records from the ring to the file. Returns the number of bytes.
+uint32_t capture_file_flush(struct capture_file_s *f)
+{
+	return capture_drain(f->c, &capture_file_put, f);
+}
+
+//Flushes every 'periodUs' from a background thread
+int capture_file_start(struct capture_file_s *f, uint32_t periodUs)
+{
+	f->periodUs = periodUs;
+	__atomic_store_n(&f->running, 1, __ATOMIC_RELEASE);
+	if(pthread_create(&f->thread, NULL, &capture_file_thread, f) != 0)
+	{
+		f->running = 0;
+		return -1;
+	}
+
+	return 0;
+}
+
+void capture_file_stop(struct capture_file_s *f)
+{
+	if(__atomic_exchange_n(&f->running, 0, __ATOMIC_ACQ_REL))
+	{
+		pthread_join(f->thread, NULL);
+	}
+}
+
+//Stops the thread, flushes and trims the file. Returns f->err.
+int capture_file_close(struct capture_file_s *f)
+{
+	if(f->fd < 0)
+	{
+		return f->err;
+	}
+
+	capture_file_stop(f);
+	capture_file_flush(f);
+	if(f->map)
+	{
+		munmap(f->map, CAPTURE_FILE_CHUNK);
+		f->map = NULL;
+	}
+	if(ftruncate(f->fd, (off_t)f->len) < 0)
+	{
+		f->err = errno;
+	}
+	close(f->fd);
+	f->fd = -1;
+
+	return f->err;
+}
+
+//Read only map of a capture file. Returns NULL if it can't be read or
+//isn't a capture file. The records start at sizeof(struct capture_file_hdr_s).
+uint8_t *capture_file_map(const char *path, uint64_t *len, uint32_t *tickHz)
+{
+	struct capture_file_hdr_s *hdr = NULL;
+	uint8_t *map = NULL;
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	if((fstat(fd, &st) < 0) || ((uint64_t)st.st_size < sizeof(*hdr)))
+	{
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	map = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	hdr = (struct capture_file_hdr_s *)map;
+	if((hdr->magic != CAPTURE_MAGIC) || (hdr->version != CAPTURE_VERSION) || \
+		(hdr->recHdrLen != CAPTURE_HDR_LEN))
+	{
+		munmap(map, (size_t)st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+	*len = (uint64_t)st.st_size;
+	if(tickHz)
+	{
+		*tickHz = hdr->tickHz;
+	}
+	return map;
+}
+
+void capture_file_unmap(uint8_t *map, uint64_t len)
+{
+	munmap(map, (size_t)len);
+}
+
+//Default capture clock: monotonic, in ns (tickHz = 1000000000)
+uint64_t capture_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#endif	//__linux__
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+#ifdef __linux__
+
+//capture_drain() sink: appends to the file through the mapped window
+static void capture_file_put(void *ctx, uint8_t *data, uint32_t len)
+{
+	struct capture_file_s *f = (struct capture_file_s *)ctx;
+	uint64_t n = 0;
+
+	while(len)
+	{
+		if((f->map == NULL) || (f->len < f->mapOff) || \
+			(f->len >= (f->mapOff + CAPTURE_FILE_CHUNK)))
+		{
+			if(capture_file_window(f) < 0)
+			{
+				return;
+			}
+		}
+
+		n = MIN(len, f->mapOff + CAPTURE_FILE_CHUNK - f->len);
+		memcpy(&f->map[f->len - f->mapOff], data, n);
+		f->len += n;
+		data += n;
+		len -= n;
+	}
+}
+
+//Maps the chunk that holds f->len, growing the file if needed
+static int capture_file_window(struct capture_file_s *f)
+{
+	uint64_t off = f->len & ~((uint64_t)CAPTURE_FILE_CHUNK - 1);
+	void *map = NULL;
+
+	if(f->map)
+	{
+		munmap(f->map, CAPTURE_FILE_CHUNK);
+		f->map = NULL;
+	}
+
+	if(f->size < (off + CAPTURE_FILE_CHUNK))
+	{
+		if(ftruncate(f->fd, (off_t)(off + CAPTURE_FILE_CHUNK)) < 0)
+		{
+			f->err = errno;
+			return -1;
+		}
+		f->size = off + CAPTURE_FILE_CHUNK;
+	}
+
+	map = mmap(NULL, CAPTURE_FILE_CHUNK, PROT_READ | PROT_WRITE, MAP_SHARED, \
+				f->fd, (off_t)off);
+	if(map == MAP_FAILED)
+	{
+		f->err = errno;
+		return -1;
+	}
+
+	f->map = (uint8_t *)map;
+	f->mapOff = off;
+	return 0;
+}
+
+static void *capture_file_thread(void *arg)
+{
+	struct capture_file_s *f = (struct capture_file_s *)arg;
+	struct timespec ts;
+
+	ts.tv_sec = f->periodUs / 1000000;
+	ts.tv_nsec = (long)(f->periodUs % 1000000) * 1000;
+	while(__atomic_load_n(&f->running, __ATOMIC_ACQUIRE))
+	{
+		capture_file_flush(f);
+		nanosleep(&ts, NULL);
+	}
+
+	return NULL;
+}
+
+#endif	//__linux__
+
+#ifdef __cplusplus
+}
+#endif
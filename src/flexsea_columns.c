@@ -0,0 +1,540 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_columns: decoded telemetry as columns
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Decoded payloads to columns: one array per field, ready for numpy & co.
+// 1) columns_init(&c), then columns_add_schema(&c, cmd, fields, n) for
+//    every command to export. Offsets and types are the ones the handler
+//    uses with REBUILD_UINT16()/REBUILD_UINT32().
+// 2) columns_add(&c, payload, len, key) for every decoded payload, or
+//    b.callback = &columns_bulk_callback, b.ctx = &c with flexsea_bulk
+// 3) columns_write(&c, "log.fxcol"), columns_free(&c)
+//Values are copied as they are (big endian), and converted to the host
+//byte order COLUMNS_BATCH rows at a time. The conversion is a plain loop
+//over a contiguous array: the compiler vectorizes it.
+//Native payloads (P_CMDS_NATIVE, see flexsea_payload) are not exported:
+//their offsets and byte order aren't the schema's. They are counted in
+//c.native.
+//Files: headers, then every column as a raw array aligned on 64 bytes. A
+//reader maps the file and uses the arrays in place (columns_find()).
+
+#ifdef __linux__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_columns.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define COLUMNS_SWAP			0
+#else
+#define COLUMNS_SWAP			1
+#endif
+
+#define COLUMNS_ALIGN_UP(x)		(((x) + COLUMNS_DATA_ALIGN - 1) & \
+								~(uint64_t)(COLUMNS_DATA_ALIGN - 1))
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int columns_grow(struct columns_table_s *t);
+static void columns_convert(struct columns_table_s *t);
+static void columns_swap16(uint16_t *v, uint64_t n);
+static void columns_swap32(uint32_t *v, uint64_t n);
+static uint8_t columns_col(struct columns_table_s *t, uint8_t i, \
+							struct columns_col_hdr_s *h, const void **data);
+static int columns_put(FILE *f, const void *data, uint64_t len);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void columns_init(struct columns_s *c)
+{
+	memset(c, 0, sizeof(struct columns_s));
+}
+
+//Exports command 'cmd' (7 bits). Returns its table, or -1.
+int columns_add_schema(struct columns_s *c, uint8_t cmd, \
+						const struct columns_field_s *fields, uint8_t n)
+{
+	struct columns_table_s *t = NULL;
+	uint8_t i = 0, size = 0;
+
+	if((cmd > 0x7F) || c->lookup[cmd] || (c->tables >= COLUMNS_MAX_TABLES) || \
+		(n > COLUMNS_MAX_FIELDS))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	t = &c->t[c->tables];
+	memset(t, 0, sizeof(struct columns_table_s));
+	t->cmd = cmd;
+	t->minLen = P_CMD1 + 1;
+	for(i = 0; i < n; i++)
+	{
+		size = COLUMNS_SIZE(fields[i].type);
+		if(((size != 1) && (size != 2) && (size != 4)) || \
+			((fields[i].offset + size) > PACKAGED_PAYLOAD_LEN))
+		{
+			errno = EINVAL;
+			return -1;
+		}
+
+		strncpy(t->name[i], fields[i].name, COLUMNS_NAME_LEN - 1);
+		t->offset[i] = fields[i].offset;
+		t->type[i] = fields[i].type;
+		t->minLen = MAX(t->minLen, fields[i].offset + size);
+	}
+	t->fields = n;
+
+	c->lookup[cmd] = ++c->tables;
+	return c->tables - 1;
+}
+
+//Adds a row to the table of its command. Returns 1 if it was added.
+uint8_t columns_add(struct columns_s *c, uint8_t *payload, uint8_t len, uint64_t key)
+{
+	struct columns_table_s *t = NULL;
+	uint8_t i = 0, idx = 0;
+	uint64_t row = 0;
+
+	if(len <= P_CMD1)
+	{
+		c->skipped++;
+		return 0;
+	}
+
+	idx = c->lookup[CMD_7BITS(payload[P_CMD1])];
+	if(idx == 0)
+	{
+		c->unknown++;
+		return 0;
+	}
+
+	//Other layout:
+	if(payload[P_CMDS] & P_CMDS_NATIVE)
+	{
+		c->native++;
+		return 0;
+	}
+
+	t = &c->t[idx - 1];
+	if((len < t->minLen) || ((t->rows == t->cap) && (columns_grow(t) < 0)))
+	{
+		c->skipped++;
+		return 0;
+	}
+
+	row = t->rows;
+	t->key[row] = key;
+	t->xid[row] = payload[P_XID];
+	for(i = 0; i < t->fields; i++)
+	{
+		//Constant sizes: memcpy() becomes a single load & store
+		switch(COLUMNS_SIZE(t->type[i]))
+		{
+			case 1:
+				((uint8_t *)t->col[i])[row] = payload[t->offset[i]];
+				break;
+			case 2:
+				memcpy(&((uint16_t *)t->col[i])[row], &payload[t->offset[i]], 2);
+				break;
+			default:
+				memcpy(&((uint32_t *)t->col[i])[row], &payload[t->offset[i]], 4);
+				break;
+		}
+	}
+
+	t->rows++;
+	c->rows++;
+	if((t->rows - t->converted) >= COLUMNS_BATCH)
+	{
+		columns_convert(t);
+	}
+
+	return 1;
+}
+
+//flexsea_bulk callback: b->ctx is the columns_s, the key is the frame offset
+void columns_bulk_callback(struct bulk_s *b, struct bulk_frame_s *f)
+{
+	columns_add((struct columns_s *)b->ctx, f->payload, f->payloadLen, f->offset);
+}
+
+struct columns_table_s *columns_table(struct columns_s *c, uint8_t cmd)
+{
+	if((cmd > 0x7F) || (c->lookup[cmd] == 0))
+	{
+		return NULL;
+	}
+
+	return &c->t[c->lookup[cmd] - 1];
+}
+
+//Converts the last rows. Call it before reading the columns.
+void columns_finish(struct columns_s *c)
+{
+	uint8_t i = 0;
+
+	for(i = 0; i < c->tables; i++)
+	{
+		columns_convert(&c->t[i]);
+	}
+}
+
+//Returns 0, or -1 (errno)
+int columns_write(struct columns_s *c, const char *path)
+{
+	struct columns_file_hdr_s fh;
+	struct columns_table_hdr_s th;
+	struct columns_col_hdr_s ch;
+	struct columns_table_s *t = NULL;
+	const void *data = NULL;
+	uint64_t off = 0, end = 0;
+	uint8_t i = 0, j = 0, size = 0;
+	FILE *f = NULL;
+	int ret = 0;
+
+	columns_finish(c);
+	f = fopen(path, "wb");
+	if(f == NULL)
+	{
+		return -1;
+	}
+
+	memset(&fh, 0, sizeof(fh));
+	fh.magic = COLUMNS_MAGIC;
+	fh.version = COLUMNS_VERSION;
+	fh.tables = c->tables;
+	ret |= columns_put(f, &fh, sizeof(fh));
+
+	//Headers, then the data:
+	off = sizeof(fh);
+	for(i = 0; i < c->tables; i++)
+	{
+		off += sizeof(th) + (2 + c->t[i].fields) * sizeof(ch);
+	}
+
+	for(i = 0; i < c->tables; i++)
+	{
+		t = &c->t[i];
+		memset(&th, 0, sizeof(th));
+		th.cmd = t->cmd;
+		th.columns = 2 + t->fields;
+		th.rows = t->rows;
+		ret |= columns_put(f, &th, sizeof(th));
+
+		for(j = 0; j < th.columns; j++)
+		{
+			size = columns_col(t, j, &ch, &data);
+			off = COLUMNS_ALIGN_UP(off);
+			ch.data = off;
+			off += t->rows * size;
+			ret |= columns_put(f, &ch, sizeof(ch));
+		}
+	}
+
+	end = (uint64_t)ftell(f);
+	for(i = 0; i < c->tables; i++)
+	{
+		t = &c->t[i];
+		for(j = 0; j < (2 + t->fields); j++)
+		{
+			size = columns_col(t, j, &ch, &data);
+			while(end < COLUMNS_ALIGN_UP(end))
+			{
+				ret |= (fputc(0, f) == EOF) ? -1 : 0;
+				end++;
+			}
+			ret |= columns_put(f, data, t->rows * size);
+			end += t->rows * size;
+		}
+	}
+
+	if(fclose(f) != 0)
+	{
+		ret = -1;
+	}
+
+	return ret;
+}
+
+void columns_free(struct columns_s *c)
+{
+	struct columns_table_s *t = NULL;
+	uint8_t i = 0, j = 0;
+
+	for(i = 0; i < c->tables; i++)
+	{
+		t = &c->t[i];
+		free(t->key);
+		free(t->xid);
+		for(j = 0; j < t->fields; j++)
+		{
+			free(t->col[j]);
+		}
+	}
+	columns_init(c);
+}
+
+//Maps a columns file. Returns NULL if it isn't one (errno).
+uint8_t *columns_map(const char *path, uint64_t *len)
+{
+	struct columns_file_hdr_s *hdr = NULL;
+	uint8_t *map = NULL;
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if(fd < 0)
+	{
+		return NULL;
+	}
+
+	if((fstat(fd, &st) < 0) || ((uint64_t)st.st_size < sizeof(*hdr)))
+	{
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	map = (uint8_t *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		return NULL;
+	}
+
+	hdr = (struct columns_file_hdr_s *)map;
+	if((hdr->magic != COLUMNS_MAGIC) || (hdr->version != COLUMNS_VERSION))
+	{
+		munmap(map, (size_t)st.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	*len = (uint64_t)st.st_size;
+	return map;
+}
+
+void columns_unmap(uint8_t *map, uint64_t len)
+{
+	munmap(map, (size_t)len);
+}
+
+//Values of column 'name' of command 'cmd', in place. NULL if it isn't there.
+const void *columns_find(uint8_t *map, uint64_t len, uint8_t cmd, \
+						const char *name, uint8_t *type, uint64_t *rows)
+{
+	struct columns_file_hdr_s *fh = (struct columns_file_hdr_s *)map;
+	struct columns_table_hdr_s *th = NULL;
+	struct columns_col_hdr_s *ch = NULL;
+	uint64_t off = sizeof(*fh);
+	uint16_t i = 0;
+	uint8_t j = 0;
+
+	for(i = 0; i < fh->tables; i++)
+	{
+		if((off + sizeof(*th)) > len)
+		{
+			return NULL;
+		}
+		th = (struct columns_table_hdr_s *)&map[off];
+		off += sizeof(*th);
+		if((off + (uint64_t)th->columns * sizeof(*ch)) > len)
+		{
+			return NULL;
+		}
+
+		for(j = 0; (j < th->columns) && (th->cmd == cmd); j++)
+		{
+			ch = (struct columns_col_hdr_s *)&map[off + j * sizeof(*ch)];
+			if((strncmp(ch->name, name, COLUMNS_NAME_LEN) != 0) || \
+				((ch->data + th->rows * COLUMNS_SIZE(ch->type)) > len))
+			{
+				continue;
+			}
+
+			if(type)
+			{
+				*type = ch->type;
+			}
+			*rows = th->rows;
+			return &map[ch->data];
+		}
+		off += (uint64_t)th->columns * sizeof(*ch);
+	}
+
+	return NULL;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Doubles the room of every column. Returns 0, or -1.
+static int columns_grow(struct columns_table_s *t)
+{
+	uint64_t cap = MAX(COLUMNS_ROWS_MIN, 2 * t->cap);
+	void *p = NULL;
+	uint8_t i = 0;
+
+	p = realloc(t->key, cap * sizeof(uint64_t));
+	if(p == NULL)
+	{
+		return -1;
+	}
+	t->key = (uint64_t *)p;
+
+	p = realloc(t->xid, cap);
+	if(p == NULL)
+	{
+		return -1;
+	}
+	t->xid = (uint8_t *)p;
+
+	for(i = 0; i < t->fields; i++)
+	{
+		p = realloc(t->col[i], cap * COLUMNS_SIZE(t->type[i]));
+		if(p == NULL)
+		{
+			return -1;
+		}
+		t->col[i] = p;
+	}
+
+	t->cap = cap;
+	return 0;
+}
+
+//Big endian to host, from 'converted' to 'rows'
+static void columns_convert(struct columns_table_s *t)
+{
+	uint64_t n = t->rows - t->converted;
+	uint8_t i = 0;
+
+	for(i = 0; (i < t->fields) && COLUMNS_SWAP; i++)
+	{
+		if(COLUMNS_SIZE(t->type[i]) == 2)
+		{
+			columns_swap16(&((uint16_t *)t->col[i])[t->converted], n);
+		}
+		else if(COLUMNS_SIZE(t->type[i]) == 4)
+		{
+			columns_swap32(&((uint32_t *)t->col[i])[t->converted], n);
+		}
+	}
+
+	t->converted = t->rows;
+}
+
+static void columns_swap16(uint16_t *v, uint64_t n)
+{
+	uint64_t i = 0;
+
+	for(i = 0; i < n; i++)
+	{
+		v[i] = __builtin_bswap16(v[i]);
+	}
+}
+
+static void columns_swap32(uint32_t *v, uint64_t n)
+{
+	uint64_t i = 0;
+
+	for(i = 0; i < n; i++)
+	{
+		v[i] = __builtin_bswap32(v[i]);
+	}
+}
+
+//Column 'i' of a table: key, xid, then the fields. Returns its value size.
+static uint8_t columns_col(struct columns_table_s *t, uint8_t i, \
+							struct columns_col_hdr_s *h, const void **data)
+{
+	memset(h, 0, sizeof(struct columns_col_hdr_s));
+	h->offset = COLUMNS_NO_OFFSET;
+	if(i == 0)
+	{
+		strcpy(h->name, COLUMNS_KEY);
+		h->type = COLUMNS_U64;
+		*data = t->key;
+	}
+	else if(i == 1)
+	{
+		strcpy(h->name, COLUMNS_XID);
+		h->type = COLUMNS_U8;
+		*data = t->xid;
+	}
+	else
+	{
+		memcpy(h->name, t->name[i - 2], COLUMNS_NAME_LEN);
+		h->type = t->type[i - 2];
+		h->offset = t->offset[i - 2];
+		*data = t->col[i - 2];
+	}
+
+	return COLUMNS_SIZE(h->type);
+}
+
+static int columns_put(FILE *f, const void *data, uint64_t len)
+{
+	if(len == 0)
+	{
+		return 0;
+	}
+
+	return (fwrite(data, 1, (size_t)len, f) == len) ? 0 : -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
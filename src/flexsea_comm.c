@@ -38,6 +38,13 @@ extern "C" {
 //=> Number of bytes includes the ESCAPE bytes
 //=> Checksum is done on the payload (data + ESCAPEs) and on the BYTES byte.
 
+//Fast framing (FRAMING_FAST, boundary preserving ports only):
+//===========================================================
+//[SYNC_H][SYNC_L][LEN_H][LEN_L][HCRC][DATA...]
+//=> LEN is the number of DATA bytes, no escaping
+//=> HCRC is a CRC-8 of the 4 previous bytes
+//=> Use comm_set_framing(port, FRAMING_FAST) on both ends of the link
+
 //To transmit a message:
 //======================
 // 1) Place the payload in an array (no header, no footer: pure data)
@@ -55,6 +62,15 @@ extern "C" {
 //    comm_str_payload buffer and do something with the data!
 // 4) At this point you might want to flush the read payload from rx_buf
 
+//Statistics:
+//===========
+// Per port counters (frames, bytes, errors) are in flexsea_stats. The _port
+// functions and unpack_payload_rx() count on their port, the others on
+// COMM_STATS_NO_PORT. cmd_valid and cmd_bad_checksum are the totals.
+// commSpy1 (last escaped frame) is deprecated and goes away next release.
+// With ENABLE_FLEXSEA_CAPTURE, the frames built and found here also go to
+// captureTap (see flexsea_capture).
+
 //****************************************************************************
 // Include(s)
 //****************************************************************************
@@ -62,6 +78,10 @@ extern "C" {
 #include <string.h>
 #include <stdlib.h>
 #include "../inc/flexsea.h"
+#include "../inc/flexsea_buffers.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_capture.h"
+#include "../inc/flexsea_arq.h"
 #include "flexsea_board.h"
 #include "flexsea_system.h"
 
@@ -102,13 +122,42 @@ uint32_t cmd_bad_checksum = 0;
 struct comm_s slaveComm[COMM_SLAVE_BUS];
 struct comm_s masterComm[COMM_MASTERS];
 
-struct commSpy_s commSpy1 = {0,0,0,0,0,0,0};
+struct commSpy_s commSpy1 = {0,0,0,0,0,0,0};	//Deprecated
+
+//Framing mode used by each port. All ports default to FRAMING_ESCAPED:
+static uint8_t comm_framing[NUMBER_OF_PORTS];
+
+//Framing each port switches to at the first valid frame received with it
+//(see comm_set_framing_next()). Same as comm_framing[] when there's none:
+static uint8_t comm_framing_next[NUMBER_OF_PORTS];
+
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+//RID filter, per port and for the port-less calls (COMM_STATS_NO_PORT). Off
+//by default:
+static uint8_t comm_rid_filter[NUMBER_OF_PORTS + 1];
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+//Transmit function for each port:
+void (*flexsea_port_send_ptr[NUMBER_OF_PORTS])(uint8_t *str, uint16_t len);
 
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************
 
-static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN]);
+static uint8_t comm_escape_str(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+								uint8_t bytes);
+static uint16_t comm_fast_str(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+								uint16_t bytes);
+static int16_t unpack_fast(uint8_t port, uint8_t *buf, uint16_t len, \
+							uint8_t **payload);
+static int8_t unpack_payload(uint8_t port, uint8_t *buf, uint32_t len, \
+							uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN], uint32_t *keep);
+static uint8_t comm_escape_state(uint8_t *buf, uint32_t from, uint32_t to, \
+									uint8_t escaped);
+static uint8_t crc8(uint8_t *buf, uint32_t len);
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+static uint8_t comm_rid_foreign(uint8_t port, uint8_t *data, uint32_t bytes);
+#endif	//ENABLE_FLEXSEA_RID_FILTER
 
 //****************************************************************************
 // Public Function(s)
@@ -117,65 +166,183 @@ static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN
 //Takes payload, adds ESCAPES, checksum, header, ...
 uint8_t comm_gen_str(uint8_t payload[], uint8_t *cstr, uint8_t bytes)
 {
-	unsigned int i = 0, escapes = 0, idx = 0, total_bytes = 0;
-	uint8_t checksum = 0;
+	return comm_escape_str(COMM_STATS_NO_PORT, payload, cstr, bytes);
+}
 
-	//Fill comm_str with known values ('a')
-	memset(cstr, 0xAA, COMM_STR_BUF_LEN);
+//Fast framing: sync word, length and header CRC, then the raw payload.
+//Returns the index of the last byte of the message (add 1 for the length),
+//0 if it doesn't fit in FAST_FRAME_MAX_LEN
+uint16_t comm_gen_str_fast(uint8_t payload[], uint8_t *cstr, uint16_t bytes)
+{
+	return comm_fast_str(COMM_STATS_NO_PORT, payload, cstr, bytes);
+}
+
+//Decodes one escaped frame located at the start of 'buf', when something
+//else already delimits the frames (datagram, DMA transfer): no HEADER hunt.
+//The payload is de-escaped in 'payload' (PACKAGED_PAYLOAD_LEN bytes).
+//Returns the length of the frame, UNPACK_ERR_x if it's not a valid one.
+int16_t unpack_payload_frame(uint8_t *buf, uint16_t len, uint8_t *payload)
+{
+	uint32_t i = 0, idx = 0, bytes = 0;
+	uint8_t checksum = 0, skip = 0;
+
+	if((len < 4) || (buf[0] != HEADER))
+	{
+		return UNPACK_ERR_HEADER;
+	}
+
+	bytes = buf[1];
+	if((bytes + 4) > len)
+	{
+		COMM_STAT_ADD(COMM_STATS_NO_PORT, badLength, 1);
+		return UNPACK_ERR_LEN;
+	}
+
+	if(buf[bytes + 3] != FOOTER)
+	{
+		COMM_STAT_ADD(COMM_STATS_NO_PORT, badFooter, 1);
+		return UNPACK_ERR_FOOTER;
+	}
 
-	//Fill comm_str with payload and add ESCAPE characters
-	escapes = 0;
-	idx = 2;
 	for(i = 0; i < bytes; i++)
 	{
-		if ((payload[i] == HEADER) || (payload[i] == FOOTER) || (payload[i] == ESCAPE))
+		checksum += buf[2 + i];
+	}
+
+	if(checksum != buf[2 + bytes])
+	{
+		cmd_bad_checksum++;
+		COMM_STAT_ADD(COMM_STATS_NO_PORT, badChecksum, 1);
+		#ifdef ENABLE_FLEXSEA_CAPTURE
+		CAPTURE_TAP(CAPTURE_RX_FRAME, COMM_STATS_NO_PORT, UNPACK_ERR_CHECKSUM, \
+					buf, bytes + 4);
+		#endif	//ENABLE_FLEXSEA_CAPTURE
+		return UNPACK_ERR_CHECKSUM;
+	}
+
+	for(i = 2; i < (bytes + 2); i++)
+	{
+		if(((buf[i] == HEADER) || (buf[i] == FOOTER) || (buf[i] == ESCAPE)) && \
+			skip == 0)
 		{
-			escapes = escapes + 1;
-			cstr[idx] = ESCAPE;
-			cstr[idx+1] = payload[i];
-			idx = idx + 1;
+			skip = 1;
 		}
 		else
 		{
-			cstr[idx] = payload[i];
+			skip = 0;
+			if(idx < PACKAGED_PAYLOAD_LEN)
+			{
+				payload[idx++] = buf[i];
+			}
 		}
-		idx++;
 	}
 
-	total_bytes = bytes + escapes;
+	cmd_valid++;
+	COMM_STAT_ADD(COMM_STATS_NO_PORT, framesDecoded, 1);
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	CAPTURE_TAP(CAPTURE_RX_FRAME, COMM_STATS_NO_PORT, 1, buf, bytes + 4);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+	return (int16_t)(bytes + 4);
+}
 
-	commSpy1.bytes = bytes;
-	commSpy1.escapes = (uint8_t) escapes;
-	commSpy1.total_bytes = (uint8_t) total_bytes;
-	commSpy1.error++;
+//Uses the framing selected for 'port'. Same return value as comm_gen_str()
+uint16_t comm_gen_str_port(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+							uint16_t bytes)
+{
+	if(comm_get_framing(port) == FRAMING_FAST)
+	{
+		return comm_fast_str(port, payload, cstr, bytes);
+	}
 
-	//String length?
-	if(total_bytes >= COMM_STR_BUF_LEN)
+	if(bytes > 0xFF)
 	{
-		//Too long, abort:
-		memset(cstr, 0, COMM_STR_BUF_LEN);	//Clear string
-		commSpy1.retVal = 0;
+		memset(cstr, 0, COMM_STR_BUF_LEN);
+		COMM_STAT_ADD(port, overruns, 1);
 		return 0;
 	}
 
-	//Checksum:
-	checksum = 0;
-	for (i = 0; i < total_bytes; i++)
+	return comm_escape_str(port, payload, cstr, (uint8_t)bytes);
+}
+
+//Selects the framing used by comm_gen_str_port() and unpack_payload_port()
+void comm_set_framing(uint8_t port, uint8_t framing)
+{
+	if(port < NUMBER_OF_PORTS)
 	{
-		checksum = checksum + cstr[2+i];
+		comm_framing[port] = framing;
+		comm_framing_next[port] = framing;
 	}
+}
 
-	commSpy1.checksum = checksum;
+uint8_t comm_get_framing(uint8_t port)
+{
+	if(port < NUMBER_OF_PORTS)
+	{
+		return comm_framing[port];
+	}
 
-	//Build comm_str:
-	cstr[0] = HEADER;
-	cstr[1] = total_bytes;
-	cstr[2 + total_bytes] = checksum;
-	cstr[3 + total_bytes] = FOOTER;
+	return FRAMING_ESCAPED;
+}
 
-	//Return the length of the valid data
-	commSpy1.retVal = 3 + (uint8_t)total_bytes;
-	return (3 + total_bytes);
+//Switch 'port' to 'framing' at the first valid frame received in that format.
+//Until then unpack_payload_port() decodes both, and comm_gen_str_port() keeps
+//using the current framing. Only FRAMING_FAST can be pending (its sync word
+//tells the two apart).
+void comm_set_framing_next(uint8_t port, uint8_t framing)
+{
+	if(port < NUMBER_OF_PORTS)
+	{
+		comm_framing_next[port] = framing;
+	}
+}
+
+uint8_t comm_get_framing_next(uint8_t port)
+{
+	if(port < NUMBER_OF_PORTS)
+	{
+		return comm_framing_next[port];
+	}
+
+	return FRAMING_ESCAPED;
+}
+
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+
+//On a shared bus, frames for the other boards are skipped by unpack_payload()
+//once their checksum is confirmed: no de-escaping, no copy to rx_cmd (noise
+//that only looks framed is never removed past the next HEADER). Frames
+//for this board, its master and its slaves (see payload_rid_match()) are
+//decoded as usual. COMM_STATS_NO_PORT: unpack_payload_N() & co.
+void comm_set_rid_filter(uint8_t port, uint8_t on)
+{
+	comm_rid_filter[COMM_STATS_IDX(port)] = on;
+}
+
+uint8_t comm_get_rid_filter(uint8_t port)
+{
+	return comm_rid_filter[COMM_STATS_IDX(port)];
+}
+
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+//Sends a comm_str on 'port' with the board's driver. Returns 1 if it was
+//handed to the driver, 0 if that port has no transmit function.
+uint8_t comm_port_send(uint8_t port, uint8_t *str, uint16_t len)
+{
+	if((port >= NUMBER_OF_PORTS) || (flexsea_port_send_ptr[port] == NULL))
+	{
+		return 0;
+	}
+
+	(*flexsea_port_send_ptr[port])(str, len);
+	COMM_STAT_ADD(port, bytesOut, len);
+	return 1;
+}
+
+//CRC-8 of the fast framing header, for the other short headers
+uint8_t comm_crc8(uint8_t *buf, uint32_t len)
+{
+	return crc8(buf, len);
 }
 
 //To avoid sharing buffers in multiple files we use specific functions:
@@ -183,42 +350,119 @@ uint8_t comm_gen_str(uint8_t payload[], uint8_t *cstr, uint8_t bytes)
 #ifdef ENABLE_FLEXSEA_BUF_1
 int8_t unpack_payload_1(void)
 {
-	return unpack_payload(rx_buf_1, rx_command_1);
+	return unpack_payload(COMM_STATS_NO_PORT, rx_buf_1, RX_BUF_LEN, \
+							rx_command_1, NULL);
 }
 #endif	//ENABLE_FLEXSEA_BUF_1
 
 #ifdef ENABLE_FLEXSEA_BUF_2
 int8_t unpack_payload_2(void)
 {
-	return unpack_payload(rx_buf_2, rx_command_2);
+	return unpack_payload(COMM_STATS_NO_PORT, rx_buf_2, RX_BUF_LEN, \
+							rx_command_2, NULL);
 }
 #endif	//ENABLE_FLEXSEA_BUF_2
 
 #ifdef ENABLE_FLEXSEA_BUF_3
 int8_t unpack_payload_3(void)
 {
-	return unpack_payload(rx_buf_3, rx_command_3);
+	return unpack_payload(COMM_STATS_NO_PORT, rx_buf_3, RX_BUF_LEN, \
+							rx_command_3, NULL);
 }
 #endif	//ENABLE_FLEXSEA_BUF_3
 
 #ifdef ENABLE_FLEXSEA_BUF_4
 int8_t unpack_payload_4(void)
 {
-	return unpack_payload(rx_buf_4, rx_command_4);
+	return unpack_payload(COMM_STATS_NO_PORT, rx_buf_4, RX_BUF_LEN, \
+							rx_command_4, NULL);
 }
 #endif	//ENABLE_FLEXSEA_BUF_4
 
 #ifdef ENABLE_FLEXSEA_BUF_5
 int8_t unpack_payload_5(void)
 {
-	return unpack_payload(rx_buf_5, rx_command_5);
+	return unpack_payload(COMM_STATS_NO_PORT, rx_buf_5, RX_BUF_LEN, \
+							rx_command_5, NULL);
 }
 #endif	//ENABLE_FLEXSEA_BUF_5
 
+//Generic version, for buffers that aren't in the list above (struct rx_buf_s)
+int8_t unpack_payload_buf(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN])
+{
+	return unpack_payload(COMM_STATS_NO_PORT, buf, RX_BUF_LEN, rx_cmd, NULL);
+}
+
+//Same, the statistics go to the buffer's port. Only the rb->idx bytes
+//received are searched, and what's before the first frame that can still
+//be completed is dropped from the buffer (it's counted as discarded).
+int8_t unpack_payload_rx(struct rx_buf_s *rb, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN])
+{
+	uint32_t keep = 0;
+	int8_t ret = 0;
+
+	ret = unpack_payload(rb->port, rb->buf, rb->idx, rx_cmd, &keep);
+	discard_rx_buf_s(rb, keep);
+
+	return ret;
+}
+
 //Special wrapper for unit test code:
 int8_t unpack_payload_test(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN])
 {
-	return unpack_payload(buf, rx_cmd);
+	return unpack_payload(COMM_STATS_NO_PORT, buf, RX_BUF_LEN, rx_cmd, NULL);
+}
+
+//Decodes one fast frame located at the start of 'buf' (ex.: a DMA buffer).
+//Nothing is copied: on success 'payload' points inside 'buf' and the
+//number of payload bytes is returned. Returns UNPACK_ERR_x otherwise.
+int16_t unpack_payload_fast(uint8_t *buf, uint16_t len, uint8_t **payload)
+{
+	return unpack_fast(COMM_STATS_NO_PORT, buf, len, payload);
+}
+
+//Uses the framing selected for 'port'. Same return value as the
+//unpack_payload_N() functions. With FRAMING_ESCAPED 'buf' has to be
+//RX_BUF_LEN bytes long ('len' is ignored). While FRAMING_FAST is pending
+//(comm_set_framing_next()), a frame that starts with the sync word is
+//decoded as a fast one, and the first valid one makes the switch.
+int8_t unpack_payload_port(uint8_t port, uint8_t *buf, uint16_t len, \
+							uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN])
+{
+	int16_t bytes = 0;
+	uint8_t *payload = NULL;
+	uint8_t pending = 0;
+
+	if(comm_get_framing(port) != FRAMING_FAST)
+	{
+		pending = ((comm_get_framing_next(port) == FRAMING_FAST) && \
+					(len >= FAST_HEADER_LEN) && (buf[0] == FAST_SYNC_H) && \
+					(buf[1] == FAST_SYNC_L));
+		if(!pending)
+		{
+			return unpack_payload(port, buf, RX_BUF_LEN, rx_cmd, NULL);
+		}
+	}
+
+	bytes = unpack_fast(port, buf, len, &payload);
+	if(bytes < 0)
+	{
+		return (int8_t)bytes;
+	}
+
+	if(pending)
+	{
+		comm_set_framing(port, FRAMING_FAST);
+	}
+
+	if(bytes > PACKAGED_PAYLOAD_LEN)
+	{
+		COMM_STAT_ADD(port, overruns, 1);
+		return UNPACK_ERR_LEN;
+	}
+
+	memcpy(rx_cmd[0], payload, bytes);
+	return 1;
 }
 
 void initRandomGenerator(int seed)
@@ -246,33 +490,193 @@ void generateRandomUint8Array(uint8_t *arr, uint8_t size)
 // Private Function(s)
 //****************************************************************************
 
+//Body of comm_gen_str_fast(), counted on 'port'
+static uint16_t comm_fast_str(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+								uint16_t bytes)
+{
+	if((FAST_HEADER_LEN + (uint32_t)bytes) > FAST_FRAME_MAX_LEN)
+	{
+		//Too long, abort:
+		COMM_STAT_ADD(port, overruns, 1);
+		return 0;
+	}
+
+	cstr[0] = FAST_SYNC_H;
+	cstr[1] = FAST_SYNC_L;
+	cstr[2] = (uint8_t) ((bytes >> 8) & 0xFF);
+	cstr[3] = (uint8_t) (bytes & 0xFF);
+	cstr[4] = crc8(cstr, 4);
+	memcpy(&cstr[FAST_HEADER_LEN], payload, bytes);
+
+	COMM_STAT_ADD(port, framesEncoded, 1);
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	CAPTURE_TAP(CAPTURE_TX_FRAME, port, 0, cstr, FAST_HEADER_LEN + bytes);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+	return (FAST_HEADER_LEN - 1 + bytes);
+}
+
+//Body of comm_gen_str(), counted on 'port'
+static uint8_t comm_escape_str(uint8_t port, uint8_t payload[], uint8_t *cstr, \
+								uint8_t bytes)
+{
+	unsigned int i = 0, escapes = 0, idx = 0, total_bytes = 0;
+	uint8_t checksum = 0;
+
+	//Fill comm_str with known values ('a')
+	memset(cstr, 0xAA, COMM_STR_BUF_LEN);
+
+	//Fill comm_str with payload and add ESCAPE characters
+	escapes = 0;
+	idx = 2;
+	for(i = 0; i < bytes; i++)
+	{
+		if ((payload[i] == HEADER) || (payload[i] == FOOTER) || (payload[i] == ESCAPE))
+		{
+			escapes = escapes + 1;
+			cstr[idx] = ESCAPE;
+			cstr[idx+1] = payload[i];
+			idx = idx + 1;
+		}
+		else
+		{
+			cstr[idx] = payload[i];
+		}
+		idx++;
+	}
+
+	total_bytes = bytes + escapes;
+
+	commSpy1.bytes = bytes;
+	commSpy1.escapes = (uint8_t) escapes;
+	commSpy1.total_bytes = (uint8_t) total_bytes;
+	commSpy1.error++;
+
+	//String length?
+	if(total_bytes >= COMM_STR_BUF_LEN)
+	{
+		//Too long, abort:
+		memset(cstr, 0, COMM_STR_BUF_LEN);	//Clear string
+		commSpy1.retVal = 0;
+		COMM_STAT_ADD(port, overruns, 1);
+		return 0;
+	}
+
+	//Checksum:
+	checksum = 0;
+	for (i = 0; i < total_bytes; i++)
+	{
+		checksum = checksum + cstr[2+i];
+	}
+
+	commSpy1.checksum = checksum;
+
+	//Build comm_str:
+	cstr[0] = HEADER;
+	cstr[1] = total_bytes;
+	cstr[2 + total_bytes] = checksum;
+	cstr[3 + total_bytes] = FOOTER;
+
+	COMM_STAT_ADD(port, framesEncoded, 1);
+	COMM_STAT_ADD(port, escapes, escapes);
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	CAPTURE_TAP(CAPTURE_TX_FRAME, port, 0, cstr, 4 + total_bytes);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	//Return the length of the valid data
+	commSpy1.retVal = 3 + (uint8_t)total_bytes;
+	return (3 + total_bytes);
+}
+
+//Body of unpack_payload_fast(), counted on 'port'
+static int16_t unpack_fast(uint8_t port, uint8_t *buf, uint16_t len, \
+							uint8_t **payload)
+{
+	uint16_t bytes = 0;
+
+	if((len < FAST_HEADER_LEN) || (buf[0] != FAST_SYNC_H) || \
+		(buf[1] != FAST_SYNC_L))
+	{
+		return UNPACK_ERR_HEADER;
+	}
+
+	if(crc8(buf, 4) != buf[4])
+	{
+		cmd_bad_checksum++;
+		COMM_STAT_ADD(port, badChecksum, 1);
+		#ifdef ENABLE_FLEXSEA_CAPTURE
+		CAPTURE_TAP(CAPTURE_RX_FRAME, port, UNPACK_ERR_CHECKSUM, buf, FAST_HEADER_LEN);
+		#endif	//ENABLE_FLEXSEA_CAPTURE
+		return UNPACK_ERR_CHECKSUM;
+	}
+
+	bytes = BYTES_TO_UINT16(buf[2], buf[3]);
+	if(((uint32_t)bytes + FAST_HEADER_LEN) > len)
+	{
+		COMM_STAT_ADD(port, badLength, 1);
+		return UNPACK_ERR_LEN;
+	}
+
+	cmd_valid++;
+	COMM_STAT_ADD(port, framesDecoded, 1);
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	CAPTURE_TAP(CAPTURE_RX_FRAME, port, 1, buf, FAST_HEADER_LEN + bytes);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+	*payload = &buf[FAST_HEADER_LEN];
+	return (int16_t)bytes;
+}
+
 //New version of comm_decode_str
 //Take a buffer as an argument, returns the number of decoded payload packets
 //ToDo: The error codes are not always right, but if it's < 0 you know it didn't
 //find a valid string
-static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN])
+//Frame starts: every HEADER, except the ones that can't be. Decoded frames
+//are skipped as a whole, and inside a frame that isn't complete (yet) an
+//escaped HEADER (ESCAPE, HEADER) is data.
+//Only the first 'len' bytes of 'buf' are searched, jumping from one HEADER
+//to the next. If 'keep' isn't NULL, it's set to the number of bytes (from the
+//start of buf) that can't be part of a frame anymore.
+static int8_t unpack_payload(uint8_t port, uint8_t *buf, uint32_t len, \
+							uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN], uint32_t *keep)
 {
 	uint32_t i = 0, j = 0, k = 0, idx = 0, h = 0;
 	uint32_t bytes = 0, possible_footer = 0, possible_footer_pos = 0;
-	uint8_t checksum = 0, skip = 0, payload_strings = 0;
+	uint32_t spanEnd = 0, pending = len;
+	uint8_t *next = NULL;
+	uint8_t checksum = 0, skip = 0, payload_strings = 0, escaped = 0;
 	uint8_t rx_buf_tmp[RX_BUF_LEN];
 	uint8_t foundHeader = 0;
 	int8_t tmpRetVal = 0;
 
 	memset(rx_buf_tmp, 0, RX_BUF_LEN);
 
-	for(i = 0; i < (RX_BUF_LEN - 2); i++)
+	//Stops when rx_cmd is full, the other strings stay in buf for the next call
+	for(i = 0; (i < len) && (payload_strings < PAYLOAD_BUFFERS); i++)
 	{
-		if(buf[i] == HEADER)
+		if(buf[i] != HEADER)
+		{
+			//Straight to the next HEADER
+			next = (uint8_t *)memchr(&buf[i], HEADER, len - i);
+			if(next == NULL)
+			{
+				i = len;
+				break;
+			}
+			h = (uint32_t)(next - buf);
+			escaped = comm_escape_state(buf, i, h, escaped);
+			i = h;
+		}
+
+		if(!(escaped && (i < spanEnd)))
 		{
 			foundHeader++;
-			bytes = buf[i+1];
+			bytes = ((i + 1) < len) ? buf[i+1] : 0;
 			possible_footer_pos = i+3+bytes;
 
-			if(possible_footer_pos <= RX_BUF_LEN)
+			if(possible_footer_pos < len)
 			{
 				//We have enough bytes for a full string
 				possible_footer = buf[possible_footer_pos];
+
 				if(possible_footer == FOOTER)
 				{
 					//Correctly framed string
@@ -291,6 +695,21 @@ static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN
 						checksum = checksum + rx_buf_tmp[2+k];
 					}
 
+					#ifdef ENABLE_FLEXSEA_RID_FILTER
+					if((checksum == rx_buf_tmp[2+bytes]) && \
+						comm_rid_filter[COMM_STATS_IDX(port)] && \
+						comm_rid_foreign(port, &buf[i+2], bytes))
+					{
+						//Someone else's (the checksum says it's a frame, not
+						//noise with a FOOTER in the right place): removed,
+						//and we move on to the next one
+						memset(&buf[i], 0, possible_footer_pos - i + 1);
+						COMM_STAT_ADD(port, filtered, 1);
+						i = possible_footer_pos;
+						continue;
+					}
+					#endif	//ENABLE_FLEXSEA_RID_FILTER
+
 					if(checksum == rx_buf_tmp[2+bytes])
 					{
 						//Now we de-escap and de-frame to get the payload
@@ -307,46 +726,84 @@ static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN
 							else
 							{
 								skip = 0;
-								rx_cmd[payload_strings][idx] = rx_buf_tmp[k];
-								idx++;
+								if(idx < PACKAGED_PAYLOAD_LEN)
+								{
+									rx_cmd[payload_strings][idx] = rx_buf_tmp[k];
+									idx++;
+								}
 							}
 						}
 
 						//At this point we have extracted a valid string
 						payload_strings++;
 						cmd_valid++;
-
-						//Remove the string to avoid double detection
+						COMM_STAT_ADD(port, framesDecoded, 1);
+						#ifdef ENABLE_FLEXSEA_CAPTURE
+						CAPTURE_TAP(CAPTURE_RX_FRAME, port, 1, rx_buf_tmp, \
+									possible_footer_pos - i + 1);
+						#endif	//ENABLE_FLEXSEA_CAPTURE
+
+						//Remove the string to avoid double detection, and
+						//continue after it
 						for(h = i; h <= possible_footer_pos; h++)
 						{
 							buf[h] = 0;
 						}
+						i = possible_footer_pos;
 
 						tmpRetVal = payload_strings;
 					}
 					else
 					{
-						//Remove the string to avoid double detection
-						for(h = i; h <= possible_footer_pos; h++)
+						//Remove the bytes up to the next HEADER: a real frame
+						//can start inside this one
+						for(h = i; (h <= possible_footer_pos) && \
+							((h == i) || (buf[h] != HEADER)); h++)
 						{
 							buf[h] = 0;
 						}
 
 						cmd_bad_checksum++;
+						COMM_STAT_ADD(port, badChecksum, 1);
+						COMM_STAT_ADD(port, discarded, h - i);
+						#ifdef ENABLE_FLEXSEA_CAPTURE
+						CAPTURE_TAP(CAPTURE_RX_FRAME, port, UNPACK_ERR_CHECKSUM, \
+									rx_buf_tmp, possible_footer_pos - i + 1);
+						#endif	//ENABLE_FLEXSEA_CAPTURE
 
 						tmpRetVal = UNPACK_ERR_CHECKSUM;
+						i = h - 1;
 					}
 				}
 				else
 				{
+					//Maybe not complete yet (nothing received where the
+					//FOOTER goes): its escaped HEADERs are data
+					if((possible_footer == 0) && (possible_footer_pos >= spanEnd))
+					{
+						spanEnd = possible_footer_pos + 1;
+					}
 					tmpRetVal = UNPACK_ERR_FOOTER;
 				}
 			}
 			else
 			{
+				//Same thing, up to the end of the buffer
+				spanEnd = len;
+				if(i < pending)
+				{
+					pending = i;
+				}
 				tmpRetVal = UNPACK_ERR_LEN;
 			}
 		}
+
+		escaped = 0;
+	}
+
+	if(keep != NULL)
+	{
+		*keep = MIN(pending, i);
 	}
 
 	if(payload_strings > 0)
@@ -370,6 +827,93 @@ static int8_t unpack_payload(uint8_t *buf, uint8_t rx_cmd[][PACKAGED_PAYLOAD_LEN
 	return 0;
 }
 
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+
+//Byte that needs (or is) an ESCAPE
+#define COMM_ESCAPED(b)			(((b) == HEADER) || ((b) == FOOTER) || ((b) == ESCAPE))
+
+//Escaped data of a frame ('bytes' bytes): 1 if its RID is none of ours.
+//Every byte up to the RID can be preceded by an ESCAPE. With ARQ on that
+//port the payload follows the ARQ header, and frames without a payload
+//(ACK, NAK) are for the ARQ layer: decoded as usual.
+static uint8_t comm_rid_foreign(uint8_t port, uint8_t *data, uint32_t bytes)
+{
+	uint32_t k = 0, n = 0, before = P_RID;
+
+	//[SEQ][ACK] then [FLAGS]:
+	if(arq_is_enabled(port))
+	{
+		before += ARQ_HEADER_LEN;
+		for(n = 0; (n < ARQ_FLAGS) && (k < bytes); n++)
+		{
+			k += (COMM_ESCAPED(data[k]) ? 2 : 1);
+		}
+		k += ((k < bytes) && COMM_ESCAPED(data[k])) ? 1 : 0;
+		if((k >= bytes) || !(data[k] & ARQ_FLAG_DATA))
+		{
+			return 0;
+		}
+		k++;
+		n++;
+	}
+
+	//Skips what's before the RID (XID):
+	for(; (n < before) && (k < bytes); n++)
+	{
+		k += (COMM_ESCAPED(data[k]) ? 2 : 1);
+	}
+	k += ((k < bytes) && COMM_ESCAPED(data[k])) ? 1 : 0;
+
+	if(k >= bytes)
+	{
+		//Too short to tell, decoded as usual
+		return 0;
+	}
+
+	return ((payload_rid_match(data[k]) == ID_NO_MATCH) ? 1 : 0);
+}
+
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
+//Escape state after buf[from] ... buf[to - 1], 'escaped' being the state
+//before buf[from]: each ESCAPE escapes the next byte, unless it's escaped
+static uint8_t comm_escape_state(uint8_t *buf, uint32_t from, uint32_t to, \
+									uint8_t escaped)
+{
+	uint32_t n = 0;
+
+	while((to > from) && (buf[to - 1] == ESCAPE))
+	{
+		to--;
+		n++;
+	}
+
+	if(to > from)
+	{
+		escaped = 0;
+	}
+
+	return (uint8_t)(escaped ^ (n & 1));
+}
+
+//CRC-8, polynomial 0x07. Used on the short fast framing header.
+static uint8_t crc8(uint8_t *buf, uint32_t len)
+{
+	uint32_t i = 0, j = 0;
+	uint8_t crc = 0;
+
+	for(i = 0; i < len; i++)
+	{
+		crc ^= buf[i];
+		for(j = 0; j < 8; j++)
+		{
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,436 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_corr: request correlation & timeouts
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Tracks the requests waiting for a reply, by (port, slave, command).
+//Insert, match and cancel are O(1): a hash table finds the request, and
+//its timeout sits in a hashed timer wheel (CORR_WHEEL_SIZE slots of one
+//tick, the slot is 'expires' modulo the wheel size). corr_advance() only
+//looks at the slots of the ticks that went by, not at every request.
+//Timeouts longer than a turn simply stay in their slot for more turns.
+//One request per (port, slave, command) at a time: a second one couldn't
+//be told apart from the first. With c.fifo set, they are answered oldest
+//first instead (for masters that know their slaves reply in order).
+//It's the only matcher: flexsea_pipeline, flexsea_tdma and flexsea_async
+//register their requests here with their own callback (corr_req_s.done),
+//so one table and one corr_receive() can serve all of them.
+// 1) corr_init(&c, timeout, &callback), or corr_init_pool() for a table
+//    that isn't CORR_MAX_PENDING long
+// 2) corr_track(&c, port, payload, now) when a Read goes out
+// 3) Decoded payloads go to corr_receive() instead of payload_parse_str()
+// 4) corr_advance(&c, now) in the main loop, or at every tick
+//The callback gets every request exactly once, replied or timed out.
+//Per slave RTTs are in c.slave[], see corr_rtt_mean().
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_corr.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_hist.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint16_t corr_hash(uint8_t port, uint8_t rid, uint8_t cmd);
+static uint16_t corr_lookup(struct corr_s *c, uint8_t port, uint8_t rid, \
+							uint8_t cmd);
+static void corr_unlink(struct corr_s *c, uint16_t i);
+static void corr_free(struct corr_s *c, uint16_t i);
+static void corr_complete(struct corr_s *c, uint16_t i, uint8_t *payload);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void corr_init(struct corr_s *c, uint32_t timeout, corr_cb_t callback)
+{
+	corr_init_pool(c, NULL, 0, timeout, callback);
+}
+
+//Same, with the caller's table of 'size' requests (at most CORR_MAX_POOL).
+//NULL: c->pool.
+void corr_init_pool(struct corr_s *c, struct corr_req_s *pool, uint16_t size, \
+					uint32_t timeout, corr_cb_t callback)
+{
+	uint16_t i = 0;
+
+	memset(c, 0, sizeof(struct corr_s));
+	c->timeout = MAX(timeout, 1);
+	c->callback = callback;
+	c->req = (pool ? pool : c->pool);
+	c->size = (pool ? MIN(size, CORR_MAX_POOL) : CORR_MAX_PENDING);
+
+	memset(c->req, 0, c->size * sizeof(struct corr_req_s));
+	memset(c->bucket, 0xFF, sizeof(c->bucket));
+	memset(c->wheel, 0xFF, sizeof(c->wheel));
+	for(i = 0; i < c->size; i++)
+	{
+		c->req[i].hnext = ((i + 1 < c->size) ? i + 1 : CORR_NONE);
+	}
+	c->freeList = (c->size ? 0 : CORR_NONE);
+}
+
+//Starts tracking a request. 'timeout' in ticks, 0 for c->timeout. Returns
+//it (set 'done' and 'user' if you need to), NULL if the table is full or
+//the same request is already pending (and c->fifo is 0).
+struct corr_req_s *corr_insert(struct corr_s *c, uint8_t port, uint8_t rid, \
+								uint8_t cmd, uint32_t now, uint32_t timeout)
+{
+	struct corr_req_s *r = NULL;
+	uint16_t i = c->freeList, h = 0, w = 0;
+
+	if((i == CORR_NONE) || (!c->fifo && (corr_lookup(c, port, rid, cmd) != CORR_NONE)))
+	{
+		c->refused++;
+		return NULL;
+	}
+
+	//Nothing in the wheel, it can jump to now:
+	if(c->pending == 0)
+	{
+		c->tick = now;
+	}
+
+	r = &c->req[i];
+	c->freeList = r->hnext;
+
+	r->port = port;
+	r->rid = rid;
+	r->cmd = cmd;
+	r->state = CORR_PENDING;
+	r->sentAt = now;
+	r->expires = now + (timeout ? timeout : c->timeout);
+	r->rtt = 0;
+	r->done = NULL;
+	r->user = NULL;
+
+	//Slots up to c->tick are done, it has to be after:
+	if((int32_t)(r->expires - c->tick) <= 0)
+	{
+		r->expires = c->tick + 1;
+	}
+
+	h = corr_hash(port, rid, cmd);
+	r->hprev = CORR_NONE;
+	r->hnext = c->bucket[h];
+	if(r->hnext != CORR_NONE)
+	{
+		c->req[r->hnext].hprev = i;
+	}
+	c->bucket[h] = i;
+
+	w = r->expires & (CORR_WHEEL_SIZE - 1);
+	r->wprev = CORR_NONE;
+	r->wnext = c->wheel[w];
+	if(r->wnext != CORR_NONE)
+	{
+		c->req[r->wnext].wprev = i;
+	}
+	c->wheel[w] = i;
+
+	c->pending++;
+	c->inserted++;
+
+	return r;
+}
+
+//corr_insert() for the Read in 'payload', with the default timeout
+struct corr_req_s *corr_track(struct corr_s *c, uint8_t port, uint8_t *payload, \
+								uint32_t now)
+{
+	return corr_insert(c, port, payload[P_RID], CMD_7BITS(payload[P_CMD1]), now, 0);
+}
+
+//Pending request (the oldest one), NULL if there is none
+struct corr_req_s *corr_find(struct corr_s *c, uint8_t port, uint8_t rid, \
+								uint8_t cmd)
+{
+	uint16_t i = corr_lookup(c, port, rid, cmd);
+	return ((i != CORR_NONE) ? &c->req[i] : NULL);
+}
+
+//Stops tracking a request, without callback. Returns 1 if it was pending.
+uint8_t corr_cancel(struct corr_s *c, uint8_t port, uint8_t rid, uint8_t cmd)
+{
+	uint16_t i = corr_lookup(c, port, rid, cmd);
+
+	if(i == CORR_NONE)
+	{
+		return 0;
+	}
+
+	corr_unlink(c, i);
+	corr_free(c, i);
+	return 1;
+}
+
+//corr_cancel() of that very request (from corr_insert()), when others can
+//have the same key
+uint8_t corr_remove(struct corr_s *c, struct corr_req_s *r)
+{
+	uint16_t i = (uint16_t)(r - c->req);
+
+	if((i >= c->size) || (r->state != CORR_PENDING))
+	{
+		return 0;
+	}
+
+	corr_unlink(c, i);
+	corr_free(c, i);
+	return 1;
+}
+
+//Is 'payload' (received on 'port') the reply to a pending request? If so,
+//the callback gets it and 1 is returned.
+uint8_t corr_reply(struct corr_s *c, uint8_t port, uint8_t *payload, uint32_t now)
+{
+	struct corr_rtt_s *s = NULL;
+	uint16_t i = corr_lookup(c, port, payload[P_XID], CMD_7BITS(payload[P_CMD1]));
+
+	if(i == CORR_NONE)
+	{
+		c->unmatched++;
+		return 0;
+	}
+
+	corr_unlink(c, i);
+	c->req[i].state = CORR_DONE;
+	c->req[i].rtt = now - c->req[i].sentAt;
+
+	s = &c->slave[c->req[i].rid];
+	s->last = c->req[i].rtt;
+	s->min = (s->replies ? MIN(s->min, s->last) : s->last);
+	s->max = MAX(s->max, s->last);
+	s->sum += s->last;
+	s->replies++;
+	c->completed++;
+	#ifdef ENABLE_FLEXSEA_HIST
+	hist_latency(HIST_STAGE_RTT, port, c->req[i].cmd, s->last);
+	#endif	//ENABLE_FLEXSEA_HIST
+
+	corr_complete(c, i, payload);
+	return 1;
+}
+
+//Times out the requests that expired by 'now'. Returns how many.
+uint16_t corr_advance(struct corr_s *c, uint32_t now)
+{
+	uint32_t ticks = now - c->tick, t = 0;
+	uint16_t i = 0, next = 0, expired = CORR_NONE, cnt = 0;
+
+	if((int32_t)ticks <= 0)
+	{
+		return 0;
+	}
+
+	//More than a turn: every slot, once
+	ticks = MIN(ticks, CORR_WHEEL_SIZE);
+
+	//Collects them first; the callbacks can insert and cancel requests
+	for(t = 1; (t <= ticks) && c->pending; t++)
+	{
+		i = c->wheel[(c->tick + t) & (CORR_WHEEL_SIZE - 1)];
+		while(i != CORR_NONE)
+		{
+			next = c->req[i].wnext;
+			if((int32_t)(c->req[i].expires - now) <= 0)
+			{
+				corr_unlink(c, i);
+				c->req[i].state = CORR_TIMEOUT;
+				c->req[i].wnext = expired;
+				expired = i;
+			}
+			i = next;
+		}
+	}
+	c->tick = now;
+
+	while(expired != CORR_NONE)
+	{
+		i = expired;
+		expired = c->req[i].wnext;
+
+		c->slave[c->req[i].rid].timeouts++;
+		c->timeouts++;
+		corr_complete(c, i, NULL);
+		cnt++;
+	}
+
+	return cnt;
+}
+
+//No request times out before '*tick': call corr_advance() then. Returns 0
+//if nothing is pending.
+uint8_t corr_next(struct corr_s *c, uint32_t *tick)
+{
+	uint32_t t = 0;
+
+	if(c->pending == 0)
+	{
+		return 0;
+	}
+
+	//First slot with something in it (could be for a later turn):
+	for(t = 1; t < CORR_WHEEL_SIZE; t++)
+	{
+		if(c->wheel[(c->tick + t) & (CORR_WHEEL_SIZE - 1)] != CORR_NONE)
+		{
+			break;
+		}
+	}
+
+	*tick = c->tick + t;
+	return 1;
+}
+
+//Use instead of payload_parse_str() for what comes back. Returns 1 if it
+//answered one of our requests.
+uint8_t corr_receive(struct corr_s *c, uint8_t *payload, uint8_t *info, \
+						uint32_t now)
+{
+	uint8_t matched = 0;
+
+	if(packetType(payload) == RX_PTYPE_REPLY)
+	{
+		matched = corr_reply(c, info[0], payload, now);
+	}
+
+	payload_parse_str(payload, info);
+	return matched;
+}
+
+//Average RTT of a slave, in ticks
+uint32_t corr_rtt_mean(struct corr_s *c, uint8_t rid)
+{
+	struct corr_rtt_s *s = &c->slave[rid];
+	return (s->replies ? (uint32_t)(s->sum / s->replies) : 0);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static uint16_t corr_hash(uint8_t port, uint8_t rid, uint8_t cmd)
+{
+	uint32_t key = ((uint32_t)port << 16) | ((uint32_t)rid << 8) | cmd;
+	return (uint16_t)((key * 2654435761u) >> (32 - CORR_HASH_BITS));
+}
+
+//Oldest match: requests go in at the head of their bucket
+static uint16_t corr_lookup(struct corr_s *c, uint8_t port, uint8_t rid, \
+							uint8_t cmd)
+{
+	uint16_t i = c->bucket[corr_hash(port, rid, cmd)], found = CORR_NONE;
+
+	while(i != CORR_NONE)
+	{
+		if((c->req[i].rid == rid) && (c->req[i].cmd == cmd) && \
+			(c->req[i].port == port))
+		{
+			found = i;
+			if(!c->fifo)
+			{
+				break;
+			}
+		}
+		i = c->req[i].hnext;
+	}
+
+	return found;
+}
+
+//Out of its bucket and wheel slot
+static void corr_unlink(struct corr_s *c, uint16_t i)
+{
+	struct corr_req_s *r = &c->req[i];
+
+	if(r->hprev != CORR_NONE)
+	{
+		c->req[r->hprev].hnext = r->hnext;
+	}
+	else
+	{
+		c->bucket[corr_hash(r->port, r->rid, r->cmd)] = r->hnext;
+	}
+	if(r->hnext != CORR_NONE)
+	{
+		c->req[r->hnext].hprev = r->hprev;
+	}
+
+	if(r->wprev != CORR_NONE)
+	{
+		c->req[r->wprev].wnext = r->wnext;
+	}
+	else
+	{
+		c->wheel[r->expires & (CORR_WHEEL_SIZE - 1)] = r->wnext;
+	}
+	if(r->wnext != CORR_NONE)
+	{
+		c->req[r->wnext].wprev = r->wprev;
+	}
+
+	c->pending--;
+}
+
+static void corr_free(struct corr_s *c, uint16_t i)
+{
+	c->req[i].state = CORR_FREE;
+	c->req[i].hnext = c->freeList;
+	c->freeList = i;
+}
+
+//Callback (the request's own, or the table's), then back in the free list
+static void corr_complete(struct corr_s *c, uint16_t i, uint8_t *payload)
+{
+	corr_cb_t cb = (c->req[i].done ? c->req[i].done : c->callback);
+
+	if(cb)
+	{
+		cb(c, &c->req[i], payload);
+	}
+
+	corr_free(c, i);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,531 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_frag: fragmentation and reassembly of messages larger
+	than one payload (sliding window, NAKs)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//How to use it:
+//==============
+// - init_flexsea_frag() once at boot, after the system init (it registers
+//   the CMD_FRAG handlers). frag_config() if the defaults don't fit.
+// - Sender: frag_send(port, rid, data, len, done, now). The message is sent
+//   FRAG_DATA_BYTES at a time, up to 'window' fragments ahead of the last
+//   acknowledgment, without waiting for a reply to each of them. 'data'
+//   has to stay valid until done() is called. Any data fits, even when
+//   every byte needs an ESCAPE.
+// - Receiver: frag_receive_into(port, buf, size, done). The fragments are
+//   copied in place in 'buf', done() is called once they are all there.
+//   A gap is NAKed right away, and the sender resends what's missing.
+// - Both ends: call frag_poll() periodically (new fragments, timeouts,
+//   delayed ACKs). Fragments received between two calls use the 'now' of
+//   the last one. Use the same window on both ends.
+//'now' is any free running tick counter, 'rto' uses the same unit.
+//One message at a time per port and per direction.
+
+//Payload:
+//[P_XID][P_RID][P_CMDS][P_CMD1][TYPE][MSG][SEQ_H][SEQ_L][LEN][DATA...]
+//ACK/NAK: SEQ is the next fragment expected, LEN is the number of SEQ_H,
+//SEQ_L pairs that follow (missing fragments, NAK only).
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_frag.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct frag_s commFrag[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t frag_header(uint8_t *buf, uint8_t rid, uint8_t type, uint8_t msg, \
+							uint16_t seq, uint8_t len);
+static uint8_t frag_send_payload(uint8_t port, uint8_t *buf, uint8_t bytes);
+static uint8_t frag_send_data(uint8_t port, uint16_t seq);
+static void frag_send_status(uint8_t port);
+static void frag_push(uint8_t port);
+static void frag_rx_data(uint8_t port, uint8_t *buf);
+static void frag_rx_status(uint8_t port, uint8_t *buf);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Call once at boot, after the system init (it registers the handlers)
+void init_flexsea_frag(void)
+{
+	uint8_t i = 0;
+
+	memset(commFrag, 0, sizeof(commFrag));
+	for(i = 0; i < NUMBER_OF_PORTS; i++)
+	{
+		frag_config(i, 0, 0);
+	}
+
+	//Fragments and acknowledgments are Writes (Replies when they come from
+	//a slave):
+	flexsea_payload_ptr[CMD_FRAG][RX_PTYPE_READ] = &flexsea_payload_catchall;
+	flexsea_payload_ptr[CMD_FRAG][RX_PTYPE_WRITE] = &rx_cmd_frag;
+	flexsea_payload_ptr[CMD_FRAG][RX_PTYPE_REPLY] = &rx_cmd_frag;
+}
+
+//rto = 0: FRAG_DEFAULT_RTO. window = 0 (or too large): FRAG_WINDOW.
+//window = 1 is stop-and-wait.
+void frag_config(uint8_t port, uint32_t rto, uint8_t window)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	commFrag[port].rto = (rto ? rto : FRAG_DEFAULT_RTO);
+	commFrag[port].window = ((window && (window <= FRAG_WINDOW)) ? \
+								window : FRAG_WINDOW);
+}
+
+//Starts sending 'len' bytes to 'rid'. Returns 0 if a message is already
+//being sent on that port, or if it's too long.
+uint8_t frag_send(uint8_t port, uint8_t rid, uint8_t *data, uint32_t len, \
+					void (*done)(uint8_t port, uint8_t state), uint32_t now)
+{
+	struct frag_tx_s *t = NULL;
+
+	if((port >= NUMBER_OF_PORTS) || (len > FRAG_MAX_LEN) || \
+		(commFrag[port].tx.state == FRAG_BUSY))
+	{
+		return 0;
+	}
+
+	t = &commFrag[port].tx;
+	t->state = FRAG_BUSY;
+	t->msg++;
+	t->rid = rid;
+	t->data = data;
+	t->len = len;
+	t->count = (uint16_t)((len + FRAG_DATA_BYTES - 1) / FRAG_DATA_BYTES);
+	if(t->count == 0)
+	{
+		//An empty message is one empty fragment
+		t->count = 1;
+	}
+	t->base = 0;
+	t->next = 0;
+	t->retries = 0;
+	t->ackAt = now;
+	t->done = done;
+
+	commFrag[port].now = now;
+	frag_push(port);
+
+	return 1;
+}
+
+//The next message received on 'port' goes in 'buf'. done() is called when
+//it's complete (with its length).
+void frag_receive_into(uint8_t port, uint8_t *buf, uint32_t size, \
+						void (*done)(uint8_t port, uint8_t *buf, uint32_t len))
+{
+	struct frag_rx_s *r = NULL;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	r = &commFrag[port].rx;
+	r->state = FRAG_IDLE;
+	r->buf = buf;
+	r->size = size;
+	r->len = 0;
+	r->done = done;
+}
+
+//New fragments, retransmissions and delayed acknowledgments
+void frag_poll(uint8_t port, uint32_t now)
+{
+	struct frag_s *f = NULL;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	f = &commFrag[port];
+	f->now = now;
+
+	if(f->tx.state == FRAG_BUSY)
+	{
+		frag_push(port);
+
+		if((f->tx.base != f->tx.next) && ((now - f->tx.ackAt) >= f->rto))
+		{
+			if(f->tx.retries >= FRAG_MAX_RETRIES)
+			{
+				//Give up:
+				f->tx.state = FRAG_FAILED;
+				if(f->tx.done)
+				{
+					f->tx.done(port, FRAG_FAILED);
+				}
+			}
+			else
+			{
+				//Nothing heard in a while: the oldest one is the one that's
+				//missing, or our ACK was lost. Either way, the receiver
+				//replies.
+				f->tx.retries++;
+				f->tx.ackAt = now;
+				f->tx.resent++;
+				frag_send_data(port, f->tx.base);
+			}
+		}
+	}
+
+	if(f->rx.ackPending && ((now - f->rx.ackSince) >= (f->rto / 2)))
+	{
+		frag_send_status(port);
+	}
+}
+
+//CMD_FRAG handler (Write and Reply). info[0] is the port.
+void rx_cmd_frag(uint8_t *buf, uint8_t *info)
+{
+	uint8_t port = info[0];
+	uint8_t type = buf[P_DATA1 + FRAG_TYPE];
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	if((type == FRAG_TYPE_DATA) || (type == FRAG_TYPE_LAST))
+	{
+		frag_rx_data(port, buf);
+	}
+	else if((type == FRAG_TYPE_ACK) || (type == FRAG_TYPE_NAK))
+	{
+		frag_rx_status(port, buf);
+	}
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Prepares a CMD_FRAG payload in 'buf'. Returns the index of the first data
+//byte.
+static uint8_t frag_header(uint8_t *buf, uint8_t rid, uint8_t type, uint8_t msg, \
+							uint16_t seq, uint8_t len)
+{
+	uint16_t index = P_DATA1;
+
+	prepare_empty_payload(board_id, rid, buf, PAYLOAD_BUF_LEN);
+	buf[P_CMDS] = 1;
+	buf[P_CMD1] = CMD_W(CMD_FRAG);
+
+	buf[index++] = type;
+	buf[index++] = msg;
+	SPLIT_16(seq, buf, &index);
+	buf[index++] = len;
+
+	return (uint8_t)index;
+}
+
+static uint8_t frag_send_payload(uint8_t port, uint8_t *buf, uint8_t bytes)
+{
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	uint16_t last = 0;
+
+	last = comm_gen_str_port(port, buf, cstr, bytes);
+	if(last == 0)
+	{
+		return 0;
+	}
+
+	return comm_port_send(port, cstr, last + 1);
+}
+
+//Fragment 'seq' of the message being sent, straight from the caller's data
+static uint8_t frag_send_data(uint8_t port, uint16_t seq)
+{
+	struct frag_tx_s *t = &commFrag[port].tx;
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint32_t offset = (uint32_t)seq * FRAG_DATA_BYTES;
+	uint8_t n = 0, index = 0;
+
+	n = (uint8_t)MIN(FRAG_DATA_BYTES, t->len - offset);
+	index = frag_header(buf, t->rid, ((seq + 1) == t->count) ? FRAG_TYPE_LAST : \
+						FRAG_TYPE_DATA, t->msg, seq, n);
+	memcpy(&buf[index], &t->data[offset], n);
+
+	return frag_send_payload(port, buf, index + n);
+}
+
+//ACK, or NAK with the fragments missing before the last one received
+static void frag_send_status(uint8_t port)
+{
+	struct frag_rx_s *r = &commFrag[port].rx;
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint16_t index = 0, seq = 0;
+	uint8_t i = 0, n = 0;
+
+	index = frag_header(buf, r->xid, FRAG_TYPE_ACK, r->msg, r->next, 0);
+	for(i = 0; (i < 32) && ((r->mask >> i) != 0) && (n < FRAG_NAK_MAX); i++)
+	{
+		if(!(r->mask & (1UL << i)))
+		{
+			seq = (uint16_t)(r->next + i);
+			SPLIT_16(seq, buf, &index);
+			n++;
+		}
+	}
+
+	if(n)
+	{
+		buf[P_DATA1 + FRAG_TYPE] = FRAG_TYPE_NAK;
+		buf[P_DATA1 + FRAG_LEN] = n;
+		r->naks++;
+	}
+	r->sinceAck = 0;
+	r->ackPending = 0;
+
+	frag_send_payload(port, buf, (uint8_t)index);
+}
+
+//Sends new fragments, as long as the window allows it
+static void frag_push(uint8_t port)
+{
+	struct frag_s *f = &commFrag[port];
+	struct frag_tx_s *t = &f->tx;
+
+	while((t->state == FRAG_BUSY) && (t->next < t->count) && \
+			((uint16_t)(t->next - t->base) < f->window))
+	{
+		if(t->base == t->next)
+		{
+			//Nothing was in flight, the timeout starts now
+			t->ackAt = f->now;
+		}
+
+		if(!frag_send_data(port, t->next))
+		{
+			//Try again at the next frag_poll()
+			break;
+		}
+
+		t->next++;
+		t->sent++;
+	}
+}
+
+//Copies the fragment in place. Acknowledges every window / 2 fragments, at
+//the end of the message, or right away when there's a gap.
+static void frag_rx_data(uint8_t port, uint8_t *buf)
+{
+	struct frag_s *f = &commFrag[port];
+	struct frag_rx_s *r = &f->rx;
+	uint16_t index = P_DATA1 + FRAG_SEQ;
+	uint16_t seq = 0, offset = 0;
+	uint8_t msg = buf[P_DATA1 + FRAG_MSG];
+	uint8_t n = buf[P_DATA1 + FRAG_LEN];
+	uint32_t at = 0;
+
+	if(r->buf == NULL)
+	{
+		//Not ready to receive
+		r->dropped++;
+		return;
+	}
+
+	seq = REBUILD_UINT16(buf, &index);
+
+	if((r->state == FRAG_IDLE) || (msg != r->msg))
+	{
+		//New message:
+		r->state = FRAG_BUSY;
+		r->msg = msg;
+		r->xid = buf[P_XID];
+		r->len = 0;
+		r->next = 0;
+		r->count = 0;
+		r->mask = 0;
+		r->nakSent = 0;
+		r->sinceAck = 0;
+		r->ackPending = 0;
+	}
+
+	if(r->state != FRAG_BUSY)
+	{
+		//Done already, our last ACK was lost. Failed: let the sender give up.
+		if(r->state == FRAG_DONE)
+		{
+			r->duplicates++;
+			frag_send_status(port);
+		}
+		return;
+	}
+
+	offset = (uint16_t)(seq - r->next);
+	if(seq < r->next)
+	{
+		//Already received, tell the sender where we are
+		r->duplicates++;
+		frag_send_status(port);
+		return;
+	}
+
+	if(offset >= FRAG_WINDOW)
+	{
+		r->dropped++;
+		return;
+	}
+
+	at = (uint32_t)seq * FRAG_DATA_BYTES;
+	if((n > FRAG_DATA_BYTES) || ((at + n) > r->size))
+	{
+		//Doesn't fit:
+		r->state = FRAG_FAILED;
+		return;
+	}
+
+	if(r->mask & (1UL << offset))
+	{
+		r->duplicates++;
+		return;
+	}
+
+	memcpy(&r->buf[at], &buf[P_DATA1 + FRAG_HEADER_LEN], n);
+	r->mask |= (1UL << offset);
+	if(buf[P_DATA1 + FRAG_TYPE] == FRAG_TYPE_LAST)
+	{
+		r->count = (uint16_t)(seq + 1);
+		r->len = at + n;
+	}
+	r->sinceAck++;
+
+	while(r->mask & 1)
+	{
+		r->mask >>= 1;
+		r->next++;
+		r->nakSent = 0;
+	}
+
+	if(r->count && (r->next == r->count))
+	{
+		r->state = FRAG_DONE;
+		frag_send_status(port);
+		if(r->done)
+		{
+			r->done(port, r->buf, r->len);
+		}
+		return;
+	}
+
+	if(r->mask && !r->nakSent)
+	{
+		//Gap: ask for what's missing now
+		r->nakSent = 1;
+		frag_send_status(port);
+	}
+	else if(r->sinceAck >= ((f->window + 1) / 2))
+	{
+		frag_send_status(port);
+	}
+	else if(!r->ackPending)
+	{
+		r->ackPending = 1;
+		r->ackSince = f->now;
+	}
+}
+
+//Cumulative ACK, and the fragments to resend (NAK)
+static void frag_rx_status(uint8_t port, uint8_t *buf)
+{
+	struct frag_s *f = &commFrag[port];
+	struct frag_tx_s *t = &f->tx;
+	uint16_t index = P_DATA1 + FRAG_SEQ;
+	uint16_t next = 0, seq = 0;
+	uint8_t n = 0, i = 0;
+
+	if((t->state != FRAG_BUSY) || (buf[P_DATA1 + FRAG_MSG] != t->msg))
+	{
+		return;
+	}
+
+	next = REBUILD_UINT16(buf, &index);
+	if((next > t->base) && (next <= t->next))
+	{
+		t->base = next;
+		t->retries = 0;
+		t->ackAt = f->now;
+	}
+
+	if(t->base == t->count)
+	{
+		t->state = FRAG_DONE;
+		if(t->done)
+		{
+			t->done(port, FRAG_DONE);
+		}
+		return;
+	}
+
+	if(buf[P_DATA1 + FRAG_TYPE] == FRAG_TYPE_NAK)
+	{
+		index = P_DATA1 + FRAG_HEADER_LEN;
+		n = MIN(buf[P_DATA1 + FRAG_LEN], FRAG_NAK_MAX);
+		for(i = 0; i < n; i++)
+		{
+			seq = REBUILD_UINT16(buf, &index);
+			if((seq >= t->base) && (seq < t->next))
+			{
+				t->resent++;
+				frag_send_data(port, seq);
+			}
+		}
+	}
+
+	frag_push(port);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,344 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_hist: latency histograms
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Fixed size log-linear (HDR style) histograms: hist_record() is a few
+//shifts and one increment, the percentiles are within 1/HIST_SUB of the
+//real value.
+//With ENABLE_FLEXSEA_HIST, three latencies are recorded per port, and per
+//command for the ones passed to hist_track_cmd():
+// - HIST_STAGE_RX: first byte received => frame decoded. The RX driver calls
+//   hist_rx_byte(port) when bytes come in (once per frame is enough), and
+//   hist_rx_frame() when a frame is decoded. flexsea_transport does both.
+//   Frames decoded from the same burst count once.
+// - HIST_STAGE_DISPATCH: hist_rx_frame() => handler, by payload_parse_str()
+// - HIST_STAGE_RTT: from flexsea_corr, in its ticks
+// 1) hist_set_clock(&myTimer) (same units for everything, ex.: us)
+// 2) hist_track_cmd(CMD_x) for the commands you want to see separately
+// 3) hist_snapshot_port() / hist_snapshot_cmd() to read (and reset) them
+//Recording isn't atomic: take the snapshots from the context that records,
+//or with the RX interrupts off.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_hist.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+#ifdef ENABLE_FLEXSEA_HIST
+
+static uint32_t (*histClock)(void) = NULL;
+
+static struct hist_s histPort[NUMBER_OF_PORTS][HIST_STAGES];
+static struct hist_s histCmd[HIST_MAX_CMDS][HIST_STAGES];
+static uint8_t histCmdSlot[MAX_CMD_CODE + 1];	//Slot + 1, 0 if not tracked
+static uint8_t histCmdCnt = 0;
+
+//Timestamps, per port:
+static uint32_t histRxAt[NUMBER_OF_PORTS];
+static uint32_t histFrameAt[NUMBER_OF_PORTS];
+static uint8_t histRxArmed[NUMBER_OF_PORTS];
+static uint8_t histFrameArmed[NUMBER_OF_PORTS];
+
+#endif	//ENABLE_FLEXSEA_HIST
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t hist_msb(uint32_t value);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void hist_init(struct hist_s *h)
+{
+	memset(h, 0, sizeof(struct hist_s));
+}
+
+void hist_record(struct hist_s *h, uint32_t value)
+{
+	h->bucket[hist_bucket(value)]++;
+	h->min = (h->count ? MIN(h->min, value) : value);
+	h->max = MAX(h->max, value);
+	h->sum += value;
+	h->count++;
+}
+
+//Adds 'src' to 'dst'
+void hist_merge(struct hist_s *dst, struct hist_s *src)
+{
+	uint16_t i = 0;
+
+	if(src->count == 0)
+	{
+		return;
+	}
+
+	for(i = 0; i < HIST_BUCKETS; i++)
+	{
+		dst->bucket[i] += src->bucket[i];
+	}
+	dst->min = (dst->count ? MIN(dst->min, src->min) : src->min);
+	dst->max = MAX(dst->max, src->max);
+	dst->sum += src->sum;
+	dst->count += src->count;
+}
+
+//Value below which 'permille' / 1000 of the samples are. This is the top
+//of their bucket, so it's never under the real value.
+uint32_t hist_percentile(struct hist_s *h, uint16_t permille)
+{
+	uint64_t rank = 0, seen = 0;
+	uint16_t i = 0;
+
+	if(h->count == 0)
+	{
+		return 0;
+	}
+
+	rank = ((uint64_t)h->count * MIN(permille, 1000) + 999) / 1000;
+	rank = MAX(rank, 1);
+	for(i = 0; i < HIST_BUCKETS; i++)
+	{
+		seen += h->bucket[i];
+		if(seen >= rank)
+		{
+			return MIN(hist_bucket_high(i), h->max);
+		}
+	}
+
+	return h->max;
+}
+
+uint32_t hist_mean(struct hist_s *h)
+{
+	return (h->count ? (uint32_t)(h->sum / h->count) : 0);
+}
+
+uint16_t hist_bucket(uint32_t value)
+{
+	uint8_t msb = 0;
+
+	if(value < HIST_SUB)
+	{
+		return (uint16_t)value;
+	}
+
+	msb = hist_msb(value);
+	return (uint16_t)(((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + \
+			((value >> (msb - HIST_SUB_BITS)) & (HIST_SUB - 1)));
+}
+
+//Smallest value that goes in 'bucket'
+uint32_t hist_bucket_low(uint16_t bucket)
+{
+	uint16_t group = bucket >> HIST_SUB_BITS, sub = bucket & (HIST_SUB - 1);
+	return (group ? ((uint32_t)(HIST_SUB + sub) << (group - 1)) : sub);
+}
+
+//Largest value that goes in 'bucket'
+uint32_t hist_bucket_high(uint16_t bucket)
+{
+	uint16_t group = bucket >> HIST_SUB_BITS;
+	return hist_bucket_low(bucket) + (group ? ((1UL << (group - 1)) - 1) : 0);
+}
+
+#ifdef ENABLE_FLEXSEA_HIST
+
+//Time source for hist_rx_byte(), hist_rx_frame() and hist_dispatch().
+//Nothing is recorded until it's set.
+void hist_set_clock(uint32_t (*clock)(void))
+{
+	histClock = clock;
+}
+
+//Gives a command (7-bit code) its own histograms. Returns 0 when the
+//HIST_MAX_CMDS slots are taken.
+uint8_t hist_track_cmd(uint8_t cmd)
+{
+	if(cmd > MAX_CMD_CODE)
+	{
+		return 0;
+	}
+
+	if(histCmdSlot[cmd] == 0)
+	{
+		if(histCmdCnt >= HIST_MAX_CMDS)
+		{
+			return 0;
+		}
+
+		histCmdSlot[cmd] = ++histCmdCnt;
+	}
+
+	return 1;
+}
+
+//Records a latency measured elsewhere
+void hist_latency(uint8_t stage, uint8_t port, uint8_t cmd, uint32_t ticks)
+{
+	if(stage >= HIST_STAGES)
+	{
+		return;
+	}
+
+	if(port < NUMBER_OF_PORTS)
+	{
+		hist_record(&histPort[port][stage], ticks);
+	}
+	if((cmd <= MAX_CMD_CODE) && histCmdSlot[cmd])
+	{
+		hist_record(&histCmd[histCmdSlot[cmd] - 1][stage], ticks);
+	}
+}
+
+//Bytes came in. Only the first call after a frame counts.
+void hist_rx_byte(uint8_t port)
+{
+	if(histClock && (port < NUMBER_OF_PORTS) && !histRxArmed[port])
+	{
+		histRxAt[port] = histClock();
+		histRxArmed[port] = 1;
+	}
+}
+
+//A frame was decoded ('cmd': 7-bit code, or any byte > MAX_CMD_CODE)
+void hist_rx_frame(uint8_t port, uint8_t cmd)
+{
+	uint32_t now = 0;
+
+	if(!histClock || (port >= NUMBER_OF_PORTS))
+	{
+		return;
+	}
+
+	now = histClock();
+	if(histRxArmed[port])
+	{
+		hist_latency(HIST_STAGE_RX, port, cmd, now - histRxAt[port]);
+		histRxArmed[port] = 0;
+	}
+
+	histFrameAt[port] = now;
+	histFrameArmed[port] = 1;
+}
+
+//The handler of a frame is about to be called
+void hist_dispatch(uint8_t port, uint8_t cmd)
+{
+	if(histClock && (port < NUMBER_OF_PORTS) && histFrameArmed[port])
+	{
+		hist_latency(HIST_STAGE_DISPATCH, port, cmd, histClock() - histFrameAt[port]);
+		histFrameArmed[port] = 0;
+	}
+}
+
+//Copies a histogram in 'out', and clears it if 'reset'. Returns 0 if
+//there is no such histogram.
+uint8_t hist_snapshot_port(uint8_t port, uint8_t stage, struct hist_s *out, \
+							uint8_t reset)
+{
+	if((port >= NUMBER_OF_PORTS) || (stage >= HIST_STAGES))
+	{
+		return 0;
+	}
+
+	memcpy(out, &histPort[port][stage], sizeof(struct hist_s));
+	if(reset)
+	{
+		hist_init(&histPort[port][stage]);
+	}
+
+	return 1;
+}
+
+uint8_t hist_snapshot_cmd(uint8_t cmd, uint8_t stage, struct hist_s *out, \
+							uint8_t reset)
+{
+	if((cmd > MAX_CMD_CODE) || !histCmdSlot[cmd] || (stage >= HIST_STAGES))
+	{
+		return 0;
+	}
+
+	memcpy(out, &histCmd[histCmdSlot[cmd] - 1][stage], sizeof(struct hist_s));
+	if(reset)
+	{
+		hist_init(&histCmd[histCmdSlot[cmd] - 1][stage]);
+	}
+
+	return 1;
+}
+
+//Clears every histogram. The tracked commands stay.
+void hist_reset_all(void)
+{
+	memset(histPort, 0, sizeof(histPort));
+	memset(histCmd, 0, sizeof(histCmd));
+	memset(histRxArmed, 0, sizeof(histRxArmed));
+	memset(histFrameArmed, 0, sizeof(histFrameArmed));
+}
+
+#endif	//ENABLE_FLEXSEA_HIST
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Position of the highest bit set ('value' > 0)
+static uint8_t hist_msb(uint32_t value)
+{
+	#ifdef __GNUC__
+	return (uint8_t)(31 - __builtin_clz(value));
+	#else
+	uint8_t msb = 0;
+	while(value >>= 1)
+	{
+		msb++;
+	}
+	return msb;
+	#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,347 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_link: link capability negotiation
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//Capability exchange:
+//====================
+// 1) Master calls link_request_caps(port, slave_id). The Read carries the
+//    master's capabilities and is sent with the legacy framing.
+// 2) Slave replies (legacy framing) with its own capabilities. It keeps
+//    sending with the legacy framing, but also decodes the new one.
+// 3) Master receives the Reply and switches to the same common capabilities.
+// 4) The slave switches at the first valid frame it gets in the new framing.
+//    If the Reply was lost, the master asks again with the legacy framing
+//    and the slave replies again.
+//A peer that doesn't know CMD_LINK_CAPS never replies: the port stays
+//LINK_PENDING and keeps using the legacy comm_gen_str() format.
+//LINK_FEAT_NATIVE isn't advertised by default: a board sets it (with
+//link_set_local_caps()) once its handlers decode both payload layouts.
+//payload_pack_native() checks link_peer_native() for the port it's sent on.
+
+//Payload:
+//[P_XID][P_RID][P_CMDS][P_CMD1][VERSION][FRAMES][MAXLEN_H][MAXLEN_L]
+//[CHECKSUMS][MAXCMDS][FEATURES]
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct link_s commLink[NUMBER_OF_PORTS];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void link_legacy_caps(struct link_caps_s *caps);
+static void link_default_caps(uint8_t port, struct link_caps_s *caps);
+static void link_apply(uint8_t port, struct link_caps_s *peer, uint8_t now, \
+						uint8_t slave);
+static uint8_t link_decode_caps(uint8_t *buf, struct link_caps_s *caps);
+static uint8_t highest_bit(uint8_t mask);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Call once at boot, after the system init (it registers the handlers)
+void init_flexsea_link(void)
+{
+	uint8_t i = 0;
+
+	for(i = 0; i < NUMBER_OF_PORTS; i++)
+	{
+		link_default_caps(i, &commLink[i].local);
+		link_reset(i);
+	}
+
+	flexsea_payload_ptr[CMD_LINK_CAPS][RX_PTYPE_READ] = &rx_cmd_link_caps_rw;
+	flexsea_payload_ptr[CMD_LINK_CAPS][RX_PTYPE_WRITE] = &flexsea_payload_catchall;
+	flexsea_payload_ptr[CMD_LINK_CAPS][RX_PTYPE_REPLY] = &rx_cmd_link_caps_rr;
+}
+
+//Overrides what this board advertises on 'port'. Takes effect at the next
+//exchange.
+void link_set_local_caps(uint8_t port, struct link_caps_s *caps)
+{
+	if(port < NUMBER_OF_PORTS)
+	{
+		commLink[port].local = *caps;
+	}
+}
+
+//Back to the legacy format
+void link_reset(uint8_t port)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	commLink[port].state = LINK_LEGACY;
+	link_legacy_caps(&commLink[port].active);
+	memset(&commLink[port].peer, 0, sizeof(struct link_caps_s));
+	comm_set_framing(port, FRAMING_ESCAPED);
+	arq_disable(port);
+}
+
+//Master: asks slave 'rid' for its capabilities. Returns 0 if the request
+//couldn't be encoded or the port has no transmit function.
+uint8_t link_request_caps(uint8_t port, uint8_t rid)
+{
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	uint8_t bytes = 0;
+	uint16_t last = 0;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return 0;
+	}
+
+	bytes = tx_cmd_link_caps(buf, board_id, rid, READ, &commLink[port].local);
+	last = comm_gen_str_port(port, buf, cstr, bytes);
+	if(last == 0)
+	{
+		return 0;
+	}
+
+	if(!comm_port_send(port, cstr, last + 1))
+	{
+		return 0;
+	}
+
+	commLink[port].state = LINK_PENDING;
+	return 1;
+}
+
+//Intersection of two sets of capabilities
+void link_common_caps(struct link_caps_s *a, struct link_caps_s *b, \
+						struct link_caps_s *common)
+{
+	common->frames = highest_bit(a->frames & b->frames);
+	common->maxFrameLen = MIN(a->maxFrameLen, b->maxFrameLen);
+	common->checksums = a->checksums & b->checksums;
+	common->maxCmds = MIN(a->maxCmds, b->maxCmds);
+	common->features = a->features & b->features;
+}
+
+//Does the other end of 'port' decode native payloads? (flexsea_payload)
+uint8_t link_peer_native(uint8_t port)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return 0;
+	}
+
+	return ((commLink[port].state == LINK_NEGOTIATED) && \
+			(commLink[port].active.features & LINK_FEAT_NATIVE)) ? 1 : 0;
+}
+
+//Prepares a CMD_LINK_CAPS payload in 'buf'. Returns its length.
+uint8_t tx_cmd_link_caps(uint8_t *buf, uint8_t xid, uint8_t rid, \
+						uint8_t rw, struct link_caps_s *caps)
+{
+	uint16_t index = P_DATA1;
+
+	prepare_empty_payload(xid, rid, buf, PAYLOAD_BUF_LEN);
+	buf[P_CMDS] = 1;
+	buf[P_CMD1] = (rw == READ) ? CMD_R(CMD_LINK_CAPS) : CMD_W(CMD_LINK_CAPS);
+
+	buf[index++] = LINK_CAPS_VERSION;
+	buf[index++] = caps->frames;
+	SPLIT_16(caps->maxFrameLen, buf, &index);
+	buf[index++] = caps->checksums;
+	buf[index++] = caps->maxCmds;
+	buf[index++] = caps->features;
+
+	return (uint8_t)index;
+}
+
+//Slave: a master asked for our capabilities. info[0] is the port.
+void rx_cmd_link_caps_rw(uint8_t *buf, uint8_t *info)
+{
+	uint8_t reply[PAYLOAD_BUF_LEN];
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	struct link_caps_s peer;
+	uint8_t port = info[0], bytes = 0;
+	uint16_t last = 0;
+
+	if((port >= NUMBER_OF_PORTS) || !link_decode_caps(buf, &peer))
+	{
+		return;
+	}
+
+	//Reply with the current framing, the master hasn't switched yet:
+	bytes = tx_cmd_link_caps(reply, board_id, buf[P_XID], WRITE, \
+								&commLink[port].local);
+	last = comm_gen_str_port(port, reply, cstr, bytes);
+	if(last == 0)
+	{
+		return;
+	}
+
+	if(comm_port_send(port, cstr, last + 1))
+	{
+		link_apply(port, &peer, 0, board_id);
+	}
+}
+
+//Master: reply to link_request_caps(). info[0] is the port.
+void rx_cmd_link_caps_rr(uint8_t *buf, uint8_t *info)
+{
+	struct link_caps_s peer;
+	uint8_t port = info[0];
+
+	if((port >= NUMBER_OF_PORTS) || !link_decode_caps(buf, &peer))
+	{
+		return;
+	}
+
+	link_apply(port, &peer, 1, buf[P_XID]);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//The comm_gen_str() format, understood by every board
+static void link_legacy_caps(struct link_caps_s *caps)
+{
+	caps->frames = LINK_FRAME_ESCAPED;
+	caps->maxFrameLen = COMM_STR_BUF_LEN;
+	caps->checksums = LINK_CHK_SUM8;
+	caps->maxCmds = 1;
+	caps->features = LINK_FEAT_NONE;
+}
+
+//What this board supports out of the box. Fast framing is only advertised
+//on SPI, the only boundary preserving port.
+static void link_default_caps(uint8_t port, struct link_caps_s *caps)
+{
+	link_legacy_caps(caps);
+
+	if(port == PORT_SPI)
+	{
+		caps->frames |= LINK_FRAME_FAST;
+		caps->maxFrameLen = FAST_FRAME_MAX_LEN;
+		caps->checksums |= LINK_CHK_CRC8;
+	}
+}
+
+//Switches 'port' to the fastest mode both ends support. now = 0 (slave):
+//the new framing is only used once the master uses it. 'slave' is the ID of
+//the slave end, its ARQ sequence numbers start over.
+static void link_apply(uint8_t port, struct link_caps_s *peer, uint8_t now, \
+						uint8_t slave)
+{
+	uint8_t framing = FRAMING_ESCAPED;
+
+	struct link_caps_s common;
+
+	link_common_caps(&commLink[port].local, peer, &common);
+	if(!common.frames)
+	{
+		//Nothing in common (shouldn't happen), stay legacy:
+		link_reset(port);
+		return;
+	}
+
+	commLink[port].peer = *peer;
+	commLink[port].active = common;
+	commLink[port].state = LINK_NEGOTIATED;
+	framing = ((common.frames & LINK_FRAME_FAST) ? FRAMING_FAST : FRAMING_ESCAPED);
+	if(now || (framing == FRAMING_ESCAPED))
+	{
+		comm_set_framing(port, framing);
+	}
+	else
+	{
+		comm_set_framing(port, FRAMING_ESCAPED);
+		comm_set_framing_next(port, framing);
+	}
+
+	if(!(common.features & LINK_FEAT_ARQ) || !arq_enable(port, 0))
+	{
+		commLink[port].active.features &= ~LINK_FEAT_ARQ;
+		arq_disable(port);
+	}
+	else
+	{
+		arq_restart(port, slave);
+	}
+}
+
+//Returns 1 if the payload holds a valid set of capabilities
+static uint8_t link_decode_caps(uint8_t *buf, struct link_caps_s *caps)
+{
+	uint16_t index = P_DATA1;
+
+	if(buf[index++] != LINK_CAPS_VERSION)
+	{
+		return 0;
+	}
+
+	caps->frames = buf[index++];
+	caps->maxFrameLen = REBUILD_UINT16(buf, &index);
+	caps->checksums = buf[index++];
+	caps->maxCmds = buf[index++];
+	caps->features = buf[index++];
+
+	return 1;
+}
+
+//Keeps only the most significant bit of 'mask'
+static uint8_t highest_bit(uint8_t mask)
+{
+	uint8_t bit = 0x80;
+
+	while(bit && !(mask & bit))
+	{
+		bit >>= 1;
+	}
+
+	return bit;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -42,6 +42,10 @@ extern "C" {
 #include <string.h>
 #include "../inc/flexsea.h"
 #include "../../flexsea-comm/inc/flexsea_comm.h"
+#include "../../flexsea-comm/inc/flexsea_txq.h"
+#include "../../flexsea-comm/inc/flexsea_hist.h"
+#include "../../flexsea-comm/inc/flexsea_stats.h"
+#include "../../flexsea-comm/inc/flexsea_link.h"
 #include "../../flexsea-system/inc/flexsea_system.h"
 #include "flexsea_board.h"
 
@@ -51,6 +55,9 @@ extern "C" {
 
 uint8_t payload_str[PAYLOAD_BUF_LEN];
 
+//Commands sent in the native layout, 1 bit each:
+static uint8_t payloadNative[(MAX_CMD_CODE + 7) / 8];
+
 //****************************************************************************
 // Private Function Prototype(s):
 //****************************************************************************
@@ -84,6 +91,10 @@ uint8_t payload_parse_str(uint8_t *cp_str, uint8_t *info)
 		//the appropriate handler (as defined in flexsea_system):
 		if((cmd_7bits <= MAX_CMD_CODE) && (pType <= RX_PTYPE_MAX_INDEX))
 		{
+			#ifdef ENABLE_FLEXSEA_HIST
+			hist_dispatch(info[0], cmd_7bits);
+			#endif	//ENABLE_FLEXSEA_HIST
+
 			(*flexsea_payload_ptr[cmd_7bits][pType]) (cp_str, info);
 
 			return PARSE_SUCCESSFUL;
@@ -176,6 +187,119 @@ uint8_t packetType(uint8_t *buf)
 	return RX_PTYPE_INVALID;
 }
 
+//Is it addressed to me? To a board "below" me? Or to my Master?
+//Also used by the decoder, before the frame is decoded (RID filter).
+uint8_t payload_rid_match(uint8_t cp_rid)
+{
+	uint8_t i = 0;
+
+	if(cp_rid == board_id)				//This board?
+	{
+		return ID_MATCH;
+	}
+	else if(cp_rid == board_up_id)		//Master?
+	{
+		return ID_UP_MATCH;
+	}
+	else
+	{
+		//Can be on a slave bus, or can be invalid.
+
+		//Search on slave bus #1:
+		for(i = 0; i < SLAVE_BUS_1_CNT; i++)
+		{
+			if(cp_rid == board_sub1_id[i])
+			{
+				return ID_SUB1_MATCH;
+			}
+		}
+
+		//Then on bus #2:
+		for(i = 0; i < SLAVE_BUS_1_CNT; i++)
+		{
+			if(cp_rid == board_sub2_id[i])
+			{
+				return ID_SUB2_MATCH;
+			}
+		}
+	}
+
+	//If we end up here it's because we didn't get a match:
+	return ID_NO_MATCH;
+}
+
+//Native layout for 'cmd_7bits' (sent by this board). It's only used on the
+//ports where the other end supports it (negotiated, see link_peer_native()):
+//older stacks would read the data as big endian. Returns 1 if it was changed.
+uint8_t payload_set_native(uint8_t cmd_7bits, uint8_t native)
+{
+	if((cmd_7bits >= MAX_CMD_CODE) || (native && !NATIVE_IS_LE))
+	{
+		return 0;
+	}
+
+	if(native)
+	{
+		payloadNative[cmd_7bits >> 3] |= (uint8_t)(1 << (cmd_7bits & 7));
+	}
+	else
+	{
+		payloadNative[cmd_7bits >> 3] &= (uint8_t)~(1 << (cmd_7bits & 7));
+	}
+
+	return 1;
+}
+
+uint8_t payload_get_native(uint8_t cmd_7bits)
+{
+	if(cmd_7bits >= MAX_CMD_CODE)
+	{
+		return 0;
+	}
+
+	return ((payloadNative[cmd_7bits >> 3] >> (cmd_7bits & 7)) & 1);
+}
+
+//Was this payload written in the native layout? (Receiving side)
+uint8_t payload_is_native(uint8_t *buf)
+{
+	return ((buf[P_CMDS] & P_CMDS_NATIVE) ? 1 : 0);
+}
+
+//Native layout in one copy: 'data' is a struct with its fields in the
+//SPLIT_x_NATIVE() order. Returns the payload length, 0 if it's too long,
+//if the native layout isn't enabled for 'cmd' (payload_set_native()), or
+//if the other end of 'port' didn't negotiate it (use the legacy layout).
+uint8_t payload_pack_native(uint8_t port, uint8_t *buf, uint8_t cmd, const void *data, \
+							uint8_t len)
+{
+	if((!payload_get_native(CMD_7BITS(cmd))) || (!link_peer_native(port)) || \
+		(!NATIVE_IS_LE) || (len > (PAYLOAD_BUF_LEN - P_DATA1)))
+	{
+		return 0;
+	}
+
+	buf[P_CMDS] = 1 | P_CMDS_NATIVE;
+	buf[P_CMD1] = cmd;
+	memcpy(&buf[P_DATA1], data, len);
+	return (P_DATA1 + len);
+}
+
+//Inverse of payload_pack_native(). Returns 0 if the payload uses the
+//legacy layout (use REBUILD_x()), or if this host is big endian (use
+//REBUILD_x_NATIVE()).
+uint8_t payload_unpack_native(uint8_t *buf, void *data, uint8_t len)
+{
+	if((!payload_is_native(buf)) || (!NATIVE_IS_LE) || \
+		(len > (PAYLOAD_BUF_LEN - P_DATA1)))
+	{
+		return 0;
+	}
+
+	memcpy(data, &buf[P_DATA1], len);
+	return 1;
+}
+
 //****************************************************************************
 // Private Function(s):
 //****************************************************************************
@@ -191,6 +315,30 @@ static void route_to_slave(uint8_t port, uint8_t *buf, uint32_t len)
 		//Repackages the payload. ToDo: would be more efficient to just resend the comm_str,
 		//but it's not passed to this function
 		numb = comm_gen_str(buf, comm_str_tmp, len);
+
+		#ifdef ENABLE_FLEXSEA_TXQ
+
+		//Too long (counted as an overrun), nothing to send:
+		if(numb == 0)
+		{
+			return;
+		}
+
+		//Queued by priority, the driver gets them with txq_fill_tx():
+		if((port == PORT_RS485_1) || (port == PORT_RS485_2))
+		{
+			uint8_t n = ((port == PORT_RS485_1) ? 0 : 1);
+			if(!txq_push(&slaveTxq[n], txq_level(buf[P_CMD1]), comm_str_tmp, \
+						numb + 1, buf[P_CMD1]))
+			{
+				COMM_STAT_ADD(port, txDropped, 1);
+			}
+			txq_fill_tx(&slaveTxq[n], &slaveComm[n].tx);
+		}
+		(void)comm_str_ptr;
+
+		#else
+
 		numb = COMM_STR_BUF_LEN;    //Fixed length for now
 
 		//Port specific flags and buffer:
@@ -212,6 +360,8 @@ static void route_to_slave(uint8_t port, uint8_t *buf, uint32_t len)
 		//Copy string:
 		memcpy(comm_str_ptr, comm_str_tmp, numb);
 
+		#endif	//ENABLE_FLEXSEA_TXQ
+
 	#else
 
 		(void)port;
@@ -221,45 +371,9 @@ static void route_to_slave(uint8_t port, uint8_t *buf, uint32_t len)
 	#endif 	//BOARD_TYPE_FLEXSEA_MANAGE
 }
 
-//Is it addressed to me? To a board "below" me? Or to my Master?
 static uint8_t get_rid(uint8_t *pldata)
 {
-	uint8_t cp_rid = pldata[P_RID];
-	uint8_t i = 0;
-
-	if(cp_rid == board_id)				//This board?
-	{
-		return ID_MATCH;
-	}
-	else if(cp_rid == board_up_id)		//Master?
-	{
-		return ID_UP_MATCH;
-	}
-	else
-	{
-		//Can be on a slave bus, or can be invalid.
-
-		//Search on slave bus #1:
-		for(i = 0; i < SLAVE_BUS_1_CNT; i++)
-		{
-			if(cp_rid == board_sub1_id[i])
-			{
-				return ID_SUB1_MATCH;
-			}
-		}
-
-		//Then on bus #2:
-		for(i = 0; i < SLAVE_BUS_1_CNT; i++)
-		{
-			if(cp_rid == board_sub2_id[i])
-			{
-				return ID_SUB2_MATCH;
-			}
-		}
-	}
-
-	//If we end up here it's because we didn't get a match:
-	return ID_NO_MATCH;
+	return payload_rid_match(pldata[P_RID]);
 }
 
 #ifdef __cplusplus
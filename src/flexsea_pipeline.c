@@ -0,0 +1,180 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_pipeline: several requests in flight per slave bus
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Master side. Instead of the TX => TX_THEN_RX => PREP_RX => RX cycle (one
+//Read at a time), up to 'window' Reads are in flight on a bus, to
+//different slaves: the bus carries the next requests while the slaves
+//compute. Replies are matched to their request by slave ID (the reply's
+//XID) and command code, in any order, by flexsea_corr.
+//The driver has to keep the slaves from talking over each other (queued
+//or full-duplex link, or a schedule, see flexsea_tdma).
+// 1) pipe_init(&p, &corr, port, 4, timeout)
+// 2) Call pipe_send() (or pipe_issue() then send it yourself) while it
+//    accepts requests
+// 3) Decoded payloads go to corr_receive(&corr, ...), not payload_parse_str()
+// 4) corr_advance(&corr, now) in the main loop times out the late ones
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_pipeline.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void pipe_free(struct pipe_s *p, struct corr_req_s *r);
+static void pipe_done(struct corr_s *c, struct corr_req_s *r, uint8_t *payload);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void pipe_init(struct pipe_s *p, struct corr_s *c, uint8_t port, uint8_t window, \
+				uint32_t timeout)
+{
+	memset(p, 0, sizeof(struct pipe_s));
+	p->corr = c;
+	p->port = port;
+	p->window = MIN(MAX(window, 1), PIPE_MAX_WINDOW);
+	p->maxPerSlave = PIPE_MAX_PER_SLAVE;
+	p->timeout = timeout;
+}
+
+//Is there room for a request to 'rid'? A second request with the same
+//command to the same slave couldn't be told apart from the first one.
+uint8_t pipe_can_issue(struct pipe_s *p, uint8_t rid, uint8_t cmd)
+{
+	if((p->inFlight >= p->window) || (p->perSlave[rid] >= p->maxPerSlave))
+	{
+		return 0;
+	}
+
+	return (corr_find(p->corr, p->port, rid, cmd) == NULL);
+}
+
+//Registers the Read in 'payload'. Returns its request, NULL if it can't
+//be issued now.
+struct corr_req_s *pipe_issue(struct pipe_s *p, uint8_t *payload, uint32_t now)
+{
+	uint8_t rid = payload[P_RID], cmd = CMD_7BITS(payload[P_CMD1]);
+	struct corr_req_s *r = NULL;
+
+	if(!pipe_can_issue(p, rid, cmd))
+	{
+		return NULL;
+	}
+
+	r = corr_insert(p->corr, p->port, rid, cmd, now, p->timeout);
+	if(r == NULL)
+	{
+		return NULL;
+	}
+
+	r->done = &pipe_done;
+	r->user = p;
+	p->inFlight++;
+	p->perSlave[rid]++;
+	p->issued++;
+
+	return r;
+}
+
+//Registers, frames (comm_gen_str_port()) and sends a request with
+//comm_port_send(). Returns 1 if it went out, 0 if it has to wait.
+uint8_t pipe_send(struct pipe_s *p, uint8_t *payload, uint8_t bytes, uint32_t now)
+{
+	uint8_t str[COMM_STR_BUF_LEN];
+	struct corr_req_s *r = NULL;
+	uint16_t len = 0;
+
+	r = pipe_issue(p, payload, now);
+	if(r == NULL)
+	{
+		return 0;
+	}
+
+	len = comm_gen_str_port(p->port, payload, str, bytes);
+	if((len == 0) || !comm_port_send(p->port, str, len + 1))
+	{
+		pipe_free(p, r);
+		corr_remove(p->corr, r);
+		p->issued--;
+		return 0;
+	}
+
+	return 1;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static void pipe_free(struct pipe_s *p, struct corr_req_s *r)
+{
+	p->inFlight--;
+	p->perSlave[r->rid]--;
+}
+
+//Replied or timed out
+static void pipe_done(struct corr_s *c, struct corr_req_s *r, uint8_t *payload)
+{
+	struct pipe_s *p = (struct pipe_s *)r->user;
+
+	(void)c;
+	(void)payload;
+
+	pipe_free(p, r);
+	if(r->state == CORR_DONE)
+	{
+		p->rttSum += r->rtt;
+		p->rttMax = MAX(p->rttMax, r->rtt);
+		p->matched++;
+	}
+	else
+	{
+		p->timeouts++;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
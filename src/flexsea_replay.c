@@ -0,0 +1,355 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_replay: capture replay through the decoder
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Feeds a capture (flexsea_capture) to the real stack: rx_buf, unpack_payload,
+//payload_parse_str() and the handlers. Field captures become regression
+//tests and benchmarks:
+// 1) replay_init(&r, REPLAY_FAST) or (&r, REPLAY_TIMED), r.speed = 100
+// 2) Optional: r.rx_callback, r.dispatch = 0 (decode only), r.diverge
+// 3) replay_file(&r, "field.fxc"), then look at r.report
+//Every CAPTURE_RX_BYTES record goes to the buffer of its port, which is
+//decoded right away (like transport_rx()). The other records are only
+//used to check the results.
+//Divergences: with ENABLE_FLEXSEA_CAPTURE, each frame found by this build
+//is compared (status and bytes) to the CAPTURE_RX_FRAME records of the
+//build that made the capture. Otherwise only the number of valid frames
+//is compared. Ports without CAPTURE_RX_BYTES records aren't checked.
+
+#ifdef __linux__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_replay.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_transport.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void replay_feed(struct replay_s *r, struct capture_rec_s *rec);
+static void replay_wait(struct replay_s *r, uint64_t target);
+static uint64_t replay_ticks_to_ns(uint64_t ticks, uint32_t tickHz);
+static struct capture_rec_s *replay_expected(struct replay_s *r, uint8_t idx);
+static void replay_diverged(struct replay_s *r, struct capture_rec_s *expected, \
+							struct capture_rec_s *got, uint64_t offset);
+#ifdef ENABLE_FLEXSEA_CAPTURE
+static void replay_compare(void *ctx, uint8_t *recs, uint32_t len);
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void replay_init(struct replay_s *r, uint8_t mode)
+{
+	memset(r, 0, sizeof(struct replay_s));
+	r->mode = mode;
+	r->speed = 100;
+	r->dispatch = 1;
+	r->defaultPort = PORT_USB;
+}
+
+//Replays the records of 'buf' from 'start' (ex.: after the file header).
+//Returns 0, or -1 if the buffer isn't a sequence of records.
+int replay_buf(struct replay_s *r, uint8_t *buf, uint64_t len, uint64_t start, \
+				uint32_t tickHz)
+{
+	struct capture_rec_s *rec = NULL, *first = NULL;
+	uint64_t t0 = capture_clock_ns(), end = start, i = 0;
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	struct capture_s *tap = captureTap;
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	if((r->speed == 0) || (tickHz == 0))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	memset(&r->report, 0, sizeof(struct replay_report_s));
+	memset(r->fed, 0, sizeof(r->fed));
+	for(i = 0; i < REPLAY_PORTS; i++)
+	{
+		memset(&r->rx[i], 0, sizeof(struct rx_buf_s));
+		r->rx[i].port = (uint8_t)i;
+		r->expect[i] = start;
+	}
+	r->buf = buf;
+	r->len = len;
+
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	capture_init(&r->observed, NULL, tickHz);
+	captureTap = &r->observed;
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	r->pos = start;
+	while((rec = capture_next(buf, len, &end)) != NULL)
+	{
+		if(first == NULL)
+		{
+			first = rec;
+		}
+
+		if(rec->type == CAPTURE_RX_BYTES)
+		{
+			if(r->mode == REPLAY_TIMED)
+			{
+				replay_wait(r, t0 + replay_ticks_to_ns(rec->time - first->time, \
+							tickHz) * 100 / r->speed);
+			}
+			replay_feed(r, rec);
+		}
+		r->pos = end;
+	}
+
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	captureTap = tap;
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	//Recorded frames that never showed up:
+	for(i = 0; i < REPLAY_PORTS; i++)
+	{
+		while(r->fed[i] && ((rec = replay_expected(r, (uint8_t)i)) != NULL))
+		{
+			#ifdef ENABLE_FLEXSEA_CAPTURE
+			replay_diverged(r, rec, NULL, (uint64_t)((uint8_t *)rec - buf));
+			#endif	//ENABLE_FLEXSEA_CAPTURE
+		}
+	}
+
+	#ifndef ENABLE_FLEXSEA_CAPTURE
+	if(r->report.frames != r->report.expected)
+	{
+		replay_diverged(r, NULL, NULL, start);
+	}
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+
+	r->report.ns = capture_clock_ns() - t0;
+	if(end != len)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	return 0;
+}
+
+//Replays a capture file. Returns 0, or -1 if it can't be read (errno).
+int replay_file(struct replay_s *r, const char *path)
+{
+	uint8_t *map = NULL;
+	uint64_t len = 0;
+	uint32_t tickHz = 0;
+	int ret = 0;
+
+	map = capture_file_map(path, &len, &tickHz);
+	if(map == NULL)
+	{
+		return -1;
+	}
+
+	ret = replay_buf(r, map, len, sizeof(struct capture_file_hdr_s), tickHz);
+	capture_file_unmap(map, len);
+
+	return ret;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Same as transport_rx(): slices that the decoder window can't miss, and
+//decoding until rx_cmd isn't full
+static void replay_feed(struct replay_s *r, struct capture_rec_s *rec)
+{
+	uint8_t idx = COMM_STATS_IDX(rec->port);
+	uint8_t info[2] = {((idx < NUMBER_OF_PORTS) ? idx : r->defaultPort), 0};
+	struct rx_buf_s *rb = &r->rx[idx];
+	uint8_t *data = CAPTURE_DATA(rec);
+	uint32_t len = rec->len, slice = 0;
+	int8_t ret = 0;
+	int i = 0;
+
+	r->fed[idx] = 1;
+	r->report.records++;
+	r->report.bytes += len;
+
+	while(len)
+	{
+		slice = MIN(len, TRANSPORT_SLICE);
+		update_rx_buf_array_s(rb, data, slice);
+		data += slice;
+		len -= slice;
+
+		do
+		{
+			ret = unpack_payload_rx(rb, r->rxCmd);
+			for(i = 0; (i < ret) && r->dispatch; i++)
+			{
+				if(r->rx_callback)
+				{
+					r->rx_callback(info[0], r->rxCmd[i]);
+				}
+				else
+				{
+					payload_parse_str(r->rxCmd[i], info);
+				}
+			}
+			r->report.frames += (uint64_t)((ret > 0) ? ret : 0);
+		}
+		while(ret == PAYLOAD_BUFFERS);
+
+		#ifdef ENABLE_FLEXSEA_CAPTURE
+		capture_drain(&r->observed, &replay_compare, r);
+		#endif	//ENABLE_FLEXSEA_CAPTURE
+	}
+}
+
+//Sleeps until 'target' (capture_clock_ns()), spins for the last REPLAY_SPIN_NS
+static void replay_wait(struct replay_s *r, uint64_t target)
+{
+	struct timespec ts;
+	uint64_t now = capture_clock_ns();
+
+	if(now > target)
+	{
+		r->report.lateNs = MAX(r->report.lateNs, now - target);
+		return;
+	}
+
+	if((target - now) > REPLAY_SPIN_NS)
+	{
+		ts.tv_sec = (time_t)((target - REPLAY_SPIN_NS) / 1000000000ULL);
+		ts.tv_nsec = (long)((target - REPLAY_SPIN_NS) % 1000000000ULL);
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+		{
+			//Interrupted, sleep again
+		}
+	}
+
+	while(capture_clock_ns() < target)
+	{
+		//Spin
+	}
+}
+
+static uint64_t replay_ticks_to_ns(uint64_t ticks, uint32_t tickHz)
+{
+	return (ticks / tickHz) * 1000000000ULL + \
+			((ticks % tickHz) * 1000000000ULL) / tickHz;
+}
+
+//Next CAPTURE_RX_FRAME recorded on port 'idx', NULL if there is none
+static struct capture_rec_s *replay_expected(struct replay_s *r, uint8_t idx)
+{
+	struct capture_rec_s *rec = NULL;
+
+	while((rec = capture_next(r->buf, r->len, &r->expect[idx])) != NULL)
+	{
+		if((rec->type == CAPTURE_RX_FRAME) && (COMM_STATS_IDX(rec->port) == idx))
+		{
+			if(rec->status > 0)
+			{
+				r->report.expected++;
+			}
+			return rec;
+		}
+	}
+
+	return NULL;
+}
+
+static void replay_diverged(struct replay_s *r, struct capture_rec_s *expected, \
+							struct capture_rec_s *got, uint64_t offset)
+{
+	if(r->report.divergences == 0)
+	{
+		r->report.firstDivergence = offset;
+	}
+	r->report.divergences++;
+
+	if(r->diverge)
+	{
+		r->diverge(expected, got);
+	}
+}
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+
+//capture_drain() sink: the frames the decoder found for the last record
+static void replay_compare(void *ctx, uint8_t *recs, uint32_t len)
+{
+	struct replay_s *r = (struct replay_s *)ctx;
+	struct capture_rec_s *got = NULL, *exp = NULL;
+	uint64_t pos = 0;
+
+	while((got = capture_next(recs, len, &pos)) != NULL)
+	{
+		if(got->type != CAPTURE_RX_FRAME)
+		{
+			continue;
+		}
+
+		exp = replay_expected(r, COMM_STATS_IDX(got->port));
+		if((exp == NULL) || (exp->status != got->status) || \
+			(exp->len != got->len) || \
+			memcmp(CAPTURE_DATA(exp), CAPTURE_DATA(got), got->len))
+		{
+			replay_diverged(r, exp, got, r->pos);
+		}
+	}
+}
+
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
@@ -0,0 +1,675 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_sim: virtual RS-485 buses and slave boards
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Discrete event simulation, in virtual time (ns), of the board running it
+//acting as the master of one or more half-duplex buses full of slaves.
+//Everything goes through the real code: comm_gen_str(), the rx_buf and
+//unpack_payload(), payload_parse_str() and its routing. Only the medium is
+//simulated:
+// - A frame occupies its bus for 10 bits per byte at the bus' baud rate,
+//   plus a turnaround time when the bus changes direction.
+// - Each byte can be corrupted (errorPpm).
+// - Requests reach every slave on the bus; replies only reach the master.
+// - Slaves reply computeNs after a request, when the bus is free.
+//The master polls the boards of each bus round robin, with up to 'window'
+//requests in flight (flexsea_pipeline). window = 1 is the classic serial
+//master. A bus can also be polled by a flexsea_tdma schedule (bus.tdma).
+//A frame that has to wait for another talker counts as a collision: on a
+//real half-duplex bus, nothing would have stopped it.
+//While a virtual board processes a frame, board_id is its ID and the Read
+//and Write entries of flexsea_payload_ptr[] point to a trampoline that
+//calls that board's handlers (sim_reply_t). Replies are dispatched to the
+//normal handlers, with board_id restored.
+// 1) sim_init(&s, seed)
+// 2) b = sim_add_bus(&s, 1000000, 5000, 0, PORT_RS485_1)
+// 3) sim_add_board(&s, b, FLEXSEA_EXECUTE_1, 50000), ...
+// 4) sim_run(&s, 1000000000), then look at the statistics
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_sim.h"
+#include "../inc/flexsea_pipeline.h"
+#include "../inc/flexsea_tdma.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_payload.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+//Context of the board being simulated (NULL: the real one)
+static struct sim_board_s *simBoard = NULL;
+
+//Handlers replaced by the trampoline during sim_run():
+static void (*simSaved[MAX_CMD_CODE][RX_PTYPE_WRITE + 1])(uint8_t *buf, uint8_t *info);
+
+//Real board:
+static uint8_t simBoardUpId = 0;
+static uint8_t simSub1[SLAVE_BUS_1_CNT], simSub2[SLAVE_BUS_1_CNT];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static void sim_trampoline(uint8_t *buf, uint8_t *info);
+static void sim_push(struct sim_s *s, uint64_t t, uint8_t type, uint8_t bus, \
+						uint16_t board);
+static void sim_pop(struct sim_s *s, struct sim_event_s *e);
+static uint32_t sim_rand(struct sim_s *s);
+static void sim_enqueue(struct sim_s *s, uint8_t bus, struct sim_frame_s *f);
+static void sim_start_tx(struct sim_s *s, uint8_t bus, struct sim_frame_s *f);
+static void sim_tx_done(struct sim_s *s, uint8_t bus);
+static void sim_slave_rx(struct sim_s *s, struct sim_board_s *b, uint8_t port, \
+						uint8_t *data, uint8_t len);
+static void sim_master_rx(struct sim_s *s, uint8_t bus, uint8_t *data, uint8_t len);
+static void sim_master_fill(struct sim_s *s, uint8_t bus);
+static void sim_timeout(struct sim_s *s, uint8_t bus);
+static void sim_tdma(struct sim_s *s, uint8_t bus);
+static void sim_enter_slaves(struct sim_s *s);
+static void sim_leave_slaves(struct sim_s *s);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void sim_init(struct sim_s *s, uint32_t seed)
+{
+	memset(s, 0, sizeof(struct sim_s));
+	s->rng = (seed ? seed : 1);
+	s->cmd = CMD_TEST;
+	s->window = 1;
+	s->latMin = UINT32_MAX;
+}
+
+//Returns the bus index, -1 if there are too many
+int sim_add_bus(struct sim_s *s, uint32_t baud, uint32_t turnaroundNs, \
+				uint32_t errorPpm, uint8_t port)
+{
+	struct sim_bus_s *bus = NULL;
+
+	if((s->busCnt >= SIM_MAX_BUSES) || (baud == 0))
+	{
+		return -1;
+	}
+
+	bus = &s->bus[s->busCnt];
+	bus->baud = baud;
+	bus->turnaroundNs = turnaroundNs;
+	bus->errorPpm = errorPpm;
+	bus->port = port;
+	bus->rx.port = COMM_STATS_NO_PORT;		//Simulated, not the real port
+
+	//Default: 1 ms, plus two full frames
+	bus->timeoutNs = 1000000 + 2 * (uint32_t)(COMM_STR_BUF_LEN * 10 * \
+						1000000000ULL / baud) + 2 * turnaroundNs;
+	corr_init(&bus->corr, bus->timeoutNs / 1000, NULL);
+	pipe_init(&bus->pipe, &bus->corr, port, s->window, bus->timeoutNs / 1000);
+
+	return s->busCnt++;
+}
+
+//Returns the board index, -1 on error. The ID has to be unique on its
+//bus, and higher than the master's.
+int sim_add_board(struct sim_s *s, uint8_t bus, uint8_t id, uint32_t computeNs)
+{
+	struct sim_board_s *b = NULL;
+
+	if((s->boardCnt >= SIM_MAX_BOARDS) || (bus >= s->busCnt) || \
+		(s->bus[bus].cnt >= SIM_MAX_BOARDS_PER_BUS) || s->bus[bus].byId[id])
+	{
+		return -1;
+	}
+
+	b = &s->board[s->boardCnt];
+	memset(b, 0, sizeof(struct sim_board_s));
+	b->id = id;
+	b->bus = bus;
+	b->computeNs = computeNs;
+	b->rx.port = COMM_STATS_NO_PORT;
+	b->replyLen = 8;
+	b->reply = &sim_reply_default;
+
+	s->bus[bus].board[s->bus[bus].cnt++] = s->boardCnt;
+	s->bus[bus].byId[id] = s->boardCnt + 1;
+	return s->boardCnt++;
+}
+
+//Runs the simulation for durationNs. Can be called again to continue.
+void sim_run(struct sim_s *s, uint64_t durationNs)
+{
+	struct sim_event_s e;
+	uint64_t end = s->now + durationNs;
+	uint8_t i = 0, j = 0;
+
+	//Install the trampoline:
+	for(i = 0; i < MAX_CMD_CODE; i++)
+	{
+		for(j = RX_PTYPE_READ; j <= RX_PTYPE_WRITE; j++)
+		{
+			simSaved[i][j] = flexsea_payload_ptr[i][j];
+			flexsea_payload_ptr[i][j] = &sim_trampoline;
+		}
+	}
+	s->masterId = board_id;
+
+	//First requests:
+	for(i = 0; i < s->busCnt; i++)
+	{
+		if(s->bus[i].tdma)
+		{
+			s->bus[i].tdma->corr = &s->bus[i].corr;
+			sim_tdma(s, i);
+		}
+		else
+		{
+			sim_master_fill(s, i);
+		}
+	}
+
+	while(s->evCnt && (s->ev[0].t <= end))
+	{
+		sim_pop(s, &e);
+		s->now = e.t;
+
+		switch(e.type)
+		{
+			case SIM_EV_TX_DONE:
+				sim_tx_done(s, e.bus);
+				break;
+			case SIM_EV_REPLY_READY:
+			{
+				struct sim_board_s *b = &s->board[e.board];
+				struct sim_frame_s f;
+
+				memcpy(f.data, b->txBuf, b->txLen);
+				f.len = b->txLen;
+				f.fromSlave = 1;
+				f.board = e.board;
+				b->txLen = 0;
+				b->replies++;
+				sim_enqueue(s, e.bus, &f);
+				break;
+			}
+			case SIM_EV_TIMEOUT:
+				sim_timeout(s, e.bus);
+				break;
+			case SIM_EV_TDMA:
+				sim_tdma(s, e.bus);
+				break;
+		}
+	}
+	s->now = end;
+
+	//Back to normal:
+	for(i = 0; i < MAX_CMD_CODE; i++)
+	{
+		for(j = RX_PTYPE_READ; j <= RX_PTYPE_WRITE; j++)
+		{
+			flexsea_payload_ptr[i][j] = simSaved[i][j];
+		}
+	}
+}
+
+//Latency (ns) under which 'percent' % of the replies arrived. Resolution:
+//SIM_LAT_RES_NS.
+uint32_t sim_latency_percentile(struct sim_s *s, uint8_t percent)
+{
+	uint64_t target = 0, cnt = 0;
+	uint32_t i = 0;
+
+	if(s->replies == 0)
+	{
+		return 0;
+	}
+
+	target = (s->replies * percent + 99) / 100;
+	for(i = 0; i < SIM_LAT_BUCKETS; i++)
+	{
+		cnt += s->lat[i];
+		if(cnt >= target)
+		{
+			break;
+		}
+	}
+
+	return MIN((i + 1) * SIM_LAT_RES_NS, s->latMax);
+}
+
+//Default reply generator: answers Reads with replyLen bytes, ignores
+//Writes
+uint8_t sim_reply_default(struct sim_board_s *b, uint8_t *rx, uint8_t *tx)
+{
+	uint8_t i = 0;
+
+	if(IS_CMD_RW(rx[P_CMD1]) != READ)
+	{
+		return 0;
+	}
+
+	prepare_empty_payload(b->id, rx[P_XID], tx, PAYLOAD_BUF_LEN);
+	tx[P_CMDS] = 1;
+	tx[P_CMD1] = CMD_W(CMD_7BITS(rx[P_CMD1]));
+	for(i = 0; (i < b->replyLen) && ((P_DATA1 + i) < PAYLOAD_BUF_LEN); i++)
+	{
+		tx[P_DATA1 + i] = (uint8_t)(b->replies + i);
+	}
+
+	return (P_DATA1 + i);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Read and Write handler of every command during sim_run()
+static void sim_trampoline(uint8_t *buf, uint8_t *info)
+{
+	struct sim_board_s *b = simBoard;
+	uint8_t cmd = CMD_7BITS(buf[P_CMD1]);
+	uint8_t tx[PAYLOAD_BUF_LEN];
+	sim_reply_t h = NULL;
+	uint8_t bytes = 0, len = 0;
+
+	if(b == NULL)
+	{
+		//Not for a virtual board
+		simSaved[cmd][packetType(buf)](buf, info);
+		return;
+	}
+
+	b->requests++;
+	h = ((b->handlers && b->handlers[cmd]) ? b->handlers[cmd] : b->reply);
+	if(h == NULL)
+	{
+		return;
+	}
+
+	bytes = h(b, buf, tx);
+	if(bytes)
+	{
+		len = comm_gen_str(tx, b->txBuf, bytes);
+		b->txLen = (len ? len + 1 : 0);
+	}
+}
+
+static void sim_push(struct sim_s *s, uint64_t t, uint8_t type, uint8_t bus, \
+						uint16_t board)
+{
+	struct sim_event_s tmp;
+	uint32_t i = s->evCnt, parent = 0;
+
+	if(s->evCnt >= SIM_MAX_EVENTS)
+	{
+		return;
+	}
+
+	s->ev[i].t = t;
+	s->ev[i].type = type;
+	s->ev[i].bus = bus;
+	s->ev[i].board = board;
+	s->evCnt++;
+
+	while(i > 0)
+	{
+		parent = (i - 1) / 2;
+		if(s->ev[parent].t <= s->ev[i].t)
+		{
+			break;
+		}
+		tmp = s->ev[parent];
+		s->ev[parent] = s->ev[i];
+		s->ev[i] = tmp;
+		i = parent;
+	}
+}
+
+static void sim_pop(struct sim_s *s, struct sim_event_s *e)
+{
+	struct sim_event_s tmp;
+	uint32_t i = 0, c = 0;
+
+	*e = s->ev[0];
+	s->ev[0] = s->ev[--s->evCnt];
+
+	while(1)
+	{
+		c = 2 * i + 1;
+		if(c >= s->evCnt)
+		{
+			break;
+		}
+		if(((c + 1) < s->evCnt) && (s->ev[c + 1].t < s->ev[c].t))
+		{
+			c++;
+		}
+		if(s->ev[i].t <= s->ev[c].t)
+		{
+			break;
+		}
+		tmp = s->ev[c];
+		s->ev[c] = s->ev[i];
+		s->ev[i] = tmp;
+		i = c;
+	}
+}
+
+//xorshift32
+static uint32_t sim_rand(struct sim_s *s)
+{
+	s->rng ^= s->rng << 13;
+	s->rng ^= s->rng >> 17;
+	s->rng ^= s->rng << 5;
+	return s->rng;
+}
+
+static void sim_enqueue(struct sim_s *s, uint8_t bus, struct sim_frame_s *f)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+
+	if(!b->busy)
+	{
+		sim_start_tx(s, bus, f);
+		return;
+	}
+
+	if(f->fromSlave || b->cur.fromSlave)
+	{
+		b->collisions++;
+	}
+
+	if(b->qCnt >= SIM_BUS_QUEUE)
+	{
+		b->dropped++;
+		return;
+	}
+
+	b->queue[(b->qHead + b->qCnt) % SIM_BUS_QUEUE] = *f;
+	b->qCnt++;
+}
+
+static void sim_start_tx(struct sim_s *s, uint8_t bus, struct sim_frame_s *f)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	uint64_t start = s->now, duration = 0;
+	uint8_t i = 0, bad = 0;
+
+	if(f->fromSlave != b->lastFromSlave)
+	{
+		start = MAX(start, b->idleSince + b->turnaroundNs);
+	}
+	duration = (uint64_t)f->len * 10 * 1000000000ULL / b->baud;
+
+	b->cur = *f;
+	for(i = 0; (i < b->cur.len) && b->errorPpm; i++)
+	{
+		if((sim_rand(s) % 1000000) < b->errorPpm)
+		{
+			b->cur.data[i] ^= (uint8_t)(1 << (sim_rand(s) & 7));
+			bad = 1;
+		}
+	}
+
+	b->corrupted += bad;
+	b->busy = 1;
+	b->busyNs += duration;
+	b->bytes += f->len;
+	sim_push(s, start + duration, SIM_EV_TX_DONE, bus, f->board);
+}
+
+static void sim_tx_done(struct sim_s *s, uint8_t bus)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	struct sim_frame_s f = b->cur;
+	uint16_t i = 0;
+
+	b->busy = 0;
+	b->idleSince = s->now;
+	b->lastFromSlave = f.fromSlave;
+
+	if(f.fromSlave)
+	{
+		sim_master_rx(s, bus, f.data, f.len);
+	}
+	else
+	{
+		sim_enter_slaves(s);
+		for(i = 0; i < b->cnt; i++)
+		{
+			if(!s->fastDelivery || (b->board[i] == f.board))
+			{
+				sim_slave_rx(s, &s->board[b->board[i]], b->port, f.data, f.len);
+			}
+		}
+		sim_leave_slaves(s);
+	}
+
+	//Next frame waiting for the bus:
+	if(!b->busy && b->qCnt)
+	{
+		f = b->queue[b->qHead];
+		b->qHead = (b->qHead + 1) % SIM_BUS_QUEUE;
+		b->qCnt--;
+		sim_start_tx(s, bus, &f);
+	}
+}
+
+static void sim_slave_rx(struct sim_s *s, struct sim_board_s *b, uint8_t port, \
+						uint8_t *data, uint8_t len)
+{
+	uint8_t info[2] = {port, 0};
+	uint8_t computing = (b->txLen != 0);
+	int8_t n = 0, i = 0;
+
+	simBoard = b;
+	board_id = b->id;
+
+	update_rx_buf_array_s(&b->rx, data, len);
+	n = unpack_payload_buf(b->rx.buf, b->rxCmd);
+	for(i = 0; i < n; i++)
+	{
+		payload_parse_str(b->rxCmd[i], info);
+	}
+
+	//Only one reply in the works per board, the last one wins:
+	if(b->txLen && !computing)
+	{
+		sim_push(s, s->now + b->computeNs, SIM_EV_REPLY_READY, b->bus, \
+					(uint16_t)(b - s->board));
+	}
+}
+
+static void sim_master_rx(struct sim_s *s, uint8_t bus, uint8_t *data, uint8_t len)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	uint8_t info[2] = {b->port, 0};
+	uint8_t *p = NULL, matched = 0;
+	uint32_t nowUs = (uint32_t)(s->now / 1000);
+	uint64_t lat = 0;
+	int8_t n = 0, i = 0;
+
+	update_rx_buf_array_s(&b->rx, data, len);
+	n = unpack_payload_buf(b->rx.buf, b->rxCmd);
+	for(i = 0; i < n; i++)
+	{
+		p = b->rxCmd[i];
+
+		//Matched to a pending request, then routed:
+		matched = corr_receive(&b->corr, p, info, nowUs);
+		if(matched && b->byId[p[P_XID]])
+		{
+			s->replies++;
+			lat = MIN(s->now - s->board[b->byId[p[P_XID]] - 1].reqAt, UINT32_MAX);
+			s->latSum += lat;
+			s->latMin = MIN(s->latMin, (uint32_t)lat);
+			s->latMax = MAX(s->latMax, (uint32_t)lat);
+			s->lat[MIN(lat / SIM_LAT_RES_NS, SIM_LAT_BUCKETS - 1)]++;
+		}
+	}
+
+	if(!b->tdma)
+	{
+		sim_master_fill(s, bus);
+	}
+}
+
+//Sends Reads to the next boards on that bus, while the pipeline takes them
+static void sim_master_fill(struct sim_s *s, uint8_t bus)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	struct sim_frame_s f;
+	uint16_t tries = 0;
+	uint8_t i = 0, len = 0;
+
+	for(tries = 0; (tries < b->cnt) && (b->pipe.inFlight < b->pipe.window); tries++)
+	{
+		f.board = b->board[b->next];
+		b->next = (b->next + 1) % b->cnt;
+
+		prepare_empty_payload(s->masterId, s->board[f.board].id, payload, PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_R(s->cmd);
+		for(i = 0; (i < s->reqLen) && ((P_DATA1 + i) < PAYLOAD_BUF_LEN); i++)
+		{
+			payload[P_DATA1 + i] = (uint8_t)(s->requests + i);
+		}
+
+		//Still waiting for that one?
+		if(pipe_issue(&b->pipe, payload, (uint32_t)(s->now / 1000)) == NULL)
+		{
+			continue;
+		}
+
+		len = comm_gen_str(payload, f.data, P_DATA1 + i);
+		f.len = len + 1;
+		f.fromSlave = 0;
+		s->board[f.board].reqAt = s->now;
+		s->requests++;
+
+		if(!b->timerArmed)
+		{
+			sim_push(s, s->now + b->timeoutNs, SIM_EV_TIMEOUT, bus, 0);
+			b->timerArmed = 1;
+		}
+
+		sim_enqueue(s, bus, &f);
+	}
+}
+
+static void sim_timeout(struct sim_s *s, uint8_t bus)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	uint32_t nowUs = (uint32_t)(s->now / 1000), tick = 0;
+	uint16_t expired = 0;
+
+	//(Keeps sim_master_fill() from arming the timer, done below)
+	b->timerArmed = 1;
+	expired = corr_advance(&b->corr, nowUs);
+	s->timeouts += expired;
+	if(expired)
+	{
+		sim_master_fill(s, bus);
+	}
+	b->timerArmed = 0;
+
+	//Next one to expire:
+	if(corr_next(&b->corr, &tick))
+	{
+		sim_push(s, s->now + (uint64_t)(tick - nowUs) * 1000, SIM_EV_TIMEOUT, bus, 0);
+		b->timerArmed = 1;
+	}
+}
+
+//Sends the request of the slot that just started, then waits for the next
+static void sim_tdma(struct sim_s *s, uint8_t bus)
+{
+	struct sim_bus_s *b = &s->bus[bus];
+	uint32_t nowUs = (uint32_t)(s->now / 1000), wait = 0;
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	struct sim_frame_s f;
+	uint8_t bytes = 0;
+
+	corr_advance(&b->corr, nowUs);
+	while((bytes = tdma_next(b->tdma, nowUs, payload)) > 0)
+	{
+		f.board = (b->byId[payload[P_RID]] ? b->byId[payload[P_RID]] - 1 : 0xFFFF);
+		f.len = comm_gen_str(payload, f.data, bytes) + 1;
+		f.fromSlave = 0;
+		if(f.board != 0xFFFF)
+		{
+			s->board[f.board].reqAt = s->now;
+		}
+		s->requests++;
+		sim_enqueue(s, bus, &f);
+	}
+
+	if(b->tdma->running)
+	{
+		wait = tdma_due(b->tdma) - nowUs;
+		sim_push(s, MAX((s->now / 1000 + wait) * 1000, s->now + 1), SIM_EV_TDMA, \
+					bus, 0);
+	}
+}
+
+//Slaves see the master as board_up_id, and have no slaves of their own
+static void sim_enter_slaves(struct sim_s *s)
+{
+	simBoardUpId = board_up_id;
+	memcpy(simSub1, board_sub1_id, sizeof(simSub1));
+	memcpy(simSub2, board_sub2_id, sizeof(simSub2));
+
+	board_up_id = s->masterId;
+	memset(board_sub1_id, 0, sizeof(simSub1));
+	memset(board_sub2_id, 0, sizeof(simSub2));
+}
+
+static void sim_leave_slaves(struct sim_s *s)
+{
+	simBoard = NULL;
+	board_id = s->masterId;
+	board_up_id = simBoardUpId;
+	memcpy(board_sub1_id, simSub1, sizeof(simSub1));
+	memcpy(board_sub2_id, simSub2, sizeof(simSub2));
+}
+
+#ifdef __cplusplus
+}
+#endif
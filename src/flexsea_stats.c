@@ -0,0 +1,107 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_stats: per port link statistics
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Link health counters, updated by the stack with COMM_STAT_ADD(). Each
+//port has its own cache line, and the increments are relaxed atomics:
+//reading them doesn't slow down the ports.
+// - comm_stats_snapshot(port, &s) copies the counters of a port
+//   (COMM_STATS_NO_PORT: calls that don't know their port)
+// - comm_stats_total(&s) adds up every port
+// - comm_stats_reset(port)
+//The counters are 64 bits: they don't wrap.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_stats.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct comm_stats_line_s commStats[COMM_STATS_PORTS];
+
+#define COMM_STATS_FIELDS		(sizeof(struct comm_stats_s) / sizeof(uint64_t))
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Ports >= NUMBER_OF_PORTS: COMM_STATS_NO_PORT
+void comm_stats_snapshot(uint8_t port, struct comm_stats_s *out)
+{
+	uint64_t *src = (uint64_t *)&commStats[COMM_STATS_IDX(port)].s;
+	uint64_t *dst = (uint64_t *)out;
+	uint8_t i = 0;
+
+	for(i = 0; i < COMM_STATS_FIELDS; i++)
+	{
+		dst[i] = COMM_STAT_LOAD(src[i]);
+	}
+}
+
+void comm_stats_total(struct comm_stats_s *out)
+{
+	struct comm_stats_s s;
+	uint64_t *src = (uint64_t *)&s, *dst = (uint64_t *)out;
+	uint8_t i = 0, port = 0;
+
+	memset(out, 0, sizeof(struct comm_stats_s));
+	for(port = 0; port < COMM_STATS_PORTS; port++)
+	{
+		comm_stats_snapshot(port, &s);
+		for(i = 0; i < COMM_STATS_FIELDS; i++)
+		{
+			dst[i] += src[i];
+		}
+	}
+}
+
+void comm_stats_reset(uint8_t port)
+{
+	uint64_t *c = (uint64_t *)&commStats[COMM_STATS_IDX(port)].s;
+	uint8_t i = 0;
+
+	for(i = 0; i < COMM_STATS_FIELDS; i++)
+	{
+		COMM_STAT_STORE(c[i], 0);
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
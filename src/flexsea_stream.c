@@ -0,0 +1,801 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_stream: bulk-stream sessions (firmware images, log dumps)
+	in large CRC-32 blocks, outside of the command framing
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//How to use it:
+//==============
+// - init_flexsea_stream() once at boot, after the system init (it registers
+//   the CMD_STREAM handlers). stream_config() if the defaults don't fit.
+// - Receiver: stream_receive(port, buf, size, write, done). 'buf' holds one
+//   block. write() gets the data in order, one block at a time (to flash,
+//   to a file), done() is called at the end of the session.
+// - Sender: stream_send(port, rid, data, len, done, now). A CMD_STREAM
+//   request opens the session. Once it's accepted both ends switch the port
+//   to bulk mode, the data goes out in large blocks, up to 'window' blocks
+//   ahead of the last ACK, and both ends go back to command mode at the end.
+//   'data' has to stay valid until done() is called.
+// - While stream_active(port), the bytes received on that port go to
+//   stream_rx() instead of the rx_buf (transport_rx() does it).
+// - Both ends: call stream_poll() periodically (new blocks, timeouts,
+//   delayed ACKs, end of the session).
+//'now' is any free running tick counter, 'rto' uses the same unit.
+//Byte stream ports only (UART, USB CDC, pty). One session at a time per
+//port: a port can't send and receive at the same time.
+
+//Bulk mode:
+//[SYNC][TYPE][SID][SEQ_H][SEQ_L][LEN_H][LEN_L][HCRC][DATA...][CRC-32]
+//=> HCRC is a CRC-8 of the 7 previous bytes (see comm_crc8()), the CRC-32
+//   covers the data
+//=> ACK/NAK: SEQ is the next block expected, LEN is 0. The receiver ACKs
+//   every (window + 1) / 2 blocks. Go-back-N: a bad CRC or a gap is NAKed
+//   and the sender resends from there, blocks received out of order are
+//   dropped.
+//=> The sender goes back to command mode as soon as the last block is
+//   ACKed. The receiver stays in bulk mode for STREAM_LINGER RTOs after the
+//   last block it got (to repeat a lost final ACK). If it doesn't get any
+//   (lost ACCEPT), the sender's next request opens the session again.
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_stream.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+struct stream_s commStream[NUMBER_OF_PORTS];
+
+//CRC-32 (IEEE 802.3, reflected), 4 bits at a time:
+static const uint32_t stream_crc_table[16] =
+{
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+	0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t stream_send_request(uint8_t port, uint8_t rid, uint8_t op, \
+					uint8_t sid, uint32_t len, uint16_t block, uint8_t window);
+static uint8_t stream_send_block(uint8_t port, uint8_t type, uint8_t sid, \
+					uint16_t seq, uint8_t *data, uint16_t n);
+static void stream_send_status(uint8_t port, uint8_t type);
+static void stream_mode(uint8_t port, uint8_t mode);
+static void stream_push(uint8_t port);
+static void stream_tx_end(uint8_t port, uint8_t state);
+static void stream_rx_open(uint8_t port, uint8_t xid, uint8_t sid, uint32_t len, \
+					uint16_t block, uint8_t window);
+static void stream_tx_open(uint8_t port, uint8_t op, uint16_t block, uint8_t window);
+static void stream_header(uint8_t port);
+static void stream_block(uint8_t port);
+static void stream_rx_data(uint8_t port, uint16_t seq, uint16_t n);
+static void stream_rx_gap(uint8_t port);
+static void stream_rx_status(uint8_t port, uint8_t type, uint16_t next);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Call once at boot, after the system init (it registers the handlers)
+void init_flexsea_stream(void)
+{
+	uint8_t i = 0;
+
+	memset(commStream, 0, sizeof(commStream));
+	for(i = 0; i < NUMBER_OF_PORTS; i++)
+	{
+		stream_config(i, 0, 0, 0);
+	}
+
+	//Requests are Writes, so are the replies (Replies when they come from a
+	//slave):
+	flexsea_payload_ptr[CMD_STREAM][RX_PTYPE_READ] = &flexsea_payload_catchall;
+	flexsea_payload_ptr[CMD_STREAM][RX_PTYPE_WRITE] = &rx_cmd_stream;
+	flexsea_payload_ptr[CMD_STREAM][RX_PTYPE_REPLY] = &rx_cmd_stream;
+}
+
+//rto = 0: STREAM_DEFAULT_RTO. window = 0: STREAM_WINDOW. block = 0 (or too
+//large): STREAM_BLOCK_MAX. The receiver can lower the block size and the
+//window, never increase them. The RTO has to cover two windows of blocks
+//on the line (after a NAK the blocks resent wait behind the ones that were
+//in flight) plus the round trip.
+void stream_config(uint8_t port, uint32_t rto, uint8_t window, uint16_t block)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	commStream[port].rto = (rto ? rto : STREAM_DEFAULT_RTO);
+	commStream[port].window = (window ? window : STREAM_WINDOW);
+	commStream[port].block = ((block && (block <= STREAM_BLOCK_MAX)) ? \
+								block : STREAM_BLOCK_MAX);
+}
+
+//Requests a session with 'rid' to send it 'len' bytes. Returns 0 if that
+//port is already busy with a session, or if it's too long.
+uint8_t stream_send(uint8_t port, uint8_t rid, uint8_t *data, uint32_t len, \
+					void (*done)(uint8_t port, uint8_t state), uint32_t now)
+{
+	struct stream_s *s = NULL;
+	struct stream_tx_s *t = NULL;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return 0;
+	}
+
+	s = &commStream[port];
+	t = &s->tx;
+	if((s->mode != STREAM_MODE_COMMAND) || (t->state == STREAM_OPENING) || \
+		(t->state == STREAM_BUSY) || \
+		(len > ((uint32_t)STREAM_MAX_BLOCKS * s->block)))
+	{
+		return 0;
+	}
+
+	t->state = STREAM_OPENING;
+	t->sid++;
+	t->rid = rid;
+	t->data = data;
+	t->len = len;
+	t->retries = 0;
+	t->ackAt = now;
+	t->done = done;
+
+	s->now = now;
+	stream_send_request(port, rid, STREAM_OP_OPEN, t->sid, len, s->block, s->window);
+
+	return 1;
+}
+
+//The next session opened on 'port' is accepted. 'buf' holds one block (the
+//sender's blocks are made smaller if needed). write() is called for every
+//block, in order, done() at the end of the session (STREAM_DONE with the
+//total length, or STREAM_FAILED).
+void stream_receive(uint8_t port, uint8_t *buf, uint16_t size, \
+					void (*write)(uint8_t port, uint32_t offset, uint8_t *data, \
+					uint16_t len), void (*done)(uint8_t port, uint8_t state, \
+					uint32_t len))
+{
+	struct stream_rx_s *r = NULL;
+
+	if((port >= NUMBER_OF_PORTS) || (commStream[port].mode != STREAM_MODE_COMMAND))
+	{
+		return;
+	}
+
+	r = &commStream[port].rx;
+	r->state = STREAM_IDLE;
+	r->buf = buf;
+	r->size = size;
+	r->len = 0;
+	r->write = write;
+	r->done = done;
+}
+
+//1 if the bytes received on that port have to go to stream_rx()
+uint8_t stream_active(uint8_t port)
+{
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return 0;
+	}
+
+	return (commStream[port].mode == STREAM_MODE_BULK);
+}
+
+//Bytes received on a port in bulk mode, in pieces of any size. The blocks
+//are processed as soon as they are complete. Returns the number of bytes
+//consumed: less than 'len' if the session ended, the rest are frames.
+uint32_t stream_rx(uint8_t port, uint8_t *data, uint32_t len)
+{
+	struct stream_s *s = NULL;
+	struct stream_parser_s *p = NULL;
+	uint8_t *sync = NULL;
+	uint32_t n = 0, left = len;
+
+	if(!stream_active(port))
+	{
+		return 0;
+	}
+
+	s = &commStream[port];
+	p = &s->parser;
+	while(len && (s->mode == STREAM_MODE_BULK))
+	{
+		if(p->hdrLen == 0)
+		{
+			//Block start:
+			sync = (uint8_t *)memchr(data, STREAM_SYNC, len);
+			n = (sync ? (uint32_t)(sync - data) : len);
+			p->skipped += n;
+			data += n;
+			len -= n;
+			if(len)
+			{
+				p->hdr[p->hdrLen++] = *data++;
+				len--;
+			}
+		}
+		else if(p->hdrLen < STREAM_HEADER_LEN)
+		{
+			n = MIN(len, (uint32_t)(STREAM_HEADER_LEN - p->hdrLen));
+			memcpy(&p->hdr[p->hdrLen], data, n);
+			p->hdrLen += (uint8_t)n;
+			data += n;
+			len -= n;
+			if(p->hdrLen == STREAM_HEADER_LEN)
+			{
+				stream_header(port);
+			}
+		}
+		else if(p->got < p->len)
+		{
+			//Data, in place:
+			n = MIN(len, p->len - p->got);
+			memcpy(&s->rx.buf[p->got], data, n);
+			p->got += n;
+			data += n;
+			len -= n;
+		}
+		else
+		{
+			n = MIN(len, p->len + STREAM_CRC_LEN - p->got);
+			memcpy(&p->crc[p->got - p->len], data, n);
+			p->got += n;
+			data += n;
+			len -= n;
+			if(p->got == (uint32_t)(p->len + STREAM_CRC_LEN))
+			{
+				stream_block(port);
+			}
+		}
+	}
+
+	return left - len;
+}
+
+//Requests and blocks to send (again), delayed ACKs, timeouts, end of the
+//session
+void stream_poll(uint8_t port, uint32_t now)
+{
+	struct stream_s *s = NULL;
+	struct stream_tx_s *t = NULL;
+	struct stream_rx_s *r = NULL;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	s = &commStream[port];
+	t = &s->tx;
+	r = &s->rx;
+	s->now = now;
+	if(s->heard)
+	{
+		s->heard = 0;
+		s->heardAt = now;
+	}
+
+	if((t->state == STREAM_OPENING) && ((now - t->ackAt) >= s->rto))
+	{
+		if(t->retries >= STREAM_MAX_RETRIES)
+		{
+			stream_tx_end(port, STREAM_FAILED);
+		}
+		else
+		{
+			t->retries++;
+			t->ackAt = now;
+			stream_send_request(port, t->rid, STREAM_OP_OPEN, t->sid, t->len, \
+								s->block, s->window);
+		}
+	}
+	else if(t->state == STREAM_BUSY)
+	{
+		stream_push(port);
+
+		if((t->base != t->next) && ((now - t->ackAt) >= s->rto))
+		{
+			if(t->retries >= STREAM_MAX_RETRIES)
+			{
+				stream_tx_end(port, STREAM_FAILED);
+			}
+			else
+			{
+				//Nothing heard in a while: go back to the oldest block
+				t->retries++;
+				t->next = t->base;
+				stream_push(port);
+			}
+		}
+	}
+
+	if(r->ackPending && ((now - r->ackSince) >= (s->rto / 2)))
+	{
+		stream_send_status(port, STREAM_BLK_ACK);
+	}
+
+	if((s->mode == STREAM_MODE_BULK) && (t->state != STREAM_BUSY) && \
+		((now - s->heardAt) >= (STREAM_LINGER * s->rto)))
+	{
+		//Receiver, quiet line: back to command mode
+		stream_mode(port, STREAM_MODE_COMMAND);
+		if((r->state == STREAM_BUSY) && (r->next == 0))
+		{
+			//Our ACCEPT was lost, the sender will ask again
+			r->state = STREAM_IDLE;
+		}
+		else if(r->state == STREAM_BUSY)
+		{
+			r->state = STREAM_FAILED;
+			if(r->done)
+			{
+				r->done(port, STREAM_FAILED, (uint32_t)r->next * r->block);
+			}
+		}
+	}
+}
+
+//CRC-32 of the data blocks (same as zlib's crc32())
+uint32_t stream_crc32(uint8_t *buf, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFF, i = 0;
+
+	for(i = 0; i < len; i++)
+	{
+		crc ^= buf[i];
+		crc = (crc >> 4) ^ stream_crc_table[crc & 0x0F];
+		crc = (crc >> 4) ^ stream_crc_table[crc & 0x0F];
+	}
+
+	return ~crc;
+}
+
+//CMD_STREAM handler (Write and Reply), command mode. info[0] is the port.
+void rx_cmd_stream(uint8_t *buf, uint8_t *info)
+{
+	uint8_t port = info[0];
+	uint16_t index = P_DATA1 + 2;
+	uint8_t op = buf[P_DATA1], sid = buf[P_DATA1 + 1];
+	uint32_t len = 0;
+	uint16_t block = 0;
+	uint8_t window = 0;
+
+	if(port >= NUMBER_OF_PORTS)
+	{
+		return;
+	}
+
+	len = REBUILD_UINT32(buf, &index);
+	block = REBUILD_UINT16(buf, &index);
+	window = buf[index];
+
+	if(op == STREAM_OP_OPEN)
+	{
+		stream_rx_open(port, buf[P_XID], sid, len, block, window);
+	}
+	else if(((op == STREAM_OP_ACCEPT) || (op == STREAM_OP_REFUSE)) && \
+			(commStream[port].tx.state == STREAM_OPENING) && \
+			(sid == commStream[port].tx.sid))
+	{
+		stream_tx_open(port, op, block, window);
+	}
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//CMD_STREAM payload, sent with the command framing
+static uint8_t stream_send_request(uint8_t port, uint8_t rid, uint8_t op, \
+					uint8_t sid, uint32_t len, uint16_t block, uint8_t window)
+{
+	uint8_t buf[PAYLOAD_BUF_LEN], cstr[COMM_STR_BUF_LEN];
+	uint16_t index = P_DATA1, last = 0;
+
+	prepare_empty_payload(board_id, rid, buf, PAYLOAD_BUF_LEN);
+	buf[P_CMDS] = 1;
+	buf[P_CMD1] = CMD_W(CMD_STREAM);
+
+	buf[index++] = op;
+	buf[index++] = sid;
+	SPLIT_32(len, buf, &index);
+	SPLIT_16(block, buf, &index);
+	buf[index++] = window;
+
+	last = comm_gen_str_port(port, buf, cstr, index);
+	if(last == 0)
+	{
+		return 0;
+	}
+
+	return comm_port_send(port, cstr, last + 1);
+}
+
+//Header, data (straight from the caller's buffer) and CRC-32
+static uint8_t stream_send_block(uint8_t port, uint8_t type, uint8_t sid, \
+					uint16_t seq, uint8_t *data, uint16_t n)
+{
+	uint8_t hdr[STREAM_HEADER_LEN], crc[STREAM_CRC_LEN];
+	uint16_t index = 0;
+
+	hdr[index++] = STREAM_SYNC;
+	hdr[index++] = type;
+	hdr[index++] = sid;
+	SPLIT_16(seq, hdr, &index);
+	SPLIT_16(n, hdr, &index);
+	hdr[index] = comm_crc8(hdr, index);
+
+	if(!comm_port_send(port, hdr, STREAM_HEADER_LEN))
+	{
+		return 0;
+	}
+
+	if(n)
+	{
+		index = 0;
+		SPLIT_32(stream_crc32(data, n), crc, &index);
+		comm_port_send(port, data, n);
+		comm_port_send(port, crc, STREAM_CRC_LEN);
+	}
+
+	return 1;
+}
+
+//ACK or NAK, with the next block expected
+static void stream_send_status(uint8_t port, uint8_t type)
+{
+	struct stream_rx_s *r = &commStream[port].rx;
+
+	r->sinceAck = 0;
+	r->ackPending = 0;
+	stream_send_block(port, type, r->sid, r->next, NULL, 0);
+}
+
+static void stream_mode(uint8_t port, uint8_t mode)
+{
+	struct stream_s *s = &commStream[port];
+
+	s->mode = mode;
+	s->heard = 1;
+	s->parser.hdrLen = 0;
+	s->parser.len = 0;
+	s->parser.got = 0;
+}
+
+//Sends blocks, as long as the window allows it
+static void stream_push(uint8_t port)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_tx_s *t = &s->tx;
+	uint32_t offset = 0;
+
+	while((t->state == STREAM_BUSY) && (t->next < t->count) && \
+			((uint16_t)(t->next - t->base) < t->window))
+	{
+		if(t->base == t->next)
+		{
+			//Nothing was in flight, the timeout starts now
+			t->ackAt = s->now;
+		}
+
+		offset = (uint32_t)t->next * t->block;
+		if(!stream_send_block(port, STREAM_BLK_DATA, t->sid, t->next, \
+					&t->data[offset], (uint16_t)MIN(t->block, t->len - offset)))
+		{
+			//Try again at the next stream_poll()
+			break;
+		}
+
+		if(t->next < t->high)
+		{
+			t->resent++;
+		}
+		else
+		{
+			t->sent++;
+			t->high = (uint16_t)(t->next + 1);
+		}
+		t->next++;
+	}
+}
+
+static void stream_tx_end(uint8_t port, uint8_t state)
+{
+	struct stream_tx_s *t = &commStream[port].tx;
+
+	t->state = state;
+	stream_mode(port, STREAM_MODE_COMMAND);
+	if(t->done)
+	{
+		t->done(port, state);
+	}
+}
+
+//Session request: accepted if stream_receive() was called, and if the
+//message fits in STREAM_MAX_BLOCKS of the size we can take
+static void stream_rx_open(uint8_t port, uint8_t xid, uint8_t sid, uint32_t len, \
+					uint16_t block, uint8_t window)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_rx_s *r = &s->rx;
+	uint32_t count = 0;
+
+	block = MIN(block, r->size);
+	window = MIN(window, s->window);
+	if(block)
+	{
+		count = (len + block - 1) / block;
+	}
+
+	if((r->buf == NULL) || (r->state != STREAM_IDLE) || (block == 0) || \
+		(window == 0) || (count > STREAM_MAX_BLOCKS) || \
+		(s->tx.state == STREAM_OPENING) || (s->tx.state == STREAM_BUSY))
+	{
+		stream_send_request(port, xid, STREAM_OP_REFUSE, sid, len, 0, 0);
+		return;
+	}
+
+	r->state = STREAM_BUSY;
+	r->sid = sid;
+	r->xid = xid;
+	r->len = len;
+	r->block = block;
+	r->window = window;
+	r->count = (uint16_t)(count ? count : 1);	//Empty: one empty block
+	r->next = 0;
+	r->nakSent = 0;
+	r->sinceAck = 0;
+	r->ackPending = 0;
+
+	stream_send_request(port, xid, STREAM_OP_ACCEPT, sid, len, block, window);
+	stream_mode(port, STREAM_MODE_BULK);
+}
+
+//Reply to our request
+static void stream_tx_open(uint8_t port, uint8_t op, uint16_t block, uint8_t window)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_tx_s *t = &s->tx;
+	uint32_t count = 0;
+
+	if(block)
+	{
+		count = (t->len + block - 1) / block;
+	}
+
+	if((op == STREAM_OP_REFUSE) || (block == 0) || (block > s->block) || \
+		(window == 0) || (count > STREAM_MAX_BLOCKS))
+	{
+		stream_tx_end(port, STREAM_FAILED);
+		return;
+	}
+
+	t->state = STREAM_BUSY;
+	t->block = block;
+	t->window = MIN(window, s->window);
+	t->count = (uint16_t)(count ? count : 1);
+	t->base = 0;
+	t->next = 0;
+	t->high = 0;
+	t->retries = 0;
+
+	stream_mode(port, STREAM_MODE_BULK);
+	stream_push(port);
+}
+
+//Complete header: checked, then the data (if any) follows. A bad header
+//is searched for the next SYNC.
+static void stream_header(uint8_t port)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_parser_s *p = &s->parser;
+	uint16_t index = 5;
+	uint8_t *sync = NULL;
+	uint8_t type = p->hdr[1];
+	uint16_t len = REBUILD_UINT16(p->hdr, &index);
+
+	if((comm_crc8(p->hdr, STREAM_HEADER_LEN - 1) != p->hdr[STREAM_HEADER_LEN - 1]) || \
+		(type < STREAM_BLK_DATA) || (type > STREAM_BLK_NAK) || \
+		((type == STREAM_BLK_DATA) && ((s->rx.buf == NULL) || (len > s->rx.size))) || \
+		((type != STREAM_BLK_DATA) && len))
+	{
+		p->badHeaders++;
+		sync = (uint8_t *)memchr(&p->hdr[1], STREAM_SYNC, STREAM_HEADER_LEN - 1);
+		p->hdrLen = (uint8_t)(sync ? (&p->hdr[STREAM_HEADER_LEN] - sync) : 0);
+		p->skipped += (STREAM_HEADER_LEN - p->hdrLen);
+		memmove(p->hdr, sync ? sync : p->hdr, p->hdrLen);
+		return;
+	}
+
+	p->len = len;
+	p->got = 0;
+	s->heard = 1;
+	if(len == 0)
+	{
+		stream_block(port);
+	}
+}
+
+//Complete block (header, data, CRC)
+static void stream_block(uint8_t port)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_parser_s *p = &s->parser;
+	uint16_t index = 3;
+	uint8_t type = p->hdr[1], sid = p->hdr[2];
+	uint16_t seq = REBUILD_UINT16(p->hdr, &index);
+	uint16_t len = p->len;
+
+	index = 0;
+	p->hdrLen = 0;
+	p->len = 0;
+	p->got = 0;
+
+	if(type == STREAM_BLK_DATA)
+	{
+		if((sid != s->rx.sid) || ((s->rx.state != STREAM_BUSY) && \
+			(s->rx.state != STREAM_DONE)))
+		{
+			return;
+		}
+
+		if(len && (stream_crc32(s->rx.buf, len) != REBUILD_UINT32(p->crc, &index)))
+		{
+			p->badCrcs++;
+			if((s->rx.state == STREAM_BUSY) && (seq >= s->rx.next))
+			{
+				stream_rx_gap(port);
+			}
+			return;
+		}
+
+		stream_rx_data(port, seq, len);
+	}
+	else if((sid == s->tx.sid) && (s->tx.state == STREAM_BUSY))
+	{
+		stream_rx_status(port, type, seq);
+	}
+}
+
+//Valid data block. Only the next one is kept.
+static void stream_rx_data(uint8_t port, uint16_t seq, uint16_t n)
+{
+	struct stream_rx_s *r = &commStream[port].rx;
+	uint32_t offset = (uint32_t)seq * r->block;
+
+	if((r->state == STREAM_DONE) || (seq < r->next))
+	{
+		//Already received, our ACK was lost
+		r->duplicates++;
+		stream_send_status(port, STREAM_BLK_ACK);
+		return;
+	}
+
+	if((seq > r->next) || \
+		(((seq + 1) < r->count) && (n != r->block)) || \
+		(((seq + 1) == r->count) && ((offset + n) != r->len)))
+	{
+		r->outOfOrder++;
+		stream_rx_gap(port);
+		return;
+	}
+
+	if(n && r->write)
+	{
+		r->write(port, offset, r->buf, n);
+	}
+	r->next++;
+	r->blocks++;
+	r->nakSent = 0;
+	r->sinceAck++;
+
+	if(r->next == r->count)
+	{
+		r->state = STREAM_DONE;
+		stream_send_status(port, STREAM_BLK_ACK);
+		if(r->done)
+		{
+			r->done(port, STREAM_DONE, r->len);
+		}
+	}
+	else if(r->sinceAck >= ((r->window + 1) / 2))
+	{
+		stream_send_status(port, STREAM_BLK_ACK);
+	}
+	else if(!r->ackPending)
+	{
+		r->ackPending = 1;
+		r->ackSince = commStream[port].now;
+	}
+}
+
+//Bad or missing block: resend from the next one expected, once per gap
+static void stream_rx_gap(uint8_t port)
+{
+	struct stream_rx_s *r = &commStream[port].rx;
+
+	if(!r->nakSent)
+	{
+		r->nakSent = 1;
+		r->naks++;
+		stream_send_status(port, STREAM_BLK_NAK);
+	}
+}
+
+//Cumulative ACK. NAK: same, and go back to the first block missing.
+static void stream_rx_status(uint8_t port, uint8_t type, uint16_t next)
+{
+	struct stream_s *s = &commStream[port];
+	struct stream_tx_s *t = &s->tx;
+
+	if((next > t->base) && (next <= t->high))
+	{
+		t->base = next;
+		t->retries = 0;
+		t->ackAt = s->now;
+		if(t->next < t->base)
+		{
+			t->next = t->base;
+		}
+	}
+
+	if(t->base == t->count)
+	{
+		stream_tx_end(port, STREAM_DONE);
+		return;
+	}
+
+	if((type == STREAM_BLK_NAK) && (next == t->base))
+	{
+		t->next = t->base;
+		stream_push(port);
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,493 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_tdma: time-slotted polling of the slave buses
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Master side. A rate table (slave, command, Hz, frame sizes) becomes a
+//cyclic schedule for one bus:
+// - The minor frame is the period of the fastest entry. Every other period
+//   is rounded down to a power of two minor frames, so the major frame is
+//   the slowest of them and every entry keeps a fixed phase.
+// - Each poll gets a slot: request, max(compute, turnaround), reply,
+//   turnaround and guard, from the baud rate and the worst case frame
+//   sizes (escapePct). Only one transaction is on the bus at a time.
+// - Entries go in the least loaded minor frames, fastest first.
+//Time is in us (wraps, like the 'now' of flexsea_arq).
+// 1) tdma_init(&t, PORT_RS485_1, 1000000, 5)
+// 2) tdma_add(&t, FLEXSEA_EXECUTE_1, CMD_xxx, 1000, 0, 20, 50), ...
+// 3) tdma_plan(&t) == TDMA_PLAN_OK? tdma_utilization() tells how full it is
+// 4) t.corr = &corr (flexsea_corr, ticks in us) to track the replies
+// 5) Call tdma_poll(&t, now) at tdma_due(&t) (timer), and give the decoded
+//    payloads to corr_receive(&corr, ...) instead of payload_parse_str()
+//A poll's request times out at the end of its slot.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_tdma.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_txq.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t tdma_build_default(struct tdma_entry_s *e, uint8_t *payload);
+static uint8_t tdma_inject(uint8_t port, uint8_t cmd, uint8_t *str, uint16_t len);
+static void tdma_track(struct tdma_s *t, uint8_t entry, uint32_t now);
+static void tdma_untrack(struct tdma_s *t);
+static void tdma_done(struct corr_s *c, struct corr_req_s *r, uint8_t *payload);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void tdma_init(struct tdma_s *t, uint8_t port, uint32_t baud, uint32_t turnaroundUs)
+{
+	memset(t, 0, sizeof(struct tdma_s));
+	t->port = port;
+	t->baud = baud;
+	t->turnaroundUs = turnaroundUs;
+	t->guardUs = turnaroundUs;
+	t->escapePct = TDMA_ESCAPE_PCT;
+	t->waiting = -1;
+}
+
+//Adds a line to the rate table. Returns its index, -1 if it's full or
+//invalid. Call tdma_plan() after the last one.
+int tdma_add(struct tdma_s *t, uint8_t rid, uint8_t cmd, uint16_t rateHz, \
+				uint8_t reqBytes, uint8_t replyBytes, uint32_t computeUs)
+{
+	struct tdma_entry_s *e = NULL;
+
+	if((t->entryCnt >= TDMA_MAX_ENTRIES) || (rateHz == 0) || \
+		((P_DATA1 + reqBytes) > PAYLOAD_BUF_LEN))
+	{
+		return -1;
+	}
+
+	e = &t->entry[t->entryCnt];
+	memset(e, 0, sizeof(struct tdma_entry_s));
+	e->rid = rid;
+	e->cmd = cmd;
+	e->rateHz = rateHz;
+	e->reqBytes = reqBytes;
+	e->replyBytes = replyBytes;
+	e->computeUs = computeUs;
+
+	t->running = 0;
+	t->slotCnt = 0;
+	return t->entryCnt++;
+}
+
+//Computes the schedule. Returns TDMA_PLAN_OK, or TDMA_PLAN_ERR_x (no
+//schedule then).
+int8_t tdma_plan(struct tdma_s *t)
+{
+	uint8_t order[TDMA_MAX_ENTRIES];
+	uint32_t load[TDMA_MAX_MINOR];
+	uint32_t period = 0, worst = 0, best = 0, cursor = 0;
+	uint16_t maxRate = 0, f = 0, o = 0, slots = 0;
+	uint8_t i = 0, j = 0, tmp = 0;
+	struct tdma_entry_s *e = NULL;
+
+	t->slotCnt = 0;
+	t->running = 0;
+	if(t->entryCnt == 0)
+	{
+		return TDMA_PLAN_ERR_EMPTY;
+	}
+
+	for(i = 0; i < t->entryCnt; i++)
+	{
+		maxRate = MAX(maxRate, t->entry[i].rateHz);
+	}
+	t->minorUs = 1000000 / maxRate;
+	t->minorCnt = 1;
+
+	//Harmonic periods and slot lengths:
+	for(i = 0; i < t->entryCnt; i++)
+	{
+		e = &t->entry[i];
+		period = (1000000 / e->rateHz) / t->minorUs;
+		for(e->every = 1; ((e->every * 2) <= period) && \
+			((e->every * 2) <= TDMA_MAX_MINOR); e->every *= 2);
+		t->minorCnt = MAX(t->minorCnt, e->every);
+
+		e->slotUs = tdma_frame_us(t, P_DATA1 + e->reqBytes) + \
+					MAX(e->computeUs, t->turnaroundUs) + \
+					tdma_frame_us(t, P_DATA1 + e->replyBytes) + \
+					t->turnaroundUs + t->guardUs;
+		order[i] = i;
+	}
+	t->majorUs = t->minorUs * t->minorCnt;
+
+	for(i = 0; i < t->entryCnt; i++)
+	{
+		slots += t->minorCnt / t->entry[i].every;
+	}
+	if(slots > TDMA_MAX_SLOTS)
+	{
+		return TDMA_PLAN_ERR_SLOTS;
+	}
+
+	//Fastest first, then longest first (insertion sort, small table):
+	for(i = 1; i < t->entryCnt; i++)
+	{
+		for(j = i; j > 0; j--)
+		{
+			struct tdma_entry_s *a = &t->entry[order[j - 1]], *b = &t->entry[order[j]];
+			if((a->every < b->every) || ((a->every == b->every) && (a->slotUs >= b->slotUs)))
+			{
+				break;
+			}
+			tmp = order[j - 1];
+			order[j - 1] = order[j];
+			order[j] = tmp;
+		}
+	}
+
+	//Each entry goes where its busiest minor frame is the least loaded:
+	memset(load, 0, sizeof(load));
+	for(i = 0; i < t->entryCnt; i++)
+	{
+		e = &t->entry[order[i]];
+		best = UINT32_MAX;
+		for(o = 0; o < e->every; o++)
+		{
+			for(f = o, worst = 0; f < t->minorCnt; f += e->every)
+			{
+				worst = MAX(worst, load[f]);
+			}
+			if(worst < best)
+			{
+				best = worst;
+				e->offset = o;
+			}
+		}
+		for(f = e->offset; f < t->minorCnt; f += e->every)
+		{
+			load[f] += e->slotUs;
+		}
+	}
+
+	t->busyUs = 0;
+	t->maxLoadUs = 0;
+	for(f = 0; f < t->minorCnt; f++)
+	{
+		t->busyUs += load[f];
+		t->maxLoadUs = MAX(t->maxLoadUs, load[f]);
+	}
+	if(t->maxLoadUs > t->minorUs)
+	{
+		return TDMA_PLAN_ERR_LOAD;
+	}
+
+	//Slots, back to back in each minor frame:
+	for(f = 0; f < t->minorCnt; f++)
+	{
+		cursor = f * t->minorUs;
+		for(i = 0; i < t->entryCnt; i++)
+		{
+			e = &t->entry[order[i]];
+			if((f % e->every) == e->offset)
+			{
+				t->slot[t->slotCnt].entry = order[i];
+				t->slot[t->slotCnt].start = cursor;
+				t->slotCnt++;
+				cursor += e->slotUs;
+			}
+		}
+	}
+
+	return TDMA_PLAN_OK;
+}
+
+//Time on the wire of a frame with a 'bytes' payload, escapes included
+//(escapePct), rounded up. 10 bits per byte.
+uint32_t tdma_frame_us(struct tdma_s *t, uint8_t bytes)
+{
+	uint32_t len = bytes + 4 + (bytes * t->escapePct + 99) / 100;
+	return (uint32_t)(((uint64_t)len * 10 * 1000000 + t->baud - 1) / t->baud);
+}
+
+//Bus time reserved by the plan, in 0.1%
+uint16_t tdma_utilization(struct tdma_s *t)
+{
+	if(t->majorUs == 0)
+	{
+		return 0;
+	}
+
+	return (uint16_t)(((uint64_t)t->busyUs * 1000) / t->majorUs);
+}
+
+//Request of the slot that just started, if any. The schedule starts on
+//the first call. Returns the number of bytes in 'payload', 0 if nothing
+//is due. Slots we are too late for (more than guardUs) are skipped.
+uint8_t tdma_next(struct tdma_s *t, uint32_t now, uint8_t *payload)
+{
+	struct tdma_entry_s *e = NULL;
+	uint32_t start = 0, cycles = 0;
+
+	if(t->slotCnt == 0)
+	{
+		return 0;
+	}
+
+	if(!t->running)
+	{
+		t->running = 1;
+		t->epoch = now;
+		t->next = 0;
+		tdma_untrack(t);
+	}
+
+	//Asleep for more than a major frame: don't replay every slot
+	if(((int32_t)(now - t->epoch) > 0) && ((now - t->epoch) >= 2 * t->majorUs))
+	{
+		cycles = (now - t->epoch) / t->majorUs - 1;
+		t->epoch += cycles * t->majorUs;
+		t->cycles += cycles;
+		t->misses += cycles * t->slotCnt;
+	}
+
+	while(1)
+	{
+		start = t->epoch + t->slot[t->next].start;
+		if((int32_t)(now - start) < 0)
+		{
+			return 0;
+		}
+
+		e = &t->entry[t->slot[t->next].entry];
+		if(++t->next >= t->slotCnt)
+		{
+			t->next = 0;
+			t->epoch += t->majorUs;
+			t->cycles++;
+		}
+
+		//The previous slot is over:
+		if(t->waiting >= 0)
+		{
+			t->entry[t->waiting].noReply++;
+			t->noReply++;
+			tdma_untrack(t);
+		}
+
+		if((now - start) > t->guardUs)
+		{
+			e->misses++;
+			t->misses++;
+			continue;
+		}
+
+		e->polls++;
+		t->polls++;
+		tdma_track(t, (uint8_t)(e - t->entry), now);
+		return (t->build ? t->build(e, payload) : tdma_build_default(e, payload));
+	}
+}
+
+//When the next slot starts
+uint32_t tdma_due(struct tdma_s *t)
+{
+	if(!t->running || (t->slotCnt == 0))
+	{
+		return 0;
+	}
+
+	return t->epoch + t->slot[t->next].start;
+}
+
+//Frames (comm_gen_str_port()) and sends the request of the slot that just
+//started, with comm_port_send(). Without a driver for that port, a Manage
+//board hands it to slaveComm[].tx like route_to_slave() (slaveTxq[] with
+//ENABLE_FLEXSEA_TXQ). Returns 1 if something went out, or was queued.
+uint8_t tdma_poll(struct tdma_s *t, uint32_t now)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[COMM_STR_BUF_LEN];
+	uint16_t len = 0;
+	uint8_t bytes = 0;
+
+	bytes = tdma_next(t, now, payload);
+	if(bytes == 0)
+	{
+		return 0;
+	}
+
+	len = comm_gen_str_port(t->port, payload, str, bytes);
+	if(len == 0)
+	{
+		return 0;
+	}
+
+	if(comm_port_send(t->port, str, len + 1))
+	{
+		return 1;
+	}
+
+	return tdma_inject(t->port, payload[P_CMD1], str, len + 1);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static uint8_t tdma_build_default(struct tdma_entry_s *e, uint8_t *payload)
+{
+	prepare_empty_payload(board_id, e->rid, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(e->cmd);
+
+	return (P_DATA1 + e->reqBytes);
+}
+
+static uint8_t tdma_inject(uint8_t port, uint8_t cmd, uint8_t *str, uint16_t len)
+{
+	#ifdef BOARD_TYPE_FLEXSEA_MANAGE
+
+		uint8_t n = 0;
+
+		if(port == PORT_RS485_1)
+		{
+			n = 0;
+		}
+		else if(port == PORT_RS485_2)
+		{
+			n = 1;
+		}
+		else
+		{
+			return 0;
+		}
+
+		#ifdef ENABLE_FLEXSEA_TXQ
+
+		//Same queue as route_to_slave(), ahead of telemetry:
+		if(!txq_push(&slaveTxq[n], TXQ_CONTROL, str, len, cmd))
+		{
+			return 0;
+		}
+		txq_fill_tx(&slaveTxq[n], &slaveComm[n].tx);
+		return 1;
+
+		#else
+
+		//The driver isn't done with the last frame:
+		if(slaveComm[n].tx.inject)
+		{
+			return 0;
+		}
+
+		memcpy(slaveComm[n].tx.txBuf, str, len);
+		slaveComm[n].tx.cmd = cmd;
+		slaveComm[n].tx.len = (uint8_t)len;
+		slaveComm[n].tx.inject = 1;
+		return 1;
+
+		#endif	//ENABLE_FLEXSEA_TXQ
+
+	#else
+
+		(void)port;
+		(void)cmd;
+		(void)str;
+		(void)len;
+		return 0;
+
+	#endif	//BOARD_TYPE_FLEXSEA_MANAGE
+}
+
+//Expects the reply of that entry
+static void tdma_track(struct tdma_s *t, uint8_t entry, uint32_t now)
+{
+	struct tdma_entry_s *e = &t->entry[entry];
+
+	t->waiting = entry;
+	t->req = NULL;
+	if(t->corr)
+	{
+		t->req = corr_insert(t->corr, t->port, e->rid, e->cmd, now, MAX(e->slotUs, 1));
+		if(t->req)
+		{
+			t->req->done = &tdma_done;
+			t->req->user = t;
+		}
+	}
+}
+
+static void tdma_untrack(struct tdma_s *t)
+{
+	if(t->req)
+	{
+		corr_remove(t->corr, t->req);
+		t->req = NULL;
+	}
+	t->waiting = -1;
+}
+
+//Reply of the current slot, or end of the slot without one
+static void tdma_done(struct corr_s *c, struct corr_req_s *r, uint8_t *payload)
+{
+	struct tdma_s *t = (struct tdma_s *)r->user;
+	struct tdma_entry_s *e = &t->entry[t->waiting];
+
+	(void)c;
+	(void)payload;
+
+	if(r->state == CORR_DONE)
+	{
+		e->replies++;
+		t->replies++;
+		t->rttMax = MAX(t->rttMax, r->rtt);
+	}
+	else
+	{
+		e->noReply++;
+		t->noReply++;
+	}
+
+	t->req = NULL;
+	t->waiting = -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
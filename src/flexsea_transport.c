@@ -0,0 +1,512 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_transport: Linux host transport (tty/pty, epoll)
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Host only: every port is a non-blocking file descriptor (tty, pty, pipe,
+//socket) multiplexed by one epoll instance. One thread, no per-byte calls:
+// 1) transport_init(&t)
+// 2) h = transport_open_tty(&t, "/dev/ttyACM0", 921600, PORT_USB), or
+//    transport_add_fd() for something that's already open
+// 3) Loop on transport_poll(&t, timeout). Decoded payloads go to
+//    t.rx_callback, or to payload_parse_str() with info[0] = port.
+// 4) transport_send(&t, h, comm_str, len) to transmit
+
+#ifdef __linux__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		//cfmakeraw()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_transport.h"
+#include "../inc/flexsea_hist.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int transport_flush(struct transport_s *t, int handle);
+static void transport_watch_tx(struct transport_s *t, int handle, uint8_t on);
+static void transport_drop(struct transport_s *t, int handle);
+static int8_t transport_unpack(struct transport_port_s *p);
+static int8_t transport_unpack_fast(struct transport_port_s *p);
+static speed_t baud_to_speed(uint32_t baud);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Returns 0 on success, -1 otherwise (errno is set)
+int transport_init(struct transport_s *t)
+{
+	memset(t, 0, sizeof(struct transport_s));
+	t->epfd = epoll_create1(EPOLL_CLOEXEC);
+	return ((t->epfd < 0) ? -1 : 0);
+}
+
+//Closes every port
+void transport_close(struct transport_s *t)
+{
+	uint8_t i = 0;
+
+	for(i = 0; i < t->cnt; i++)
+	{
+		if(t->port[i].fd >= 0)
+		{
+			close(t->port[i].fd);
+			t->port[i].fd = -1;
+		}
+	}
+
+	if(t->epfd >= 0)
+	{
+		close(t->epfd);
+		t->epfd = -1;
+	}
+	t->cnt = 0;
+}
+
+//Opens a tty (or pty slave) in non-blocking raw mode. baud = 0 keeps the
+//current speed. Returns a handle, -1 on error (EINVAL: unsupported baud).
+int transport_open_tty(struct transport_s *t, const char *path, uint32_t baud, \
+						uint8_t port)
+{
+	int fd = 0, handle = 0;
+
+	fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if(fd < 0)
+	{
+		return -1;
+	}
+
+	if(transport_set_raw(fd, baud) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	handle = transport_add_fd(t, fd, port);
+	if(handle < 0)
+	{
+		close(fd);
+	}
+
+	return handle;
+}
+
+//Adds an open file descriptor. It is switched to non-blocking mode and
+//closed by transport_close(). Returns a handle, -1 on error.
+int transport_add_fd(struct transport_s *t, int fd, uint8_t port)
+{
+	struct epoll_event ev;
+	struct transport_port_s *p = NULL;
+	int handle = t->cnt;
+
+	if(t->cnt >= TRANSPORT_MAX_PORTS)
+	{
+		errno = ENOSPC;
+		return -1;
+	}
+
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = (uint32_t)handle;
+	if(epoll_ctl(t->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+	{
+		return -1;
+	}
+
+	p = &t->port[handle];
+	memset(p, 0, sizeof(struct transport_port_s));
+	p->fd = fd;
+	p->port = port;
+	p->rx.port = port;
+	t->cnt++;
+
+	return handle;
+}
+
+//Waits up to timeout_ms for data, reads every readable port in large
+//chunks and decodes them. Returns the number of payloads decoded, -1 on
+//error.
+int transport_poll(struct transport_s *t, int timeout_ms)
+{
+	struct epoll_event ev[TRANSPORT_MAX_PORTS];
+	struct transport_port_s *p = NULL;
+	int n = 0, i = 0, handle = 0, total = 0;
+	uint8_t hup = 0;
+	ssize_t len = 0;
+
+	n = epoll_wait(t->epfd, ev, TRANSPORT_MAX_PORTS, timeout_ms);
+	t->syscalls++;
+	if(n < 0)
+	{
+		return ((errno == EINTR) ? 0 : -1);
+	}
+
+	for(i = 0; i < n; i++)
+	{
+		handle = (int)ev[i].data.u32;
+		p = &t->port[handle];
+
+		if(ev[i].events & EPOLLOUT)
+		{
+			transport_flush(t, handle);
+		}
+
+		if(!(ev[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)))
+		{
+			continue;
+		}
+
+		//Drain it. Hung up: everything that's left, then it's closed (it
+		//would be reported by every epoll_wait())
+		hup = ((ev[i].events & (EPOLLHUP | EPOLLERR)) ? 1 : 0);
+		do
+		{
+			len = read(p->fd, t->chunk, TRANSPORT_CHUNK);
+			t->syscalls++;
+			if(len > 0)
+			{
+				total += transport_rx(t, handle, t->chunk, (uint32_t)len);
+			}
+		}
+		while((len == TRANSPORT_CHUNK) || (hup && (len > 0)));
+
+		if(hup)
+		{
+			transport_drop(t, handle);
+		}
+	}
+
+	return total;
+}
+
+//Sends (or queues) a comm_str. Returns 0 on success, -1 if the port
+//can't take it (backlog full, error or closed).
+int transport_send(struct transport_s *t, int handle, uint8_t *str, uint32_t len)
+{
+	struct transport_port_s *p = &t->port[handle];
+	ssize_t ret = 0;
+
+	if(p->fd < 0)
+	{
+		errno = EBADF;
+		return -1;
+	}
+
+	if(p->txLen == 0)
+	{
+		ret = write(p->fd, str, len);
+		t->syscalls++;
+		if(ret < 0)
+		{
+			if((errno != EAGAIN) && (errno != EWOULDBLOCK))
+			{
+				return -1;
+			}
+			ret = 0;
+		}
+
+		p->bytesOut += (uint32_t)ret;
+		str += ret;
+		len -= (uint32_t)ret;
+		if(len == 0)
+		{
+			return 0;
+		}
+	}
+
+	//The driver is busy, keep the rest for EPOLLOUT:
+	if((p->txLen + len) > TRANSPORT_TX_BUF_LEN)
+	{
+		return -1;
+	}
+
+	memcpy(&p->txBuf[p->txLen], str, len);
+	p->txLen += len;
+	transport_watch_tx(t, handle, 1);
+	return 0;
+}
+
+//Feeds received bytes to a port's buffer and decodes them. Also used by
+//the other backends. Returns the number of payloads decoded.
+int transport_rx(struct transport_s *t, int handle, uint8_t *data, uint32_t len)
+{
+	struct transport_port_s *p = &t->port[handle];
+	uint8_t info[2] = {p->port, 0};
+	uint32_t slice = 0;
+	int8_t ret = 0;
+	int i = 0, total = 0;
+
+	p->bytesIn += len;
+	#ifdef ENABLE_FLEXSEA_HIST
+	hist_rx_byte(p->port);
+	#endif	//ENABLE_FLEXSEA_HIST
+
+	while(len)
+	{
+		if(stream_active(p->port))
+		{
+			//Bulk-stream session: blocks, not frames (see flexsea_stream).
+			//Back to frames with what's left if it ends in this chunk.
+			slice = stream_rx(p->port, data, len);
+			data += slice;
+			len -= slice;
+			continue;
+		}
+
+		slice = MIN(len, TRANSPORT_SLICE);
+		update_rx_buf_array_s(&p->rx, data, slice);
+		data += slice;
+		len -= slice;
+
+		//rx_cmd holds PAYLOAD_BUFFERS strings, call again if it's full:
+		do
+		{
+			ret = transport_unpack(p);
+			p->decodes++;
+			for(i = 0; i < ret; i++)
+			{
+				#ifdef ENABLE_FLEXSEA_HIST
+				hist_rx_frame(p->port, CMD_7BITS(p->rxCmd[i][P_CMD1]));
+				#endif	//ENABLE_FLEXSEA_HIST
+
+				if(t->rx_callback)
+				{
+					t->rx_callback(p->port, p->rxCmd[i]);
+				}
+				else
+				{
+					payload_parse_str(p->rxCmd[i], info);
+				}
+			}
+			total += ((ret > 0) ? ret : 0);
+		}
+		while(ret == PAYLOAD_BUFFERS);
+	}
+
+	p->frames += (uint32_t)total;
+	return total;
+}
+
+//Raw, non-blocking, 8N1, no flow control. baud = 0 keeps the current speed.
+//Returns -1 with errno = EINVAL if 'baud' isn't a standard speed.
+int transport_set_raw(int fd, uint32_t baud)
+{
+	struct termios tio;
+	speed_t speed = B0;
+
+	if(baud)
+	{
+		speed = baud_to_speed(baud);
+		if(speed == B0)
+		{
+			errno = EINVAL;
+			return -1;
+		}
+	}
+
+	if(tcgetattr(fd, &tio) < 0)
+	{
+		return -1;
+	}
+
+	cfmakeraw(&tio);
+	tio.c_cflag |= (CLOCAL | CREAD);
+	tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+	tio.c_cc[VMIN] = 0;
+	tio.c_cc[VTIME] = 0;
+
+	if(baud)
+	{
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+	}
+
+	return tcsetattr(fd, TCSANOW, &tio);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Sends what's left in txBuf
+static int transport_flush(struct transport_s *t, int handle)
+{
+	struct transport_port_s *p = &t->port[handle];
+	ssize_t ret = 0;
+
+	ret = write(p->fd, p->txBuf, p->txLen);
+	t->syscalls++;
+	if(ret < 0)
+	{
+		return (((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : -1);
+	}
+
+	p->bytesOut += (uint32_t)ret;
+	memmove(p->txBuf, &p->txBuf[ret], p->txLen - (uint32_t)ret);
+	p->txLen -= (uint32_t)ret;
+
+	if(p->txLen == 0)
+	{
+		transport_watch_tx(t, handle, 0);
+	}
+
+	return 0;
+}
+
+//Port hung up: out of the epoll set, closed. Its handle stays valid, but
+//transport_send() fails.
+static void transport_drop(struct transport_s *t, int handle)
+{
+	struct transport_port_s *p = &t->port[handle];
+
+	if(p->fd < 0)
+	{
+		return;
+	}
+
+	epoll_ctl(t->epfd, EPOLL_CTL_DEL, p->fd, NULL);
+	close(p->fd);
+	t->syscalls += 2;
+	p->fd = -1;
+	p->txLen = 0;
+}
+
+//Decodes what's in a port's buffer with the framing selected for that
+//port (comm_set_framing()). Same return value as unpack_payload_rx().
+static int8_t transport_unpack(struct transport_port_s *p)
+{
+	struct rx_buf_s *rb = &p->rx;
+	uint8_t fast = 0;
+
+	fast = (comm_get_framing(p->port) == FRAMING_FAST);
+	if(!fast && (comm_get_framing_next(p->port) == FRAMING_FAST))
+	{
+		//Pending: the sync word tells them apart
+		fast = ((rb->idx >= 2) && (rb->buf[0] == FAST_SYNC_H) && \
+				(rb->buf[1] == FAST_SYNC_L));
+	}
+
+	return (fast ? transport_unpack_fast(p) : unpack_payload_rx(rb, p->rxCmd));
+}
+
+//Fast frames, one after the other. A frame that isn't complete yet stays in
+//the buffer; after an invalid one we look for the next sync byte.
+static int8_t transport_unpack_fast(struct transport_port_s *p)
+{
+	struct rx_buf_s *rb = &p->rx;
+	uint32_t frame = 0, skip = 0;
+	int8_t ret = 0, cnt = 0;
+
+	while((cnt < PAYLOAD_BUFFERS) && (rb->idx >= FAST_HEADER_LEN))
+	{
+		frame = FAST_HEADER_LEN + BYTES_TO_UINT16(rb->buf[2], rb->buf[3]);
+		ret = unpack_payload_port(p->port, rb->buf, (uint16_t)rb->idx, \
+									&p->rxCmd[cnt]);
+		if(ret == 1)
+		{
+			discard_rx_buf_s(rb, frame);
+			cnt++;
+			continue;
+		}
+
+		if((ret == UNPACK_ERR_LEN) && (frame > rb->idx) && (frame <= RX_BUF_LEN))
+		{
+			break;		//Incomplete
+		}
+
+		skip = 1;
+		while((skip < rb->idx) && (rb->buf[skip] != FAST_SYNC_H))
+		{
+			skip++;
+		}
+		discard_rx_buf_s(rb, skip);
+	}
+
+	return cnt;
+}
+
+//Enables/disables EPOLLOUT for a port
+static void transport_watch_tx(struct transport_s *t, int handle, uint8_t on)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN | (on ? EPOLLOUT : 0);
+	ev.data.u32 = (uint32_t)handle;
+	epoll_ctl(t->epfd, EPOLL_CTL_MOD, t->port[handle].fd, &ev);
+	t->syscalls++;
+}
+
+//Returns B0 if 'baud' isn't supported
+static speed_t baud_to_speed(uint32_t baud)
+{
+	switch(baud)
+	{
+		case 9600:		return B9600;
+		case 19200:		return B19200;
+		case 38400:		return B38400;
+		case 57600:		return B57600;
+		case 115200:	return B115200;
+		case 230400:	return B230400;
+		case 460800:	return B460800;
+		case 921600:	return B921600;
+		case 1000000:	return B1000000;
+		case 2000000:	return B2000000;
+		case 3000000:	return B3000000;
+		case 4000000:	return B4000000;
+		default:		return B0;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
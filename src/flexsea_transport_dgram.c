@@ -0,0 +1,560 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_transport_dgram: UDP and Unix datagram sockets
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Same comm_str as on a serial port, carried in datagrams. A datagram holds
+//one or more complete frames back to back, so the receiver decodes them
+//in place with unpack_payload_frame(): no rx_buf, no HEADER hunt.
+//One socket talks to many peers (simulated boards, gateways):
+// 1) transport_dgram_open_udp(&d, "127.0.0.1", 5000), or
+//    transport_dgram_open_unix(&d, "/tmp/flexsea.sock")
+// 2) p = transport_dgram_add_peer(&d, "127.0.0.1", 5001, PORT_USB). Senders
+//    we don't know yet are added automatically (see learnPort).
+// 3) transport_dgram_send(&d, p, comm_str, len) queues frames. They go out
+//    with the next transport_dgram_flush()/transport_dgram_poll(), up to
+//    TRANSPORT_DGRAM_BATCH datagrams per sendmmsg().
+// 4) Loop on transport_dgram_poll(&d, timeout)
+
+#ifdef __linux__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		//recvmmsg(), sendmmsg()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_transport.h"
+#include "../inc/flexsea_hist.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+#define DGRAM_RCVBUF			(4 * 1024 * 1024)	//Best effort
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static int dgram_open(struct transport_dgram_s *d, int family);
+static int dgram_resolve(struct transport_dgram_s *d, const char *addr, \
+						uint16_t udpPort, int flags, \
+						struct sockaddr_storage *sa, socklen_t *len);
+static int dgram_find_peer(struct transport_dgram_s *d, \
+						struct sockaddr_storage *sa, socklen_t len);
+static int dgram_rx(struct transport_dgram_s *d, uint8_t *buf, uint32_t len, \
+						struct sockaddr_storage *sa, socklen_t saLen);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Binds a UDP socket. addr = NULL: any address. udpPort = 0: the kernel
+//picks one. Returns 0 on success, -1 otherwise (errno is set).
+int transport_dgram_open_udp(struct transport_dgram_s *d, const char *addr, \
+								uint16_t udpPort)
+{
+	struct sockaddr_storage sa;
+	socklen_t len = 0;
+
+	memset(d, 0, sizeof(struct transport_dgram_s));
+	d->fd = -1;
+	d->family = AF_UNSPEC;
+	if(dgram_resolve(d, addr, udpPort, AI_PASSIVE, &sa, &len) < 0)
+	{
+		return -1;
+	}
+
+	if(dgram_open(d, sa.ss_family) < 0)
+	{
+		return -1;
+	}
+
+	if(bind(d->fd, (struct sockaddr *)&sa, len) < 0)
+	{
+		transport_dgram_close(d);
+		return -1;
+	}
+
+	return 0;
+}
+
+//Binds a Unix datagram socket to 'path' (an old socket file is replaced)
+int transport_dgram_open_unix(struct transport_dgram_s *d, const char *path)
+{
+	struct sockaddr_un sa;
+
+	memset(d, 0, sizeof(struct transport_dgram_s));
+	d->fd = -1;
+	if(strlen(path) >= sizeof(sa.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+
+	if(dgram_open(d, AF_UNIX) < 0)
+	{
+		return -1;
+	}
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sun_family = AF_UNIX;
+	strcpy(sa.sun_path, path);
+	unlink(path);
+
+	if(bind(d->fd, (struct sockaddr *)&sa, sizeof(sa)) < 0)
+	{
+		transport_dgram_close(d);
+		return -1;
+	}
+
+	strcpy(d->unixPath, path);
+	return 0;
+}
+
+void transport_dgram_close(struct transport_dgram_s *d)
+{
+	if(d->fd >= 0)
+	{
+		close(d->fd);
+		d->fd = -1;
+	}
+
+	if(d->unixPath[0])
+	{
+		unlink(d->unixPath);
+		d->unixPath[0] = 0;
+	}
+
+	d->peerCnt = 0;
+	d->txCnt = 0;
+}
+
+//Adds a destination: numeric address and UDP port, or a socket path for
+//Unix sockets (udpPort is then ignored). Returns a peer handle, -1 on
+//error.
+int transport_dgram_add_peer(struct transport_dgram_s *d, const char *addr, \
+								uint16_t udpPort, uint8_t port)
+{
+	struct transport_dgram_peer_s *p = NULL;
+	struct sockaddr_storage sa;
+	socklen_t len = 0;
+	int handle = 0;
+
+	if(dgram_resolve(d, addr, udpPort, 0, &sa, &len) < 0)
+	{
+		return -1;
+	}
+
+	//Already known (it talked to us first)?
+	handle = dgram_find_peer(d, &sa, len);
+	if(handle >= 0)
+	{
+		d->peer[handle].port = port;
+		return handle;
+	}
+
+	if(d->peerCnt >= TRANSPORT_DGRAM_MAX_PEERS)
+	{
+		errno = ENOSPC;
+		return -1;
+	}
+
+	handle = d->peerCnt++;
+	p = &d->peer[handle];
+	memset(p, 0, sizeof(struct transport_dgram_peer_s));
+	memcpy(&p->addr, &sa, len);
+	p->addrLen = len;
+	p->port = port;
+
+	return handle;
+}
+
+//Queues a comm_str for 'peer'. It shares a datagram with the other frames
+//queued for that peer, if there is room. Returns 0 on success, -1 if the
+//frame is too long or nothing can be sent right now.
+int transport_dgram_send(struct transport_dgram_s *d, int peer, uint8_t *str, \
+							uint32_t len)
+{
+	int i = 0;
+
+	if((len > TRANSPORT_DGRAM_MTU) || (peer < 0) || (peer >= d->peerCnt))
+	{
+		return -1;
+	}
+
+	//Last datagram for this peer:
+	for(i = (int)d->txCnt - 1; i >= 0; i--)
+	{
+		if(d->txPeer[i] == peer)
+		{
+			if((d->txLen[i] + len) <= TRANSPORT_DGRAM_MTU)
+			{
+				memcpy(&d->txBuf[i][d->txLen[i]], str, len);
+				d->txLen[i] += (uint16_t)len;
+				return 0;
+			}
+			break;
+		}
+	}
+
+	//New datagram:
+	if(d->txCnt >= TRANSPORT_DGRAM_BATCH)
+	{
+		transport_dgram_flush(d);
+		if(d->txCnt >= TRANSPORT_DGRAM_BATCH)
+		{
+			return -1;
+		}
+	}
+
+	memcpy(d->txBuf[d->txCnt], str, len);
+	d->txLen[d->txCnt] = (uint16_t)len;
+	d->txPeer[d->txCnt] = (uint16_t)peer;
+	d->txCnt++;
+
+	return 0;
+}
+
+//Sends the queued datagrams with sendmmsg(). A datagram the kernel
+//refuses (ex.: nobody bound to that path) is dropped; when the socket is
+//full the rest stays queued. Returns the number of datagrams still queued.
+int transport_dgram_flush(struct transport_dgram_s *d)
+{
+	struct mmsghdr msg[TRANSPORT_DGRAM_BATCH];
+	struct iovec iov[TRANSPORT_DGRAM_BATCH];
+	struct transport_dgram_peer_s *p = NULL;
+	int i = 0, ret = 0, sent = 0;
+
+	if(d->txCnt == 0)
+	{
+		return 0;
+	}
+
+	memset(msg, 0, sizeof(struct mmsghdr) * d->txCnt);
+	for(i = 0; i < d->txCnt; i++)
+	{
+		p = &d->peer[d->txPeer[i]];
+		iov[i].iov_base = d->txBuf[i];
+		iov[i].iov_len = d->txLen[i];
+		msg[i].msg_hdr.msg_iov = &iov[i];
+		msg[i].msg_hdr.msg_iovlen = 1;
+		msg[i].msg_hdr.msg_name = &p->addr;
+		msg[i].msg_hdr.msg_namelen = p->addrLen;
+	}
+
+	while(sent < d->txCnt)
+	{
+		ret = sendmmsg(d->fd, &msg[sent], d->txCnt - sent, MSG_DONTWAIT);
+		d->syscalls++;
+		if(ret > 0)
+		{
+			sent += ret;
+			d->dgramOut += (uint32_t)ret;
+			continue;
+		}
+
+		if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ENOBUFS))
+		{
+			break;
+		}
+		if(errno != EINTR)
+		{
+			//That one can't be delivered, skip it:
+			sent++;
+			d->dgramDropped++;
+		}
+	}
+
+	//Keep what's left, in order:
+	for(i = sent; i < d->txCnt; i++)
+	{
+		memcpy(d->txBuf[i - sent], d->txBuf[i], d->txLen[i]);
+		d->txLen[i - sent] = d->txLen[i];
+		d->txPeer[i - sent] = d->txPeer[i];
+	}
+	d->txCnt -= (uint8_t)sent;
+
+	return d->txCnt;
+}
+
+//Flushes, then waits up to timeout_ms for datagrams and decodes them,
+//TRANSPORT_DGRAM_BATCH per recvmmsg(). Returns the number of payloads
+//decoded, -1 on error.
+int transport_dgram_poll(struct transport_dgram_s *d, int timeout_ms)
+{
+	struct mmsghdr msg[TRANSPORT_DGRAM_BATCH];
+	struct iovec iov[TRANSPORT_DGRAM_BATCH];
+	struct pollfd pfd;
+	int i = 0, ret = 0, total = 0;
+	uint8_t waited = 0;
+
+	transport_dgram_flush(d);
+
+	for(i = 0; i < TRANSPORT_DGRAM_BATCH; i++)
+	{
+		iov[i].iov_base = d->rxBuf[i];
+		iov[i].iov_len = TRANSPORT_DGRAM_MTU;
+	}
+
+	do
+	{
+		memset(msg, 0, sizeof(msg));
+		for(i = 0; i < TRANSPORT_DGRAM_BATCH; i++)
+		{
+			msg[i].msg_hdr.msg_iov = &iov[i];
+			msg[i].msg_hdr.msg_iovlen = 1;
+			msg[i].msg_hdr.msg_name = &d->rxAddr[i];
+			msg[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+		}
+
+		ret = recvmmsg(d->fd, msg, TRANSPORT_DGRAM_BATCH, MSG_DONTWAIT, NULL);
+		d->syscalls++;
+		if(ret < 0)
+		{
+			if((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+			{
+				return -1;
+			}
+
+			//Nothing yet, wait once:
+			if((timeout_ms == 0) || waited || total)
+			{
+				break;
+			}
+			pfd.fd = d->fd;
+			pfd.events = POLLIN;
+			poll(&pfd, 1, timeout_ms);
+			d->syscalls++;
+			waited = 1;
+			ret = TRANSPORT_DGRAM_BATCH;	//Try again
+			continue;
+		}
+
+		d->dgramIn += (uint32_t)ret;
+		for(i = 0; i < ret; i++)
+		{
+			total += dgram_rx(d, d->rxBuf[i], msg[i].msg_len, &d->rxAddr[i], \
+								msg[i].msg_hdr.msg_namelen);
+		}
+	}
+	while(ret == TRANSPORT_DGRAM_BATCH);
+
+	return total;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+static int dgram_open(struct transport_dgram_s *d, int family)
+{
+	int size = DGRAM_RCVBUF;
+
+	d->fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if(d->fd < 0)
+	{
+		return -1;
+	}
+
+	d->family = family;
+	d->learnPort = PORT_USB;
+	setsockopt(d->fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+	setsockopt(d->fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+
+	return 0;
+}
+
+//Numeric address (or socket path) to sockaddr, in the socket's family
+static int dgram_resolve(struct transport_dgram_s *d, const char *addr, \
+						uint16_t udpPort, int flags, \
+						struct sockaddr_storage *sa, socklen_t *len)
+{
+	struct addrinfo hints, *res = NULL;
+	struct sockaddr_un *un = (struct sockaddr_un *)sa;
+	char service[8];
+
+	memset(sa, 0, sizeof(struct sockaddr_storage));
+
+	if(d->family == AF_UNIX)
+	{
+		if((addr == NULL) || (strlen(addr) >= sizeof(un->sun_path)))
+		{
+			errno = EINVAL;
+			return -1;
+		}
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, addr);
+		//Same length as the one recvmmsg() reports, for dgram_find_peer():
+		*len = (socklen_t)(offsetof(struct sockaddr_un, sun_path) + strlen(addr) + 1);
+		return 0;
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = d->family;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV | flags;
+	snprintf(service, sizeof(service), "%u", udpPort);
+
+	if(getaddrinfo(addr, service, &hints, &res) || (res == NULL))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	memcpy(sa, res->ai_addr, res->ai_addrlen);
+	*len = res->ai_addrlen;
+	freeaddrinfo(res);
+	return 0;
+}
+
+static int dgram_find_peer(struct transport_dgram_s *d, \
+						struct sockaddr_storage *sa, socklen_t len)
+{
+	struct transport_dgram_peer_s *p = NULL;
+	int i = 0;
+
+	//Most datagrams come from the same peer as the previous one:
+	if(d->lastPeer < d->peerCnt)
+	{
+		p = &d->peer[d->lastPeer];
+		if((p->addrLen == len) && !memcmp(&p->addr, sa, len))
+		{
+			return d->lastPeer;
+		}
+	}
+
+	for(i = 0; i < d->peerCnt; i++)
+	{
+		p = &d->peer[i];
+		if((p->addrLen == len) && !memcmp(&p->addr, sa, len))
+		{
+			d->lastPeer = (uint16_t)i;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+//Decodes every frame in one datagram
+static int dgram_rx(struct transport_dgram_s *d, uint8_t *buf, uint32_t len, \
+						struct sockaddr_storage *sa, socklen_t saLen)
+{
+	struct transport_dgram_peer_s *p = NULL;
+	uint8_t info[2] = {0, 0};
+	uint32_t off = 0;
+	int16_t ret = 0;
+	int handle = 0, total = 0;
+
+	handle = dgram_find_peer(d, sa, saLen);
+	if(handle < 0)
+	{
+		//New sender. Unbound Unix sockets have no address we could reply to.
+		if((d->learnPort == 0xFF) || (d->peerCnt >= TRANSPORT_DGRAM_MAX_PEERS) \
+			|| (saLen <= sizeof(sa_family_t)))
+		{
+			d->dgramDropped++;
+			return 0;
+		}
+
+		handle = d->peerCnt++;
+		p = &d->peer[handle];
+		memset(p, 0, sizeof(struct transport_dgram_peer_s));
+		memcpy(&p->addr, sa, saLen);
+		p->addrLen = saLen;
+		p->port = d->learnPort;
+	}
+
+	p = &d->peer[handle];
+	p->dgramIn++;
+	info[0] = p->port;
+	#ifdef ENABLE_FLEXSEA_HIST
+	hist_rx_byte(p->port);
+	#endif	//ENABLE_FLEXSEA_HIST
+
+	while(off < len)
+	{
+		ret = unpack_payload_frame(&buf[off], (uint16_t)(len - off), d->rxCmd);
+		if(ret == UNPACK_ERR_CHECKSUM)
+		{
+			//Length is fine (checked), skip that frame only
+			p->badFrames++;
+			off += (uint32_t)buf[off + 1] + 4;
+			continue;
+		}
+		else if(ret < 0)
+		{
+			//The rest of the datagram can't be delimited
+			p->badFrames++;
+			break;
+		}
+		off += (uint32_t)ret;
+		p->frames++;
+		total++;
+		#ifdef ENABLE_FLEXSEA_HIST
+		hist_rx_frame(p->port, CMD_7BITS(d->rxCmd[P_CMD1]));
+		#endif	//ENABLE_FLEXSEA_HIST
+
+		if(d->rx_callback)
+		{
+			d->rx_callback(handle, d->rxCmd);
+		}
+		else
+		{
+			payload_parse_str(d->rxCmd, info);
+		}
+	}
+
+	return total;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
@@ -0,0 +1,551 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_transport_uring: io_uring backend for the Linux host
+	transport
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Same ports and decoder as flexsea_transport, but:
+// - every port always has a READ_FIXED in flight, into a registered buffer.
+//   It's linked to a POLL_ADD: the ports stay non-blocking, and can still be
+//   used with transport_send()
+// - transport_uring_send() only prepares a WRITE_FIXED, they are all
+//   submitted by the next transport_uring_poll(). Each port has one write
+//   in flight, the next one is queued when it completes (in order)
+// - one io_uring_enter() per poll submits everything and waits. When
+//   completions are already there and nothing is queued, no syscall at all.
+//Talks to the kernel directly (no liburing). Needs Linux 5.11+.
+// 1) Add the ports with transport_open_tty()/transport_add_fd()
+// 2) transport_uring_init(&u, &t)
+// 3) Loop on transport_uring_poll(&u, timeout)
+
+#ifdef __linux__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_transport.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+#ifdef ENABLE_FLEXSEA_IO_URING
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+//****************************************************************************
+// Definition(s):
+//****************************************************************************
+
+//user_data: [TYPE:8][HANDLE:16][SLOT:16]
+#define URING_READ			1ULL
+#define URING_WRITE			2ULL
+#define URING_POLL			3ULL
+
+#define URING_NO_SLOT		0xFF
+#define URING_DATA(type, handle, slot)	(((type) << 32) | \
+										((uint64_t)(handle) << 16) | (slot))
+#define URING_TYPE(d)		((d) >> 32)
+#define URING_HANDLE(d)		((int)(((d) >> 16) & 0xFFFF))
+#define URING_SLOT(d)		((uint8_t)((d) & 0xFFFF))
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static struct io_uring_sqe *uring_get_sqe(struct transport_uring_s *u);
+static int uring_queue_poll(struct transport_uring_s *u, int handle, \
+							uint32_t events);
+static int uring_queue_read(struct transport_uring_s *u, int handle);
+static int uring_queue_write(struct transport_uring_s *u, int handle, uint8_t wait);
+static void uring_tx_done(struct transport_uring_s *u, int handle, uint8_t error);
+static int uring_reap(struct transport_uring_s *u);
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+//Sets up the rings, registers the buffers and starts reading every port of
+//'t'. Returns 0 on success, -1 otherwise (errno is set).
+int transport_uring_init(struct transport_uring_s *u, struct transport_s *t)
+{
+	struct io_uring_params p;
+	struct iovec iov[TRANSPORT_MAX_PORTS + TRANSPORT_URING_TX_SLOTS];
+	uint8_t *sq = NULL, *cq = NULL;
+	int i = 0, n = 0;
+
+	memset(u, 0, sizeof(struct transport_uring_s));
+	memset(&p, 0, sizeof(p));
+	u->t = t;
+	u->fd = (int)syscall(__NR_io_uring_setup, TRANSPORT_URING_ENTRIES, &p);
+	if(u->fd < 0)
+	{
+		return -1;
+	}
+	u->features = p.features;
+
+	//Map the rings:
+	u->sqRingSize = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+	u->cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		u->sqRingSize = MAX(u->sqRingSize, u->cqRingSize);
+		u->cqRingSize = u->sqRingSize;
+	}
+
+	u->sqRing = mmap(NULL, u->sqRingSize, PROT_READ | PROT_WRITE, \
+					MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	if(u->sqRing == MAP_FAILED)
+	{
+		goto fail;
+	}
+
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		u->cqRing = u->sqRing;
+	}
+	else
+	{
+		u->cqRing = mmap(NULL, u->cqRingSize, PROT_READ | PROT_WRITE, \
+						MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+		if(u->cqRing == MAP_FAILED)
+		{
+			goto fail;
+		}
+	}
+
+	u->sqesSize = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = mmap(NULL, u->sqesSize, PROT_READ | PROT_WRITE, \
+					MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if(u->sqes == MAP_FAILED)
+	{
+		goto fail;
+	}
+
+	sq = (uint8_t *)u->sqRing;
+	cq = (uint8_t *)u->cqRing;
+	u->sqHead = (uint32_t *)(sq + p.sq_off.head);
+	u->sqTail = (uint32_t *)(sq + p.sq_off.tail);
+	u->sqMask = (uint32_t *)(sq + p.sq_off.ring_mask);
+	u->sqArray = (uint32_t *)(sq + p.sq_off.array);
+	u->sqEntries = p.sq_entries;
+	u->cqHead = (uint32_t *)(cq + p.cq_off.head);
+	u->cqTail = (uint32_t *)(cq + p.cq_off.tail);
+	u->cqMask = (uint32_t *)(cq + p.cq_off.ring_mask);
+	u->cqes = cq + p.cq_off.cqes;
+	u->sqLocalTail = *u->sqTail;
+
+	//Register the buffers: RX first (index = handle), then TX:
+	for(i = 0; i < t->cnt; i++)
+	{
+		iov[n].iov_base = u->rxBuf[i];
+		iov[n++].iov_len = TRANSPORT_CHUNK;
+	}
+	for(i = 0; i < TRANSPORT_URING_TX_SLOTS; i++)
+	{
+		iov[n].iov_base = u->txBuf[i];
+		iov[n++].iov_len = TRANSPORT_URING_TX_LEN;
+		u->txFree[i] = (uint8_t)i;
+	}
+	u->txFreeCnt = TRANSPORT_URING_TX_SLOTS;
+	memset(u->txHead, URING_NO_SLOT, sizeof(u->txHead));
+	memset(u->txTail, URING_NO_SLOT, sizeof(u->txTail));
+
+	if(syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, iov, n) < 0)
+	{
+		goto fail;
+	}
+
+	for(i = 0; i < t->cnt; i++)
+	{
+		uring_queue_read(u, i);
+	}
+
+	return 0;
+
+	fail:
+	transport_uring_close(u);
+	return -1;
+}
+
+void transport_uring_close(struct transport_uring_s *u)
+{
+	if(u->sqes && (u->sqes != MAP_FAILED))
+	{
+		munmap(u->sqes, u->sqesSize);
+	}
+	if(u->cqRing && (u->cqRing != MAP_FAILED) && (u->cqRing != u->sqRing))
+	{
+		munmap(u->cqRing, u->cqRingSize);
+	}
+	if(u->sqRing && (u->sqRing != MAP_FAILED))
+	{
+		munmap(u->sqRing, u->sqRingSize);
+	}
+	if(u->fd >= 0)
+	{
+		close(u->fd);
+	}
+
+	u->sqes = u->cqRing = u->sqRing = NULL;
+	u->fd = -1;
+}
+
+//Copies 'str' in a registered TX slot and queues it behind what's already
+//waiting for that port. Nothing is submitted before the next
+//transport_uring_poll(). Returns 0 on success, -1 if all the slots are in
+//use (poll, then try again) or if the port is closed.
+int transport_uring_send(struct transport_uring_s *u, int handle, uint8_t *str, \
+							uint32_t len)
+{
+	uint8_t slot = 0;
+
+	if((len > TRANSPORT_URING_TX_LEN) || (u->txFreeCnt == 0) || \
+		(u->t->port[handle].fd < 0))
+	{
+		return -1;
+	}
+
+	slot = u->txFree[--u->txFreeCnt];
+	memcpy(u->txBuf[slot], str, len);
+	u->txLen[slot] = (uint16_t)len;
+	u->txSent[slot] = 0;
+	u->txNext[slot] = URING_NO_SLOT;
+
+	if(u->txTail[handle] == URING_NO_SLOT)
+	{
+		u->txHead[handle] = slot;
+	}
+	else
+	{
+		u->txNext[u->txTail[handle]] = slot;
+	}
+	u->txTail[handle] = slot;
+
+	if(!u->txBusy[handle])
+	{
+		uring_queue_write(u, handle, 0);
+	}
+
+	return 0;
+}
+
+//Submits what's queued, waits up to timeout_ms (-1: forever, 0: don't)
+//for completions and processes them. Returns the number of payloads
+//decoded, -1 on error.
+int transport_uring_poll(struct transport_uring_s *u, int timeout_ms)
+{
+	struct io_uring_getevents_arg arg;
+	struct __kernel_timespec ts;
+	uint32_t flags = 0, wait = 0;
+	int ret = 0, i = 0;
+
+	//Reads and writes that couldn't get a SQE earlier:
+	for(i = 0; i < u->t->cnt; i++)
+	{
+		if(u->rxRetry[i])
+		{
+			uring_queue_read(u, i);
+		}
+		if(!u->txBusy[i] && (u->txHead[i] != URING_NO_SLOT))
+		{
+			uring_queue_write(u, i, 0);
+		}
+	}
+
+	//Completions already waiting: no need to sleep
+	if(__atomic_load_n(u->cqTail, __ATOMIC_ACQUIRE) != *u->cqHead)
+	{
+		timeout_ms = 0;
+	}
+
+	if(timeout_ms != 0)
+	{
+		flags |= IORING_ENTER_GETEVENTS;
+		wait = 1;
+	}
+
+	if(u->toSubmit || wait)
+	{
+		__atomic_store_n(u->sqTail, u->sqLocalTail, __ATOMIC_RELEASE);
+
+		if(timeout_ms > 0)
+		{
+			memset(&arg, 0, sizeof(arg));
+			ts.tv_sec = timeout_ms / 1000;
+			ts.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+			arg.ts = (uint64_t)(uintptr_t)&ts;
+			flags |= IORING_ENTER_EXT_ARG;
+			ret = (int)syscall(__NR_io_uring_enter, u->fd, u->toSubmit, wait, \
+								flags, &arg, sizeof(arg));
+		}
+		else
+		{
+			ret = (int)syscall(__NR_io_uring_enter, u->fd, u->toSubmit, wait, \
+								flags, NULL, 0);
+		}
+		u->enters++;
+		u->t->syscalls++;
+
+		if(ret >= 0)
+		{
+			u->toSubmit -= MIN((uint32_t)ret, u->toSubmit);
+		}
+		else if((errno != ETIME) && (errno != EINTR) && (errno != EAGAIN) && \
+				(errno != EBUSY))
+		{
+			return -1;
+		}
+	}
+
+	return uring_reap(u);
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Next free SQE, NULL if the SQ is full
+static struct io_uring_sqe *uring_get_sqe(struct transport_uring_s *u)
+{
+	struct io_uring_sqe *sqe = NULL;
+	uint32_t head = __atomic_load_n(u->sqHead, __ATOMIC_ACQUIRE);
+	uint32_t idx = 0;
+
+	if((u->sqLocalTail - head) >= u->sqEntries)
+	{
+		return NULL;
+	}
+
+	idx = u->sqLocalTail & *u->sqMask;
+	sqe = &((struct io_uring_sqe *)u->sqes)[idx];
+	memset(sqe, 0, sizeof(struct io_uring_sqe));
+	u->sqArray[idx] = idx;
+	u->sqLocalTail++;
+	u->toSubmit++;
+
+	return sqe;
+}
+
+//Waits for 'events' on a port, then starts the next SQE (linked)
+static int uring_queue_poll(struct transport_uring_s *u, int handle, \
+							uint32_t events)
+{
+	struct io_uring_sqe *sqe = NULL;
+
+	//Room for the linked SQE too:
+	if((u->sqLocalTail + 1 - __atomic_load_n(u->sqHead, __ATOMIC_ACQUIRE)) >= \
+		u->sqEntries)
+	{
+		return -1;
+	}
+
+	sqe = uring_get_sqe(u);
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = u->t->port[handle].fd;
+	sqe->poll32_events = events;
+	sqe->flags = IOSQE_IO_LINK;
+	sqe->user_data = URING_DATA(URING_POLL, handle, 0);
+
+	return 0;
+}
+
+//Readable, then read (the port is non-blocking). When there's no SQE left
+//the port is flagged, transport_uring_poll() tries again.
+static int uring_queue_read(struct transport_uring_s *u, int handle)
+{
+	struct io_uring_sqe *sqe = NULL;
+
+	if(uring_queue_poll(u, handle, POLLIN) < 0)
+	{
+		u->rxRetry[handle] = 1;
+		return -1;
+	}
+	u->rxRetry[handle] = 0;
+	sqe = uring_get_sqe(u);
+
+	sqe->opcode = IORING_OP_READ_FIXED;
+	sqe->fd = u->t->port[handle].fd;
+	sqe->addr = (uint64_t)(uintptr_t)u->rxBuf[handle];
+	sqe->len = TRANSPORT_CHUNK;
+	sqe->off = (uint64_t)-1;		//Current position (streams)
+	sqe->buf_index = (uint16_t)handle;
+	sqe->user_data = URING_DATA(URING_READ, handle, 0);
+
+	return 0;
+}
+
+//Queues what's left to send in the first TX slot of a port. wait = 1: only
+//once it's writable (it returned -EAGAIN). When there's no SQE left it
+//stays queued, transport_uring_poll() tries again.
+static int uring_queue_write(struct transport_uring_s *u, int handle, uint8_t wait)
+{
+	struct io_uring_sqe *sqe = NULL;
+	uint8_t slot = u->txHead[handle];
+
+	if(wait && (uring_queue_poll(u, handle, POLLOUT) < 0))
+	{
+		return -1;
+	}
+
+	sqe = uring_get_sqe(u);
+	if(sqe == NULL)
+	{
+		return -1;
+	}
+	u->txBusy[handle] = 1;
+
+	sqe->opcode = IORING_OP_WRITE_FIXED;
+	sqe->fd = u->t->port[handle].fd;
+	sqe->addr = (uint64_t)(uintptr_t)&u->txBuf[slot][u->txSent[slot]];
+	sqe->len = u->txLen[slot] - u->txSent[slot];
+	sqe->off = (uint64_t)-1;
+	sqe->buf_index = (uint16_t)(u->t->cnt + slot);
+	sqe->user_data = URING_DATA(URING_WRITE, handle, slot);
+
+	return 0;
+}
+
+//The first TX slot of a port is done (sent, or error = 1: dropped with
+//everything queued behind it). Starts the next one.
+static void uring_tx_done(struct transport_uring_s *u, int handle, uint8_t error)
+{
+	uint8_t slot = 0;
+
+	u->txBusy[handle] = 0;
+	do
+	{
+		slot = u->txHead[handle];
+		u->txHead[handle] = u->txNext[slot];
+		u->txFree[u->txFreeCnt++] = slot;
+		u->txErrors += error;
+	}
+	while(error && (u->txHead[handle] != URING_NO_SLOT));
+
+	if(u->txHead[handle] == URING_NO_SLOT)
+	{
+		u->txTail[handle] = URING_NO_SLOT;
+	}
+	else
+	{
+		uring_queue_write(u, handle, 0);
+	}
+}
+
+//Processes every completion, from user space
+static int uring_reap(struct transport_uring_s *u)
+{
+	struct io_uring_cqe *cqe = NULL;
+	uint32_t head = *u->cqHead;
+	uint32_t tail = __atomic_load_n(u->cqTail, __ATOMIC_ACQUIRE);
+	uint64_t data = 0;
+	int handle = 0, total = 0;
+	uint8_t slot = 0;
+
+	while(head != tail)
+	{
+		cqe = &((struct io_uring_cqe *)u->cqes)[head & *u->cqMask];
+		data = cqe->user_data;
+		handle = URING_HANDLE(data);
+		u->completions++;
+
+		if(URING_TYPE(data) == URING_READ)
+		{
+			if(cqe->res > 0)
+			{
+				total += transport_rx(u->t, handle, u->rxBuf[handle], \
+										(uint32_t)cqe->res);
+			}
+
+			//Keep a read in flight, unless the port is gone (-ECANCELED: its
+			//poll failed):
+			if((cqe->res > 0) || (cqe->res == -EAGAIN) || (cqe->res == -EINTR))
+			{
+				uring_queue_read(u, handle);
+			}
+		}
+		else if(URING_TYPE(data) == URING_WRITE)
+		{
+			slot = URING_SLOT(data);
+			u->txBusy[handle] = 0;
+			if(cqe->res > 0)
+			{
+				u->t->port[handle].bytesOut += (uint32_t)cqe->res;
+				u->txSent[slot] += (uint16_t)cqe->res;
+				if(u->txSent[slot] < u->txLen[slot])
+				{
+					//Partial write, send the rest before anything else:
+					uring_queue_write(u, handle, 0);
+				}
+				else
+				{
+					uring_tx_done(u, handle, 0);
+				}
+			}
+			else if((cqe->res == -EAGAIN) || (cqe->res == -EINTR))
+			{
+				uring_queue_write(u, handle, 1);
+			}
+			else
+			{
+				//0 (nothing written) or error: the port can't take it
+				uring_tx_done(u, handle, 1);
+			}
+		}
+
+		head++;
+	}
+
+	__atomic_store_n(u->cqHead, head, __ATOMIC_RELEASE);
+	return total;
+}
+
+#endif	//ENABLE_FLEXSEA_IO_URING
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	//__linux__
@@ -0,0 +1,312 @@
+/****************************************************************************
+	[Project] FlexSEA: Flexible & Scalable Electronics Architecture
+	[Sub-project] 'flexsea-comm' Communication stack
+	Copyright (C) 2016 Dephy, Inc. <http://dephy.com/>
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************
+	[Lead developper] Jean-Francois (JF) Duval, jfduval at dephy dot com.
+	[Origin] Based on Jean-Francois Duval's work at the MIT Media Lab
+	Biomechatronics research group <http://biomech.media.mit.edu/>
+	[Contributors]
+*****************************************************************************
+	[This file] flexsea_txq: priority transmit queues
+*****************************************************************************
+	[Change log] (Convention: YYYY-MM-DD | author | comment)
+	* 2026-10-19 | agent | Initial release
+	*
+****************************************************************************/
+
+//Frames waiting for a port, in TXQ_LEVELS priority levels of TXQ_DEPTH
+//preallocated slots. The highest priority frame always goes out first, so
+//a control Write waits for at most one frame, whatever is queued behind.
+//Push and pop are O(1): one ring per level, and a bitmask of the levels
+//that aren't empty.
+//A zeroed txq_s is ready to use.
+// 1) txq_push(&q, txq_level(payload[P_CMD1]), str, len, payload[P_CMD1])
+// 2) When the port is free: txq_send(&q, port), or txq_front() / DMA /
+//    txq_release(), or txq_fill_tx() for the slaveComm[].tx.inject drivers
+//Between txq_front() and txq_release() the frame is in flight: TXQ_DROP_OLDEST
+//evicts the one behind it, and a higher priority frame waits.
+//With ENABLE_FLEXSEA_TXQ, route_to_slave() queues in slaveTxq[] instead of
+//overwriting slaveComm[].tx. The board calls txq_fill_tx() when its driver
+//is done with a frame. The frames it can't queue are counted in the port's
+//txDropped (flexsea_stats).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//****************************************************************************
+// Include(s)
+//****************************************************************************
+
+#include <string.h>
+#include "../inc/flexsea.h"
+#include "../inc/flexsea_txq.h"
+#include "../inc/flexsea_comm.h"
+#include "flexsea_system.h"
+#include "flexsea_board.h"
+
+//****************************************************************************
+// Variable(s)
+//****************************************************************************
+
+#ifdef ENABLE_FLEXSEA_TXQ
+struct txq_s slaveTxq[COMM_SLAVE_BUS];
+#endif	//ENABLE_FLEXSEA_TXQ
+
+//Level by command code, + 1 (0: from the R/W bit)
+static uint8_t txqCmdLevel[MAX_CMD_CODE];
+
+//****************************************************************************
+// Private Function Prototype(s):
+//****************************************************************************
+
+static uint8_t txq_evict(struct txq_s *q, uint8_t level);
+
+//Lowest bit set, for 4 bits:
+static const uint8_t txqFirst[1 << TXQ_LEVELS] = {0, 0, 1, 0, 2, 0, 1, 0, \
+													3, 0, 1, 0, 2, 0, 1, 0};
+
+//TXQ_POLICY_DEFAULT, by level:
+static const uint8_t txqDefaultPolicy[TXQ_LEVELS] = {TXQ_DROP_OLDEST, \
+								TXQ_DROP_NEWEST, TXQ_DROP_OLDEST, TXQ_DROP_NEWEST};
+
+//****************************************************************************
+// Public Function(s)
+//****************************************************************************
+
+void txq_init(struct txq_s *q)
+{
+	memset(q, 0, sizeof(struct txq_s));
+}
+
+void txq_set_policy(struct txq_s *q, uint8_t level, uint8_t policy)
+{
+	if(level < TXQ_LEVELS)
+	{
+		q->level[level].policy = policy;
+	}
+}
+
+//Forces the level of a command code (ex.: TXQ_BULK for a streaming
+//command). TXQ_AUTO goes back to Writes: TXQ_CONTROL, Reads: TXQ_TELEMETRY.
+void txq_set_cmd_level(uint8_t cmd, uint8_t level)
+{
+	if(cmd < MAX_CMD_CODE)
+	{
+		txqCmdLevel[cmd] = ((level < TXQ_LEVELS) ? level + 1 : 0);
+	}
+}
+
+//Level of a request, from its command byte (with the R/W bit). Replies
+//are pushed on TXQ_REPLY by whoever generates them.
+uint8_t txq_level(uint8_t cmd)
+{
+	uint8_t c = CMD_7BITS(cmd);
+
+	if((c < MAX_CMD_CODE) && txqCmdLevel[c])
+	{
+		return txqCmdLevel[c] - 1;
+	}
+
+	return ((IS_CMD_RW(cmd) == READ) ? TXQ_TELEMETRY : TXQ_CONTROL);
+}
+
+//Copies a comm_str in the queue. Returns 1 if it's queued, 0 if it was
+//dropped (TXQ_DROP_NEWEST on a full level, nothing to evict, or too long).
+uint8_t txq_push(struct txq_s *q, uint8_t level, uint8_t *str, uint16_t len, \
+					uint8_t cmd)
+{
+	struct txq_level_s *l = NULL;
+	struct txq_slot_s *s = NULL;
+	uint8_t policy = 0;
+
+	if((level >= TXQ_LEVELS) || (len == 0) || (len > COMM_STR_BUF_LEN))
+	{
+		return 0;
+	}
+
+	l = &q->level[level];
+	if(l->cnt >= TXQ_DEPTH)
+	{
+		l->dropped++;
+		policy = (l->policy ? l->policy : txqDefaultPolicy[level]);
+		if((policy != TXQ_DROP_OLDEST) || !txq_evict(q, level))
+		{
+			return 0;
+		}
+	}
+
+	s = &l->slot[(l->head + l->cnt) & (TXQ_DEPTH - 1)];
+	memcpy(s->data, str, len);
+	s->len = (uint8_t)len;
+	s->cmd = cmd;
+
+	l->cnt++;
+	l->pushed++;
+	l->highWater = MAX(l->highWater, l->cnt);
+	q->pending |= (uint8_t)(1 << level);
+
+	return 1;
+}
+
+//Next frame to send, NULL if there is none. It stays in the queue, and
+//in flight, until txq_release(). Called again before that, it returns the
+//same frame.
+struct txq_slot_s *txq_front(struct txq_s *q)
+{
+	struct txq_level_s *l = NULL;
+
+	if(q->pending == 0)
+	{
+		return NULL;
+	}
+
+	if(!q->out)
+	{
+		q->out = txqFirst[q->pending] + 1;
+	}
+	l = &q->level[q->out - 1];
+	return &l->slot[l->head];
+}
+
+//Done with the frame returned by txq_front()
+void txq_release(struct txq_s *q)
+{
+	uint8_t n = 0;
+	struct txq_level_s *l = NULL;
+
+	if(q->pending == 0)
+	{
+		return;
+	}
+
+	n = (q->out ? (q->out - 1) : txqFirst[q->pending]);
+	q->out = 0;
+	l = &q->level[n];
+	l->head = (l->head + 1) & (TXQ_DEPTH - 1);
+	l->cnt--;
+	l->popped++;
+	if(l->cnt == 0)
+	{
+		q->pending &= (uint8_t)~(1 << n);
+	}
+}
+
+//Copies the next frame in 'str' (COMM_STR_BUF_LEN bytes). Returns its
+//length, 0 if the queue is empty.
+uint16_t txq_pop(struct txq_s *q, uint8_t *str, uint8_t *cmd)
+{
+	struct txq_slot_s *s = txq_front(q);
+	uint16_t len = 0;
+
+	if(s == NULL)
+	{
+		return 0;
+	}
+
+	memcpy(str, s->data, s->len);
+	len = s->len;
+	if(cmd)
+	{
+		*cmd = s->cmd;
+	}
+	txq_release(q);
+
+	return len;
+}
+
+uint8_t txq_count(struct txq_s *q)
+{
+	uint8_t i = 0, cnt = 0;
+
+	for(i = 0; i < TXQ_LEVELS; i++)
+	{
+		cnt += q->level[i].cnt;
+	}
+
+	return cnt;
+}
+
+//Sends the next frame with comm_port_send(). Returns 1 if one went out.
+uint8_t txq_send(struct txq_s *q, uint8_t port)
+{
+	struct txq_slot_s *s = txq_front(q);
+
+	if((s == NULL) || !comm_port_send(port, s->data, s->len))
+	{
+		return 0;
+	}
+
+	txq_release(q);
+	return 1;
+}
+
+//For the drivers that use comm_tx_s: loads the next frame when the last
+//one is gone (inject == 0). Returns 1 if it did.
+uint8_t txq_fill_tx(struct txq_s *q, struct comm_tx_s *tx)
+{
+	if(tx->inject)
+	{
+		return 0;
+	}
+
+	tx->len = (uint8_t)txq_pop(q, tx->txBuf, &tx->cmd);
+	if(tx->len == 0)
+	{
+		return 0;
+	}
+
+	tx->inject = 1;
+	return 1;
+}
+
+//****************************************************************************
+// Private Function(s)
+//****************************************************************************
+
+//Makes room on a full level: drops its oldest frame, or the next one if the
+//oldest is in flight. Returns 0 if there's nothing it can drop.
+static uint8_t txq_evict(struct txq_s *q, uint8_t level)
+{
+	struct txq_level_s *l = &q->level[level];
+	uint8_t i = 0;
+
+	if(q->out != (level + 1))
+	{
+		l->head = (l->head + 1) & (TXQ_DEPTH - 1);
+		l->cnt--;
+		return 1;
+	}
+
+	if(l->cnt < 2)
+	{
+		return 0;
+	}
+
+	//Keep the head where it is, close the gap behind it:
+	for(i = 1; i < (l->cnt - 1); i++)
+	{
+		l->slot[(l->head + i) & (TXQ_DEPTH - 1)] = \
+			l->slot[(l->head + i + 1) & (TXQ_DEPTH - 1)];
+	}
+	l->cnt--;
+	return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -30,6 +30,25 @@ int flexsea_comm_test(void)
 	test_flexsea_comm();
 	test_flexsea_payload();
 	test_flexsea_buffers();
+	test_flexsea_link();
+	test_flexsea_arq();
+	test_flexsea_frag();
+	test_flexsea_stream();
+	test_flexsea_transport();
+	test_flexsea_pipeline();
+	test_flexsea_sim();
+	test_flexsea_tdma();
+	test_flexsea_txq();
+	test_flexsea_corr();
+	test_flexsea_hist();
+	test_flexsea_stats();
+	test_flexsea_capture();
+	test_flexsea_replay();
+	test_flexsea_bulk();
+	test_flexsea_columns();
+	#ifdef ENABLE_FLEXSEA_ASYNC
+	test_flexsea_async();
+	#endif	//ENABLE_FLEXSEA_ASYNC
 
 	return UNITY_END();
 }
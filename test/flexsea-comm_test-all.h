@@ -17,6 +17,23 @@ void test_flexsea(void);
 void test_flexsea_buffers(void);
 void test_flexsea_comm(void);
 void test_flexsea_payload(void);
+void test_flexsea_link(void);
+void test_flexsea_arq(void);
+void test_flexsea_frag(void);
+void test_flexsea_stream(void);
+void test_flexsea_transport(void);
+void test_flexsea_pipeline(void);
+void test_flexsea_sim(void);
+void test_flexsea_tdma(void);
+void test_flexsea_txq(void);
+void test_flexsea_corr(void);
+void test_flexsea_hist(void);
+void test_flexsea_stats(void);
+void test_flexsea_capture(void);
+void test_flexsea_replay(void);
+void test_flexsea_bulk(void);
+void test_flexsea_columns(void);
+void test_flexsea_async(void);		//C++20, test-flexsea_async.cpp
 
 #endif	//TEST_ALL_FX_COMM_H
 
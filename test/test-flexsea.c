@@ -79,11 +79,39 @@ void test_SPLIT_REBUILD_32(void)
 	}
 }
 
+//Functions under test: SPLIT_x_NATIVE() & REBUILD_x_NATIVE()
+void test_SPLIT_REBUILD_NATIVE(void)
+{
+	uint8_t myBuf[16];
+	uint16_t index = 0;
+
+	//u8, u32, u16, u16, u32: aligned, little endian
+	memset(myBuf, 0, sizeof(myBuf));
+	myBuf[index++] = 0xAA;
+	SPLIT_32_NATIVE(0x12345678, myBuf, &index);
+	TEST_ASSERT_EQUAL(8, index);
+	SPLIT_16_NATIVE((uint16_t)-2, myBuf, &index);
+	SPLIT_16_NATIVE(0xBEEF, myBuf, &index);
+	SPLIT_32_NATIVE((uint32_t)-123456, myBuf, &index);
+	TEST_ASSERT_EQUAL(16, index);
+	TEST_ASSERT_EQUAL(0x78, myBuf[4]);
+	TEST_ASSERT_EQUAL(0x12, myBuf[7]);
+	TEST_ASSERT_EQUAL(0xEF, myBuf[10]);
+
+	index = 1;
+	TEST_ASSERT_EQUAL(0x12345678, REBUILD_UINT32_NATIVE(myBuf, &index));
+	TEST_ASSERT_EQUAL(-2, (int16_t)REBUILD_UINT16_NATIVE(myBuf, &index));
+	TEST_ASSERT_EQUAL(0xBEEF, REBUILD_UINT16_NATIVE(myBuf, &index));
+	TEST_ASSERT_EQUAL(-123456, (int32_t)REBUILD_UINT32_NATIVE(myBuf, &index));
+	TEST_ASSERT_EQUAL(16, index);
+}
+
 void test_flexsea(void)
 {
 	UNITY_BEGIN();
 	RUN_TEST(test_SPLIT_REBUILD_16);
 	RUN_TEST(test_SPLIT_REBUILD_32);
+	RUN_TEST(test_SPLIT_REBUILD_NATIVE);
 	UNITY_END();
 }
 
@@ -0,0 +1,369 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+//Definitions and variables used by some/all tests:
+//Two ends in the same process: A uses PORT_SPI, B uses PORT_USB.
+#define WIRE_DEPTH		16
+#define ARQ_PORT_A		PORT_SPI
+#define ARQ_PORT_B		PORT_USB
+
+struct wire_s
+{
+	uint8_t str[WIRE_DEPTH][RX_BUF_LEN];
+	uint8_t cnt;
+	uint8_t drop;		//Drop frame number 'drop' (1 = next one)
+	uint8_t corrupt;	//Same, but flip a bit instead
+};
+
+struct wire_s wireToA, wireToB;
+uint8_t arqDelivered[16];
+uint8_t arqDeliveredCnt = 0;
+uint8_t arqRxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+
+static void wire_push(struct wire_s *w, uint8_t *str, uint16_t len)
+{
+	if(w->drop && !(--w->drop))
+	{
+		return;
+	}
+
+	memset(w->str[w->cnt], 0, RX_BUF_LEN);
+	memcpy(w->str[w->cnt], str, len);
+	if(w->corrupt && !(--w->corrupt))
+	{
+		w->str[w->cnt][3] ^= 0x10;
+	}
+	w->cnt++;
+}
+
+static void sendA(uint8_t *str, uint16_t len) { wire_push(&wireToB, str, len); }
+static void sendB(uint8_t *str, uint16_t len) { wire_push(&wireToA, str, len); }
+
+static void arqTestHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)info;
+	arqDelivered[arqDeliveredCnt++] = buf[P_DATA1];
+}
+
+//Decodes everything on the wire and passes it to 'port'
+static void wire_pump(struct wire_s *w, uint8_t port, uint32_t now)
+{
+	uint8_t info[2] = {port, 0};
+	uint8_t i = 0, cnt = w->cnt;
+
+	w->cnt = 0;
+	for(i = 0; i < cnt; i++)
+	{
+		if(unpack_payload_test(w->str[i], arqRxCmd) == 1)
+		{
+			arq_receive(port, arqRxCmd[0], info, now);
+		}
+		else
+		{
+			arq_rx_error(port, now);
+		}
+	}
+}
+
+static void arq_test_setup(void)
+{
+	memset(&wireToA, 0, sizeof(wireToA));
+	memset(&wireToB, 0, sizeof(wireToB));
+	arqDeliveredCnt = 0;
+	flexsea_port_send_ptr[ARQ_PORT_A] = &sendA;
+	flexsea_port_send_ptr[ARQ_PORT_B] = &sendB;
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_WRITE] = &arqTestHandler;
+	arq_enable(ARQ_PORT_A, 10);
+	arq_enable(ARQ_PORT_B, 10);
+}
+
+static void arq_test_cleanup(void)
+{
+	arq_disable(ARQ_PORT_A);
+	arq_disable(ARQ_PORT_B);
+	flexsea_port_send_ptr[ARQ_PORT_A] = NULL;
+	flexsea_port_send_ptr[ARQ_PORT_B] = NULL;
+}
+
+static uint8_t arq_test_send(uint8_t n, uint32_t now)
+{
+	uint8_t buf[PAYLOAD_BUF_LEN];
+
+	prepare_empty_payload(FLEXSEA_PLAN_1, board_id, buf, PAYLOAD_BUF_LEN);
+	buf[P_CMDS] = 1;
+	buf[P_CMD1] = CMD_W(CMD_TEST);
+	buf[P_DATA1] = n;
+	return arq_send(ARQ_PORT_A, buf, P_DATA1 + 1, now);
+}
+
+void test_arq_in_order(void)
+{
+	uint8_t i = 0;
+
+	arq_test_setup();
+
+	for(i = 0; i < ARQ_WINDOW; i++)
+	{
+		TEST_ASSERT_EQUAL(1, arq_test_send(i, 0));
+	}
+	TEST_ASSERT_EQUAL_MESSAGE(0, arq_test_send(i, 0), "Window full");
+	TEST_ASSERT_EQUAL(ARQ_WINDOW, arq_in_flight(ARQ_PORT_A));
+
+	wire_pump(&wireToB, ARQ_PORT_B, 1);
+	TEST_ASSERT_EQUAL(ARQ_WINDOW, arqDeliveredCnt);
+	for(i = 0; i < ARQ_WINDOW; i++)
+	{
+		TEST_ASSERT_EQUAL(i, arqDelivered[i]);
+	}
+
+	//Standalone ACK once the delay expired:
+	arq_poll(ARQ_PORT_B, 1);
+	TEST_ASSERT_EQUAL(0, wireToA.cnt);
+	arq_poll(ARQ_PORT_B, 6);
+	TEST_ASSERT_EQUAL(1, wireToA.cnt);
+	wire_pump(&wireToA, ARQ_PORT_A, 6);
+	TEST_ASSERT_EQUAL(0, arq_in_flight(ARQ_PORT_A));
+	TEST_ASSERT_EQUAL(0, commArq[ARQ_PORT_A].retransmits);
+
+	arq_test_cleanup();
+}
+
+//A lost frame is NAKed by the receiver and resent before the timeout
+void test_arq_selective_retransmit(void)
+{
+	uint8_t i = 0;
+
+	arq_test_setup();
+	wireToB.drop = 2;
+
+	for(i = 0; i < ARQ_WINDOW; i++)
+	{
+		arq_test_send(i, 0);
+	}
+	wire_pump(&wireToB, ARQ_PORT_B, 1);
+	TEST_ASSERT_EQUAL_MESSAGE(1, arqDeliveredCnt, "Stops at the gap");
+
+	//NAK, resend (one round trip, no timeout):
+	arq_poll(ARQ_PORT_B, 1);
+	wire_pump(&wireToA, ARQ_PORT_A, 2);
+	TEST_ASSERT_EQUAL(1, commArq[ARQ_PORT_A].retransmits);
+	wire_pump(&wireToB, ARQ_PORT_B, 3);
+
+	TEST_ASSERT_EQUAL(ARQ_WINDOW, arqDeliveredCnt);
+	for(i = 0; i < ARQ_WINDOW; i++)
+	{
+		TEST_ASSERT_EQUAL(i, arqDelivered[i]);
+	}
+
+	arq_test_cleanup();
+}
+
+//Bad checksum: immediate NAK
+void test_arq_checksum_nak(void)
+{
+	arq_test_setup();
+	wireToB.corrupt = 1;
+
+	arq_test_send(0, 0);
+	wire_pump(&wireToB, ARQ_PORT_B, 1);
+	TEST_ASSERT_EQUAL(0, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL_MESSAGE(1, wireToA.cnt, "NAK sent");
+
+	wire_pump(&wireToA, ARQ_PORT_A, 2);
+	wire_pump(&wireToB, ARQ_PORT_B, 3);
+	TEST_ASSERT_EQUAL(1, arqDeliveredCnt);
+
+	arq_test_cleanup();
+}
+
+//Lost ACK: timeout, retransmission, duplicate filtered
+void test_arq_timeout(void)
+{
+	arq_test_setup();
+
+	arq_test_send(7, 0);
+	wire_pump(&wireToB, ARQ_PORT_B, 1);
+	TEST_ASSERT_EQUAL(1, arqDeliveredCnt);
+
+	arq_poll(ARQ_PORT_A, 5);
+	TEST_ASSERT_EQUAL(0, commArq[ARQ_PORT_A].retransmits);
+	arq_poll(ARQ_PORT_A, 10);
+	TEST_ASSERT_EQUAL(1, commArq[ARQ_PORT_A].retransmits);
+
+	wire_pump(&wireToB, ARQ_PORT_B, 11);
+	TEST_ASSERT_EQUAL_MESSAGE(1, arqDeliveredCnt, "No duplicate delivery");
+	TEST_ASSERT_EQUAL(1, commArq[ARQ_PORT_B].duplicates);
+
+	arq_test_cleanup();
+}
+
+//Multi-drop bus: this board (FLEXSEA_MANAGE_1) is the master on PORT_485_1.
+//Its slaves FLEXSEA_EXECUTE_1 and _2 share the other end, PORT_485_2:
+//board_id is theirs while they decode.
+#define ARQ_BUS_MASTER		PORT_485_1
+#define ARQ_BUS_SLAVE		PORT_485_2
+
+//Slaves reply to every write, with the same data (a Reply for the master)
+static void arqBusHandler(uint8_t *buf, uint8_t *info)
+{
+	uint8_t reply[PAYLOAD_BUF_LEN];
+
+	arqDelivered[arqDeliveredCnt++] = buf[P_DATA1];
+	if(info[0] == ARQ_BUS_SLAVE)
+	{
+		prepare_empty_payload(board_id, buf[P_XID], reply, PAYLOAD_BUF_LEN);
+		reply[P_CMDS] = 1;
+		reply[P_CMD1] = CMD_W(CMD_TEST);
+		reply[P_DATA1] = buf[P_DATA1];
+		TEST_ASSERT_EQUAL(1, arq_send(ARQ_BUS_SLAVE, reply, P_DATA1 + 1, 0));
+	}
+}
+
+static uint8_t arq_bus_send(uint8_t rid, uint8_t n, uint32_t now)
+{
+	uint8_t buf[PAYLOAD_BUF_LEN];
+
+	prepare_empty_payload(board_id, rid, buf, PAYLOAD_BUF_LEN);
+	buf[P_CMDS] = 1;
+	buf[P_CMD1] = CMD_W(CMD_TEST);
+	buf[P_DATA1] = n;
+	return arq_send(ARQ_BUS_MASTER, buf, P_DATA1 + 1, now);
+}
+
+//Slave 'id' (no slaves of its own) decodes what the master sent, or polls
+static void arq_bus_slave(uint8_t id, uint32_t now, uint8_t poll)
+{
+	uint8_t master = board_id, up = board_up_id;
+	uint8_t sub1[SLAVE_BUS_1_CNT], sub2[SLAVE_BUS_1_CNT];
+
+	memcpy(sub1, board_sub1_id, sizeof(sub1));
+	memcpy(sub2, board_sub2_id, sizeof(sub2));
+	memset(board_sub1_id, 0, sizeof(sub1));
+	memset(board_sub2_id, 0, sizeof(sub2));
+	board_id = id;
+	board_up_id = master;
+
+	if(poll)
+	{
+		arq_poll(ARQ_BUS_SLAVE, now);
+	}
+	else
+	{
+		wire_pump(&wireToB, ARQ_BUS_SLAVE, now);
+	}
+
+	board_id = master;
+	board_up_id = up;
+	memcpy(board_sub1_id, sub1, sizeof(sub1));
+	memcpy(board_sub2_id, sub2, sizeof(sub2));
+}
+
+//Per slave sequence numbers, ACK/NAK only in reply to the master
+void test_arq_bus(void)
+{
+	memset(&wireToA, 0, sizeof(wireToA));
+	memset(&wireToB, 0, sizeof(wireToB));
+	arqDeliveredCnt = 0;
+	flexsea_port_send_ptr[ARQ_BUS_MASTER] = &sendA;
+	flexsea_port_send_ptr[ARQ_BUS_SLAVE] = &sendB;
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_WRITE] = &arqBusHandler;
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &arqBusHandler;
+	TEST_ASSERT_EQUAL(1, arq_enable(ARQ_BUS_MASTER, 10));
+	TEST_ASSERT_EQUAL(1, arq_enable(ARQ_BUS_SLAVE, 10));
+
+	//One frame for each slave, only EXECUTE_1 listens:
+	TEST_ASSERT_EQUAL(1, arq_bus_send(FLEXSEA_EXECUTE_1, 1, 0));
+	TEST_ASSERT_EQUAL(1, arq_bus_send(FLEXSEA_EXECUTE_2, 2, 0));
+	TEST_ASSERT_EQUAL(1, arq_peer_in_flight(ARQ_BUS_MASTER, FLEXSEA_EXECUTE_1));
+	TEST_ASSERT_EQUAL(1, arq_peer_in_flight(ARQ_BUS_MASTER, FLEXSEA_EXECUTE_2));
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 1, 0);
+	TEST_ASSERT_EQUAL(1, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL(1, commArq[ARQ_BUS_SLAVE].ignored);
+	TEST_ASSERT_EQUAL_MESSAGE(1, wireToA.cnt, "Reply, with the ACK");
+	wire_pump(&wireToA, ARQ_BUS_MASTER, 2);
+	TEST_ASSERT_EQUAL(2, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL(0, arq_peer_in_flight(ARQ_BUS_MASTER, FLEXSEA_EXECUTE_1));
+	TEST_ASSERT_EQUAL(1, arq_peer_in_flight(ARQ_BUS_MASTER, FLEXSEA_EXECUTE_2));
+
+	//Lost frame: NAKed right after the next one, resent in one round trip
+	arqDeliveredCnt = 0;
+	wireToB.drop = 1;
+	arq_bus_send(FLEXSEA_EXECUTE_1, 3, 3);
+	arq_bus_send(FLEXSEA_EXECUTE_1, 4, 3);
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 4, 0);
+	TEST_ASSERT_EQUAL(0, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL_MESSAGE(1, wireToA.cnt, "NAK");
+	wire_pump(&wireToA, ARQ_BUS_MASTER, 5);
+	TEST_ASSERT_EQUAL(1, commArq[ARQ_BUS_MASTER].retransmits);
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 6, 0);
+	TEST_ASSERT_EQUAL(2, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL(3, arqDelivered[0]);
+	TEST_ASSERT_EQUAL(4, arqDelivered[1]);
+
+	//Lost reply: the slave keeps quiet until the master times out and sends
+	//again, then resends it
+	wireToA.cnt = 0;
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 100, 1);
+	TEST_ASSERT_EQUAL_MESSAGE(0, wireToA.cnt, "The slave never talks first");
+	arq_poll(ARQ_BUS_MASTER, 100);
+	TEST_ASSERT_NOT_EQUAL(0, wireToB.cnt);
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 101, 0);
+	TEST_ASSERT_EQUAL(2, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL(2, commArq[ARQ_BUS_SLAVE].retransmits);
+	wire_pump(&wireToA, ARQ_BUS_MASTER, 102);
+	TEST_ASSERT_EQUAL(4, arqDeliveredCnt);
+	TEST_ASSERT_EQUAL(0, arq_peer_in_flight(ARQ_BUS_MASTER, FLEXSEA_EXECUTE_1));
+
+	//The master can ACK on its own:
+	arq_poll(ARQ_BUS_MASTER, 110);
+	arq_bus_slave(FLEXSEA_EXECUTE_1, 111, 0);
+	TEST_ASSERT_EQUAL(0, arq_peer_in_flight(ARQ_BUS_SLAVE, FLEXSEA_EXECUTE_1));
+
+	arq_disable(ARQ_BUS_MASTER);
+	arq_disable(ARQ_BUS_SLAVE);
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &flexsea_payload_catchall;
+	flexsea_port_send_ptr[ARQ_BUS_MASTER] = NULL;
+	flexsea_port_send_ptr[ARQ_BUS_SLAVE] = NULL;
+}
+
+//Negotiated on bus ports too
+void test_arq_bus_link(void)
+{
+	struct link_caps_s caps;
+	uint8_t info[2] = {PORT_485_1, 0};
+	uint8_t buf[PAYLOAD_BUF_LEN];
+
+	init_flexsea_link();
+	caps = commLink[PORT_485_1].local;
+	caps.features = LINK_FEAT_ARQ;
+	link_set_local_caps(PORT_485_1, &caps);
+	TEST_ASSERT_EQUAL(LINK_FEAT_ARQ, commLink[PORT_485_1].local.features);
+
+	tx_cmd_link_caps(buf, FLEXSEA_EXECUTE_1, FLEXSEA_MANAGE_1, WRITE, &caps);
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(LINK_NEGOTIATED, commLink[PORT_485_1].state);
+	TEST_ASSERT_EQUAL(LINK_FEAT_ARQ, commLink[PORT_485_1].active.features);
+	TEST_ASSERT_EQUAL(1, arq_is_enabled(PORT_485_1));
+
+	link_reset(PORT_485_1);
+	TEST_ASSERT_EQUAL(0, arq_is_enabled(PORT_485_1));
+}
+
+void test_flexsea_arq(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_arq_in_order);
+	RUN_TEST(test_arq_selective_retransmit);
+	RUN_TEST(test_arq_checksum_nak);
+	RUN_TEST(test_arq_timeout);
+	RUN_TEST(test_arq_bus);
+	RUN_TEST(test_arq_bus_link);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
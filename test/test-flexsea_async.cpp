@@ -0,0 +1,304 @@
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../inc/flexsea_async.hpp"
+#include "../inc/flexsea_pipeline.h"
+
+extern "C" {
+
+#include "flexsea-comm_test-all.h"
+
+}
+
+#ifdef ENABLE_FLEXSEA_ASYNC
+
+//Definitions and variables used by some/all tests:
+using namespace std::chrono_literals;
+
+static std::vector<std::vector<uint8_t>> asyncSent;
+
+static bool asyncTestSend(uint8_t port, uint8_t *str, uint16_t len)
+{
+	(void)port;
+	asyncSent.emplace_back(str, str + len);
+	return true;
+}
+
+static void asyncTestReplyHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+}
+
+//Reply from 'slave' to the master, one data byte
+static void asyncTestReply(uint8_t *payload, uint8_t slave, uint8_t cmd, uint8_t data)
+{
+	prepare_empty_payload(slave, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(cmd);
+	payload[P_DATA1] = data;
+}
+
+static flexsea::Task asyncTestRead(flexsea::Port &port, uint8_t slave, \
+									flexsea::Reply *out, int *done)
+{
+	*out = co_await port.read(slave, CMD_TEST);
+	(*done)++;
+}
+
+//Suspends on the request, resumes with the reply
+void test_async_read(void)
+{
+	uint8_t payload[PACKAGED_PAYLOAD_LEN], info[2] = {PORT_USB, 0};
+	flexsea::Reply r;
+	int done = 0;
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &asyncTestReplyHandler;
+	asyncSent.clear();
+	{
+		flexsea::EventLoop loop;
+		flexsea::Port port(loop, PORT_USB);
+		loop.set_sender(&asyncTestSend);
+
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+		TEST_ASSERT_EQUAL(0, done);
+		TEST_ASSERT_EQUAL(1, loop.pending());
+		TEST_ASSERT_EQUAL(1, asyncSent.size());
+
+		//That's our Read:
+		TEST_ASSERT_GREATER_THAN(0, unpack_payload_frame(asyncSent[0].data(), \
+								(uint16_t)asyncSent[0].size(), payload));
+		TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1, payload[P_RID]);
+		TEST_ASSERT_EQUAL(CMD_R(CMD_TEST), payload[P_CMD1]);
+
+		//Someone else's reply, then ours. Resumed by the loop only:
+		asyncTestReply(payload, FLEXSEA_EXECUTE_2, CMD_TEST, 1);
+		TEST_ASSERT_FALSE(corr_receive(loop.corr(), payload, info, loop.ticks()));
+		asyncTestReply(payload, FLEXSEA_EXECUTE_1, CMD_TEST, 42);
+		TEST_ASSERT_TRUE(corr_receive(loop.corr(), payload, info, loop.ticks()));
+		TEST_ASSERT_EQUAL(0, done);
+		TEST_ASSERT_EQUAL(1, loop.poll(flexsea::Clock::now()));
+
+		TEST_ASSERT_EQUAL(1, done);
+		TEST_ASSERT_TRUE(r.status == flexsea::Status::Ok);
+		TEST_ASSERT_EQUAL(42, r.payload[P_DATA1]);
+		TEST_ASSERT_EQUAL(0, loop.pending());
+		TEST_ASSERT_EQUAL(1, loop.corr()->unmatched);
+	}
+}
+
+void test_async_timeout(void)
+{
+	flexsea::Reply r;
+	int done = 0;
+
+	{
+		flexsea::EventLoop loop;
+		flexsea::Port port(loop, PORT_USB);
+		auto t0 = flexsea::Clock::now();
+
+		loop.set_sender(&asyncTestSend);
+		loop.set_timeout(20ms);
+		loop.poll(t0);
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+
+		loop.poll(t0 + 19ms);
+		TEST_ASSERT_EQUAL(0, done);
+		loop.poll(t0 + 20ms);
+		TEST_ASSERT_EQUAL(1, done);
+		TEST_ASSERT_TRUE(r.status == flexsea::Status::Timeout);
+		TEST_ASSERT_EQUAL(1, loop.timeouts);
+
+		//Can't send:
+		loop.set_sender([](uint8_t, uint8_t *, uint16_t) { return false; });
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+		TEST_ASSERT_EQUAL(2, done);
+		TEST_ASSERT_TRUE(r.status == flexsea::Status::SendError);
+
+		//Destroyed with a read in flight:
+		loop.set_sender(&asyncTestSend);
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+	}
+	TEST_ASSERT_EQUAL(3, done);
+	TEST_ASSERT_TRUE(r.status == flexsea::Status::Cancelled);
+}
+
+//Several reads per slave, in order, on many slaves at once
+static flexsea::Task asyncTestLoop(flexsea::Port &port, uint8_t slave, int n, \
+									std::vector<uint8_t> *got)
+{
+	for(int i = 0; i < n; i++)
+	{
+		flexsea::Reply r = co_await port.read(slave, CMD_TEST);
+		got->push_back(r.payload[P_DATA1]);
+	}
+}
+
+void test_async_many(void)
+{
+	uint8_t payload[PACKAGED_PAYLOAD_LEN], info[2] = {PORT_USB, 0};
+	std::vector<uint8_t> got[8];
+	int i = 0, j = 0;
+
+	flexsea::EventLoop loop;
+	flexsea::Port port(loop, PORT_USB);
+	loop.set_sender(&asyncTestSend);
+
+	//8 slaves, 250 coroutines each with 4 reads:
+	for(i = 0; i < 2000; i++)
+	{
+		asyncTestLoop(port, (uint8_t)(FLEXSEA_EXECUTE_1 + (i % 8)), 4, &got[i % 8]);
+	}
+	TEST_ASSERT_EQUAL(2000, loop.pending());
+
+	for(j = 0; j < 4 * 250; j++)
+	{
+		for(i = 0; i < 8; i++)
+		{
+			asyncTestReply(payload, (uint8_t)(FLEXSEA_EXECUTE_1 + i), CMD_TEST, (uint8_t)j);
+			corr_receive(loop.corr(), payload, info, loop.ticks());
+		}
+		loop.poll(flexsea::Clock::now());
+	}
+
+	TEST_ASSERT_EQUAL(0, loop.pending());
+	TEST_ASSERT_EQUAL(8000, loop.replies);
+	for(i = 0; i < 8; i++)
+	{
+		TEST_ASSERT_EQUAL(1000, got[i].size());
+		for(j = 0; j < 1000; j++)
+		{
+			TEST_ASSERT_EQUAL((uint8_t)j, got[i][j]);
+		}
+	}
+}
+
+//One table for the coroutines and a pipeline on the same port
+void test_async_shared(void)
+{
+	static struct corr_s c;
+	struct pipe_s pipe;
+	uint8_t payload[PACKAGED_PAYLOAD_LEN], info[2] = {PORT_USB, 0};
+	flexsea::Reply r;
+	int done = 0;
+
+	corr_init(&c, 100, nullptr);
+	{
+		flexsea::EventLoop loop(&c);
+		flexsea::Port port(loop, PORT_USB);
+		loop.set_sender(&asyncTestSend);
+		pipe_init(&pipe, &c, PORT_USB, 2, 0);
+
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+		prepare_empty_payload(board_id, FLEXSEA_EXECUTE_2, payload, PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_R(CMD_TEST);
+		TEST_ASSERT_NOT_NULL(pipe_issue(&pipe, payload, loop.ticks()));
+
+		//Not twice:
+		prepare_empty_payload(board_id, FLEXSEA_EXECUTE_1, payload, PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_R(CMD_TEST);
+		TEST_ASSERT_NULL(pipe_issue(&pipe, payload, loop.ticks()));
+		TEST_ASSERT_EQUAL(2, c.pending);
+
+		asyncTestReply(payload, FLEXSEA_EXECUTE_2, CMD_TEST, 1);
+		TEST_ASSERT_TRUE(corr_receive(loop.corr(), payload, info, loop.ticks()));
+		asyncTestReply(payload, FLEXSEA_EXECUTE_1, CMD_TEST, 2);
+		TEST_ASSERT_TRUE(corr_receive(loop.corr(), payload, info, loop.ticks()));
+		TEST_ASSERT_EQUAL(1, pipe.matched);
+		TEST_ASSERT_EQUAL(1, loop.poll(flexsea::Clock::now()));
+		TEST_ASSERT_EQUAL(1, done);
+		TEST_ASSERT_EQUAL(2, r.payload[P_DATA1]);
+
+		//Cancelled by the loop, the pipeline's stays:
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+		prepare_empty_payload(board_id, FLEXSEA_EXECUTE_2, payload, PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_R(CMD_TEST);
+		TEST_ASSERT_NOT_NULL(pipe_issue(&pipe, payload, loop.ticks()));
+		TEST_ASSERT_EQUAL(2, c.pending);
+	}
+	TEST_ASSERT_EQUAL(2, done);
+	TEST_ASSERT_TRUE(r.status == flexsea::Status::Cancelled);
+	TEST_ASSERT_EQUAL(1, c.pending);
+}
+
+//Shared with a table in us (flexsea_tdma's unit): same time base
+void test_async_shared_us(void)
+{
+	static struct corr_s c;
+	flexsea::Reply r;
+	int done = 0;
+
+	corr_init(&c, 100, nullptr);
+	{
+		flexsea::EventLoop loop(&c, 1us);
+		flexsea::Port port(loop, PORT_USB);
+		auto t0 = flexsea::Clock::now();
+
+		TEST_ASSERT_EQUAL(5000, loop.ticks(t0 + 5ms) - loop.ticks(t0));
+		loop.set_sender(&asyncTestSend);
+		loop.set_timeout(2ms);
+		loop.poll(t0);
+		asyncTestRead(port, FLEXSEA_EXECUTE_1, &r, &done);
+		TEST_ASSERT_EQUAL(1, c.pending);
+
+		loop.poll(t0 + 1999us);
+		TEST_ASSERT_EQUAL(0, done);
+		loop.poll(t0 + 2ms);
+		TEST_ASSERT_EQUAL(1, done);
+		TEST_ASSERT_TRUE(r.status == flexsea::Status::Timeout);
+	}
+}
+
+//Driven by flexsea_transport: the reply comes back on a socket
+void test_async_transport(void)
+{
+	static struct transport_s t;
+	uint8_t payload[PAYLOAD_BUF_LEN], str[COMM_STR_BUF_LEN], rx[COMM_STR_BUF_LEN];
+	flexsea::Reply r;
+	int sv[2], done = 0;
+	uint8_t len = 0;
+
+	TEST_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+	TEST_ASSERT_EQUAL(0, transport_init(&t));
+	TEST_ASSERT_EQUAL(0, transport_add_fd(&t, sv[0], PORT_USB));
+
+	{
+		flexsea::EventLoop loop;
+		flexsea::Port port(loop, PORT_USB);
+		loop.bind(&t);
+
+		asyncTestRead(port, FLEXSEA_EXECUTE_2, &r, &done);
+		TEST_ASSERT_GREATER_THAN(0, read(sv[1], rx, sizeof(rx)));
+
+		asyncTestReply(payload, FLEXSEA_EXECUTE_2, CMD_TEST, 7);
+		len = comm_gen_str(payload, str, P_DATA1 + 1);
+		TEST_ASSERT_EQUAL(len + 1, write(sv[1], str, len + 1));
+
+		TEST_ASSERT_EQUAL(0, loop.run());
+		TEST_ASSERT_EQUAL(1, done);
+		TEST_ASSERT_TRUE(r.status == flexsea::Status::Ok);
+		TEST_ASSERT_EQUAL(7, r.payload[P_DATA1]);
+	}
+
+	transport_close(&t);
+	close(sv[1]);
+}
+
+#endif	//ENABLE_FLEXSEA_ASYNC
+
+extern "C" void test_flexsea_async(void)
+{
+	UNITY_BEGIN();
+	#ifdef ENABLE_FLEXSEA_ASYNC
+	RUN_TEST(test_async_read);
+	RUN_TEST(test_async_timeout);
+	RUN_TEST(test_async_many);
+	RUN_TEST(test_async_shared);
+	RUN_TEST(test_async_shared_us);
+	RUN_TEST(test_async_transport);
+	#endif	//ENABLE_FLEXSEA_ASYNC
+	UNITY_END();
+}
@@ -14,7 +14,34 @@ void test_update_rx_buf_byte_1(void)
 
 void test_update_rx_buf_array_1(void)
 {
-	//ToDo
+	uint8_t arr[RX_BUF_LEN + 20];
+	struct rx_buf_s rb;
+	int i;
+
+	for(i = 0; i < RX_BUF_LEN + 20; i++)
+	{
+		arr[i] = i;
+	}
+
+	//Fits without shifting:
+	memset(&rb, 0, sizeof(rb));
+	update_rx_buf_array_s(&rb, arr, 30);
+	TEST_ASSERT_EQUAL(30, rb.idx);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(arr, rb.buf, 30);
+
+	//Partly fits: the oldest bytes are discarded
+	update_rx_buf_array_s(&rb, &arr[30], 80);
+	TEST_ASSERT_EQUAL(RX_BUF_LEN, rb.idx);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(&arr[10], rb.buf, RX_BUF_LEN);
+
+	//Longer than the buffer:
+	update_rx_buf_array_s(&rb, arr, RX_BUF_LEN + 20);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(&arr[20], rb.buf, RX_BUF_LEN);
+
+	//Buffer #1 is full after test_buffer_stack():
+	update_rx_buf_array_1(arr, 10);
+	TEST_ASSERT_EQUAL(9, rx_buf_1[RX_BUF_LEN - 1]);
+	TEST_ASSERT_EQUAL(0, rx_buf_1[RX_BUF_LEN - 10]);
 }
 
 void test_buffer_stack(void)
@@ -64,6 +91,7 @@ void test_flexsea_buffers(void)
 	UNITY_BEGIN();
 	RUN_TEST(test_buffer_stack);
 	RUN_TEST(test_buffer_circular);
+	RUN_TEST(test_update_rx_buf_array_1);
 	UNITY_END();
 }
 
@@ -0,0 +1,220 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+#ifdef __linux__
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "../inc/flexsea_bulk.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+#define BULK_TEST_LEN		60000
+#define BULK_TEST_FRAMES	(BULK_TEST_LEN / BULK_MIN_FRAME)
+
+struct bulk_test_s
+{
+	uint64_t offset[BULK_TEST_FRAMES];
+	uint8_t data[BULK_TEST_FRAMES];
+	uint32_t cnt;
+	uint32_t sum;
+};
+
+static struct bulk_s testBulk;
+static struct bulk_test_s bulkRef, bulkGot;
+static uint8_t bulkStream[BULK_TEST_LEN];
+
+static void bulkTestCallback(struct bulk_s *b, struct bulk_frame_s *f)
+{
+	struct bulk_test_s *t = (struct bulk_test_s *)b->ctx;
+	uint8_t i = 0;
+
+	TEST_ASSERT_EQUAL(f->len, bulk_frame_at(bulkStream, BULK_TEST_LEN, f->offset));
+	t->offset[t->cnt] = f->offset;
+	t->data[t->cnt] = (f->payloadLen > P_DATA1) ? f->payload[P_DATA1] : 0;
+	for(i = 0; i < f->payloadLen; i++)
+	{
+		t->sum = t->sum * 31 + f->payload[i];
+	}
+	t->cnt++;
+}
+
+//Frame with 'data' in P_DATA1 and 'n' bytes of payload. Returns its length.
+static uint8_t bulkTestFrame(uint8_t *str, uint8_t data, uint8_t n)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint8_t i = 0;
+
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	for(i = P_DATA1; i < n; i++)
+	{
+		payload[i] = (uint8_t)(data + i - P_DATA1);
+	}
+	return comm_gen_str(payload, str, n) + 1;
+}
+
+//Frames and noise made of framing bytes. Some frames are cut.
+static void bulkTestNoisy(uint32_t seed)
+{
+	uint8_t alphabet[7] = {HEADER, FOOTER, ESCAPE, 0, 1, 2, 3};
+	uint8_t str[2 * COMM_STR_BUF_LEN];
+	uint32_t pos = 0;
+	uint8_t len = 0, i = 0;
+
+	srand(seed);
+	while(pos < BULK_TEST_LEN)
+	{
+		if(rand() & 1)
+		{
+			bulkStream[pos++] = alphabet[rand() % sizeof(alphabet)];
+			continue;
+		}
+
+		len = bulkTestFrame(str, (uint8_t)rand(), \
+							P_DATA1 + 1 + (rand() % (PAYLOAD_BUF_LEN - P_DATA1)));
+		if((rand() % 8) == 0)
+		{
+			len = (uint8_t)(rand() % len);
+		}
+		for(i = 0; (i < len) && (pos < BULK_TEST_LEN); i++)
+		{
+			bulkStream[pos++] = str[i];
+		}
+	}
+}
+
+static void bulkTestDecode(struct bulk_test_s *t, uint8_t threads, uint32_t chunk)
+{
+	memset(t, 0, sizeof(struct bulk_test_s));
+	TEST_ASSERT_EQUAL(0, bulk_init(&testBulk, threads, chunk));
+	testBulk.callback = &bulkTestCallback;
+	testBulk.ctx = t;
+	TEST_ASSERT_EQUAL(0, bulk_decode(&testBulk, bulkStream, BULK_TEST_LEN));
+	TEST_ASSERT_EQUAL(t->cnt, testBulk.frames);
+	TEST_ASSERT_EQUAL(BULK_TEST_LEN, testBulk.bytes);
+	bulk_free(&testBulk);
+}
+
+//Same frames as a serial decode, whatever the chunks
+void test_bulk_serial_match(void)
+{
+	uint32_t chunk[6] = {1, 7, 13, 64, 100, 4096};
+	uint8_t threads[3] = {2, 3, 8};
+	uint8_t i = 0, j = 0, seed = 0;
+
+	for(seed = 1; seed <= 4; seed++)
+	{
+		bulkTestNoisy(seed);
+		bulkTestDecode(&bulkRef, 1, BULK_CHUNK_DEFAULT);
+		TEST_ASSERT_GREATER_THAN(1000, bulkRef.cnt);
+		TEST_ASSERT_EQUAL(0, testBulk.fixups);
+
+		for(i = 0; i < sizeof(chunk) / sizeof(chunk[0]); i++)
+		{
+			for(j = 0; j < sizeof(threads); j++)
+			{
+				bulkTestDecode(&bulkGot, threads[j], chunk[i]);
+				TEST_ASSERT_EQUAL(bulkRef.cnt, bulkGot.cnt);
+				TEST_ASSERT_EQUAL(bulkRef.sum, bulkGot.sum);
+				TEST_ASSERT_EQUAL(0, memcmp(bulkRef.offset, bulkGot.offset, \
+								bulkRef.cnt * sizeof(uint64_t)));
+			}
+		}
+	}
+}
+
+//Clean stream: what unpack_payload_frame() gives, frame by frame
+void test_bulk_clean(void)
+{
+	uint8_t out[PACKAGED_PAYLOAD_LEN];
+	uint32_t pos = 0, n = 0, i = 0;
+	uint8_t len = 0;
+
+	memset(bulkStream, 0, BULK_TEST_LEN);
+	while((pos + 2 * COMM_STR_BUF_LEN) < BULK_TEST_LEN)
+	{
+		//Data with HEADER, FOOTER and ESCAPE in it:
+		len = bulkTestFrame(&bulkStream[pos], (uint8_t)(0xE0 + n), P_DATA1 + 24);
+		pos += len;
+		n++;
+	}
+
+	bulkTestDecode(&bulkGot, 4, 1000);
+	TEST_ASSERT_EQUAL(n, bulkGot.cnt);
+	TEST_ASSERT_LESS_THAN(4 * (BULK_TEST_LEN / 1000), testBulk.fixups);
+	for(i = 0; i < n; i++)
+	{
+		TEST_ASSERT_EQUAL((uint8_t)(0xE0 + i), bulkGot.data[i]);
+	}
+
+	pos = 0;
+	for(i = 0; i < n; i++)
+	{
+		len = (uint8_t)bulk_frame_at(bulkStream, BULK_TEST_LEN, pos);
+		TEST_ASSERT_EQUAL(bulkGot.offset[i], pos);
+		TEST_ASSERT_GREATER_THAN(0, unpack_payload_frame(&bulkStream[pos], len, out));
+		TEST_ASSERT_EQUAL(bulkGot.data[i], out[P_DATA1]);
+		pos += len;
+	}
+}
+
+//Through a file, and what can't be decoded
+void test_bulk_file(void)
+{
+	char path[64];
+	FILE *f = NULL;
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-bulk-%d.bin", (int)getpid());
+	bulkTestNoisy(5);
+	bulkTestDecode(&bulkRef, 1, BULK_CHUNK_DEFAULT);
+
+	f = fopen(path, "wb");
+	TEST_ASSERT_NOT_NULL(f);
+	TEST_ASSERT_EQUAL(BULK_TEST_LEN, fwrite(bulkStream, 1, BULK_TEST_LEN, f));
+	fclose(f);
+
+	memset(&bulkGot, 0, sizeof(bulkGot));
+	TEST_ASSERT_EQUAL(0, bulk_init(&testBulk, 4, 4096));
+	testBulk.callback = &bulkTestCallback;
+	testBulk.ctx = &bulkGot;
+	TEST_ASSERT_EQUAL(0, bulk_decode_file(&testBulk, path));
+	TEST_ASSERT_EQUAL(bulkRef.cnt, bulkGot.cnt);
+	TEST_ASSERT_EQUAL(bulkRef.sum, bulkGot.sum);
+	TEST_ASSERT_GREATER_THAN(0, testBulk.ns);
+
+	//Empty, missing:
+	TEST_ASSERT_EQUAL(0, bulk_decode_file(&testBulk, "/dev/null"));
+	TEST_ASSERT_EQUAL(0, testBulk.frames);
+	TEST_ASSERT_EQUAL(-1, bulk_decode_file(&testBulk, "/nonexistent/flexsea.bin"));
+	bulk_free(&testBulk);
+	unlink(path);
+
+	TEST_ASSERT_EQUAL(-1, bulk_init(&testBulk, 0, 4096));
+	TEST_ASSERT_EQUAL(-1, bulk_init(&testBulk, BULK_MAX_THREADS + 1, 4096));
+	TEST_ASSERT_EQUAL(-1, bulk_init(&testBulk, 2, 0));
+}
+
+#endif	//__linux__
+
+void test_flexsea_bulk(void)
+{
+	UNITY_BEGIN();
+	#ifdef __linux__
+	RUN_TEST(test_bulk_serial_match);
+	RUN_TEST(test_bulk_clean);
+	RUN_TEST(test_bulk_file);
+	#endif	//__linux__
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,221 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <unistd.h>
+#include <sched.h>
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_capture.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_buffers.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+static struct capture_s testCapture;
+static uint8_t captureOut[4 * CAPTURE_RING_LEN];
+static uint32_t captureOutLen = 0;
+static uint64_t captureTicks = 0;
+
+static uint64_t captureTestClock(void)
+{
+	return ++captureTicks;
+}
+
+static void captureTestSink(void *ctx, uint8_t *rec, uint32_t len)
+{
+	(void)ctx;
+	TEST_ASSERT_LESS_OR_EQUAL(sizeof(captureOut), captureOutLen + len);
+	memcpy(&captureOut[captureOutLen], rec, len);
+	captureOutLen += len;
+}
+
+//Record 'n': n % 200 bytes, all equal to n
+static uint8_t captureTestWrite(uint32_t n)
+{
+	uint8_t data[200];
+
+	memset(data, (uint8_t)n, sizeof(data));
+	return capture_write(&testCapture, CAPTURE_TX_FRAME, (uint8_t)(n & 3), 0, \
+							data, (uint16_t)(n % 200));
+}
+
+//Checks records first..last in captureOut
+static void captureTestCheck(uint32_t first, uint32_t last)
+{
+	struct capture_rec_s *r = NULL;
+	uint64_t pos = 0;
+	uint32_t n = first;
+
+	while((r = capture_next(captureOut, captureOutLen, &pos)) != NULL)
+	{
+		TEST_ASSERT_EQUAL(CAPTURE_TX_FRAME, r->type);
+		TEST_ASSERT_EQUAL(n % 200, r->len);
+		TEST_ASSERT_EQUAL(n & 3, r->port);
+		if(r->len)
+		{
+			TEST_ASSERT_EQUAL((uint8_t)n, CAPTURE_DATA(r)[r->len - 1]);
+		}
+		n++;
+	}
+
+	TEST_ASSERT_EQUAL(pos, captureOutLen);
+	TEST_ASSERT_EQUAL(last + 1, n);
+}
+
+//Records go around the ring many times, in order
+void test_capture_ring(void)
+{
+	uint32_t n = 0, i = 0, first = 0;
+
+	capture_init(&testCapture, &captureTestClock, 1000);
+	for(i = 0; i < 50; i++)
+	{
+		captureOutLen = 0;
+		first = n;
+		for(; n < (first + 97 + i); n++)
+		{
+			TEST_ASSERT_EQUAL(1, captureTestWrite(n));
+		}
+		TEST_ASSERT_EQUAL(captureOutLen, capture_drain(&testCapture, \
+							&captureTestSink, NULL));
+		captureTestCheck(first, n - 1);
+	}
+	TEST_ASSERT_EQUAL(n, testCapture.records);
+	TEST_ASSERT_EQUAL(0, testCapture.dropped);
+	TEST_ASSERT_EQUAL(0, capture_drain(&testCapture, &captureTestSink, NULL));
+
+	//Full: the new records are dropped
+	captureOutLen = 0;
+	first = n;
+	while(captureTestWrite(n))
+	{
+		n++;
+	}
+	TEST_ASSERT_EQUAL(1, testCapture.dropped);
+	TEST_ASSERT_GREATER_THAN(CAPTURE_RING_LEN - CAPTURE_REC_LEN(200) * 2, \
+								capture_drain(&testCapture, &captureTestSink, NULL));
+	captureTestCheck(first, n - 1);
+	TEST_ASSERT_EQUAL(1, captureTestWrite(n));
+}
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+
+//What the stack writes in captureTap
+void test_capture_tap(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t type[5] = {CAPTURE_TX_FRAME, CAPTURE_RX_BYTES, CAPTURE_RX_FRAME, \
+						CAPTURE_RX_BYTES, CAPTURE_RX_FRAME};
+	int8_t status[5] = {0, 0, 1, 0, UNPACK_ERR_CHECKSUM};
+	struct capture_rec_s *r = NULL;
+	struct rx_buf_s rb;
+	uint64_t pos = 0;
+	uint8_t len = 0, i = 0;
+
+	capture_init(&testCapture, &captureTestClock, 1000);
+	captureTicks = 0;
+	captureTap = &testCapture;
+
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	len = (uint8_t)comm_gen_str_port(PORT_485_1, payload, str, P_DATA1 + 1) + 1;
+
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_485_1;
+	update_rx_buf_array_s(&rb, str, len);
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd));
+	str[len - 2]++;
+	update_rx_buf_array_s(&rb, str, len);
+	TEST_ASSERT_EQUAL(UNPACK_ERR_CHECKSUM, unpack_payload_rx(&rb, rx_cmd));
+	captureTap = NULL;
+
+	captureOutLen = 0;
+	capture_drain(&testCapture, &captureTestSink, NULL);
+	for(i = 0; i < 5; i++)
+	{
+		r = capture_next(captureOut, captureOutLen, &pos);
+		TEST_ASSERT_NOT_NULL(r);
+		TEST_ASSERT_EQUAL(type[i], r->type);
+		TEST_ASSERT_EQUAL(status[i], r->status);
+		TEST_ASSERT_EQUAL(PORT_485_1, r->port);
+		TEST_ASSERT_EQUAL(len, r->len);
+		TEST_ASSERT_EQUAL(HEADER, CAPTURE_DATA(r)[0]);
+		TEST_ASSERT_EQUAL(i + 1, r->time);
+	}
+	TEST_ASSERT_NULL(capture_next(captureOut, captureOutLen, &pos));
+}
+
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+//Background thread to a mapped file, more than one chunk, then appending
+void test_capture_file(void)
+{
+	struct capture_file_s f;
+	struct capture_rec_s *r = NULL;
+	char path[64];
+	uint8_t *map = NULL;
+	uint64_t len = 0, pos = 0;
+	uint32_t n = 0, cnt = 0, tickHz = 0;
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-capture-%d.fxc", (int)getpid());
+	unlink(path);
+	capture_init(&testCapture, &captureTestClock, 1000);
+	TEST_ASSERT_EQUAL(0, capture_file_open(&f, &testCapture, path));
+	TEST_ASSERT_EQUAL(0, capture_file_start(&f, 100));
+
+	//~1.8 MB: the producer waits for the thread when the ring is full
+	for(n = 0; n < 20000; n++)
+	{
+		while(!captureTestWrite(n))
+		{
+			sched_yield();
+		}
+	}
+	TEST_ASSERT_EQUAL(0, capture_file_close(&f));
+
+	//Appended by a second session:
+	TEST_ASSERT_EQUAL(0, capture_file_open(&f, &testCapture, path));
+	TEST_ASSERT_EQUAL(1, captureTestWrite(n++));
+	TEST_ASSERT_EQUAL(0, capture_file_close(&f));
+
+	map = capture_file_map(path, &len, &tickHz);
+	TEST_ASSERT_NOT_NULL(map);
+	TEST_ASSERT_EQUAL(1000, tickHz);
+	TEST_ASSERT_GREATER_THAN(CAPTURE_FILE_CHUNK, len);
+	pos = sizeof(struct capture_file_hdr_s);
+	while((r = capture_next(map, len, &pos)) != NULL)
+	{
+		TEST_ASSERT_EQUAL(cnt % 200, r->len);
+		if(r->len)
+		{
+			TEST_ASSERT_EQUAL((uint8_t)cnt, CAPTURE_DATA(r)[0]);
+		}
+		cnt++;
+	}
+	TEST_ASSERT_EQUAL(n, cnt);
+	TEST_ASSERT_EQUAL(len, pos);
+	capture_file_unmap(map, len);
+
+	//Not a capture file:
+	TEST_ASSERT_NULL(capture_file_map("/dev/null", &len, NULL));
+	unlink(path);
+}
+
+void test_flexsea_capture(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_capture_ring);
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	RUN_TEST(test_capture_tap);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+	RUN_TEST(test_capture_file);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
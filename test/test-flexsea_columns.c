@@ -0,0 +1,221 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include "../inc/flexsea_columns.h"
+#include "../inc/flexsea_bulk.h"
+#include "../inc/flexsea_comm.h"
+
+//Definitions and variables used by some/all tests:
+#define COLUMNS_TEST_ROWS	5000
+#define COLUMNS_TEST_CMD	42
+#define COLUMNS_TEST_STEP	40		//Longest frame, with escapes
+
+static struct columns_s testColumns;
+
+//Like a handler would read them, with REBUILD_UINT16()/REBUILD_UINT32()
+static const struct columns_field_s columnsTestFields[5] =
+{
+	{"enc", P_DATA1, COLUMNS_I32},
+	{"current", P_DATA1 + 4, COLUMNS_I16},
+	{"status", P_DATA1 + 6, COLUMNS_U8},
+	{"volt", P_DATA1 + 7, COLUMNS_U16},
+	{"ticks", P_DATA1 + 9, COLUMNS_U32}
+};
+
+//Payload for row 'n'. Returns its length.
+static uint8_t columnsTestPayload(uint8_t *payload, uint32_t n)
+{
+	uint16_t index = P_DATA1;
+
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	payload[P_XID] = (uint8_t)(FLEXSEA_EXECUTE_1 + (n & 1));
+	payload[P_RID] = FLEXSEA_PLAN_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(COLUMNS_TEST_CMD);
+	SPLIT_32((uint32_t)(-(int32_t)n * 1000), payload, &index);
+	SPLIT_16((uint16_t)(int16_t)(n - 2500), payload, &index);
+	payload[index++] = (uint8_t)n;
+	SPLIT_16((uint16_t)(n * 3), payload, &index);
+	SPLIT_32(n * 0x10001, payload, &index);
+	return (uint8_t)index;
+}
+
+static void columnsTestInit(void)
+{
+	columns_init(&testColumns);
+	TEST_ASSERT_EQUAL(0, columns_add_schema(&testColumns, COLUMNS_TEST_CMD, \
+						columnsTestFields, 5));
+}
+
+//Checks the 5 fields of 'rows' rows, and their keys (key = step * row)
+static void columnsTestCheck(const int32_t *enc, const int16_t *current, \
+							const uint8_t *status, const uint16_t *volt, \
+							const uint32_t *ticks, const uint64_t *key, \
+							uint32_t rows, uint64_t step)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint32_t n = 0;
+	uint16_t index = 0;
+
+	for(n = 0; n < rows; n++)
+	{
+		columnsTestPayload(payload, n);
+		index = P_DATA1;
+		TEST_ASSERT_EQUAL((int32_t)REBUILD_UINT32(payload, &index), enc[n]);
+		TEST_ASSERT_EQUAL((int16_t)REBUILD_UINT16(payload, &index), current[n]);
+		TEST_ASSERT_EQUAL(payload[index++], status[n]);
+		TEST_ASSERT_EQUAL(REBUILD_UINT16(payload, &index), volt[n]);
+		TEST_ASSERT_EQUAL(REBUILD_UINT32(payload, &index), ticks[n]);
+		TEST_ASSERT_EQUAL(step * n, key[n]);
+	}
+}
+
+//Rows to typed arrays in host byte order
+void test_columns_add(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	struct columns_table_s *t = NULL;
+	uint8_t len = 0;
+	uint32_t n = 0;
+
+	columnsTestInit();
+	for(n = 0; n < COLUMNS_TEST_ROWS; n++)
+	{
+		len = columnsTestPayload(payload, n);
+		TEST_ASSERT_EQUAL(1, columns_add(&testColumns, payload, len, n));
+	}
+
+	//Too short, and a command without schema:
+	TEST_ASSERT_EQUAL(0, columns_add(&testColumns, payload, len - 1, 0));
+	payload[P_CMD1] = CMD_R((COLUMNS_TEST_CMD + 1));
+	TEST_ASSERT_EQUAL(0, columns_add(&testColumns, payload, len, 0));
+
+	//Native layout: not byte swapped into the wrong values, refused
+	payload[P_CMD1] = CMD_W(COLUMNS_TEST_CMD);
+	payload[P_CMDS] = 1 | P_CMDS_NATIVE;
+	TEST_ASSERT_EQUAL(0, columns_add(&testColumns, payload, len, 0));
+	columns_finish(&testColumns);
+
+	TEST_ASSERT_EQUAL(COLUMNS_TEST_ROWS, testColumns.rows);
+	TEST_ASSERT_EQUAL(1, testColumns.skipped);
+	TEST_ASSERT_EQUAL(1, testColumns.unknown);
+	TEST_ASSERT_EQUAL(1, testColumns.native);
+	TEST_ASSERT_NULL(columns_table(&testColumns, COLUMNS_TEST_CMD + 1));
+	t = columns_table(&testColumns, COLUMNS_TEST_CMD);
+	TEST_ASSERT_NOT_NULL(t);
+	TEST_ASSERT_EQUAL(COLUMNS_TEST_ROWS, t->rows);
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_2, t->xid[1]);
+	columnsTestCheck((int32_t *)t->col[0], (int16_t *)t->col[1], \
+					(uint8_t *)t->col[2], (uint16_t *)t->col[3], \
+					(uint32_t *)t->col[4], t->key, COLUMNS_TEST_ROWS, 1);
+
+	//Bad schemas:
+	TEST_ASSERT_EQUAL(-1, columns_add_schema(&testColumns, COLUMNS_TEST_CMD, \
+						columnsTestFields, 5));
+	TEST_ASSERT_EQUAL(-1, columns_add_schema(&testColumns, 0x80, columnsTestFields, 5));
+	columns_free(&testColumns);
+	TEST_ASSERT_EQUAL(0, testColumns.tables);
+}
+
+//Written, then mapped and used in place
+void test_columns_file(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	const void *col[6];
+	uint8_t *map = NULL;
+	uint64_t len = 0, rows = 0;
+	uint8_t type = 0, i = 0;
+	uint32_t n = 0;
+	char path[64];
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-columns-%d.fxcol", (int)getpid());
+	columnsTestInit();
+	for(n = 0; n < COLUMNS_TEST_ROWS; n++)
+	{
+		columns_add(&testColumns, payload, columnsTestPayload(payload, n), n);
+	}
+	TEST_ASSERT_EQUAL(0, columns_write(&testColumns, path));
+	columns_free(&testColumns);
+
+	map = columns_map(path, &len);
+	TEST_ASSERT_NOT_NULL(map);
+	for(i = 0; i < 5; i++)
+	{
+		col[i] = columns_find(map, len, COLUMNS_TEST_CMD, columnsTestFields[i].name, \
+								&type, &rows);
+		TEST_ASSERT_NOT_NULL(col[i]);
+		TEST_ASSERT_EQUAL(0, (uintptr_t)col[i] % COLUMNS_DATA_ALIGN);
+		TEST_ASSERT_EQUAL(columnsTestFields[i].type, type);
+		TEST_ASSERT_EQUAL(COLUMNS_TEST_ROWS, rows);
+	}
+	col[5] = columns_find(map, len, COLUMNS_TEST_CMD, COLUMNS_KEY, &type, &rows);
+	TEST_ASSERT_EQUAL(COLUMNS_U64, type);
+	columnsTestCheck((const int32_t *)col[0], (const int16_t *)col[1], \
+					(const uint8_t *)col[2], (const uint16_t *)col[3], \
+					(const uint32_t *)col[4], (const uint64_t *)col[5], \
+					COLUMNS_TEST_ROWS, 1);
+
+	TEST_ASSERT_NULL(columns_find(map, len, COLUMNS_TEST_CMD, "missing", &type, &rows));
+	TEST_ASSERT_NULL(columns_find(map, len, 1, "enc", &type, &rows));
+	columns_unmap(map, len);
+	unlink(path);
+
+	TEST_ASSERT_NULL(columns_map("/dev/null", &len));
+}
+
+//Straight from the parallel decoder
+void test_columns_bulk(void)
+{
+	static uint8_t stream[COLUMNS_TEST_ROWS * COLUMNS_TEST_STEP];
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	struct columns_table_s *t = NULL;
+	struct bulk_s b;
+	uint8_t len = 0;
+	uint32_t n = 0;
+
+	//One frame every COLUMNS_TEST_STEP bytes:
+	for(n = 0; n < COLUMNS_TEST_ROWS; n++)
+	{
+		len = comm_gen_str(payload, str, columnsTestPayload(payload, n)) + 1;
+		TEST_ASSERT_LESS_OR_EQUAL(COLUMNS_TEST_STEP, len);
+		memcpy(&stream[n * COLUMNS_TEST_STEP], str, len);
+	}
+
+	columnsTestInit();
+	TEST_ASSERT_EQUAL(0, bulk_init(&b, 4, 4096));
+	b.callback = &columns_bulk_callback;
+	b.ctx = &testColumns;
+	TEST_ASSERT_EQUAL(0, bulk_decode(&b, stream, sizeof(stream)));
+	bulk_free(&b);
+	columns_finish(&testColumns);
+
+	t = columns_table(&testColumns, COLUMNS_TEST_CMD);
+	TEST_ASSERT_EQUAL(COLUMNS_TEST_ROWS, t->rows);
+	columnsTestCheck((int32_t *)t->col[0], (int16_t *)t->col[1], \
+					(uint8_t *)t->col[2], (uint16_t *)t->col[3], \
+					(uint32_t *)t->col[4], t->key, COLUMNS_TEST_ROWS, COLUMNS_TEST_STEP);
+	columns_free(&testColumns);
+}
+
+#endif	//__linux__
+
+void test_flexsea_columns(void)
+{
+	UNITY_BEGIN();
+	#ifdef __linux__
+	RUN_TEST(test_columns_add);
+	RUN_TEST(test_columns_file);
+	RUN_TEST(test_columns_bulk);
+	#endif	//__linux__
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
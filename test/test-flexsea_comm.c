@@ -3,6 +3,8 @@ extern "C" {
 #endif
 
 #include "../inc/flexsea.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_arq.h"
 #include "flexsea-comm_test-all.h"
 
 //Definitions and variables used by some/all tests:
@@ -14,6 +16,7 @@ uint8_t fakeCommStrArray2[COMM_STR_BUF_LEN];
 uint8_t rx_cmd_test[4][PACKAGED_PAYLOAD_LEN];
 uint8_t retVal = 0;
 int8_t retVal2 = 0;
+struct comm_stats_s commTestStats;
 
 void resetCommStats(void)
 {
@@ -23,6 +26,7 @@ void resetCommStats(void)
 	commSpy1.checksum = 0;
 	commSpy1.retVal = 0;
 	commSpy1.escapes = 0;
+	comm_stats_reset(COMM_STATS_NO_PORT);
 }
 
 void test_comm_gen_str_simple(void)
@@ -57,6 +61,11 @@ void test_comm_gen_str_simple(void)
 	TEST_ASSERT_EQUAL(7, retVal);
 	TEST_ASSERT_EQUAL_MESSAGE(commSpy1.checksum, checksum, "checksum");
 
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &commTestStats);
+	TEST_ASSERT_EQUAL_MESSAGE(1, commTestStats.framesEncoded, "frames");
+	TEST_ASSERT_EQUAL_MESSAGE(4, fakeCommStr[1], "total bytes");
+	TEST_ASSERT_EQUAL_MESSAGE(fakeCommStr[retVal-1], checksum, "checksum in the frame");
+
 	for(i = retVal+1; i < COMM_STR_BUF_LEN; i++)
 	{
 		TEST_ASSERT_EQUAL_MESSAGE(0xAA, fakeCommStr[i], "filler");
@@ -67,7 +76,6 @@ void test_comm_gen_str_simple(void)
 void test_comm_gen_str_tooLong1(void)
 {
 	int i = 0;
-	uint8_t checksum = 0;
 
 	//Empty strings:
 	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
@@ -84,17 +92,15 @@ void test_comm_gen_str_tooLong1(void)
 	//Gen comm str, with 48 bytes:
 	retVal = comm_gen_str(fakePayload, fakeCommStr, 48);
 
-	//Recalculate the checksum here:
-	for(i = 0; i < commSpy1.total_bytes; i++)
-	{
-		checksum += fakeCommStr[2+i];
-	}
-
 	//Tests:
 
 	TEST_ASSERT_EQUAL_MESSAGE(commSpy1.retVal, retVal, "retval");
 	TEST_ASSERT_EQUAL(0, retVal);
 
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &commTestStats);
+	TEST_ASSERT_EQUAL_MESSAGE(1, commTestStats.overruns, "overruns");
+	TEST_ASSERT_EQUAL_MESSAGE(0, commTestStats.framesEncoded, "frames");
+
 	for(i = 0; i < COMM_STR_BUF_LEN; i++)
 	{
 		TEST_ASSERT_EQUAL_MESSAGE(0, fakeCommStr[i], "filler");
@@ -105,7 +111,6 @@ void test_comm_gen_str_tooLong1(void)
 void test_comm_gen_str_tooLong2(void)
 {
 	int i = 0;
-	uint8_t checksum = 0;
 
 	//Empty strings:
 	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
@@ -128,18 +133,18 @@ void test_comm_gen_str_tooLong2(void)
 	//Gen comm str, with 48 bytes:
 	retVal = comm_gen_str(fakePayload, fakeCommStr, 28);
 
-	//Recalculate the checksum here:
-	for(i = 0; i < commSpy1.total_bytes; i++)
-	{
-		checksum += fakeCommStr[2+i];
-	}
-
 	//Tests:
 
 	TEST_ASSERT_EQUAL_MESSAGE(commSpy1.retVal, retVal, "retval");
 	TEST_ASSERT_EQUAL(0, retVal);
 	TEST_ASSERT_EQUAL_MESSAGE(24, commSpy1.escapes, "Escape characters");
 
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &commTestStats);
+	TEST_ASSERT_EQUAL_MESSAGE(1, commTestStats.overruns, "overruns");
+
+	//The statistics only count the escapes of the frames that were encoded:
+	TEST_ASSERT_EQUAL_MESSAGE(0, commTestStats.escapes, "Escapes, refused frame");
+
 	for(i = 0; i < COMM_STR_BUF_LEN; i++)
 	{
 		TEST_ASSERT_EQUAL_MESSAGE(0, fakeCommStr[i], "filler");
@@ -220,6 +225,380 @@ void test_unpack_payload_2(void)
 	TEST_ASSERT_EQUAL_INT8_MESSAGE(UNPACK_ERR_LEN, retVal2, "Wrong length / too long");
 }
 
+//Fast framing: encode, then decode in place
+void test_comm_gen_str_fast(void)
+{
+	uint8_t *payloadPtr = NULL;
+	int16_t len = 0;
+	int i = 0;
+
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	memset(fakeCommStr, 0, COMM_STR_BUF_LEN);
+
+	fakePayload[P_XID] = FLEXSEA_PLAN_1;
+	fakePayload[P_RID] = FLEXSEA_MANAGE_1;
+	fakePayload[P_CMDS] = 1;
+	fakePayload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	//Framing characters don't need to be escaped:
+	for(i = 0; i < 8; i++)
+	{
+		fakePayload[P_DATA1+i] = HEADER;
+	}
+
+	retVal = comm_gen_str_fast(fakePayload, fakeCommStr, 12);
+	TEST_ASSERT_EQUAL_MESSAGE(FAST_HEADER_LEN + 12 - 1, retVal, "Last index");
+	TEST_ASSERT_EQUAL(FAST_SYNC_H, fakeCommStr[0]);
+	TEST_ASSERT_EQUAL(FAST_SYNC_L, fakeCommStr[1]);
+
+	len = unpack_payload_fast(fakeCommStr, retVal + 1, &payloadPtr);
+	TEST_ASSERT_EQUAL_MESSAGE(12, len, "Payload length");
+	TEST_ASSERT_TRUE_MESSAGE(payloadPtr == &fakeCommStr[FAST_HEADER_LEN], "Zero-copy");
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fakePayload, payloadPtr, 12);
+
+	//Too long for the buffer:
+	retVal = comm_gen_str_fast(fakePayload, fakeCommStr, FAST_FRAME_MAX_LEN);
+	TEST_ASSERT_EQUAL(0, retVal);
+}
+
+void test_unpack_payload_fast_errors(void)
+{
+	uint8_t *payloadPtr = NULL;
+
+	memset(fakePayload, 0x55, PAYLOAD_BUF_LEN);
+	retVal = comm_gen_str_fast(fakePayload, fakeCommStr, 10);
+
+	//Truncated transfer:
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(UNPACK_ERR_LEN, \
+		unpack_payload_fast(fakeCommStr, retVal, &payloadPtr), "Truncated");
+
+	//Corrupted length:
+	memcpy(fakeCommStrArray0, fakeCommStr, COMM_STR_BUF_LEN);
+	fakeCommStrArray0[3] ^= 0x01;
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(UNPACK_ERR_CHECKSUM, \
+		unpack_payload_fast(fakeCommStrArray0, retVal + 1, &payloadPtr), "Header CRC");
+
+	//No sync word:
+	memcpy(fakeCommStrArray0, fakeCommStr, COMM_STR_BUF_LEN);
+	fakeCommStrArray0[0] = HEADER;
+	TEST_ASSERT_EQUAL_INT8_MESSAGE(UNPACK_ERR_HEADER, \
+		unpack_payload_fast(fakeCommStrArray0, retVal + 1, &payloadPtr), "Sync");
+}
+
+//Frames that are already delimited (datagrams), back to back
+void test_unpack_payload_frame(void)
+{
+	uint8_t stream[2 * COMM_STR_BUF_LEN], payload[PACKAGED_PAYLOAD_LEN];
+	int16_t len1 = 0, len2 = 0;
+
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	fakePayload[0] = 0x11;
+	fakePayload[1] = HEADER;		//Escaped
+	len1 = comm_gen_str(fakePayload, stream, 4) + 1;
+	fakePayload[0] = 0x22;
+	len2 = comm_gen_str(fakePayload, &stream[len1], 4) + 1;
+
+	TEST_ASSERT_EQUAL_INT16(len1, unpack_payload_frame(stream, len1 + len2, payload));
+	TEST_ASSERT_EQUAL_HEX8(0x11, payload[0]);
+	TEST_ASSERT_EQUAL_HEX8(HEADER, payload[1]);
+	TEST_ASSERT_EQUAL_INT16(len2, unpack_payload_frame(&stream[len1], len2, payload));
+	TEST_ASSERT_EQUAL_HEX8(0x22, payload[0]);
+
+	//Errors:
+	TEST_ASSERT_EQUAL_INT16(UNPACK_ERR_LEN, unpack_payload_frame(stream, len1 - 1, payload));
+	TEST_ASSERT_EQUAL_INT16(UNPACK_ERR_HEADER, unpack_payload_frame(&stream[1], len1, payload));
+	stream[3] ^= 0x01;
+	TEST_ASSERT_EQUAL_INT16(UNPACK_ERR_CHECKSUM, unpack_payload_frame(stream, len1, payload));
+}
+
+//Framing is selected per port
+void test_comm_framing_port(void)
+{
+	uint8_t rxBuf[RX_BUF_LEN];
+
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	fakePayload[P_XID] = FLEXSEA_PLAN_1;
+	fakePayload[P_RID] = FLEXSEA_MANAGE_1;
+	fakePayload[P_CMDS] = 1;
+	fakePayload[P_CMD1] = CMD_R(CMD_READ_ALL);
+
+	comm_set_framing(PORT_SPI, FRAMING_FAST);
+	TEST_ASSERT_EQUAL(FRAMING_FAST, comm_get_framing(PORT_SPI));
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_485_1));
+
+	//RS-485 keeps the escaped framing:
+	memset(rxBuf, 0, RX_BUF_LEN);
+	retVal = comm_gen_str_port(PORT_485_1, fakePayload, rxBuf, 4);
+	TEST_ASSERT_EQUAL(HEADER, rxBuf[0]);
+	TEST_ASSERT_EQUAL(1, unpack_payload_port(PORT_485_1, rxBuf, RX_BUF_LEN, rx_cmd_test));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fakePayload, rx_cmd_test[0], 4);
+
+	memset(rxBuf, 0, RX_BUF_LEN);
+	memset(rx_cmd_test, 0, sizeof(rx_cmd_test));
+	retVal = comm_gen_str_port(PORT_SPI, fakePayload, rxBuf, 4);
+	TEST_ASSERT_EQUAL(FAST_SYNC_H, rxBuf[0]);
+	TEST_ASSERT_EQUAL(1, unpack_payload_port(PORT_SPI, rxBuf, RX_BUF_LEN, rx_cmd_test));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fakePayload, rx_cmd_test[0], 4);
+
+	comm_set_framing(PORT_SPI, FRAMING_ESCAPED);
+}
+
+//Escaped HEADERs are data: a frame that's still being received isn't
+//damaged, and escape-heavy frames are all found
+void test_unpack_payload_escapes(void)
+{
+	uint8_t str[4 * COMM_STR_BUF_LEN];
+	uint8_t special[3] = {HEADER, ESCAPE, FOOTER};
+	struct rx_buf_s rb;
+	uint8_t len = 0, i = 0, j = 0, found = 0;
+	int8_t ret = 0;
+
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	fakePayload[P_XID] = FLEXSEA_PLAN_1;
+	fakePayload[P_RID] = FLEXSEA_MANAGE_1;
+	fakePayload[P_CMDS] = 1;
+	fakePayload[P_CMD1] = CMD_R(CMD_READ_ALL);
+
+	//ESCAPE, HEADER, 1, 0, ESCAPE, FOOTER looks like a frame with a bad
+	//checksum:
+	fakePayload[P_DATA1] = HEADER;
+	fakePayload[P_DATA1 + 1] = 1;
+	fakePayload[P_DATA1 + 2] = 0;
+	fakePayload[P_DATA1 + 3] = FOOTER;
+	len = comm_gen_str(fakePayload, str, P_DATA1 + 4) + 1;
+
+	comm_stats_reset(PORT_USB);
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_USB;
+	update_rx_buf_array_s(&rb, str, len - 2);
+	TEST_ASSERT_LESS_THAN(0, unpack_payload_rx(&rb, rx_cmd_test));
+	update_rx_buf_array_s(&rb, &str[len - 2], 2);
+	memset(rx_cmd_test, 0, sizeof(rx_cmd_test));
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd_test));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fakePayload, rx_cmd_test[0], P_DATA1 + 4);
+
+	//4 frames made of special bytes, received 8 bytes at a time:
+	len = 0;
+	for(i = 0; i < 4; i++)
+	{
+		for(j = 0; j < 6; j++)
+		{
+			fakePayload[P_DATA1 + j] = special[(i + j) % 3];
+		}
+		len += comm_gen_str(fakePayload, &str[len], P_DATA1 + 6) + 1;
+	}
+	TEST_ASSERT_LESS_OR_EQUAL(RX_BUF_LEN, len);
+
+	for(i = 0; i < len; i += 8)
+	{
+		update_rx_buf_array_s(&rb, &str[i], MIN(8, len - i));
+		ret = unpack_payload_rx(&rb, rx_cmd_test);
+		if(ret > 0)
+		{
+			TEST_ASSERT_EQUAL(1, ret);
+			TEST_ASSERT_EQUAL(special[found % 3], rx_cmd_test[0][P_DATA1]);
+			TEST_ASSERT_EQUAL(special[(found + 2) % 3], rx_cmd_test[0][P_DATA1 + 5]);
+			found++;
+		}
+	}
+	TEST_ASSERT_EQUAL(4, found);
+
+	comm_stats_snapshot(PORT_USB, &commTestStats);
+	TEST_ASSERT_EQUAL(5, commTestStats.framesDecoded);
+	TEST_ASSERT_EQUAL(0, commTestStats.badChecksum);
+	TEST_ASSERT_EQUAL(0, commTestStats.discarded);
+}
+
+//Noise before a frame is dropped by unpack_payload_rx(), a frame that's
+//still being received is kept
+void test_unpack_payload_resync(void)
+{
+	uint8_t str[2 * COMM_STR_BUF_LEN], noise[40];
+	struct rx_buf_s rb;
+	uint8_t len = 0, i = 0;
+
+	for(i = 0; i < sizeof(noise); i++)
+	{
+		noise[i] = (uint8_t)(i * 37 + 11);
+		if((noise[i] == HEADER) || (noise[i] == 0))
+		{
+			noise[i] = 0x55;
+		}
+	}
+	//Looks like the start of a frame, but there's no FOOTER:
+	noise[10] = HEADER;
+	noise[11] = 3;
+
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	fakePayload[P_XID] = FLEXSEA_PLAN_1;
+	fakePayload[P_RID] = FLEXSEA_MANAGE_1;
+	fakePayload[P_CMDS] = 1;
+	fakePayload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	len = comm_gen_str(fakePayload, str, P_DATA1 + 1) + 1;
+
+	comm_stats_reset(PORT_485_1);
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_485_1;
+	update_rx_buf_array_s(&rb, noise, sizeof(noise));
+	update_rx_buf_array_s(&rb, str, len);
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd_test));
+	TEST_ASSERT_EQUAL(0, rb.idx);
+	comm_stats_snapshot(PORT_485_1, &commTestStats);
+	TEST_ASSERT_EQUAL(sizeof(noise), commTestStats.discarded);
+
+	//Noise, then the first half of a frame:
+	update_rx_buf_array_s(&rb, noise, sizeof(noise));
+	update_rx_buf_array_s(&rb, str, len / 2);
+	TEST_ASSERT_EQUAL(UNPACK_ERR_LEN, unpack_payload_rx(&rb, rx_cmd_test));
+	TEST_ASSERT_EQUAL(len / 2, rb.idx);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(str, rb.buf, len / 2);
+	update_rx_buf_array_s(&rb, &str[len / 2], len - len / 2);
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd_test));
+	TEST_ASSERT_EQUAL(0, rb.idx);
+
+	comm_stats_snapshot(PORT_485_1, &commTestStats);
+	TEST_ASSERT_EQUAL(2 * sizeof(noise), commTestStats.discarded);
+	TEST_ASSERT_EQUAL(2, commTestStats.framesDecoded);
+	TEST_ASSERT_EQUAL(0, commTestStats.badChecksum);
+}
+
+#ifdef ENABLE_FLEXSEA_RID_FILTER
+
+//Frame from 'xid' to 'rid' appended to 'str'. Returns the new length.
+static uint8_t ridTestFrame(uint8_t *str, uint8_t len, uint8_t xid, uint8_t rid)
+{
+	memset(fakePayload, 0, PAYLOAD_BUF_LEN);
+	fakePayload[P_XID] = xid;
+	fakePayload[P_RID] = rid;
+	fakePayload[P_CMDS] = 1;
+	fakePayload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	fakePayload[P_DATA1] = rid;
+	return len + comm_gen_str(fakePayload, &str[len], P_DATA1 + 1) + 1;
+}
+
+//Only the frames for this board, its master and its slaves are decoded
+void test_unpack_payload_rid_filter(void)
+{
+	uint8_t str[6 * COMM_STR_BUF_LEN];
+	struct rx_buf_s rb;
+	uint8_t len = 0, i = 0;
+
+	//Foreign, ours with an escaped XID, foreign with an escaped RID, for
+	//a slave, for the master:
+	len = ridTestFrame(str, len, FLEXSEA_PLAN_1, 50);
+	len = ridTestFrame(str, len, FOOTER, FLEXSEA_MANAGE_1);
+	len = ridTestFrame(str, len, FLEXSEA_PLAN_1, ESCAPE);
+	len = ridTestFrame(str, len, FLEXSEA_PLAN_1, FLEXSEA_EXECUTE_2);
+	len = ridTestFrame(str, len, FLEXSEA_EXECUTE_1, FLEXSEA_PLAN_1);
+	TEST_ASSERT_LESS_OR_EQUAL(RX_BUF_LEN, len);
+
+	for(i = 0; i < 2; i++)
+	{
+		comm_stats_reset(PORT_485_2);
+		comm_set_rid_filter(PORT_485_2, i);
+		TEST_ASSERT_EQUAL(i, comm_get_rid_filter(PORT_485_2));
+		memset(&rb, 0, sizeof(rb));
+		rb.port = PORT_485_2;
+		update_rx_buf_array_s(&rb, str, len);
+
+		memset(rx_cmd_test, 0, sizeof(rx_cmd_test));
+		TEST_ASSERT_EQUAL(i ? 3 : PAYLOAD_BUFFERS, unpack_payload_rx(&rb, rx_cmd_test));
+		TEST_ASSERT_EQUAL(i ? FLEXSEA_MANAGE_1 : 50, rx_cmd_test[0][P_DATA1]);
+		TEST_ASSERT_EQUAL(i ? FLEXSEA_EXECUTE_2 : FLEXSEA_MANAGE_1, rx_cmd_test[1][P_DATA1]);
+		TEST_ASSERT_EQUAL(FOOTER, rx_cmd_test[1 - i][P_XID]);
+		comm_stats_snapshot(PORT_485_2, &commTestStats);
+		TEST_ASSERT_EQUAL(2 * i, commTestStats.filtered);
+		TEST_ASSERT_EQUAL(i ? 3 : PAYLOAD_BUFFERS, commTestStats.framesDecoded);
+		TEST_ASSERT_EQUAL(0, commTestStats.badChecksum);
+	}
+
+	//Other ports aren't filtered:
+	TEST_ASSERT_EQUAL(0, comm_get_rid_filter(PORT_485_1));
+	comm_set_rid_filter(PORT_485_2, 0);
+}
+
+//Noise whose length byte points to the FOOTER of a frame for this board:
+//the frame isn't filtered with it
+void test_unpack_payload_rid_filter_noise(void)
+{
+	uint8_t str[2 * COMM_STR_BUF_LEN] = {HEADER, 0x09, 0x11, 0x63};
+	struct rx_buf_s rb;
+	uint8_t len = 4, i = 0;
+
+	len = ridTestFrame(str, len, FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1);
+	TEST_ASSERT_EQUAL(13, len);
+	TEST_ASSERT_EQUAL(FOOTER, str[12]);
+
+	for(i = 0; i < 2; i++)
+	{
+		comm_stats_reset(PORT_485_2);
+		comm_set_rid_filter(PORT_485_2, i);
+		memset(&rb, 0, sizeof(rb));
+		rb.port = PORT_485_2;
+		update_rx_buf_array_s(&rb, str, len);
+
+		memset(rx_cmd_test, 0, sizeof(rx_cmd_test));
+		TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd_test));
+		TEST_ASSERT_EQUAL(FLEXSEA_MANAGE_1, rx_cmd_test[0][P_DATA1]);
+		comm_stats_snapshot(PORT_485_2, &commTestStats);
+		TEST_ASSERT_EQUAL(0, commTestStats.filtered);
+		TEST_ASSERT_EQUAL(1, commTestStats.framesDecoded);
+	}
+
+	comm_set_rid_filter(PORT_485_2, 0);
+}
+
+//Same with an ARQ header in front: [SEQ][ACK][FLAGS] then the payload
+static uint8_t ridTestArqFrame(uint8_t *str, uint8_t len, uint8_t ack, \
+								uint8_t flags, uint8_t rid)
+{
+	uint8_t tmp[PAYLOAD_BUF_LEN];
+
+	memset(tmp, 0, PAYLOAD_BUF_LEN);
+	tmp[ARQ_SEQ] = HEADER;			//Escaped
+	tmp[ARQ_ACK] = ack;
+	tmp[ARQ_FLAGS] = flags;
+	tmp[ARQ_HEADER_LEN + P_XID] = FLEXSEA_PLAN_1;
+	tmp[ARQ_HEADER_LEN + P_RID] = rid;
+	tmp[ARQ_HEADER_LEN + P_CMDS] = 1;
+	tmp[ARQ_HEADER_LEN + P_CMD1] = CMD_R(CMD_READ_ALL);
+	tmp[ARQ_HEADER_LEN + P_DATA1] = rid;
+	return len + comm_gen_str(tmp, &str[len], ARQ_HEADER_LEN + P_DATA1 + 1) + 1;
+}
+
+//ARQ and the filter on the same port: the RID is found behind the header
+void test_unpack_payload_rid_filter_arq(void)
+{
+	uint8_t str[4 * COMM_STR_BUF_LEN];
+	struct rx_buf_s rb;
+	uint8_t len = 0;
+
+	//Ours with a foreign ACK number, foreign with an ACK number that looks
+	//like our ID, ACK only:
+	len = ridTestArqFrame(str, len, 50, ARQ_FLAG_DATA | ARQ_FLAG_ACK, FLEXSEA_MANAGE_1);
+	len = ridTestArqFrame(str, len, FLEXSEA_MANAGE_1, ARQ_FLAG_DATA, 50);
+	len = ridTestArqFrame(str, len, 50, ARQ_FLAG_ACK, 50);
+	TEST_ASSERT_LESS_OR_EQUAL(RX_BUF_LEN, len);
+
+	TEST_ASSERT_EQUAL(1, arq_enable(PORT_SPI, 0));
+	comm_set_rid_filter(PORT_SPI, 1);
+	comm_stats_reset(PORT_SPI);
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_SPI;
+	update_rx_buf_array_s(&rb, str, len);
+
+	memset(rx_cmd_test, 0, sizeof(rx_cmd_test));
+	TEST_ASSERT_EQUAL(2, unpack_payload_rx(&rb, rx_cmd_test));
+	TEST_ASSERT_EQUAL(FLEXSEA_MANAGE_1, rx_cmd_test[0][ARQ_HEADER_LEN + P_DATA1]);
+	TEST_ASSERT_EQUAL(ARQ_FLAG_ACK, rx_cmd_test[1][ARQ_FLAGS]);
+	comm_stats_snapshot(PORT_SPI, &commTestStats);
+	TEST_ASSERT_EQUAL(1, commTestStats.filtered);
+
+	comm_set_rid_filter(PORT_SPI, 0);
+	arq_disable(PORT_SPI);
+}
+
+#endif	//ENABLE_FLEXSEA_RID_FILTER
+
 void test_flexsea_comm(void)
 {
 	UNITY_BEGIN();
@@ -228,6 +607,17 @@ void test_flexsea_comm(void)
 	RUN_TEST(test_comm_gen_str_tooLong2);
 	RUN_TEST(test_unpack_payload_1);
 	RUN_TEST(test_unpack_payload_2);
+	RUN_TEST(test_comm_gen_str_fast);
+	RUN_TEST(test_unpack_payload_fast_errors);
+	RUN_TEST(test_comm_framing_port);
+	RUN_TEST(test_unpack_payload_frame);
+	RUN_TEST(test_unpack_payload_escapes);
+	RUN_TEST(test_unpack_payload_resync);
+	#ifdef ENABLE_FLEXSEA_RID_FILTER
+	RUN_TEST(test_unpack_payload_rid_filter);
+	RUN_TEST(test_unpack_payload_rid_filter_noise);
+	RUN_TEST(test_unpack_payload_rid_filter_arq);
+	#endif	//ENABLE_FLEXSEA_RID_FILTER
 	UNITY_END();
 }
 
@@ -0,0 +1,268 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_corr.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+struct corr_s testCorr;
+uint16_t corrTestDone = 0, corrTestTimeouts = 0;
+uint8_t corrTestLastRid = 0;
+uint32_t corrTestLastRtt = 0;
+uint8_t corrTestCancel = 0;		//Callback cancels this slave's request
+
+static void corrTestCallback(struct corr_s *c, struct corr_req_s *r, \
+								uint8_t *payload)
+{
+	if(r->state == CORR_DONE)
+	{
+		TEST_ASSERT_NOT_NULL(payload);
+		corrTestDone++;
+		corrTestLastRtt = r->rtt;
+	}
+	else
+	{
+		TEST_ASSERT_EQUAL(CORR_TIMEOUT, r->state);
+		TEST_ASSERT_NULL(payload);
+		corrTestTimeouts++;
+	}
+	corrTestLastRid = r->rid;
+
+	if(corrTestCancel)
+	{
+		corr_cancel(c, r->port, corrTestCancel, CMD_TEST);
+	}
+}
+
+static void corrTestInit(uint32_t timeout)
+{
+	corr_init(&testCorr, timeout, &corrTestCallback);
+	corrTestDone = 0;
+	corrTestTimeouts = 0;
+	corrTestLastRid = 0;
+	corrTestCancel = 0;
+}
+
+//Reply from 'slave' to the master
+static void corrTestReply(uint8_t *payload, uint8_t slave, uint8_t cmd)
+{
+	prepare_empty_payload(slave, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(cmd);
+}
+
+//Replies complete their own request only, with the RTT
+void test_corr_reply(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+
+	corrTestInit(100);
+	TEST_ASSERT_NOT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 1000, 0));
+	TEST_ASSERT_NOT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, 1002, 0));
+	TEST_ASSERT_NOT_NULL(corr_insert(&testCorr, PORT_485_1, FLEXSEA_EXECUTE_1, CMD_TEST, 1003, 0));
+	TEST_ASSERT_EQUAL(3, testCorr.pending);
+
+	//Same request twice:
+	TEST_ASSERT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 1004, 0));
+	TEST_ASSERT_EQUAL(1, testCorr.refused);
+
+	//Wrong command, then wrong port:
+	corrTestReply(payload, FLEXSEA_EXECUTE_2, CMD_READ_ALL);
+	TEST_ASSERT_EQUAL(0, corr_reply(&testCorr, PORT_USB, payload, 1010));
+	corrTestReply(payload, FLEXSEA_EXECUTE_2, CMD_TEST);
+	TEST_ASSERT_EQUAL(0, corr_reply(&testCorr, PORT_485_1, payload, 1010));
+	TEST_ASSERT_EQUAL(2, testCorr.unmatched);
+
+	TEST_ASSERT_EQUAL(1, corr_reply(&testCorr, PORT_USB, payload, 1010));
+	TEST_ASSERT_EQUAL(1, corrTestDone);
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_2, corrTestLastRid);
+	TEST_ASSERT_EQUAL(8, corrTestLastRtt);
+	TEST_ASSERT_EQUAL(2, testCorr.pending);
+	TEST_ASSERT_NULL(corr_find(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST));
+
+	//Late duplicate:
+	TEST_ASSERT_EQUAL(0, corr_reply(&testCorr, PORT_USB, payload, 1011));
+
+	//Per slave RTT:
+	TEST_ASSERT_NOT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, 1020, 0));
+	TEST_ASSERT_EQUAL(1, corr_reply(&testCorr, PORT_USB, payload, 1024));
+	TEST_ASSERT_EQUAL(2, testCorr.slave[FLEXSEA_EXECUTE_2].replies);
+	TEST_ASSERT_EQUAL(4, testCorr.slave[FLEXSEA_EXECUTE_2].min);
+	TEST_ASSERT_EQUAL(8, testCorr.slave[FLEXSEA_EXECUTE_2].max);
+	TEST_ASSERT_EQUAL(6, corr_rtt_mean(&testCorr, FLEXSEA_EXECUTE_2));
+	TEST_ASSERT_EQUAL(0, corr_rtt_mean(&testCorr, FLEXSEA_EXECUTE_1));
+
+	//Canceled: no callback
+	TEST_ASSERT_EQUAL(1, corr_cancel(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST));
+	TEST_ASSERT_EQUAL(0, corr_cancel(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST));
+	TEST_ASSERT_EQUAL(1, testCorr.pending);
+	TEST_ASSERT_EQUAL(1, corr_advance(&testCorr, 2000));
+	TEST_ASSERT_EQUAL(1, corrTestTimeouts);
+	TEST_ASSERT_EQUAL(2, corrTestDone);
+}
+
+//Timeouts fire at their tick, short or longer than a wheel turn
+void test_corr_timeout(void)
+{
+	uint32_t t0 = 0xFFFFFF00;	//Wraps around
+	uint32_t t = 0;
+
+	corrTestInit(10);
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, t0, 0);
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, t0, 3 * CORR_WHEEL_SIZE + 5);
+
+	for(t = t0 + 1; t != t0 + 10; t++)
+	{
+		TEST_ASSERT_EQUAL(0, corr_advance(&testCorr, t));
+	}
+	TEST_ASSERT_EQUAL(1, corr_advance(&testCorr, t0 + 10));
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1, corrTestLastRid);
+	TEST_ASSERT_EQUAL(1, testCorr.slave[FLEXSEA_EXECUTE_1].timeouts);
+
+	//Passes over its slot 3 times, in steps of 7:
+	for(t = t0 + 11; t != t0 + 3 * CORR_WHEEL_SIZE + 5; t += 1)
+	{
+		if(((t - t0) % 7) == 0)
+		{
+			TEST_ASSERT_EQUAL(0, corr_advance(&testCorr, t));
+		}
+	}
+	TEST_ASSERT_EQUAL(0, corr_advance(&testCorr, t0 + 3 * CORR_WHEEL_SIZE + 4));
+	TEST_ASSERT_EQUAL(1, corr_advance(&testCorr, t0 + 3 * CORR_WHEEL_SIZE + 5));
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_2, corrTestLastRid);
+	TEST_ASSERT_EQUAL(0, testCorr.pending);
+
+	//A long time without corr_advance():
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 5000, 0);
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, 5000, 2000);
+	TEST_ASSERT_EQUAL(1, corr_advance(&testCorr, 6000));
+	TEST_ASSERT_EQUAL(1, corr_advance(&testCorr, 100000));
+	TEST_ASSERT_EQUAL(4, corrTestTimeouts);
+	TEST_ASSERT_EQUAL(4, testCorr.timeouts);
+}
+
+//Table full, requests reused, callbacks that cancel
+void test_corr_full(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint16_t i = 0;
+
+	corrTestInit(50);
+	for(i = 0; i < CORR_MAX_PENDING; i++)
+	{
+		TEST_ASSERT_NOT_NULL(corr_insert(&testCorr, (uint8_t)(i & 3), \
+							(uint8_t)(FLEXSEA_EXECUTE_1 + (i >> 2)), CMD_TEST, i, 0));
+	}
+	TEST_ASSERT_NULL(corr_insert(&testCorr, 0, 200, CMD_TEST, i, 0));
+	TEST_ASSERT_EQUAL(CORR_MAX_PENDING, testCorr.pending);
+
+	//Every one of them can be found:
+	for(i = 0; i < CORR_MAX_PENDING; i++)
+	{
+		corrTestReply(payload, (uint8_t)(FLEXSEA_EXECUTE_1 + (i >> 2)), CMD_TEST);
+		TEST_ASSERT_EQUAL(1, corr_reply(&testCorr, (uint8_t)(i & 3), payload, 60));
+	}
+	TEST_ASSERT_EQUAL(0, testCorr.pending);
+	TEST_ASSERT_EQUAL(CORR_MAX_PENDING, corrTestDone);
+
+	//Two expire on the same tick, their callback cancels a third one:
+	corrTestInit(50);
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 0, 0);
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, 0, 0);
+	corr_insert(&testCorr, PORT_USB, 200, CMD_TEST, 0, 100);
+	corrTestCancel = 200;
+	TEST_ASSERT_EQUAL(2, corr_advance(&testCorr, 50));
+	TEST_ASSERT_EQUAL(0, testCorr.pending);
+	TEST_ASSERT_EQUAL(0, corr_advance(&testCorr, 100));
+	TEST_ASSERT_EQUAL(2, corrTestTimeouts);
+
+	//Too late to cancel one that expires on the same tick:
+	corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 200, 0);
+	corr_insert(&testCorr, PORT_USB, 200, CMD_TEST, 200, 0);
+	TEST_ASSERT_EQUAL(2, corr_advance(&testCorr, 250));
+	TEST_ASSERT_EQUAL(4, corrTestTimeouts);
+	corrTestCancel = 0;
+}
+
+//corr_receive() still parses everything
+void test_corr_receive(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_USB, 0};
+
+	corrTestInit(10);
+	prepare_empty_payload(board_id, FLEXSEA_EXECUTE_1, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_TEST);
+	TEST_ASSERT_NOT_NULL(corr_track(&testCorr, PORT_USB, payload, 0));
+	TEST_ASSERT_NOT_NULL(corr_find(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST));
+
+	corrTestReply(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_receive(&testCorr, payload, info, 3));
+	TEST_ASSERT_EQUAL(1, corrTestDone);
+	TEST_ASSERT_EQUAL(0, corr_receive(&testCorr, payload, info, 4));
+}
+
+static void corrTestOwner(struct corr_s *c, struct corr_req_s *r, uint8_t *payload)
+{
+	(void)c;
+	(void)payload;
+	*(uint32_t *)r->user = r->sentAt;
+}
+
+//Requests with their own callback, several per key (fifo), own table
+void test_corr_owners(void)
+{
+	static struct corr_req_s pool[3];
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	struct corr_req_s *r[3];
+	uint32_t got = 0, tick = 0;
+	uint8_t i = 0;
+
+	corr_init_pool(&testCorr, pool, 3, 100, &corrTestCallback);
+	corrTestDone = 0;
+	TEST_ASSERT_EQUAL(0, corr_next(&testCorr, &tick));
+
+	//Refused until fifo is set:
+	r[0] = corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 10, 0);
+	TEST_ASSERT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 11, 0));
+	testCorr.fifo = 1;
+	for(i = 1; i < 3; i++)
+	{
+		r[i] = corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 10 + i, 0);
+		TEST_ASSERT_NOT_NULL(r[i]);
+		r[i]->done = &corrTestOwner;
+		r[i]->user = &got;
+	}
+	TEST_ASSERT_NULL(corr_insert(&testCorr, PORT_USB, FLEXSEA_EXECUTE_2, CMD_TEST, 13, 0));
+	TEST_ASSERT_EQUAL(1, corr_next(&testCorr, &tick));
+	TEST_ASSERT_EQUAL(110, tick);
+
+	//Oldest first, each to its own callback:
+	corrTestReply(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_reply(&testCorr, PORT_USB, payload, 20));
+	TEST_ASSERT_EQUAL(1, corrTestDone);
+	TEST_ASSERT_EQUAL(1, corr_remove(&testCorr, r[2]));
+	TEST_ASSERT_EQUAL(0, corr_remove(&testCorr, r[2]));
+	TEST_ASSERT_EQUAL(1, corr_reply(&testCorr, PORT_USB, payload, 20));
+	TEST_ASSERT_EQUAL(11, got);
+	TEST_ASSERT_EQUAL(1, corrTestDone);
+	TEST_ASSERT_EQUAL(0, testCorr.pending);
+}
+
+void test_flexsea_corr(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_corr_reply);
+	RUN_TEST(test_corr_timeout);
+	RUN_TEST(test_corr_full);
+	RUN_TEST(test_corr_receive);
+	RUN_TEST(test_corr_owners);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
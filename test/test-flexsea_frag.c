@@ -0,0 +1,240 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+//Definitions and variables used by some/all tests:
+//Two ends in the same process: A (PORT_485_1) sends to B (PORT_485_2).
+#define FRAG_WIRE_DEPTH		32
+#define FRAG_PORT_A			PORT_485_1
+#define FRAG_PORT_B			PORT_485_2
+#define FRAG_TEST_LEN		1000
+
+struct frag_wire_s
+{
+	uint8_t str[FRAG_WIRE_DEPTH][RX_BUF_LEN];
+	uint8_t cnt;
+	uint8_t drop;		//Drop frame number 'drop' (1 = next one)
+};
+
+static struct frag_wire_s fragToA, fragToB;
+static uint8_t fragMsg[FRAG_TEST_LEN], fragBuf[FRAG_TEST_LEN + 24];
+static uint8_t fragTxState = FRAG_IDLE;
+static uint32_t fragRxLen = 0;
+static uint8_t fragRxCnt = 0;
+
+static void frag_wire_push(struct frag_wire_s *w, uint8_t *str, uint16_t len)
+{
+	if(w->drop && !(--w->drop))
+	{
+		return;
+	}
+
+	TEST_ASSERT_LESS_THAN(FRAG_WIRE_DEPTH, w->cnt);
+	memset(w->str[w->cnt], 0, RX_BUF_LEN);
+	memcpy(w->str[w->cnt], str, len);
+	w->cnt++;
+}
+
+static void fragSendA(uint8_t *str, uint16_t len) { frag_wire_push(&fragToB, str, len); }
+static void fragSendB(uint8_t *str, uint16_t len) { frag_wire_push(&fragToA, str, len); }
+
+static void fragTestTxDone(uint8_t port, uint8_t state)
+{
+	TEST_ASSERT_EQUAL(FRAG_PORT_A, port);
+	fragTxState = state;
+}
+
+static void fragTestRxDone(uint8_t port, uint8_t *buf, uint32_t len)
+{
+	TEST_ASSERT_EQUAL(FRAG_PORT_B, port);
+	TEST_ASSERT_TRUE(buf == fragBuf);
+	fragRxLen = len;
+	fragRxCnt++;
+}
+
+//Decodes everything on the wire and passes it to 'port'
+static void frag_wire_pump(struct frag_wire_s *w, uint8_t port)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t info[2] = {port, 0};
+	uint8_t i = 0, cnt = w->cnt;
+	uint8_t str[FRAG_WIRE_DEPTH][RX_BUF_LEN];
+
+	//The handlers can send more while we go through the list:
+	memcpy(str, w->str, sizeof(str));
+	w->cnt = 0;
+	for(i = 0; i < cnt; i++)
+	{
+		TEST_ASSERT_EQUAL(1, unpack_payload_test(str[i], rx_cmd));
+		TEST_ASSERT_EQUAL(CMD_W(CMD_FRAG), rx_cmd[0][P_CMD1]);
+		rx_cmd_frag(rx_cmd[0], info);
+	}
+}
+
+//Both ends, one tick at a time. Returns the tick the sender was done at.
+static uint32_t frag_test_run(uint32_t now, uint32_t ticks)
+{
+	uint32_t end = now + ticks;
+
+	for(; (now < end) && (fragTxState != FRAG_DONE) && (fragTxState != FRAG_FAILED); now++)
+	{
+		frag_wire_pump(&fragToB, FRAG_PORT_B);
+		frag_wire_pump(&fragToA, FRAG_PORT_A);
+		frag_poll(FRAG_PORT_A, now);
+		frag_poll(FRAG_PORT_B, now);
+	}
+
+	return now;
+}
+
+static void frag_test_setup(uint8_t window)
+{
+	uint32_t i = 0;
+
+	memset(&fragToA, 0, sizeof(fragToA));
+	memset(&fragToB, 0, sizeof(fragToB));
+	for(i = 0; i < FRAG_TEST_LEN; i++)
+	{
+		fragMsg[i] = (uint8_t)(i * 7 + 3);
+	}
+	memset(fragBuf, 0, sizeof(fragBuf));
+	fragTxState = FRAG_IDLE;
+	fragRxLen = 0;
+	fragRxCnt = 0;
+
+	init_flexsea_frag();
+	frag_config(FRAG_PORT_A, 10, window);
+	frag_config(FRAG_PORT_B, 10, window);
+	flexsea_port_send_ptr[FRAG_PORT_A] = &fragSendA;
+	flexsea_port_send_ptr[FRAG_PORT_B] = &fragSendB;
+}
+
+static void frag_test_cleanup(void)
+{
+	flexsea_port_send_ptr[FRAG_PORT_A] = NULL;
+	flexsea_port_send_ptr[FRAG_PORT_B] = NULL;
+}
+
+//Back to back fragments, one ACK per half window
+void test_frag_transfer(void)
+{
+	uint32_t count = (FRAG_TEST_LEN + FRAG_DATA_BYTES - 1) / FRAG_DATA_BYTES;
+
+	frag_test_setup(8);
+	frag_receive_into(FRAG_PORT_B, fragBuf, sizeof(fragBuf), &fragTestRxDone);
+
+	TEST_ASSERT_EQUAL(1, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, \
+						FRAG_TEST_LEN, &fragTestTxDone, 0));
+	TEST_ASSERT_EQUAL_MESSAGE(8, fragToB.cnt, "A full window, right away");
+	TEST_ASSERT_EQUAL_MESSAGE(0, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, \
+						FRAG_TEST_LEN, &fragTestTxDone, 0), "Busy");
+
+	TEST_ASSERT_LESS_THAN(count, frag_test_run(1, 100));
+	TEST_ASSERT_EQUAL(FRAG_DONE, fragTxState);
+	TEST_ASSERT_EQUAL(1, fragRxCnt);
+	TEST_ASSERT_EQUAL(FRAG_TEST_LEN, fragRxLen);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fragMsg, fragBuf, FRAG_TEST_LEN);
+	TEST_ASSERT_EQUAL(count, commFrag[FRAG_PORT_A].tx.sent);
+	TEST_ASSERT_EQUAL(0, commFrag[FRAG_PORT_A].tx.resent);
+	TEST_ASSERT_EQUAL(0, commFrag[FRAG_PORT_B].rx.naks);
+	TEST_ASSERT_EQUAL(FRAG_DONE, commFrag[FRAG_PORT_B].rx.state);
+
+	//Next message, the same buffer:
+	fragTxState = FRAG_IDLE;
+	frag_receive_into(FRAG_PORT_B, fragBuf, sizeof(fragBuf), &fragTestRxDone);
+	TEST_ASSERT_EQUAL(1, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, 30, \
+						&fragTestTxDone, 200));
+	frag_test_run(200, 100);
+	TEST_ASSERT_EQUAL(FRAG_DONE, fragTxState);
+	TEST_ASSERT_EQUAL(2, fragRxCnt);
+	TEST_ASSERT_EQUAL(30, fragRxLen);
+
+	frag_test_cleanup();
+}
+
+//Every byte needs an ESCAPE: the fragments still fit in a comm. string
+void test_frag_escapes(void)
+{
+	frag_test_setup(8);
+	memset(fragMsg, ESCAPE, 100);
+	memset(&fragMsg[100], HEADER, 100);
+	frag_receive_into(FRAG_PORT_B, fragBuf, sizeof(fragBuf), &fragTestRxDone);
+
+	TEST_ASSERT_EQUAL(1, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, \
+						200, &fragTestTxDone, 0));
+	TEST_ASSERT_EQUAL(8, fragToB.cnt);
+	frag_test_run(1, 100);
+	TEST_ASSERT_EQUAL(FRAG_DONE, fragTxState);
+	TEST_ASSERT_EQUAL(200, fragRxLen);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fragMsg, fragBuf, 200);
+	TEST_ASSERT_EQUAL(0, commFrag[FRAG_PORT_A].tx.resent);
+
+	frag_test_cleanup();
+}
+
+//Lost fragment: NAKed by the receiver right away. Lost ACK: timeout.
+void test_frag_loss(void)
+{
+	frag_test_setup(8);
+	frag_receive_into(FRAG_PORT_B, fragBuf, sizeof(fragBuf), &fragTestRxDone);
+	fragToB.drop = 3;
+	fragToA.drop = 2;
+
+	frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, FRAG_TEST_LEN, \
+				&fragTestTxDone, 0);
+	frag_test_run(1, 200);
+
+	TEST_ASSERT_EQUAL(FRAG_DONE, fragTxState);
+	TEST_ASSERT_EQUAL(1, fragRxCnt);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(fragMsg, fragBuf, FRAG_TEST_LEN);
+	TEST_ASSERT_GREATER_OR_EQUAL(1, commFrag[FRAG_PORT_B].rx.naks);
+	TEST_ASSERT_GREATER_OR_EQUAL(1, commFrag[FRAG_PORT_A].tx.resent);
+
+	frag_test_cleanup();
+}
+
+//Too long for the receiver: the sender gives up. Nobody listening: same.
+void test_frag_errors(void)
+{
+	frag_test_setup(4);
+	frag_receive_into(FRAG_PORT_B, fragBuf, 100, &fragTestRxDone);
+
+	frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, FRAG_TEST_LEN, \
+				&fragTestTxDone, 0);
+	frag_test_run(1, 10 * (FRAG_MAX_RETRIES + 2));
+	TEST_ASSERT_EQUAL(FRAG_FAILED, fragTxState);
+	TEST_ASSERT_EQUAL(FRAG_FAILED, commFrag[FRAG_PORT_B].rx.state);
+	TEST_ASSERT_EQUAL(FRAG_MAX_RETRIES, commFrag[FRAG_PORT_A].tx.resent);
+	TEST_ASSERT_EQUAL(0, fragRxCnt);
+
+	//No buffer:
+	frag_test_setup(4);
+	fragTxState = FRAG_IDLE;
+	TEST_ASSERT_EQUAL(1, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, 10, \
+						&fragTestTxDone, 0));
+	frag_test_run(1, 10 * (FRAG_MAX_RETRIES + 2));
+	TEST_ASSERT_EQUAL(FRAG_FAILED, fragTxState);
+	TEST_ASSERT_EQUAL(FRAG_MAX_RETRIES + 1, commFrag[FRAG_PORT_B].rx.dropped);
+
+	//Too long to be sent:
+	TEST_ASSERT_EQUAL(0, frag_send(FRAG_PORT_A, FLEXSEA_EXECUTE_1, fragMsg, \
+						FRAG_MAX_LEN + 1, &fragTestTxDone, 0));
+
+	frag_test_cleanup();
+}
+
+void test_flexsea_frag(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_frag_transfer);
+	RUN_TEST(test_frag_escapes);
+	RUN_TEST(test_frag_loss);
+	RUN_TEST(test_frag_errors);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,173 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_hist.h"
+#include "../inc/flexsea_corr.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+struct hist_s testHist, testHist2;
+
+//Every value is in its bucket, buckets are 1/HIST_SUB of their values wide
+void test_hist_buckets(void)
+{
+	uint32_t v = 0, i = 0;
+	uint16_t b = 0, last = 0;
+
+	for(v = 0; v < 2 * HIST_SUB; v++)
+	{
+		TEST_ASSERT_EQUAL(v, hist_bucket(v));
+		TEST_ASSERT_EQUAL(v, hist_bucket_low(hist_bucket(v)));
+		TEST_ASSERT_EQUAL(v, hist_bucket_high(hist_bucket(v)));
+	}
+
+	initRandomGenerator(39);
+	for(i = 0; i < 10000; i++)
+	{
+		v = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+		v >>= (i % 32);
+		b = hist_bucket(v);
+		TEST_ASSERT_TRUE(b < HIST_BUCKETS);
+		TEST_ASSERT_TRUE(hist_bucket_low(b) <= v);
+		TEST_ASSERT_TRUE(hist_bucket_high(b) >= v);
+		TEST_ASSERT_TRUE((hist_bucket_high(b) - hist_bucket_low(b)) <= (v / HIST_SUB));
+	}
+
+	//In order, no gaps:
+	for(b = 1; b < HIST_BUCKETS; b++)
+	{
+		TEST_ASSERT_EQUAL(hist_bucket_high(b - 1) + 1, hist_bucket_low(b));
+	}
+	last = hist_bucket(0xFFFFFFFF);
+	TEST_ASSERT_EQUAL(HIST_BUCKETS - 1, last);
+	TEST_ASSERT_EQUAL(0xFFFFFFFF, hist_bucket_high(last));
+}
+
+void test_hist_percentile(void)
+{
+	uint32_t i = 0, p = 0;
+
+	hist_init(&testHist);
+	TEST_ASSERT_EQUAL(0, hist_percentile(&testHist, 500));
+	TEST_ASSERT_EQUAL(0, hist_mean(&testHist));
+
+	for(i = 1; i <= 1000; i++)
+	{
+		hist_record(&testHist, i);
+	}
+	TEST_ASSERT_EQUAL(1000, testHist.count);
+	TEST_ASSERT_EQUAL(1, testHist.min);
+	TEST_ASSERT_EQUAL(1000, testHist.max);
+	TEST_ASSERT_EQUAL(500, hist_mean(&testHist));
+
+	p = hist_percentile(&testHist, 500);
+	TEST_ASSERT_TRUE((p >= 500) && (p <= 500 + 500 / HIST_SUB));
+	p = hist_percentile(&testHist, 990);
+	TEST_ASSERT_TRUE((p >= 990) && (p <= 1000));
+	TEST_ASSERT_EQUAL(1000, hist_percentile(&testHist, 1000));
+	TEST_ASSERT_EQUAL(1, hist_percentile(&testHist, 0));
+
+	//One spike moves the tail only:
+	hist_init(&testHist2);
+	hist_record(&testHist2, 100000);
+	hist_merge(&testHist, &testHist2);
+	TEST_ASSERT_EQUAL(1001, testHist.count);
+	TEST_ASSERT_EQUAL(100000, testHist.max);
+	TEST_ASSERT_TRUE(hist_percentile(&testHist, 999) <= 1000 + 1000 / HIST_SUB);
+	TEST_ASSERT_EQUAL(100000, hist_percentile(&testHist, 1000));
+}
+
+#ifdef ENABLE_FLEXSEA_HIST
+
+static uint32_t histTestNow = 0;
+
+static uint32_t histTestClock(void)
+{
+	return histTestNow;
+}
+
+static void histTestHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+}
+
+//Byte => frame => handler, and request => reply, per port and command
+void test_hist_latency(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_USB, 0};
+	static struct corr_s c;
+
+	hist_reset_all();
+	TEST_ASSERT_EQUAL(1, hist_track_cmd(CMD_TEST));
+	TEST_ASSERT_EQUAL(0, hist_snapshot_cmd(CMD_READ_ALL, HIST_STAGE_RX, &testHist, 0));
+	hist_set_clock(&histTestClock);
+
+	//Second call doesn't restart the frame:
+	histTestNow = 100;
+	hist_rx_byte(PORT_USB);
+	histTestNow = 150;
+	hist_rx_byte(PORT_USB);
+	histTestNow = 160;
+	hist_rx_frame(PORT_USB, CMD_TEST);
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_READ] = &histTestHandler;
+	prepare_empty_payload(board_up_id, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_TEST);
+	histTestNow = 167;
+	TEST_ASSERT_EQUAL(PARSE_SUCCESSFUL, payload_parse_str(payload, info));
+
+	TEST_ASSERT_EQUAL(1, hist_snapshot_port(PORT_USB, HIST_STAGE_RX, &testHist, 0));
+	TEST_ASSERT_EQUAL(1, testHist.count);
+	TEST_ASSERT_EQUAL(60, testHist.max);
+	TEST_ASSERT_EQUAL(1, hist_snapshot_cmd(CMD_TEST, HIST_STAGE_DISPATCH, &testHist, 0));
+	TEST_ASSERT_EQUAL(1, testHist.count);
+	TEST_ASSERT_EQUAL(7, testHist.max);
+
+	//A frame without bytes (same burst) has no RX latency:
+	hist_rx_frame(PORT_USB, CMD_READ_ALL);
+	hist_snapshot_port(PORT_USB, HIST_STAGE_RX, &testHist, 0);
+	TEST_ASSERT_EQUAL(1, testHist.count);
+
+	//RTTs from the correlation table:
+	corr_init(&c, 100, NULL);
+	corr_insert(&c, PORT_USB, FLEXSEA_EXECUTE_1, CMD_TEST, 1000, 0);
+	prepare_empty_payload(FLEXSEA_EXECUTE_1, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMD1] = CMD_W(CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_reply(&c, PORT_USB, payload, 1042));
+	TEST_ASSERT_EQUAL(1, hist_snapshot_cmd(CMD_TEST, HIST_STAGE_RTT, &testHist, 1));
+	TEST_ASSERT_EQUAL(42, testHist.min);
+	hist_snapshot_cmd(CMD_TEST, HIST_STAGE_RTT, &testHist, 0);
+	TEST_ASSERT_EQUAL(0, testHist.count);
+	hist_snapshot_port(PORT_USB, HIST_STAGE_RTT, &testHist, 0);
+	TEST_ASSERT_EQUAL(1, testHist.count);
+
+	//Limits:
+	TEST_ASSERT_EQUAL(0, hist_snapshot_port(NUMBER_OF_PORTS, HIST_STAGE_RX, &testHist, 0));
+	TEST_ASSERT_EQUAL(0, hist_snapshot_port(PORT_USB, HIST_STAGES, &testHist, 0));
+	TEST_ASSERT_EQUAL(0, hist_track_cmd(MAX_CMD_CODE + 1));
+
+	hist_set_clock(NULL);
+	hist_reset_all();
+}
+
+#endif	//ENABLE_FLEXSEA_HIST
+
+void test_flexsea_hist(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_hist_buckets);
+	RUN_TEST(test_hist_percentile);
+	#ifdef ENABLE_FLEXSEA_HIST
+	RUN_TEST(test_hist_latency);
+	#endif	//ENABLE_FLEXSEA_HIST
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
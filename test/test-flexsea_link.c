@@ -0,0 +1,199 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+//Definitions and variables used by some/all tests:
+uint8_t linkTxBuf[RX_BUF_LEN];
+uint16_t linkTxLen = 0;
+uint8_t linkRxCmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+
+static void fakeLinkSend(uint8_t *str, uint16_t len)
+{
+	memset(linkTxBuf, 0, RX_BUF_LEN);
+	memcpy(linkTxBuf, str, len);
+	linkTxLen = len;
+}
+
+void test_link_common_caps(void)
+{
+	struct link_caps_s a = {LINK_FRAME_ESCAPED | LINK_FRAME_FAST, 64, \
+							LINK_CHK_SUM8 | LINK_CHK_CRC8, 4, 0};
+	struct link_caps_s b = {LINK_FRAME_ESCAPED, 48, LINK_CHK_SUM8, 1, 0};
+	struct link_caps_s c;
+
+	link_common_caps(&a, &b, &c);
+	TEST_ASSERT_EQUAL(LINK_FRAME_ESCAPED, c.frames);
+	TEST_ASSERT_EQUAL(48, c.maxFrameLen);
+	TEST_ASSERT_EQUAL(LINK_CHK_SUM8, c.checksums);
+	TEST_ASSERT_EQUAL(1, c.maxCmds);
+
+	link_common_caps(&a, &a, &c);
+	TEST_ASSERT_EQUAL_MESSAGE(LINK_FRAME_FAST, c.frames, "Fastest common frame");
+
+	a.features = LINK_FEAT_ARQ | LINK_FEAT_NATIVE;
+	b.features = LINK_FEAT_NATIVE;
+	link_common_caps(&a, &b, &c);
+	TEST_ASSERT_EQUAL(LINK_FEAT_NATIVE, c.features);
+}
+
+//Slave side: replies with the legacy framing, then upgrades
+void test_link_slave_reply(void)
+{
+	uint8_t info[2] = {PORT_SPI, 0};
+	uint8_t buf[PAYLOAD_BUF_LEN];
+
+	init_flexsea_link();
+	flexsea_port_send_ptr[PORT_SPI] = &fakeLinkSend;
+
+	tx_cmd_link_caps(buf, FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1, READ, \
+						&commLink[PORT_SPI].local);
+	linkTxLen = 0;
+	rx_cmd_link_caps_rw(buf, info);
+
+	TEST_ASSERT_GREATER_THAN(0, linkTxLen);
+	TEST_ASSERT_EQUAL_MESSAGE(HEADER, linkTxBuf[0], "Reply uses the legacy framing");
+	TEST_ASSERT_EQUAL(1, unpack_payload_test(linkTxBuf, linkRxCmd));
+	TEST_ASSERT_EQUAL(CMD_W(CMD_LINK_CAPS), linkRxCmd[0][P_CMD1]);
+	TEST_ASSERT_EQUAL(FLEXSEA_PLAN_1, linkRxCmd[0][P_RID]);
+
+	//Keeps the legacy framing until the master uses the new one:
+	TEST_ASSERT_EQUAL(LINK_NEGOTIATED, commLink[PORT_SPI].state);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+	TEST_ASSERT_EQUAL(FRAMING_FAST, comm_get_framing_next(PORT_SPI));
+
+	//First fast frame from the master:
+	memset(buf, 0, PAYLOAD_BUF_LEN);
+	buf[P_CMD1] = CMD_R(CMD_LINK_CAPS);
+	memset(linkTxBuf, 0, RX_BUF_LEN);
+	linkTxLen = comm_gen_str_fast(buf, linkTxBuf, PAYLOAD_BUF_LEN) + 1;
+	TEST_ASSERT_EQUAL(1, unpack_payload_port(PORT_SPI, linkTxBuf, linkTxLen, \
+												linkRxCmd));
+	TEST_ASSERT_EQUAL(CMD_R(CMD_LINK_CAPS), linkRxCmd[0][P_CMD1]);
+	TEST_ASSERT_EQUAL(FRAMING_FAST, comm_get_framing(PORT_SPI));
+
+	link_reset(PORT_SPI);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing_next(PORT_SPI));
+	flexsea_port_send_ptr[PORT_SPI] = NULL;
+}
+
+//Slave side: the Reply is lost, the master asks again with the legacy framing
+void test_link_lost_reply(void)
+{
+	uint8_t info[2] = {PORT_SPI, 0};
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	uint8_t rxBuf[RX_BUF_LEN];
+	uint8_t len = 0;
+
+	init_flexsea_link();
+	flexsea_port_send_ptr[PORT_SPI] = &fakeLinkSend;
+
+	//Request, Reply lost:
+	tx_cmd_link_caps(buf, FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1, READ, \
+						&commLink[PORT_SPI].local);
+	rx_cmd_link_caps_rw(buf, info);
+	linkTxLen = 0;
+
+	//Retry, legacy framing. The slave still decodes it:
+	tx_cmd_link_caps(buf, FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1, READ, \
+						&commLink[PORT_SPI].local);
+	memset(rxBuf, 0, RX_BUF_LEN);
+	len = comm_gen_str(buf, rxBuf, PAYLOAD_BUF_LEN);
+	TEST_ASSERT_EQUAL(1, unpack_payload_port(PORT_SPI, rxBuf, len + 1, \
+												linkRxCmd));
+	TEST_ASSERT_EQUAL(CMD_R(CMD_LINK_CAPS), linkRxCmd[0][P_CMD1]);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+
+	//...and replies again, still with the legacy framing:
+	rx_cmd_link_caps_rw(linkRxCmd[0], info);
+	TEST_ASSERT_GREATER_THAN(0, linkTxLen);
+	TEST_ASSERT_EQUAL(HEADER, linkTxBuf[0]);
+	TEST_ASSERT_EQUAL(1, unpack_payload_test(linkTxBuf, linkRxCmd));
+	TEST_ASSERT_EQUAL(CMD_W(CMD_LINK_CAPS), linkRxCmd[0][P_CMD1]);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+	TEST_ASSERT_EQUAL(FRAMING_FAST, comm_get_framing_next(PORT_SPI));
+
+	//A corrupted fast frame doesn't make the switch:
+	memset(buf, 0, PAYLOAD_BUF_LEN);
+	buf[P_CMD1] = CMD_R(CMD_LINK_CAPS);
+	memset(rxBuf, 0, RX_BUF_LEN);
+	len = comm_gen_str_fast(buf, rxBuf, PAYLOAD_BUF_LEN) + 1;
+	rxBuf[FAST_HEADER_LEN - 1] ^= 0x01;
+	TEST_ASSERT_TRUE(unpack_payload_port(PORT_SPI, rxBuf, len, linkRxCmd) <= 0);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+
+	link_reset(PORT_SPI);
+	flexsea_port_send_ptr[PORT_SPI] = NULL;
+}
+
+//Master side: upgrades on a reply, stays legacy otherwise
+void test_link_master_upgrade(void)
+{
+	uint8_t info[2] = {PORT_SPI, 0};
+	uint8_t buf[PAYLOAD_BUF_LEN];
+	struct link_caps_s legacyPeer = {LINK_FRAME_ESCAPED, 48, LINK_CHK_SUM8, 1, 0};
+
+	init_flexsea_link();
+
+	//No transmit function:
+	TEST_ASSERT_EQUAL(0, link_request_caps(PORT_SPI, FLEXSEA_MANAGE_1));
+
+	flexsea_port_send_ptr[PORT_SPI] = &fakeLinkSend;
+	TEST_ASSERT_EQUAL(1, link_request_caps(PORT_SPI, FLEXSEA_MANAGE_1));
+	TEST_ASSERT_EQUAL(1, unpack_payload_test(linkTxBuf, linkRxCmd));
+	TEST_ASSERT_EQUAL(CMD_R(CMD_LINK_CAPS), linkRxCmd[0][P_CMD1]);
+
+	//Peer doesn't answer:
+	TEST_ASSERT_EQUAL(LINK_PENDING, commLink[PORT_SPI].state);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+
+	//Legacy peer:
+	tx_cmd_link_caps(buf, FLEXSEA_MANAGE_1, FLEXSEA_PLAN_1, WRITE, &legacyPeer);
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(LINK_NEGOTIATED, commLink[PORT_SPI].state);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_SPI));
+
+	//Peer that supports the fast framing:
+	tx_cmd_link_caps(buf, FLEXSEA_MANAGE_1, FLEXSEA_PLAN_1, WRITE, \
+						&commLink[PORT_SPI].local);
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(FRAMING_FAST, comm_get_framing(PORT_SPI));
+
+	//RS-485 never advertises it:
+	info[0] = PORT_485_1;
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(FRAMING_ESCAPED, comm_get_framing(PORT_485_1));
+
+	//Native payloads, only when both ends say so:
+	TEST_ASSERT_EQUAL(0, link_peer_native(PORT_SPI));
+	legacyPeer.features = LINK_FEAT_NATIVE;
+	tx_cmd_link_caps(buf, FLEXSEA_MANAGE_1, FLEXSEA_PLAN_1, WRITE, &legacyPeer);
+	info[0] = PORT_SPI;
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(0, link_peer_native(PORT_SPI));
+	commLink[PORT_SPI].local.features |= LINK_FEAT_NATIVE;
+	rx_cmd_link_caps_rr(buf, info);
+	TEST_ASSERT_EQUAL(1, link_peer_native(PORT_SPI));
+	link_reset(PORT_SPI);
+	TEST_ASSERT_EQUAL(0, link_peer_native(PORT_SPI));
+	commLink[PORT_SPI].local.features &= ~LINK_FEAT_NATIVE;
+
+	link_reset(PORT_SPI);
+	link_reset(PORT_485_1);
+	flexsea_port_send_ptr[PORT_SPI] = NULL;
+}
+
+void test_flexsea_link(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_link_common_caps);
+	RUN_TEST(test_link_slave_reply);
+	RUN_TEST(test_link_lost_reply);
+	RUN_TEST(test_link_master_upgrade);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
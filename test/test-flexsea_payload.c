@@ -77,6 +77,92 @@ void test_packetType(void)
 	TEST_ASSERT_EQUAL_MESSAGE(RX_PTYPE_INVALID, packetType(testBuffer), "Slave read (invalid)");
 }
 
+//Native layout: one copy each way, through a real frame. Only sent on the
+//ports where it was negotiated.
+void test_payload_native(void)
+{
+	struct
+	{
+		int32_t enc;
+		uint32_t ticks;
+		int16_t current;
+		uint16_t volt;
+		uint8_t status;
+	} in = {-123456, 0xDEADBEEF, -42, 24000, 0x5A}, out;
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t rx[PACKAGED_PAYLOAD_LEN];
+	uint8_t info[2] = {PORT_SPI, 0};
+	struct link_caps_s caps;
+	uint16_t index = P_DATA1;
+	uint8_t len = 0;
+
+	//The other end of PORT_SPI decodes native payloads:
+	init_flexsea_link();
+	caps = commLink[PORT_SPI].local;
+	caps.features |= LINK_FEAT_NATIVE;
+	link_set_local_caps(PORT_SPI, &caps);
+	tx_cmd_link_caps(payload, FLEXSEA_MANAGE_1, FLEXSEA_PLAN_1, WRITE, &caps);
+	rx_cmd_link_caps_rr(payload, info);
+	TEST_ASSERT_EQUAL(1, link_peer_native(PORT_SPI));
+
+	TEST_ASSERT_EQUAL(0, payload_get_native(CMD_TEST));
+	prepare_empty_payload(FLEXSEA_EXECUTE_1, FLEXSEA_PLAN_1, payload, PAYLOAD_BUF_LEN);
+	TEST_ASSERT_EQUAL(0, payload_pack_native(PORT_SPI, payload, CMD_W(CMD_TEST), \
+						&in, sizeof(in)));
+
+	TEST_ASSERT_EQUAL(NATIVE_IS_LE, payload_set_native(CMD_TEST, 1));
+	TEST_ASSERT_EQUAL(NATIVE_IS_LE, payload_get_native(CMD_TEST));
+	TEST_ASSERT_EQUAL(0, payload_set_native(MAX_CMD_CODE, 1));
+	if(!NATIVE_IS_LE)
+	{
+		//Big endian: can't be enabled, can't be packed
+		TEST_ASSERT_EQUAL(0, payload_pack_native(PORT_SPI, payload, CMD_W(CMD_TEST), \
+							&in, sizeof(in)));
+		link_reset(PORT_SPI);
+		return;
+	}
+
+	//Legacy peer on PORT_485_1:
+	TEST_ASSERT_EQUAL(0, link_peer_native(PORT_485_1));
+	TEST_ASSERT_EQUAL(0, payload_pack_native(PORT_485_1, payload, CMD_W(CMD_TEST), \
+						&in, sizeof(in)));
+
+	len = payload_pack_native(PORT_SPI, payload, CMD_W(CMD_TEST), &in, sizeof(in));
+	TEST_ASSERT_EQUAL(P_DATA1 + sizeof(in), len);
+	TEST_ASSERT_EQUAL(1, payload_is_native(payload));
+	TEST_ASSERT_EQUAL(1, P_CMDS_COUNT(payload[P_CMDS]));
+	TEST_ASSERT_EQUAL(RX_PTYPE_REPLY, packetType(payload));
+
+	len = comm_gen_str(payload, str, len) + 1;
+	TEST_ASSERT_GREATER_THAN(0, unpack_payload_frame(str, len, rx));
+	memset(&out, 0, sizeof(out));
+	TEST_ASSERT_EQUAL(NATIVE_IS_LE, payload_unpack_native(rx, &out, sizeof(out)));
+	TEST_ASSERT_EQUAL(in.enc, out.enc);
+	TEST_ASSERT_EQUAL(in.ticks, out.ticks);
+	TEST_ASSERT_EQUAL(in.current, out.current);
+	TEST_ASSERT_EQUAL(in.volt, out.volt);
+	TEST_ASSERT_EQUAL(in.status, out.status);
+
+	//Same bytes as SPLIT_x_NATIVE(), field by field:
+	TEST_ASSERT_EQUAL(in.enc, (int32_t)REBUILD_UINT32_NATIVE(rx, &index));
+	TEST_ASSERT_EQUAL(in.ticks, REBUILD_UINT32_NATIVE(rx, &index));
+	TEST_ASSERT_EQUAL(in.current, (int16_t)REBUILD_UINT16_NATIVE(rx, &index));
+	TEST_ASSERT_EQUAL(in.volt, REBUILD_UINT16_NATIVE(rx, &index));
+	TEST_ASSERT_EQUAL(in.status, rx[index]);
+
+	//Legacy payloads aren't copied, and the default stays legacy:
+	rx[P_CMDS] = 1;
+	TEST_ASSERT_EQUAL(0, payload_unpack_native(rx, &out, sizeof(out)));
+	TEST_ASSERT_EQUAL(0, payload_pack_native(PORT_SPI, payload, CMD_W(CMD_TEST), str, \
+						PAYLOAD_BUF_LEN));
+	payload_set_native(CMD_TEST, 0);
+	TEST_ASSERT_EQUAL(0, payload_get_native(CMD_TEST));
+
+	link_reset(PORT_SPI);
+	caps.features &= ~LINK_FEAT_NATIVE;
+	link_set_local_caps(PORT_SPI, &caps);
+}
+
 void test_flexsea_payload(void)
 {
 	UNITY_BEGIN();
@@ -84,6 +170,7 @@ void test_flexsea_payload(void)
 	RUN_TEST(test_prepare_empty_payload);
 	RUN_TEST(test_sent_from_a_slave);
 	RUN_TEST(test_packetType);
+	RUN_TEST(test_payload_native);
 	UNITY_END();
 }
 
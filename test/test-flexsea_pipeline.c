@@ -0,0 +1,139 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_pipeline.h"
+#include "../inc/flexsea_corr.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+struct pipe_s testPipe;
+struct corr_s testPipeCorr;
+uint8_t pipeTestInfo[2] = {PORT_RS485_1, 0};
+
+static void pipeTestSetup(uint8_t window)
+{
+	corr_init(&testPipeCorr, 1000, NULL);
+	pipe_init(&testPipe, &testPipeCorr, PORT_RS485_1, window, 100);
+}
+
+static void pipeTestRequest(uint8_t *payload, uint8_t rid, uint8_t cmd)
+{
+	prepare_empty_payload(FLEXSEA_MANAGE_1, rid, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(cmd);
+}
+
+static void pipeTestReply(uint8_t *payload, uint8_t xid, uint8_t cmd)
+{
+	prepare_empty_payload(xid, FLEXSEA_MANAGE_1, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(cmd);
+}
+
+static void pipeTestReplyHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+}
+
+//Window, and one request per slave
+void test_pipe_issue(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	struct corr_req_s *r = NULL;
+	uint8_t i = 0;
+
+	pipeTestSetup(3);
+
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	r = pipe_issue(&testPipe, payload, 0);
+	TEST_ASSERT_NOT_NULL(r);
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1, r->rid);
+	TEST_ASSERT_EQUAL(CMD_TEST, r->cmd);
+	TEST_ASSERT_NULL(pipe_issue(&testPipe, payload, 0));		//Same slave
+
+	for(i = 1; i < 3; i++)
+	{
+		pipeTestRequest(payload, FLEXSEA_EXECUTE_1 + i, CMD_TEST);
+		TEST_ASSERT_NOT_NULL(pipe_issue(&testPipe, payload, 0));
+	}
+
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_1 + 3, CMD_TEST);
+	TEST_ASSERT_NULL(pipe_issue(&testPipe, payload, 0));		//Window
+	TEST_ASSERT_EQUAL(3, testPipe.inFlight);
+	TEST_ASSERT_EQUAL(3, testPipeCorr.pending);
+
+	//Somebody else is waiting for that reply:
+	pipeTestSetup(3);
+	corr_insert(&testPipeCorr, PORT_RS485_1, FLEXSEA_EXECUTE_1, CMD_TEST, 0, 0);
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	TEST_ASSERT_NULL(pipe_issue(&testPipe, payload, 0));
+	TEST_ASSERT_EQUAL(0, testPipe.inFlight);
+}
+
+//Replies in any order, matched by XID and command
+void test_pipe_match(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint8_t i = 0;
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &pipeTestReplyHandler;
+	flexsea_payload_ptr[CMD_READ_ALL][RX_PTYPE_REPLY] = &pipeTestReplyHandler;
+	pipeTestSetup(4);
+	for(i = 0; i < 3; i++)
+	{
+		pipeTestRequest(payload, FLEXSEA_EXECUTE_1 + i, CMD_TEST);
+		pipe_issue(&testPipe, payload, i);
+	}
+
+	pipeTestReply(payload, FLEXSEA_EXECUTE_1 + 2, CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_receive(&testPipeCorr, payload, pipeTestInfo, 10));
+	pipeTestReply(payload, FLEXSEA_EXECUTE_1 + 2, CMD_TEST);
+	TEST_ASSERT_EQUAL(0, corr_receive(&testPipeCorr, payload, pipeTestInfo, 10));	//Duplicate
+	pipeTestReply(payload, FLEXSEA_EXECUTE_1, CMD_READ_ALL);
+	TEST_ASSERT_EQUAL(0, corr_receive(&testPipeCorr, payload, pipeTestInfo, 10));	//Other command
+	pipeTestReply(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_receive(&testPipeCorr, payload, pipeTestInfo, 20));
+
+	TEST_ASSERT_EQUAL(1, testPipe.inFlight);
+	TEST_ASSERT_EQUAL(2, testPipe.matched);
+	TEST_ASSERT_EQUAL(2, testPipeCorr.unmatched);
+	TEST_ASSERT_EQUAL(20, testPipe.rttMax);
+	TEST_ASSERT_EQUAL(28, testPipe.rttSum);
+
+	//Free again:
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	TEST_ASSERT_NOT_NULL(pipe_issue(&testPipe, payload, 30));
+}
+
+void test_pipe_expire(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+
+	pipeTestSetup(4);
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_1, CMD_TEST);
+	pipe_issue(&testPipe, payload, 0xFFFFFFF0);			//Wraps
+	pipeTestRequest(payload, FLEXSEA_EXECUTE_2, CMD_TEST);
+	pipe_issue(&testPipe, payload, 50);
+
+	TEST_ASSERT_EQUAL(0, corr_advance(&testPipeCorr, 50));
+	TEST_ASSERT_EQUAL(1, corr_advance(&testPipeCorr, 90));
+	TEST_ASSERT_EQUAL(1, corr_advance(&testPipeCorr, 150));
+	TEST_ASSERT_EQUAL(0, testPipe.inFlight);
+	TEST_ASSERT_EQUAL(2, testPipe.timeouts);
+}
+
+void test_flexsea_pipeline(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_pipe_issue);
+	RUN_TEST(test_pipe_match);
+	RUN_TEST(test_pipe_expire);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
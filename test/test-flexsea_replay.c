@@ -0,0 +1,280 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include "../inc/flexsea_replay.h"
+#include "../inc/flexsea_capture.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+static struct replay_s testReplay;
+static struct capture_s replayCapture;
+static uint8_t replayRecs[CAPTURE_RING_LEN];
+static uint32_t replayRecsLen = 0;
+static uint8_t replayRx[64];
+static uint8_t replayRxPort[64];
+static uint8_t replayRxCnt = 0;
+static uint8_t replayDiverged = 0;
+static uint64_t replayTicks = 0;
+
+static uint64_t replayTestClock(void)
+{
+	return replayTicks;
+}
+
+static void replayTestSink(void *ctx, uint8_t *rec, uint32_t len)
+{
+	(void)ctx;
+	memcpy(&replayRecs[replayRecsLen], rec, len);
+	replayRecsLen += len;
+}
+
+static void replayTestCallback(uint8_t port, uint8_t *payload)
+{
+	if(replayRxCnt < sizeof(replayRx))
+	{
+		replayRx[replayRxCnt] = payload[P_DATA1];
+		replayRxPort[replayRxCnt] = port;
+	}
+	replayRxCnt++;
+}
+
+//Frame with 'data' in P_DATA1. Returns its length.
+static uint8_t replayTestFrame(uint8_t *str, uint8_t data)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	payload[P_DATA1] = data;
+	return comm_gen_str(payload, str, P_DATA1 + 1) + 1;
+}
+
+static void replayTestReset(void)
+{
+	replayRecsLen = 0;
+	replayRxCnt = 0;
+	replayDiverged = 0;
+	replayTicks = 0;
+	capture_init(&replayCapture, &replayTestClock, 1000);
+}
+
+//RX_BYTES record, 'ms' after the start
+static void replayTestBytes(uint8_t port, uint8_t *data, uint16_t len, uint64_t ms)
+{
+	replayTicks = ms;
+	capture_write(&replayCapture, CAPTURE_RX_BYTES, port, 0, data, len);
+}
+
+#ifdef ENABLE_FLEXSEA_CAPTURE
+
+static void replayTestDiverge(struct capture_rec_s *expected, struct capture_rec_s *got)
+{
+	TEST_ASSERT_NOT_NULL(expected);
+	TEST_ASSERT_NOT_NULL(got);
+	replayDiverged++;
+}
+
+static void replayTestDecode(struct rx_buf_s *rb)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+
+	while(unpack_payload_rx(rb, rx_cmd) == PAYLOAD_BUFFERS)
+	{
+		//rx_cmd was full, decode again
+	}
+}
+
+//Records a session: frames on two ports, one of them corrupted, split
+//in the middle of a frame. The records stay in replayCapture.
+static void replayTestRecord(void)
+{
+	uint8_t str[8 * COMM_STR_BUF_LEN];
+	struct rx_buf_s rb[2];
+	uint16_t len = 0;
+	uint8_t i = 0, j = 0;
+
+	replayTestReset();
+	memset(rb, 0, sizeof(rb));
+	rb[0].port = PORT_485_1;
+	rb[1].port = PORT_USB;
+	captureTap = &replayCapture;
+
+	for(i = 0; i < 10; i++)
+	{
+		len = 0;
+		for(j = 0; j < 3; j++)
+		{
+			len += replayTestFrame(&str[len], (uint8_t)(i * 3 + j));
+		}
+		if(i == 4)
+		{
+			str[len - 2]++;
+		}
+
+		//First 5 bytes, then the rest:
+		update_rx_buf_array_s(&rb[i & 1], str, 5);
+		replayTestDecode(&rb[i & 1]);
+		update_rx_buf_array_s(&rb[i & 1], &str[5], len - 5);
+		replayTestDecode(&rb[i & 1]);
+	}
+
+	captureTap = NULL;
+}
+
+//Same frames, same order, same ports
+void test_replay_fast(void)
+{
+	uint8_t i = 0;
+
+	replayTestRecord();
+	capture_drain(&replayCapture, &replayTestSink, NULL);
+	replay_init(&testReplay, REPLAY_FAST);
+	testReplay.rx_callback = &replayTestCallback;
+	TEST_ASSERT_EQUAL(0, replay_buf(&testReplay, replayRecs, replayRecsLen, 0, 1000));
+
+	TEST_ASSERT_EQUAL(20, testReplay.report.records);
+	TEST_ASSERT_EQUAL(29, testReplay.report.frames);
+	TEST_ASSERT_EQUAL(29, testReplay.report.expected);
+	TEST_ASSERT_EQUAL(0, testReplay.report.divergences);
+	TEST_ASSERT_EQUAL(29, replayRxCnt);
+	for(i = 0; i < 29; i++)
+	{
+		//Frame 14 (the last of group 4) was corrupted:
+		TEST_ASSERT_EQUAL(i + (i >= 14), replayRx[i]);
+		TEST_ASSERT_EQUAL(((replayRx[i] / 3) & 1) ? PORT_USB : PORT_485_1, \
+							replayRxPort[i]);
+	}
+
+	//Decode only:
+	replay_init(&testReplay, REPLAY_FAST);
+	testReplay.dispatch = 0;
+	testReplay.rx_callback = &replayTestCallback;
+	replayRxCnt = 0;
+	TEST_ASSERT_EQUAL(0, replay_buf(&testReplay, replayRecs, replayRecsLen, 0, 1000));
+	TEST_ASSERT_EQUAL(29, testReplay.report.frames);
+	TEST_ASSERT_EQUAL(0, replayRxCnt);
+}
+
+//A capture made by a "different decoder"
+void test_replay_divergence(void)
+{
+	struct capture_rec_s *r = NULL;
+	uint64_t pos = 0, first = 0;
+	uint8_t n = 0;
+
+	replayTestRecord();
+	capture_drain(&replayCapture, &replayTestSink, NULL);
+
+	//Changes the 3rd frame that was recorded:
+	while((r = capture_next(replayRecs, replayRecsLen, &pos)) != NULL)
+	{
+		if((r->type == CAPTURE_RX_FRAME) && (++n == 3))
+		{
+			CAPTURE_DATA(r)[3]++;
+			break;
+		}
+	}
+	TEST_ASSERT_NOT_NULL(r);
+
+	replay_init(&testReplay, REPLAY_FAST);
+	testReplay.dispatch = 0;
+	testReplay.diverge = &replayTestDiverge;
+	TEST_ASSERT_EQUAL(0, replay_buf(&testReplay, replayRecs, replayRecsLen, 0, 1000));
+	TEST_ASSERT_EQUAL(1, testReplay.report.divergences);
+	TEST_ASSERT_EQUAL(1, replayDiverged);
+	TEST_ASSERT_EQUAL(29, testReplay.report.frames);
+
+	//Found while replaying the bytes that came before it:
+	first = testReplay.report.firstDivergence;
+	TEST_ASSERT_LESS_THAN((uint64_t)((uint8_t *)r - replayRecs), first);
+	TEST_ASSERT_EQUAL(CAPTURE_RX_BYTES, ((struct capture_rec_s *)&replayRecs[first])->type);
+}
+
+//Through a capture file
+void test_replay_file(void)
+{
+	struct capture_file_s f;
+	char path[64];
+
+	snprintf(path, sizeof(path), "/tmp/flexsea-replay-%d.fxc", (int)getpid());
+	unlink(path);
+	replayTestRecord();
+	TEST_ASSERT_EQUAL(0, capture_file_open(&f, &replayCapture, path));
+	TEST_ASSERT_EQUAL(0, capture_file_close(&f));
+
+	replay_init(&testReplay, REPLAY_FAST);
+	testReplay.dispatch = 0;
+	TEST_ASSERT_EQUAL(0, replay_file(&testReplay, path));
+	TEST_ASSERT_EQUAL(20, testReplay.report.records);
+	TEST_ASSERT_EQUAL(29, testReplay.report.frames);
+	TEST_ASSERT_EQUAL(0, testReplay.report.divergences);
+	TEST_ASSERT_GREATER_THAN(0, testReplay.report.ns);
+
+	TEST_ASSERT_EQUAL(-1, replay_file(&testReplay, "/dev/null"));
+	unlink(path);
+}
+
+#endif	//ENABLE_FLEXSEA_CAPTURE
+
+//Original timing, and faster
+void test_replay_timed(void)
+{
+	uint8_t str[COMM_STR_BUF_LEN];
+	uint8_t len = 0, i = 0;
+
+	replayTestReset();
+	for(i = 0; i < 3; i++)
+	{
+		len = replayTestFrame(str, i);
+		replayTestBytes(PORT_SPI, str, len, 100 + i * 20);
+	}
+	capture_drain(&replayCapture, &replayTestSink, NULL);
+
+	replay_init(&testReplay, REPLAY_TIMED);
+	testReplay.rx_callback = &replayTestCallback;
+	TEST_ASSERT_EQUAL(0, replay_buf(&testReplay, replayRecs, replayRecsLen, 0, 1000));
+	TEST_ASSERT_EQUAL(3, replayRxCnt);
+	TEST_ASSERT_EQUAL(3, testReplay.report.frames);
+	TEST_ASSERT_GREATER_OR_EQUAL(40000000, testReplay.report.ns);
+	TEST_ASSERT_LESS_THAN(100000000, testReplay.report.ns);
+
+	testReplay.speed = 400;
+	TEST_ASSERT_EQUAL(0, replay_buf(&testReplay, replayRecs, replayRecsLen, 0, 1000));
+	TEST_ASSERT_GREATER_OR_EQUAL(10000000, testReplay.report.ns);
+	TEST_ASSERT_LESS_THAN(40000000, testReplay.report.ns);
+
+	//Not a sequence of records:
+	replay_init(&testReplay, REPLAY_FAST);
+	testReplay.dispatch = 0;
+	TEST_ASSERT_EQUAL(-1, replay_buf(&testReplay, replayRecs, replayRecsLen - 1, 0, 1000));
+}
+
+#endif	//__linux__
+
+void test_flexsea_replay(void)
+{
+	UNITY_BEGIN();
+	#ifdef __linux__
+	#ifdef ENABLE_FLEXSEA_CAPTURE
+	RUN_TEST(test_replay_fast);
+	RUN_TEST(test_replay_divergence);
+	RUN_TEST(test_replay_file);
+	#endif	//ENABLE_FLEXSEA_CAPTURE
+	RUN_TEST(test_replay_timed);
+	#endif	//__linux__
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
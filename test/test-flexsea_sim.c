@@ -0,0 +1,198 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_sim.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_tdma.h"
+
+//Definitions and variables used by some/all tests:
+struct sim_s testSim;
+uint32_t simReplies = 0;
+uint8_t simIdSeen = 0, simIdOk = 1;
+
+static void simTestReplyHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+	simReplies++;
+}
+
+//Checks that board_id is the virtual board's while its handler runs
+static uint8_t simTestHandler(struct sim_board_s *b, uint8_t *rx, uint8_t *tx)
+{
+	simIdSeen = b->id;
+	if(board_id != b->id)
+	{
+		simIdOk = 0;
+	}
+	return sim_reply_default(b, rx, tx);
+}
+
+static uint64_t simFrameNs(struct sim_s *s, uint8_t bytes, uint32_t baud)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], cstr[COMM_STR_BUF_LEN];
+
+	(void)s;
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	return (uint64_t)(comm_gen_str(payload, cstr, bytes) + 1) * 10 * 1000000000ULL / baud;
+}
+
+static void simTestSetup(uint32_t errorPpm)
+{
+	int bus = 0, i = 0;
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &simTestReplyHandler;
+	simReplies = 0;
+
+	sim_init(&testSim, 1234);
+	bus = sim_add_bus(&testSim, 1000000, 5000, errorPpm, PORT_RS485_1);
+	for(i = 0; i < 4; i++)
+	{
+		sim_add_board(&testSim, bus, FLEXSEA_EXECUTE_1 + i, 50000);
+	}
+}
+
+//Clean bus: every request gets a reply, round robin, fixed latency
+void test_sim_clean_bus(void)
+{
+	uint64_t cycle = 0;
+	int i = 0;
+
+	simTestSetup(0);
+	sim_run(&testSim, 100000000);	//100 ms
+
+	TEST_ASSERT_EQUAL(0, testSim.timeouts);
+	TEST_ASSERT_EQUAL(0, testSim.bus[0].collisions);
+	TEST_ASSERT_GREATER_THAN(0, testSim.replies);
+	TEST_ASSERT_EQUAL(testSim.replies, simReplies);	//Through payload_parse_str()
+	for(i = 0; i < 4; i++)
+	{
+		TEST_ASSERT_LESS_OR_EQUAL(1, testSim.board[0].requests - testSim.board[i].requests);
+	}
+
+	//Request, compute (the turnaround happens meanwhile), reply:
+	cycle = simFrameNs(&testSim, P_DATA1, 1000000) + 50000 + \
+			simFrameNs(&testSim, P_DATA1 + 8, 1000000);
+	TEST_ASSERT_EQUAL_UINT32((uint32_t)cycle, testSim.latMin);
+	TEST_ASSERT_LESS_OR_EQUAL(cycle + 8 * 10000, testSim.latMax);	//Escapes
+
+	//Next request after another turnaround:
+	TEST_ASSERT_LESS_OR_EQUAL((100000000 + 5000) / (cycle + 5000), testSim.replies);
+	TEST_ASSERT_GREATER_OR_EQUAL(100000000 / (cycle + 5000 + 8 * 10000), testSim.replies);
+	TEST_ASSERT_GREATER_OR_EQUAL(cycle, sim_latency_percentile(&testSim, 99));
+
+	//Everything is back to normal:
+	TEST_ASSERT_EQUAL(FLEXSEA_MANAGE_1, board_id);
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1, board_sub1_id[0]);
+}
+
+//Corrupted bytes: lost replies end with a timeout, the master moves on
+void test_sim_errors(void)
+{
+	simTestSetup(5000);		//0.5% of the bytes
+	sim_run(&testSim, 100000000);
+
+	TEST_ASSERT_GREATER_THAN(0, testSim.timeouts);
+	TEST_ASSERT_GREATER_THAN(0, testSim.bus[0].corrupted);
+	TEST_ASSERT_LESS_OR_EQUAL(1, testSim.requests - testSim.replies - testSim.timeouts);
+	TEST_ASSERT_GREATER_THAN(testSim.replies / 2, testSim.requests - testSim.timeouts);
+}
+
+//Per-board handler tables
+void test_sim_handlers(void)
+{
+	static sim_reply_t table[MAX_CMD_CODE];
+
+	simTestSetup(0);
+	table[CMD_TEST] = &simTestHandler;
+	testSim.board[2].handlers = table;
+	simIdOk = 1;
+	simIdSeen = 0;
+
+	sim_run(&testSim, 10000000);
+
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1 + 2, simIdSeen);
+	TEST_ASSERT_EQUAL(1, simIdOk);
+	TEST_ASSERT_EQUAL(0, testSim.timeouts);
+}
+
+//Slow slaves: with 4 requests in flight the bus works while they compute
+void test_sim_pipelined(void)
+{
+	uint64_t serial = 0;
+	int bus = 0, i = 0;
+
+	simTestSetup(0);
+	for(i = 0; i < 4; i++)
+	{
+		testSim.board[i].computeNs = 1000000;
+	}
+	sim_run(&testSim, 100000000);
+	serial = testSim.replies;
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &simTestReplyHandler;
+	sim_init(&testSim, 1234);
+	testSim.window = 4;
+	bus = sim_add_bus(&testSim, 1000000, 5000, 0, PORT_RS485_1);
+	testSim.bus[bus].timeoutNs = 5000000;
+	testSim.bus[bus].pipe.timeout = 5000;
+	for(i = 0; i < 4; i++)
+	{
+		sim_add_board(&testSim, bus, FLEXSEA_EXECUTE_1 + i, 1000000);
+	}
+	sim_run(&testSim, 100000000);
+
+	TEST_ASSERT_EQUAL(0, testSim.timeouts);
+	TEST_ASSERT_EQUAL(0, testSim.bus[bus].corr.unmatched);
+	TEST_ASSERT_GREATER_THAN(3 * serial, testSim.replies);
+	TEST_ASSERT_GREATER_THAN(0, testSim.bus[bus].collisions);	//Needs a queue
+}
+
+//Scheduled bus: every slot on time, nobody talks over anybody
+void test_sim_tdma(void)
+{
+	static struct tdma_s tdma;
+	uint8_t i = 0;
+
+	simTestSetup(0);
+	tdma_init(&tdma, PORT_RS485_1, 1000000, 5);
+	tdma.escapePct = 25;
+	for(i = 0; i < 4; i++)
+	{
+		tdma_add(&tdma, FLEXSEA_EXECUTE_1 + i, CMD_TEST, 500, 0, 8, 50);
+	}
+	TEST_ASSERT_EQUAL(TDMA_PLAN_OK, tdma_plan(&tdma));
+	TEST_ASSERT_EQUAL(680, tdma_utilization(&tdma));
+	testSim.bus[0].tdma = &tdma;
+
+	sim_run(&testSim, 100000000);
+
+	TEST_ASSERT_EQUAL(0, testSim.bus[0].collisions);
+	TEST_ASSERT_EQUAL(0, tdma.misses);
+	TEST_ASSERT_EQUAL(0, tdma.noReply);
+	TEST_ASSERT_EQUAL(0, testSim.bus[0].corr.unmatched);
+	TEST_ASSERT_EQUAL(200, testSim.replies);		//50 major frames of 4
+	TEST_ASSERT_EQUAL(testSim.replies, simReplies);
+	TEST_ASSERT_LESS_OR_EQUAL(tdma.entry[0].slotUs * 1000, testSim.latMax);
+	for(i = 0; i < 4; i++)
+	{
+		TEST_ASSERT_EQUAL(50, tdma.entry[i].replies);
+	}
+}
+
+void test_flexsea_sim(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_sim_clean_bus);
+	RUN_TEST(test_sim_errors);
+	RUN_TEST(test_sim_handlers);
+	RUN_TEST(test_sim_pipelined);
+	RUN_TEST(test_sim_tdma);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
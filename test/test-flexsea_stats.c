@@ -0,0 +1,207 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_stats.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_buffers.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+static uint16_t statsSent = 0;
+
+static void statsTestSend(uint8_t *str, uint16_t len)
+{
+	(void)str;
+	statsSent += len;
+}
+
+static void statsTestResetAll(void)
+{
+	uint8_t i = 0;
+
+	for(i = 0; i < COMM_STATS_PORTS; i++)
+	{
+		comm_stats_reset(i);
+	}
+}
+
+static void statsTestPayload(uint8_t *payload)
+{
+	memset(payload, 0, PAYLOAD_BUF_LEN);
+	payload[P_XID] = FLEXSEA_PLAN_1;
+	payload[P_RID] = FLEXSEA_MANAGE_1;
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+}
+
+//Encoding and sending count on their own port
+void test_stats_tx(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	struct comm_stats_s s;
+	uint16_t len = 0;
+
+	statsTestResetAll();
+	statsTestPayload(payload);
+	payload[P_DATA1] = HEADER;
+	payload[P_DATA1 + 1] = ESCAPE;
+
+	len = comm_gen_str_port(PORT_485_1, payload, str, P_DATA1 + 2);
+	TEST_ASSERT_GREATER_THAN(0, len);
+	flexsea_port_send_ptr[PORT_485_1] = &statsTestSend;
+	statsSent = 0;
+	TEST_ASSERT_EQUAL(1, comm_port_send(PORT_485_1, str, len + 1));
+	flexsea_port_send_ptr[PORT_485_1] = NULL;
+
+	comm_stats_snapshot(PORT_485_1, &s);
+	TEST_ASSERT_EQUAL(1, s.framesEncoded);
+	TEST_ASSERT_EQUAL(2, s.escapes);
+	TEST_ASSERT_EQUAL(len + 1, s.bytesOut);
+	TEST_ASSERT_EQUAL(statsSent, s.bytesOut);
+
+	//Nothing on the other ports:
+	comm_stats_snapshot(PORT_SPI, &s);
+	TEST_ASSERT_EQUAL(0, s.framesEncoded);
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &s);
+	TEST_ASSERT_EQUAL(0, s.framesEncoded);
+
+	//Too long:
+	TEST_ASSERT_EQUAL(0, comm_gen_str_port(PORT_485_1, payload, str, 0x100));
+	comm_stats_snapshot(PORT_485_1, &s);
+	TEST_ASSERT_EQUAL(1, s.overruns);
+	TEST_ASSERT_EQUAL(1, s.framesEncoded);
+}
+
+//Bytes in, frames decoded, and what was lost on the way
+void test_stats_rx(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t junk[RX_BUF_LEN];
+	struct rx_buf_s rb;
+	struct comm_stats_s s;
+	uint8_t len = 0;
+
+	statsTestResetAll();
+	memset(&rb, 0, sizeof(rb));
+	rb.port = PORT_SPI;
+	statsTestPayload(payload);
+	len = comm_gen_str(payload, str, P_DATA1 + 1) + 1;
+
+	update_rx_buf_array_s(&rb, str, len);
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&rb, rx_cmd));
+	comm_stats_snapshot(PORT_SPI, &s);
+	TEST_ASSERT_EQUAL(len, s.bytesIn);
+	TEST_ASSERT_EQUAL(1, s.framesDecoded);
+	TEST_ASSERT_EQUAL(0, s.discarded);
+
+	//Bad checksum: the frame is discarded
+	str[len - 2]++;
+	update_rx_buf_array_s(&rb, str, len);
+	TEST_ASSERT_EQUAL(UNPACK_ERR_CHECKSUM, unpack_payload_rx(&rb, rx_cmd));
+	comm_stats_snapshot(PORT_SPI, &s);
+	TEST_ASSERT_EQUAL(1, s.badChecksum);
+	TEST_ASSERT_EQUAL(len, s.discarded);
+
+	//Noise pushed out of the buffer without being decoded:
+	memset(junk, 0x55, sizeof(junk));
+	update_rx_buf_array_s(&rb, junk, RX_BUF_LEN);
+	update_rx_buf_byte_s(&rb, 0x55);
+	comm_stats_snapshot(PORT_SPI, &s);
+	TEST_ASSERT_EQUAL(2 * len + RX_BUF_LEN + 1, s.bytesIn);
+	TEST_ASSERT_EQUAL(len + 1, s.discarded);
+	TEST_ASSERT_EQUAL(1, s.framesDecoded);
+
+	//The port-less calls have their own counters:
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &s);
+	TEST_ASSERT_EQUAL(1, s.framesEncoded);
+	TEST_ASSERT_EQUAL(0, s.framesDecoded);
+}
+
+void test_stats_frame_errors(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	uint8_t out[PACKAGED_PAYLOAD_LEN];
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	struct comm_stats_s s;
+	uint8_t len = 0;
+
+	statsTestResetAll();
+	statsTestPayload(payload);
+	len = comm_gen_str(payload, str, P_DATA1 + 1) + 1;
+
+	TEST_ASSERT_GREATER_THAN(0, unpack_payload_frame(str, len, out));
+	TEST_ASSERT_EQUAL(UNPACK_ERR_LEN, unpack_payload_frame(str, len - 1, out));
+	str[len - 1] = 0;
+	TEST_ASSERT_EQUAL(UNPACK_ERR_FOOTER, unpack_payload_frame(str, len, out));
+	str[len - 1] = FOOTER;
+	str[len - 2]++;
+	TEST_ASSERT_EQUAL(UNPACK_ERR_CHECKSUM, unpack_payload_frame(str, len, out));
+
+	comm_stats_snapshot(COMM_STATS_NO_PORT, &s);
+	TEST_ASSERT_EQUAL(1, s.framesDecoded);
+	TEST_ASSERT_EQUAL(1, s.badLength);
+	TEST_ASSERT_EQUAL(1, s.badFooter);
+	TEST_ASSERT_EQUAL(1, s.badChecksum);
+
+	//Fast framing:
+	comm_set_framing(PORT_SPI, FRAMING_FAST);
+	len = (uint8_t)comm_gen_str_port(PORT_SPI, payload, str, P_DATA1 + 1) + 1;
+	TEST_ASSERT_EQUAL(1, unpack_payload_port(PORT_SPI, str, len, rx_cmd));
+	str[4]++;
+	TEST_ASSERT_EQUAL(UNPACK_ERR_CHECKSUM, unpack_payload_port(PORT_SPI, str, \
+						len, rx_cmd));
+	comm_set_framing(PORT_SPI, FRAMING_ESCAPED);
+
+	comm_stats_snapshot(PORT_SPI, &s);
+	TEST_ASSERT_EQUAL(1, s.framesEncoded);
+	TEST_ASSERT_EQUAL(1, s.framesDecoded);
+	TEST_ASSERT_EQUAL(1, s.badChecksum);
+}
+
+void test_stats_total_reset(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], str[2 * COMM_STR_BUF_LEN];
+	struct comm_stats_s s;
+	uint8_t i = 0;
+
+	statsTestResetAll();
+	statsTestPayload(payload);
+	for(i = 0; i < NUMBER_OF_PORTS; i++)
+	{
+		comm_gen_str_port(i, payload, str, P_DATA1 + 1);
+	}
+	comm_gen_str(payload, str, P_DATA1 + 1);
+
+	comm_stats_total(&s);
+	TEST_ASSERT_EQUAL(NUMBER_OF_PORTS + 1, s.framesEncoded);
+
+	//Out of range ports share the port-less counters:
+	comm_stats_snapshot(0xFF, &s);
+	TEST_ASSERT_EQUAL(1, s.framesEncoded);
+
+	comm_stats_reset(PORT_485_1);
+	comm_stats_snapshot(PORT_485_1, &s);
+	TEST_ASSERT_EQUAL(0, s.framesEncoded);
+	comm_stats_total(&s);
+	TEST_ASSERT_EQUAL(NUMBER_OF_PORTS, s.framesEncoded);
+
+	//Counters have their own cache line:
+	TEST_ASSERT_EQUAL(0, sizeof(struct comm_stats_line_s) % COMM_STATS_LINE);
+}
+
+void test_flexsea_stats(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_stats_tx);
+	RUN_TEST(test_stats_rx);
+	RUN_TEST(test_stats_frame_errors);
+	RUN_TEST(test_stats_total_reset);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,450 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		//posix_openpt(), ptsname()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_buffers.h"
+
+//Definitions and variables used by some/all tests:
+//Two ends in the same process: A (PORT_485_1) sends to B (PORT_485_2) over
+//a byte stream, delivered STREAM_WIRE_SLICE bytes at a time.
+#define STREAM_WIRE_LEN		8192
+#define STREAM_WIRE_SLICE	37
+#define STREAM_PORT_A		PORT_485_1
+#define STREAM_PORT_B		PORT_485_2
+#define STREAM_TEST_LEN		5000
+#define STREAM_TEST_BLOCK	512
+#define STREAM_TEST_RTO		200		//Ticks, a few windows on the wire
+
+struct stream_wire_s
+{
+	uint8_t data[STREAM_WIRE_LEN];
+	uint32_t len;
+	uint32_t total;			//Bytes sent so far
+	uint32_t corrupt;		//Changes byte number 'corrupt' - 1 (0: none)
+	uint8_t dropFinal;		//Drops the receiver's final ACK
+	struct rx_buf_s rx;
+};
+
+static struct stream_wire_s streamToA, streamToB;
+static uint8_t streamMsg[STREAM_TEST_LEN], streamOut[STREAM_TEST_LEN];
+static uint8_t streamBlock[STREAM_TEST_BLOCK];
+static uint8_t streamTxState = STREAM_IDLE, streamRxState = STREAM_IDLE;
+static uint32_t streamRxLen = 0, streamWriteAt = 0;
+
+static void stream_wire_push(struct stream_wire_s *w, uint8_t *str, uint16_t len)
+{
+	if(w->dropFinal && (commStream[STREAM_PORT_B].rx.state == STREAM_DONE))
+	{
+		w->dropFinal = 0;
+		return;
+	}
+
+	TEST_ASSERT_LESS_OR_EQUAL(STREAM_WIRE_LEN, w->len + len);
+	memcpy(&w->data[w->len], str, len);
+	if(w->corrupt && (w->corrupt > w->total) && (w->corrupt <= (w->total + len)))
+	{
+		w->data[w->len + (w->corrupt - w->total - 1)] ^= 0x10;
+	}
+	w->len += len;
+	w->total += len;
+}
+
+static void streamSendA(uint8_t *str, uint16_t len) { stream_wire_push(&streamToB, str, len); }
+static void streamSendB(uint8_t *str, uint16_t len) { stream_wire_push(&streamToA, str, len); }
+
+static void streamTestTxDone(uint8_t port, uint8_t state)
+{
+	TEST_ASSERT_EQUAL(STREAM_PORT_A, port);
+	streamTxState = state;
+}
+
+static void streamTestWrite(uint8_t port, uint32_t offset, uint8_t *data, uint16_t len)
+{
+	TEST_ASSERT_EQUAL(STREAM_PORT_B, port);
+	TEST_ASSERT_EQUAL_MESSAGE(streamWriteAt, offset, "In order");
+	TEST_ASSERT_LESS_OR_EQUAL(STREAM_TEST_LEN, offset + len);
+	memcpy(&streamOut[offset], data, len);
+	streamWriteAt = offset + len;
+}
+
+static void streamTestRxDone(uint8_t port, uint8_t state, uint32_t len)
+{
+	TEST_ASSERT_EQUAL(STREAM_PORT_B, port);
+	streamRxState = state;
+	streamRxLen = len;
+}
+
+//What transport_rx() does: bulk mode bytes to stream_rx(), the others to
+//the decoder. What's left after the end of a session waits for the next
+//call.
+static void stream_wire_pump(struct stream_wire_s *w, uint8_t port)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t info[2] = {port, 0};
+	uint32_t n = MIN(w->len, STREAM_WIRE_SLICE);
+	int8_t ret = 0, i = 0;
+
+	if(stream_active(port))
+	{
+		n = stream_rx(port, w->data, n);
+	}
+	else
+	{
+		update_rx_buf_array_s(&w->rx, w->data, n);
+		ret = unpack_payload_rx(&w->rx, rx_cmd);
+		for(i = 0; i < ret; i++)
+		{
+			TEST_ASSERT_EQUAL(CMD_W(CMD_STREAM), rx_cmd[i][P_CMD1]);
+			rx_cmd_stream(rx_cmd[i], info);
+		}
+	}
+
+	memmove(w->data, &w->data[n], w->len - n);
+	w->len -= n;
+}
+
+//Both ends, one tick at a time, until the receiver is back in command mode
+static uint32_t stream_test_run(uint32_t now, uint32_t ticks)
+{
+	uint32_t end = now + ticks;
+
+	for(; now < end; now++)
+	{
+		stream_wire_pump(&streamToB, STREAM_PORT_B);
+		stream_wire_pump(&streamToA, STREAM_PORT_A);
+		stream_poll(STREAM_PORT_A, now);
+		stream_poll(STREAM_PORT_B, now);
+
+		if((streamTxState != STREAM_IDLE) && !stream_active(STREAM_PORT_B) && \
+			!streamToA.len && !streamToB.len)
+		{
+			break;
+		}
+	}
+
+	return now;
+}
+
+static void stream_test_setup(uint8_t window)
+{
+	uint32_t i = 0;
+
+	memset(&streamToA, 0, sizeof(streamToA));
+	memset(&streamToB, 0, sizeof(streamToB));
+	streamToA.rx.port = STREAM_PORT_A;
+	streamToB.rx.port = STREAM_PORT_B;
+	for(i = 0; i < STREAM_TEST_LEN; i++)
+	{
+		//Framing bytes and SYNC in the data:
+		streamMsg[i] = (uint8_t)(i * 13 + 5);
+	}
+	memset(streamOut, 0, sizeof(streamOut));
+	streamTxState = STREAM_IDLE;
+	streamRxState = STREAM_IDLE;
+	streamRxLen = 0;
+	streamWriteAt = 0;
+
+	init_flexsea_stream();
+	stream_config(STREAM_PORT_A, STREAM_TEST_RTO, window, 0);
+	stream_config(STREAM_PORT_B, STREAM_TEST_RTO, window, 0);
+	flexsea_port_send_ptr[STREAM_PORT_A] = &streamSendA;
+	flexsea_port_send_ptr[STREAM_PORT_B] = &streamSendB;
+}
+
+static void stream_test_cleanup(void)
+{
+	flexsea_port_send_ptr[STREAM_PORT_A] = NULL;
+	flexsea_port_send_ptr[STREAM_PORT_B] = NULL;
+}
+
+void test_stream_crc32(void)
+{
+	uint8_t check[9] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+	TEST_ASSERT_EQUAL_HEX32(0xCBF43926, stream_crc32(check, sizeof(check)));
+	TEST_ASSERT_EQUAL_HEX32(0, stream_crc32(check, 0));
+}
+
+//Request, blocks as large as the receiver can take, back to command mode
+void test_stream_transfer(void)
+{
+	uint32_t count = (STREAM_TEST_LEN + STREAM_TEST_BLOCK - 1) / STREAM_TEST_BLOCK;
+	uint32_t overhead = 0, now = 0;
+
+	stream_test_setup(4);
+	stream_receive(STREAM_PORT_B, streamBlock, sizeof(streamBlock), \
+					&streamTestWrite, &streamTestRxDone);
+
+	TEST_ASSERT_EQUAL(1, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, \
+						STREAM_TEST_LEN, &streamTestTxDone, 0));
+	TEST_ASSERT_EQUAL(STREAM_OPENING, commStream[STREAM_PORT_A].tx.state);
+	TEST_ASSERT_EQUAL_MESSAGE(0, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, \
+						streamMsg, 10, &streamTestTxDone, 0), "Busy");
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+
+	now = stream_test_run(1, 5000);
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamTxState);
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamRxState);
+	TEST_ASSERT_EQUAL(STREAM_TEST_LEN, streamRxLen);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(streamMsg, streamOut, STREAM_TEST_LEN);
+	TEST_ASSERT_EQUAL(STREAM_TEST_BLOCK, commStream[STREAM_PORT_A].tx.block);
+	TEST_ASSERT_EQUAL(count, commStream[STREAM_PORT_A].tx.sent);
+	TEST_ASSERT_EQUAL(0, commStream[STREAM_PORT_A].tx.resent);
+	TEST_ASSERT_EQUAL(count, commStream[STREAM_PORT_B].rx.blocks);
+	TEST_ASSERT_EQUAL(0, commStream[STREAM_PORT_B].parser.badHeaders);
+	TEST_ASSERT_EQUAL(0, commStream[STREAM_PORT_B].parser.skipped);
+
+	//Headers and CRCs only, no escaping:
+	overhead = streamToB.total - STREAM_TEST_LEN;
+	TEST_ASSERT_LESS_THAN(COMM_STR_BUF_LEN + count * \
+							(STREAM_HEADER_LEN + STREAM_CRC_LEN) + 1, overhead);
+
+	//Both ends are back in command mode:
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_B));
+
+	//Next session, a few bytes:
+	stream_receive(STREAM_PORT_B, streamBlock, sizeof(streamBlock), \
+					&streamTestWrite, &streamTestRxDone);
+	streamTxState = STREAM_IDLE;
+	streamWriteAt = 0;
+	TEST_ASSERT_EQUAL(1, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, \
+						30, &streamTestTxDone, now));
+	stream_test_run(now, 5000);
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamTxState);
+	TEST_ASSERT_EQUAL(30, streamRxLen);
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_B));
+
+	stream_test_cleanup();
+}
+
+//The sender leaves bulk mode on the final ACK: a frame in the same chunk
+//is left to the decoder
+void test_stream_rx_tail(void)
+{
+	uint8_t rx_cmd[PAYLOAD_BUFFERS][PACKAGED_PAYLOAD_LEN];
+	uint8_t tmp[PAYLOAD_BUF_LEN], str[COMM_STR_BUF_LEN];
+	uint32_t now = 0, n = 0;
+	uint8_t len = 0;
+
+	stream_test_setup(4);
+	stream_receive(STREAM_PORT_B, streamBlock, sizeof(streamBlock), \
+					&streamTestWrite, &streamTestRxDone);
+	TEST_ASSERT_EQUAL(1, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, \
+						30, &streamTestTxDone, 0));
+
+	//Until the final ACK is on its way to A:
+	for(now = 1; (now < 5000) && (streamRxState == STREAM_IDLE); now++)
+	{
+		stream_wire_pump(&streamToA, STREAM_PORT_A);
+		stream_poll(STREAM_PORT_A, now);
+		stream_poll(STREAM_PORT_B, now);
+		stream_wire_pump(&streamToB, STREAM_PORT_B);
+	}
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamRxState);
+	TEST_ASSERT_TRUE(stream_active(STREAM_PORT_A));
+	TEST_ASSERT_NOT_EQUAL(0, streamToA.len);
+
+	//B is back to frames right after it:
+	memset(tmp, 0, sizeof(tmp));
+	tmp[P_XID] = FLEXSEA_EXECUTE_1;
+	tmp[P_RID] = FLEXSEA_PLAN_1;
+	tmp[P_CMDS] = 1;
+	tmp[P_CMD1] = CMD_R(CMD_READ_ALL);
+	tmp[P_DATA1] = 0xA5;
+	len = comm_gen_str(tmp, str, P_DATA1 + 1) + 1;
+	stream_wire_push(&streamToA, str, len);
+
+	n = stream_rx(STREAM_PORT_A, streamToA.data, streamToA.len);
+	TEST_ASSERT_EQUAL(streamToA.len - len, n);
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamTxState);
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+
+	update_rx_buf_array_s(&streamToA.rx, &streamToA.data[n], len);
+	TEST_ASSERT_EQUAL(1, unpack_payload_rx(&streamToA.rx, rx_cmd));
+	TEST_ASSERT_EQUAL(0xA5, rx_cmd[0][P_DATA1]);
+
+	stream_test_cleanup();
+}
+
+//Corrupted block: NAKed, resent. Lost final ACK: the sender times out and
+//the receiver, still in bulk mode, repeats it.
+void test_stream_errors(void)
+{
+	stream_test_setup(4);
+	stream_receive(STREAM_PORT_B, streamBlock, sizeof(streamBlock), \
+					&streamTestWrite, &streamTestRxDone);
+	streamToB.corrupt = 1500;
+	streamToA.dropFinal = 1;
+
+	stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, STREAM_TEST_LEN, \
+				&streamTestTxDone, 0);
+	stream_test_run(1, 5000);
+
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamTxState);
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamRxState);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(streamMsg, streamOut, STREAM_TEST_LEN);
+	TEST_ASSERT_EQUAL(1, commStream[STREAM_PORT_B].parser.badCrcs);
+	TEST_ASSERT_EQUAL(1, commStream[STREAM_PORT_B].rx.naks);
+	TEST_ASSERT_GREATER_OR_EQUAL(1, commStream[STREAM_PORT_B].rx.duplicates);
+	TEST_ASSERT_GREATER_OR_EQUAL(2, commStream[STREAM_PORT_A].tx.resent);
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_B));
+
+	//Not ready to receive: refused
+	stream_test_setup(4);
+	TEST_ASSERT_EQUAL(1, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, \
+						STREAM_TEST_LEN, &streamTestTxDone, 0));
+	stream_test_run(1, STREAM_TEST_RTO);
+	TEST_ASSERT_EQUAL(STREAM_FAILED, streamTxState);
+	TEST_ASSERT_EQUAL(0, commStream[STREAM_PORT_A].tx.sent);
+
+	//Nobody listening: the sender gives up
+	stream_test_setup(4);
+	flexsea_port_send_ptr[STREAM_PORT_A] = NULL;
+	stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamMsg, 10, &streamTestTxDone, 0);
+	stream_test_run(1, STREAM_TEST_RTO * (STREAM_MAX_RETRIES + 2));
+	TEST_ASSERT_EQUAL(STREAM_FAILED, streamTxState);
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+
+	stream_test_cleanup();
+}
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "../inc/flexsea_transport.h"
+
+#define STREAM_PTY_LEN		65536
+
+static struct transport_s streamTransport;
+static int streamPtyA = -1, streamPtyB = -1;
+static uint8_t streamPtyMsg[STREAM_PTY_LEN], streamPtyOut[STREAM_PTY_LEN];
+static uint8_t streamPtyBlock[STREAM_BLOCK_MAX];
+static uint32_t streamPtyGot = 0;
+
+static void streamPtySendA(uint8_t *str, uint16_t len)
+{
+	transport_send(&streamTransport, streamPtyA, str, len);
+}
+
+static void streamPtySendB(uint8_t *str, uint16_t len)
+{
+	transport_send(&streamTransport, streamPtyB, str, len);
+}
+
+static void streamPtyCallback(uint8_t port, uint8_t *payload)
+{
+	uint8_t info[2] = {port, 0};
+
+	if(payload[P_CMD1] == CMD_W(CMD_STREAM))
+	{
+		rx_cmd_stream(payload, info);
+	}
+}
+
+static void streamPtyWrite(uint8_t port, uint32_t offset, uint8_t *data, uint16_t len)
+{
+	(void)port;
+	memcpy(&streamPtyOut[offset], data, len);
+	streamPtyGot += len;
+}
+
+static uint32_t streamPtyNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+//End to end over a pty pair, through the Linux transport: the master side
+//is A, the slave side (raw mode) is B. Ticks are ms.
+void test_stream_pty(void)
+{
+	char slavePath[64];
+	uint32_t i = 0, now = 0, end = 0;
+	int ptm = -1;
+
+	ptm = posix_openpt(O_RDWR | O_NOCTTY);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, ptm);
+	TEST_ASSERT_EQUAL(0, grantpt(ptm));
+	TEST_ASSERT_EQUAL(0, unlockpt(ptm));
+	strncpy(slavePath, ptsname(ptm), sizeof(slavePath) - 1);
+	slavePath[sizeof(slavePath) - 1] = 0;
+
+	TEST_ASSERT_EQUAL(0, transport_init(&streamTransport));
+	streamPtyA = transport_add_fd(&streamTransport, ptm, STREAM_PORT_A);
+	streamPtyB = transport_open_tty(&streamTransport, slavePath, 0, STREAM_PORT_B);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, streamPtyA);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, streamPtyB);
+	streamTransport.rx_callback = &streamPtyCallback;
+
+	for(i = 0; i < STREAM_PTY_LEN; i++)
+	{
+		streamPtyMsg[i] = (uint8_t)(i ^ (i >> 8));
+	}
+	memset(streamPtyOut, 0, sizeof(streamPtyOut));
+	streamPtyGot = 0;
+	streamTxState = STREAM_IDLE;
+
+	//Less than what the pty and the transport can buffer in flight:
+	init_flexsea_stream();
+	stream_config(STREAM_PORT_A, 200, 2, 0);
+	stream_config(STREAM_PORT_B, 200, 2, 0);
+	flexsea_port_send_ptr[STREAM_PORT_A] = &streamPtySendA;
+	flexsea_port_send_ptr[STREAM_PORT_B] = &streamPtySendB;
+	stream_receive(STREAM_PORT_B, streamPtyBlock, sizeof(streamPtyBlock), \
+					&streamPtyWrite, NULL);
+
+	now = streamPtyNow();
+	end = now + 5000;
+	TEST_ASSERT_EQUAL(1, stream_send(STREAM_PORT_A, FLEXSEA_EXECUTE_1, streamPtyMsg, \
+						STREAM_PTY_LEN, &streamTestTxDone, now));
+	while((streamTxState == STREAM_IDLE) && (now < end))
+	{
+		transport_poll(&streamTransport, 1);
+		now = streamPtyNow();
+		stream_poll(STREAM_PORT_A, now);
+		stream_poll(STREAM_PORT_B, now);
+	}
+
+	TEST_ASSERT_EQUAL(STREAM_DONE, streamTxState);
+	TEST_ASSERT_EQUAL(STREAM_DONE, commStream[STREAM_PORT_B].rx.state);
+	TEST_ASSERT_EQUAL(STREAM_PTY_LEN, streamPtyGot);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(streamPtyMsg, streamPtyOut, STREAM_PTY_LEN);
+	TEST_ASSERT_EQUAL(STREAM_PTY_LEN / STREAM_BLOCK_MAX, \
+						commStream[STREAM_PORT_A].tx.sent);
+	TEST_ASSERT_FALSE(stream_active(STREAM_PORT_A));
+
+	flexsea_port_send_ptr[STREAM_PORT_A] = NULL;
+	flexsea_port_send_ptr[STREAM_PORT_B] = NULL;
+	transport_close(&streamTransport);
+}
+
+#endif	//__linux__
+
+void test_flexsea_stream(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_stream_crc32);
+	RUN_TEST(test_stream_transfer);
+	RUN_TEST(test_stream_rx_tail);
+	RUN_TEST(test_stream_errors);
+	#ifdef __linux__
+	RUN_TEST(test_stream_pty);
+	#endif	//__linux__
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,223 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_tdma.h"
+#include "../inc/flexsea_corr.h"
+#include "../inc/flexsea_txq.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+
+//Definitions and variables used by some/all tests:
+struct tdma_s testTdma;
+struct corr_s testTdmaCorr;
+uint8_t tdmaSent[COMM_STR_BUF_LEN];
+uint16_t tdmaSentLen = 0;
+
+static void tdmaTestSend(uint8_t *str, uint16_t len)
+{
+	memcpy(tdmaSent, str, MIN(len, COMM_STR_BUF_LEN));
+	tdmaSentLen = len;
+}
+
+static void tdmaTestReplyHandler(uint8_t *buf, uint8_t *info)
+{
+	(void)buf;
+	(void)info;
+}
+
+//1 Mbaud, 5 us turnaround, a quarter of the bytes escaped: empty Read is
+//90 us, 8 bytes reply 190 us
+static void tdmaTestSetup(void)
+{
+	tdma_init(&testTdma, PORT_RS485_1, 1000000, 5);
+	testTdma.escapePct = 25;
+	corr_init(&testTdmaCorr, 1000, NULL);
+	testTdma.corr = &testTdmaCorr;
+}
+
+//Rates, phases, and no overlap
+void test_tdma_plan(void)
+{
+	uint16_t cnt[TDMA_MAX_ENTRIES];
+	uint32_t end = 0;
+	uint16_t i = 0;
+
+	tdmaTestSetup();
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_1, CMD_TEST, 1000, 0, 8, 20);
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_2, CMD_TEST, 1000, 0, 8, 20);
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_1 + 2, CMD_TEST, 500, 0, 8, 20);
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_1, CMD_READ_ALL, 10, 0, 8, 50);
+	TEST_ASSERT_EQUAL(TDMA_PLAN_OK, tdma_plan(&testTdma));
+
+	TEST_ASSERT_EQUAL(310, testTdma.entry[0].slotUs);
+	TEST_ASSERT_EQUAL(340, testTdma.entry[3].slotUs);
+	TEST_ASSERT_EQUAL(1000, testTdma.minorUs);
+	TEST_ASSERT_EQUAL(64, testTdma.minorCnt);		//10 Hz => 64 ms
+	TEST_ASSERT_EQUAL(64000, testTdma.majorUs);
+	TEST_ASSERT_EQUAL(64 * 2 + 32 + 1, testTdma.slotCnt);
+	TEST_ASSERT_EQUAL(1, testTdma.entry[3].offset);	//Odd frames are lighter
+	TEST_ASSERT_EQUAL(960, testTdma.maxLoadUs);
+	TEST_ASSERT_EQUAL(780, tdma_utilization(&testTdma));
+
+	memset(cnt, 0, sizeof(cnt));
+	for(i = 0; i < testTdma.slotCnt; i++)
+	{
+		cnt[testTdma.slot[i].entry]++;
+		if(i > 0)
+		{
+			TEST_ASSERT_GREATER_OR_EQUAL(end, testTdma.slot[i].start);
+		}
+		end = testTdma.slot[i].start + testTdma.entry[testTdma.slot[i].entry].slotUs;
+		TEST_ASSERT_LESS_OR_EQUAL((testTdma.slot[i].start / 1000 + 1) * 1000, end);
+	}
+	TEST_ASSERT_EQUAL(64, cnt[0]);
+	TEST_ASSERT_EQUAL(64, cnt[1]);
+	TEST_ASSERT_EQUAL(32, cnt[2]);
+	TEST_ASSERT_EQUAL(1, cnt[3]);
+}
+
+void test_tdma_overload(void)
+{
+	uint8_t i = 0;
+
+	tdmaTestSetup();
+	TEST_ASSERT_EQUAL(TDMA_PLAN_ERR_EMPTY, tdma_plan(&testTdma));
+
+	for(i = 0; i < 4; i++)
+	{
+		tdma_add(&testTdma, FLEXSEA_EXECUTE_1 + i, CMD_TEST, 1000, 0, 8, 20);
+	}
+	TEST_ASSERT_EQUAL(TDMA_PLAN_ERR_LOAD, tdma_plan(&testTdma));
+	TEST_ASSERT_EQUAL(0, testTdma.slotCnt);
+	TEST_ASSERT_EQUAL(-1, tdma_add(&testTdma, FLEXSEA_EXECUTE_1, CMD_TEST, 0, 0, 8, 20));
+}
+
+//Slow entry: 128 minor frames per major frame, each fast entry adds 128
+//slots
+void test_tdma_too_many_slots(void)
+{
+	uint8_t i = 0;
+
+	tdmaTestSetup();
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_1, CMD_TEST, 5, 0, 1, 1);
+	for(i = 0; i < 3; i++)
+	{
+		tdma_add(&testTdma, FLEXSEA_EXECUTE_2 + i, CMD_TEST, 640, 0, 1, 1);
+	}
+	TEST_ASSERT_EQUAL(TDMA_PLAN_OK, tdma_plan(&testTdma));
+	TEST_ASSERT_EQUAL(128, testTdma.minorCnt);
+	TEST_ASSERT_EQUAL(3 * 128 + 1, testTdma.slotCnt);
+
+	//513 slots:
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_2 + i, CMD_TEST, 640, 0, 1, 1);
+	TEST_ASSERT_EQUAL(TDMA_PLAN_ERR_SLOTS, tdma_plan(&testTdma));
+	TEST_ASSERT_EQUAL(0, testTdma.slotCnt);
+}
+
+//Slots start on time, late ones are skipped, missing replies are counted
+void test_tdma_schedule(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_RS485_1, 0};
+
+	flexsea_payload_ptr[CMD_TEST][RX_PTYPE_REPLY] = &tdmaTestReplyHandler;
+	tdmaTestSetup();
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_1, CMD_TEST, 1000, 0, 8, 20);
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_2, CMD_TEST, 1000, 0, 8, 20);
+	TEST_ASSERT_EQUAL(TDMA_PLAN_OK, tdma_plan(&testTdma));
+
+	TEST_ASSERT_EQUAL(P_DATA1, tdma_next(&testTdma, 1000, payload));
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_1, payload[P_RID]);
+	TEST_ASSERT_EQUAL(CMD_R(CMD_TEST), payload[P_CMD1]);
+	TEST_ASSERT_EQUAL(1310, tdma_due(&testTdma));
+	TEST_ASSERT_EQUAL(0, tdma_next(&testTdma, 1100, payload));
+
+	//Reply:
+	prepare_empty_payload(FLEXSEA_EXECUTE_1, board_id, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(CMD_TEST);
+	TEST_ASSERT_EQUAL(1, corr_receive(&testTdmaCorr, payload, info, 1200));
+	TEST_ASSERT_EQUAL(0, corr_receive(&testTdmaCorr, payload, info, 1201));	//Duplicate
+	TEST_ASSERT_EQUAL(200, testTdma.rttMax);
+
+	//No reply from the second one, times out at the end of its slot:
+	TEST_ASSERT_EQUAL(P_DATA1, tdma_next(&testTdma, 1310, payload));
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_2, payload[P_RID]);
+	TEST_ASSERT_EQUAL(0, corr_advance(&testTdmaCorr, 1310 + testTdma.entry[1].slotUs - 1));
+	TEST_ASSERT_EQUAL(1, corr_advance(&testTdmaCorr, 1310 + testTdma.entry[1].slotUs));
+	TEST_ASSERT_EQUAL(1, testTdma.noReply);
+	TEST_ASSERT_EQUAL(P_DATA1, tdma_next(&testTdma, 2000, payload));
+	TEST_ASSERT_EQUAL(1, testTdma.noReply);
+	TEST_ASSERT_EQUAL(1, testTdma.cycles);
+
+	//Late by more than the guard time:
+	TEST_ASSERT_EQUAL(0, tdma_next(&testTdma, 2320, payload));
+	TEST_ASSERT_EQUAL(1, testTdma.misses);
+	TEST_ASSERT_EQUAL(1, testTdma.entry[1].misses);
+	TEST_ASSERT_EQUAL(2, testTdma.noReply);
+
+	//Stalled for a while:
+	TEST_ASSERT_EQUAL(P_DATA1, tdma_next(&testTdma, 100000, payload));
+	TEST_ASSERT_EQUAL(1 + 2 * 96 + 2, testTdma.misses);
+	TEST_ASSERT_EQUAL(4, testTdma.polls);
+	TEST_ASSERT_EQUAL(1, testTdma.replies);
+	TEST_ASSERT_EQUAL(100310, tdma_due(&testTdma));
+}
+
+//Framed and sent with the port's driver, or handed to slaveComm[] (through
+//slaveTxq[] with ENABLE_FLEXSEA_TXQ)
+void test_tdma_poll(void)
+{
+	uint8_t payload[PACKAGED_PAYLOAD_LEN];
+
+	tdmaTestSetup();
+	tdma_add(&testTdma, FLEXSEA_EXECUTE_2, CMD_TEST, 1000, 3, 8, 20);
+	tdma_plan(&testTdma);
+
+	flexsea_port_send_ptr[PORT_RS485_1] = &tdmaTestSend;
+	tdmaSentLen = 0;
+	TEST_ASSERT_EQUAL(1, tdma_poll(&testTdma, 0));
+	TEST_ASSERT_EQUAL(tdmaSentLen, unpack_payload_frame(tdmaSent, tdmaSentLen, payload));
+	TEST_ASSERT_EQUAL(FLEXSEA_EXECUTE_2, payload[P_RID]);
+	TEST_ASSERT_EQUAL(CMD_R(CMD_TEST), payload[P_CMD1]);
+	TEST_ASSERT_EQUAL(0, tdma_poll(&testTdma, 500));
+
+	flexsea_port_send_ptr[PORT_RS485_1] = NULL;
+	slaveComm[0].tx.inject = 0;
+	TEST_ASSERT_EQUAL(1, tdma_poll(&testTdma, 1000));
+	TEST_ASSERT_EQUAL(1, slaveComm[0].tx.inject);
+	TEST_ASSERT_EQUAL(tdmaSentLen, slaveComm[0].tx.len);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(tdmaSent, slaveComm[0].tx.txBuf, tdmaSentLen);
+
+	#ifdef ENABLE_FLEXSEA_TXQ
+
+	//Driver still busy: queued behind, not written over it
+	txq_init(&slaveTxq[0]);
+	slaveComm[0].tx.txBuf[0] = 0;
+	TEST_ASSERT_EQUAL(1, tdma_poll(&testTdma, 2000));
+	TEST_ASSERT_EQUAL(0, slaveComm[0].tx.txBuf[0]);
+	TEST_ASSERT_EQUAL(1, txq_count(&slaveTxq[0]));
+	slaveComm[0].tx.inject = 0;
+	TEST_ASSERT_EQUAL(1, txq_fill_tx(&slaveTxq[0], &slaveComm[0].tx));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(tdmaSent, slaveComm[0].tx.txBuf, tdmaSentLen);
+
+	#endif	//ENABLE_FLEXSEA_TXQ
+
+	slaveComm[0].tx.inject = 0;
+}
+
+void test_flexsea_tdma(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_tdma_plan);
+	RUN_TEST(test_tdma_overload);
+	RUN_TEST(test_tdma_too_many_slots);
+	RUN_TEST(test_tdma_schedule);
+	RUN_TEST(test_tdma_poll);
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,565 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		//posix_openpt(), ptsname()
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "../inc/flexsea_transport.h"
+
+//Definitions and variables used by some/all tests:
+struct transport_s testTransport;
+uint8_t transportRx[32];
+uint8_t transportRxCnt = 0;
+
+static void transportTestCallback(uint8_t port, uint8_t *payload)
+{
+	(void)port;
+	if(transportRxCnt < sizeof(transportRx))
+	{
+		transportRx[transportRxCnt] = payload[P_DATA1];
+	}
+	transportRxCnt++;
+}
+
+//Opens a pty pair: we write on the master, the transport uses the slave
+static int openPtyPair(int *ptm, char *slavePath, size_t len)
+{
+	*ptm = posix_openpt(O_RDWR | O_NOCTTY);
+	if((*ptm < 0) || grantpt(*ptm) || unlockpt(*ptm))
+	{
+		return -1;
+	}
+
+	strncpy(slavePath, ptsname(*ptm), len - 1);
+	slavePath[len - 1] = 0;
+	return 0;
+}
+
+static uint8_t transportTestFrame(uint8_t n, uint8_t *cstr)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+
+	prepare_empty_payload(FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1, payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_W(CMD_TEST);
+	payload[P_DATA1] = n;
+	payload[P_DATA1 + 1] = HEADER;		//Needs escaping
+	return comm_gen_str(payload, cstr, P_DATA1 + 8) + 1;
+}
+
+//Many frames in one write(): more than RX_BUF_LEN bytes in one chunk
+void test_transport_pty_rx(void)
+{
+	uint8_t stream[20 * COMM_STR_BUF_LEN];
+	uint32_t len = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	testTransport.rx_callback = &transportTestCallback;
+	transportRxCnt = 0;
+
+	for(i = 0; i < 20; i++)
+	{
+		len += transportTestFrame(i, &stream[len]);
+	}
+	TEST_ASSERT_EQUAL((int)len, write(ptm, stream, len));
+
+	for(i = 0; (i < 50) && (transportRxCnt < 20); i++)
+	{
+		transport_poll(&testTransport, 20);
+	}
+
+	TEST_ASSERT_EQUAL(20, transportRxCnt);
+	for(i = 0; i < 20; i++)
+	{
+		TEST_ASSERT_EQUAL(i, transportRx[i]);
+	}
+	TEST_ASSERT_EQUAL(len, testTransport.port[h].bytesIn);
+	TEST_ASSERT_LESS_THAN(len, testTransport.port[h].decodes);
+
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+void test_transport_pty_tx(void)
+{
+	uint8_t cstr[COMM_STR_BUF_LEN], readBack[COMM_STR_BUF_LEN];
+	uint8_t len = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+	ssize_t got = 0, ret = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+
+	len = transportTestFrame(5, cstr);
+	TEST_ASSERT_EQUAL(0, transport_send(&testTransport, h, cstr, len));
+
+	fcntl(ptm, F_SETFL, fcntl(ptm, F_GETFL) | O_NONBLOCK);
+	for(i = 0; (i < 50) && (got < len); i++)
+	{
+		ret = read(ptm, &readBack[got], len - got);
+		if(ret > 0)
+		{
+			got += ret;
+		}
+		else
+		{
+			transport_poll(&testTransport, 10);
+		}
+	}
+
+	TEST_ASSERT_EQUAL(len, got);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(cstr, readBack, len);
+
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+//Non-standard baud rate: refused, not silently replaced
+void test_transport_pty_baud(void)
+{
+	char slavePath[64];
+	int ptm = -1;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	errno = 0;
+	TEST_ASSERT_EQUAL(-1, transport_open_tty(&testTransport, slavePath, 12345, \
+												PORT_USB));
+	TEST_ASSERT_EQUAL(EINVAL, errno);
+	TEST_ASSERT_EQUAL(0, testTransport.cnt);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, transport_open_tty(&testTransport, slavePath, \
+												115200, PORT_USB));
+
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+//The other end goes away: what was sent before is decoded, then the port is
+//closed instead of waking up every poll
+void test_transport_pty_hangup(void)
+{
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	uint8_t len = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+	uint64_t syscalls = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	testTransport.rx_callback = &transportTestCallback;
+	transportRxCnt = 0;
+
+	len = transportTestFrame(9, cstr);
+	TEST_ASSERT_EQUAL(len, write(ptm, cstr, len));
+	for(i = 0; (i < 50) && (transportRxCnt < 1); i++)
+	{
+		transport_poll(&testTransport, 20);
+	}
+	TEST_ASSERT_EQUAL(1, transportRxCnt);
+	close(ptm);
+
+	for(i = 0; (i < 10) && (testTransport.port[h].fd >= 0); i++)
+	{
+		transport_poll(&testTransport, 20);
+	}
+	TEST_ASSERT_EQUAL(-1, testTransport.port[h].fd);
+
+	//Nothing left to report:
+	syscalls = testTransport.syscalls;
+	TEST_ASSERT_EQUAL(0, transport_poll(&testTransport, 0));
+	TEST_ASSERT_EQUAL(syscalls + 1, testTransport.syscalls);
+	TEST_ASSERT_EQUAL(-1, transport_send(&testTransport, h, cstr, len));
+
+	transport_close(&testTransport);
+}
+
+//Fast framing on that port: frames back to back, split across reads, with
+//garbage in between
+void test_transport_pty_fast(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN];
+	uint8_t stream[10 * COMM_STR_BUF_LEN];
+	uint32_t len = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_SPI);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	testTransport.rx_callback = &transportTestCallback;
+	transportRxCnt = 0;
+	comm_set_framing(PORT_SPI, FRAMING_FAST);
+
+	for(i = 0; i < 6; i++)
+	{
+		prepare_empty_payload(FLEXSEA_PLAN_1, FLEXSEA_MANAGE_1, payload, \
+								PAYLOAD_BUF_LEN);
+		payload[P_CMDS] = 1;
+		payload[P_CMD1] = CMD_W(CMD_TEST);
+		payload[P_DATA1] = i;
+		len += comm_gen_str_fast(payload, &stream[len], P_DATA1 + 8) + 1;
+		if(i == 2)
+		{
+			stream[len++] = FAST_SYNC_H;	//Garbage
+			stream[len++] = 0;
+		}
+	}
+
+	//First half, then the rest:
+	TEST_ASSERT_EQUAL((int)(len / 2), write(ptm, stream, len / 2));
+	transport_poll(&testTransport, 20);
+	TEST_ASSERT_EQUAL((int)(len - len / 2), write(ptm, &stream[len / 2], \
+												len - len / 2));
+	for(i = 0; (i < 50) && (transportRxCnt < 6); i++)
+	{
+		transport_poll(&testTransport, 20);
+	}
+
+	TEST_ASSERT_EQUAL(6, transportRxCnt);
+	for(i = 0; i < 6; i++)
+	{
+		TEST_ASSERT_EQUAL(i, transportRx[i]);
+	}
+
+	comm_set_framing(PORT_SPI, FRAMING_ESCAPED);
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+#ifdef ENABLE_FLEXSEA_IO_URING
+
+struct transport_uring_s testUring;
+
+//Same stream as test_transport_pty_rx(), through io_uring. Frames go back
+//out on the same port, one io_uring_enter() submits them all.
+void test_transport_uring_pty(void)
+{
+	uint8_t stream[20 * COMM_STR_BUF_LEN], readBack[20 * COMM_STR_BUF_LEN];
+	uint32_t len = 0, frameLen = 0;
+	uint64_t enters = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+	ssize_t got = 0, ret = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	testTransport.rx_callback = &transportTestCallback;
+	transportRxCnt = 0;
+	TEST_ASSERT_EQUAL(0, transport_uring_init(&testUring, &testTransport));
+
+	//The port stays usable by transport_send():
+	TEST_ASSERT_TRUE(fcntl(testTransport.port[h].fd, F_GETFL) & O_NONBLOCK);
+
+	//Reception:
+	for(i = 0; i < 20; i++)
+	{
+		len += transportTestFrame(i, &stream[len]);
+	}
+	TEST_ASSERT_EQUAL((int)len, write(ptm, stream, len));
+
+	for(i = 0; (i < 50) && (transportRxCnt < 20); i++)
+	{
+		transport_uring_poll(&testUring, 20);
+	}
+
+	TEST_ASSERT_EQUAL(20, transportRxCnt);
+	for(i = 0; i < 20; i++)
+	{
+		TEST_ASSERT_EQUAL(i, transportRx[i]);
+	}
+	TEST_ASSERT_EQUAL(len, testTransport.port[h].bytesIn);
+
+	//Transmission: 8 different frames, queued then submitted together
+	len = 0;
+	for(i = 0; i < 8; i++)
+	{
+		frameLen = transportTestFrame(i, &stream[len]);
+		TEST_ASSERT_EQUAL(0, transport_uring_send(&testUring, h, &stream[len], \
+													frameLen));
+		len += frameLen;
+	}
+	enters = testUring.enters;
+	transport_uring_poll(&testUring, 0);
+	TEST_ASSERT_EQUAL(enters + 1, testUring.enters);
+
+	fcntl(ptm, F_SETFL, fcntl(ptm, F_GETFL) | O_NONBLOCK);
+	for(i = 0; (i < 50) && (got < (ssize_t)len); i++)
+	{
+		ret = read(ptm, &readBack[got], len - got);
+		if(ret > 0)
+		{
+			got += ret;
+		}
+		else
+		{
+			transport_uring_poll(&testUring, 10);
+		}
+	}
+
+	//Same order:
+	TEST_ASSERT_EQUAL(len, got);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(stream, readBack, len);
+
+	transport_uring_close(&testUring);
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+//The read can't be queued again (SQ full): the next poll retries it
+void test_transport_uring_rx_retry(void)
+{
+	uint8_t stream[COMM_STR_BUF_LEN];
+	uint32_t len = 0, sqEntries = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	testTransport.rx_callback = &transportTestCallback;
+	transportRxCnt = 0;
+	TEST_ASSERT_EQUAL(0, transport_uring_init(&testUring, &testTransport));
+	transport_uring_poll(&testUring, 0);
+
+	//No SQE for the next read:
+	sqEntries = testUring.sqEntries;
+	testUring.sqEntries = 0;
+	len = transportTestFrame(0, stream);
+	TEST_ASSERT_EQUAL((int)len, write(ptm, stream, len));
+	for(i = 0; (i < 50) && (transportRxCnt < 1); i++)
+	{
+		transport_uring_poll(&testUring, 20);
+	}
+	TEST_ASSERT_EQUAL(1, transportRxCnt);
+	TEST_ASSERT_EQUAL(1, testUring.rxRetry[h]);
+
+	//Room again:
+	testUring.sqEntries = sqEntries;
+	len = transportTestFrame(1, stream);
+	TEST_ASSERT_EQUAL((int)len, write(ptm, stream, len));
+	for(i = 0; (i < 50) && (transportRxCnt < 2); i++)
+	{
+		transport_uring_poll(&testUring, 20);
+	}
+	TEST_ASSERT_EQUAL(2, transportRxCnt);
+	TEST_ASSERT_EQUAL(1, transportRx[1]);
+	TEST_ASSERT_EQUAL(0, testUring.rxRetry[h]);
+
+	transport_uring_close(&testUring);
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+//More than the pty can buffer: partial writes and -EAGAIN, frames still in
+//order
+void test_transport_uring_pty_order(void)
+{
+	static uint8_t stream[60 * 5 * COMM_STR_BUF_LEN];
+	static uint8_t readBack[60 * 5 * COMM_STR_BUF_LEN];
+	uint32_t len = 0, sendLen = 0, start = 0;
+	char slavePath[64];
+	int ptm = -1, h = 0, i = 0, j = 0;
+	ssize_t got = 0, ret = 0;
+
+	TEST_ASSERT_EQUAL(0, openPtyPair(&ptm, slavePath, sizeof(slavePath)));
+	TEST_ASSERT_EQUAL(0, transport_init(&testTransport));
+	h = transport_open_tty(&testTransport, slavePath, 0, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, h);
+	TEST_ASSERT_EQUAL(0, transport_uring_init(&testUring, &testTransport));
+
+	//60 sends of 5 frames each, all different:
+	for(i = 0; i < 60; i++)
+	{
+		start = len;
+		for(j = 0; j < 5; j++)
+		{
+			len += transportTestFrame((uint8_t)(5 * i + j), &stream[len]);
+		}
+		sendLen = len - start;
+		TEST_ASSERT_EQUAL(0, transport_uring_send(&testUring, h, &stream[start], \
+													sendLen));
+	}
+
+	fcntl(ptm, F_SETFL, fcntl(ptm, F_GETFL) | O_NONBLOCK);
+	for(i = 0; (i < 2000) && (got < (ssize_t)len); i++)
+	{
+		transport_uring_poll(&testUring, 0);
+		ret = read(ptm, &readBack[got], len - got);
+		if(ret > 0)
+		{
+			got += ret;
+		}
+		else
+		{
+			transport_uring_poll(&testUring, 5);
+		}
+	}
+
+	TEST_ASSERT_EQUAL(len, got);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(stream, readBack, len);
+	TEST_ASSERT_EQUAL(0, testUring.txErrors);
+	TEST_ASSERT_EQUAL(TRANSPORT_URING_TX_SLOTS, testUring.txFreeCnt);
+
+	transport_uring_close(&testUring);
+	transport_close(&testTransport);
+	close(ptm);
+}
+
+#endif	//ENABLE_FLEXSEA_IO_URING
+
+//Unix datagrams: frames queued for one peer share a datagram, the
+//receiver learns the sender and can reply
+struct transport_dgram_s testDgramA, testDgramB;
+int dgramLastPeer = -1;
+
+static void dgramTestCallback(int peer, uint8_t *payload)
+{
+	dgramLastPeer = peer;
+	transportTestCallback(0, payload);
+}
+
+void test_transport_dgram_unix(void)
+{
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	char pathA[64], pathB[64];
+	uint8_t len = 0;
+	int peerB = 0, i = 0;
+
+	snprintf(pathA, sizeof(pathA), "/tmp/fx_dgram_a_%d", (int)getpid());
+	snprintf(pathB, sizeof(pathB), "/tmp/fx_dgram_b_%d", (int)getpid());
+	TEST_ASSERT_EQUAL(0, transport_dgram_open_unix(&testDgramA, pathA));
+	TEST_ASSERT_EQUAL(0, transport_dgram_open_unix(&testDgramB, pathB));
+	testDgramA.rx_callback = &dgramTestCallback;
+	testDgramB.rx_callback = &dgramTestCallback;
+
+	peerB = transport_dgram_add_peer(&testDgramA, pathB, 0, PORT_USB);
+	TEST_ASSERT_EQUAL(0, peerB);
+	for(i = 0; i < 5; i++)
+	{
+		len = transportTestFrame(i, cstr);
+		TEST_ASSERT_EQUAL(0, transport_dgram_send(&testDgramA, peerB, cstr, len));
+	}
+	TEST_ASSERT_EQUAL(1, testDgramA.txCnt);
+	TEST_ASSERT_EQUAL(0, transport_dgram_flush(&testDgramA));
+
+	transportRxCnt = 0;
+	TEST_ASSERT_EQUAL(5, transport_dgram_poll(&testDgramB, 100));
+	for(i = 0; i < 5; i++)
+	{
+		TEST_ASSERT_EQUAL(i, transportRx[i]);
+	}
+	TEST_ASSERT_EQUAL(1, testDgramB.dgramIn);
+	TEST_ASSERT_EQUAL(1, testDgramB.peerCnt);
+
+	//Reply to the learned peer:
+	len = transportTestFrame(42, cstr);
+	TEST_ASSERT_EQUAL(0, transport_dgram_send(&testDgramB, dgramLastPeer, cstr, len));
+	transport_dgram_flush(&testDgramB);
+	transportRxCnt = 0;
+	TEST_ASSERT_EQUAL(1, transport_dgram_poll(&testDgramA, 100));
+	TEST_ASSERT_EQUAL(42, transportRx[0]);
+	TEST_ASSERT_EQUAL(peerB, dgramLastPeer);
+
+	transport_dgram_close(&testDgramA);
+	transport_dgram_close(&testDgramB);
+	TEST_ASSERT_EQUAL(-1, access(pathA, F_OK));
+}
+
+//UDP loopback. A frame with a bad checksum is skipped, a datagram that
+//doesn't start with a frame is dropped.
+void test_transport_dgram_udp(void)
+{
+	uint8_t cstr[COMM_STR_BUF_LEN];
+	struct sockaddr_storage sa;
+	socklen_t saLen = sizeof(sa);
+	uint16_t udpPort = 0;
+	uint8_t len = 0;
+	int peerB = 0, i = 0;
+
+	TEST_ASSERT_EQUAL(0, transport_dgram_open_udp(&testDgramA, "127.0.0.1", 0));
+	TEST_ASSERT_EQUAL(0, transport_dgram_open_udp(&testDgramB, "127.0.0.1", 0));
+	testDgramB.rx_callback = &dgramTestCallback;
+	getsockname(testDgramB.fd, (struct sockaddr *)&sa, &saLen);
+	udpPort = ntohs(((struct sockaddr_in *)&sa)->sin_port);
+
+	peerB = transport_dgram_add_peer(&testDgramA, "127.0.0.1", udpPort, PORT_USB);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, peerB);
+
+	//Datagram 1: [bad checksum][frame 2]
+	len = transportTestFrame(1, cstr);
+	cstr[3] ^= 0x01;
+	transport_dgram_send(&testDgramA, peerB, cstr, len);
+	len = transportTestFrame(2, cstr);
+	transport_dgram_send(&testDgramA, peerB, cstr, len);
+	transport_dgram_flush(&testDgramA);
+
+	//Datagram 2: [garbage][frame 3]
+	cstr[0] = 0;
+	transport_dgram_send(&testDgramA, peerB, cstr, len);
+	len = transportTestFrame(3, cstr);
+	transport_dgram_send(&testDgramA, peerB, cstr, len);
+	transport_dgram_flush(&testDgramA);
+
+	transportRxCnt = 0;
+	for(i = 0; (i < 10) && (testDgramB.dgramIn < 2); i++)
+	{
+		transport_dgram_poll(&testDgramB, 20);
+	}
+	TEST_ASSERT_EQUAL(2, testDgramB.dgramIn);
+	TEST_ASSERT_EQUAL(1, transportRxCnt);
+	TEST_ASSERT_EQUAL(2, transportRx[0]);
+	TEST_ASSERT_EQUAL(2, testDgramB.peer[0].badFrames);
+
+	transport_dgram_close(&testDgramA);
+	transport_dgram_close(&testDgramB);
+}
+
+#endif	//__linux__
+
+void test_flexsea_transport(void)
+{
+	UNITY_BEGIN();
+	#ifdef __linux__
+	RUN_TEST(test_transport_pty_rx);
+	RUN_TEST(test_transport_pty_tx);
+	RUN_TEST(test_transport_pty_baud);
+	RUN_TEST(test_transport_pty_hangup);
+	RUN_TEST(test_transport_pty_fast);
+	#ifdef ENABLE_FLEXSEA_IO_URING
+	RUN_TEST(test_transport_uring_pty);
+	RUN_TEST(test_transport_uring_rx_retry);
+	RUN_TEST(test_transport_uring_pty_order);
+	#endif	//ENABLE_FLEXSEA_IO_URING
+	RUN_TEST(test_transport_dgram_unix);
+	RUN_TEST(test_transport_dgram_udp);
+	#endif	//__linux__
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,269 @@
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "flexsea-comm_test-all.h"
+#include "../inc/flexsea_txq.h"
+#include "../inc/flexsea_comm.h"
+#include "../inc/flexsea_payload.h"
+#include "../inc/flexsea_stats.h"
+
+//Definitions and variables used by some/all tests:
+struct txq_s testTxq;
+
+//Frame 'n' of a level: first byte is the level, second is n
+static uint8_t txqTestPush(uint8_t level, uint8_t n)
+{
+	uint8_t str[COMM_STR_BUF_LEN];
+
+	memset(str, 0, sizeof(str));
+	str[0] = level;
+	str[1] = n;
+	return txq_push(&testTxq, level, str, 10 + n, CMD_W(CMD_TEST));
+}
+
+//Highest level first, FIFO in a level
+void test_txq_priority(void)
+{
+	uint8_t str[COMM_STR_BUF_LEN], cmd = 0;
+	uint8_t i = 0;
+
+	txq_init(&testTxq);
+	TEST_ASSERT_EQUAL(0, txq_pop(&testTxq, str, &cmd));
+	TEST_ASSERT_NULL(txq_front(&testTxq));
+
+	txqTestPush(TXQ_BULK, 0);
+	txqTestPush(TXQ_TELEMETRY, 0);
+	txqTestPush(TXQ_BULK, 1);
+	txqTestPush(TXQ_TELEMETRY, 1);
+	txqTestPush(TXQ_CONTROL, 0);
+	TEST_ASSERT_EQUAL(5, txq_count(&testTxq));
+
+	TEST_ASSERT_EQUAL(10, txq_pop(&testTxq, str, &cmd));
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, str[0]);
+	TEST_ASSERT_EQUAL(CMD_W(CMD_TEST), cmd);
+
+	//A control frame pushed now passes the rest:
+	txqTestPush(TXQ_CONTROL, 1);
+	TEST_ASSERT_EQUAL(11, txq_pop(&testTxq, str, NULL));
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, str[0]);
+
+	for(i = 0; i < 2; i++)
+	{
+		TEST_ASSERT_EQUAL(10 + i, txq_pop(&testTxq, str, NULL));
+		TEST_ASSERT_EQUAL(TXQ_TELEMETRY, str[0]);
+		TEST_ASSERT_EQUAL(i, str[1]);
+	}
+	for(i = 0; i < 2; i++)
+	{
+		TEST_ASSERT_EQUAL(10 + i, txq_pop(&testTxq, str, NULL));
+		TEST_ASSERT_EQUAL(TXQ_BULK, str[0]);
+	}
+
+	TEST_ASSERT_EQUAL(0, txq_count(&testTxq));
+	TEST_ASSERT_EQUAL(0, testTxq.pending);
+}
+
+//Full levels: bulk refuses, telemetry keeps the freshest
+void test_txq_drop(void)
+{
+	uint8_t str[COMM_STR_BUF_LEN];
+	uint8_t i = 0;
+
+	txq_init(&testTxq);
+	for(i = 0; i < TXQ_DEPTH; i++)
+	{
+		TEST_ASSERT_EQUAL(1, txqTestPush(TXQ_BULK, i));
+		TEST_ASSERT_EQUAL(1, txqTestPush(TXQ_TELEMETRY, i));
+	}
+	TEST_ASSERT_EQUAL(0, txqTestPush(TXQ_BULK, TXQ_DEPTH));
+	TEST_ASSERT_EQUAL(1, txqTestPush(TXQ_TELEMETRY, TXQ_DEPTH));
+	TEST_ASSERT_EQUAL(1, testTxq.level[TXQ_BULK].dropped);
+	TEST_ASSERT_EQUAL(1, testTxq.level[TXQ_TELEMETRY].dropped);
+	TEST_ASSERT_EQUAL(TXQ_DEPTH, testTxq.level[TXQ_TELEMETRY].highWater);
+
+	//Telemetry lost its oldest:
+	txq_pop(&testTxq, str, NULL);
+	TEST_ASSERT_EQUAL(1, str[1]);
+
+	//Policy can be changed:
+	txq_set_policy(&testTxq, TXQ_TELEMETRY, TXQ_DROP_NEWEST);
+	txqTestPush(TXQ_TELEMETRY, 0);
+	TEST_ASSERT_EQUAL(0, txqTestPush(TXQ_TELEMETRY, 0));
+
+	//Too long:
+	TEST_ASSERT_EQUAL(0, txq_push(&testTxq, TXQ_CONTROL, str, COMM_STR_BUF_LEN + 1, 0));
+}
+
+//The frame handed out by txq_front() stays put until txq_release()
+void test_txq_in_flight(void)
+{
+	struct txq_slot_s *s = NULL;
+	uint8_t str[COMM_STR_BUF_LEN];
+	uint8_t i = 0;
+
+	txq_init(&testTxq);
+	for(i = 0; i < TXQ_DEPTH; i++)
+	{
+		txqTestPush(TXQ_TELEMETRY, i);
+	}
+	s = txq_front(&testTxq);
+	TEST_ASSERT_EQUAL(0, s->data[1]);
+
+	//Full, DROP_OLDEST: the one behind it goes
+	TEST_ASSERT_EQUAL(1, txqTestPush(TXQ_TELEMETRY, TXQ_DEPTH));
+	TEST_ASSERT_EQUAL(0, s->data[1]);
+	TEST_ASSERT_EQUAL(TXQ_DEPTH, txq_count(&testTxq));
+
+	//A control frame doesn't take its place:
+	txqTestPush(TXQ_CONTROL, 0);
+	TEST_ASSERT_TRUE(s == txq_front(&testTxq));
+	txq_release(&testTxq);
+	TEST_ASSERT_EQUAL(TXQ_DEPTH, txq_count(&testTxq));
+	TEST_ASSERT_EQUAL(TXQ_DEPTH - 1, testTxq.level[TXQ_TELEMETRY].cnt);
+
+	txq_pop(&testTxq, str, NULL);
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, str[0]);
+	for(i = 2; i <= TXQ_DEPTH; i++)
+	{
+		txq_pop(&testTxq, str, NULL);
+		TEST_ASSERT_EQUAL(i, str[1]);
+	}
+	TEST_ASSERT_EQUAL(0, txq_count(&testTxq));
+	TEST_ASSERT_EQUAL(0, testTxq.out);
+}
+
+void test_txq_level(void)
+{
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, txq_level(CMD_W(CMD_TEST)));
+	TEST_ASSERT_EQUAL(TXQ_TELEMETRY, txq_level(CMD_R(CMD_TEST)));
+
+	txq_set_cmd_level(CMD_TEST, TXQ_BULK);
+	TEST_ASSERT_EQUAL(TXQ_BULK, txq_level(CMD_W(CMD_TEST)));
+	TEST_ASSERT_EQUAL(TXQ_BULK, txq_level(CMD_R(CMD_TEST)));
+
+	txq_set_cmd_level(CMD_TEST, TXQ_AUTO);
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, txq_level(CMD_W(CMD_TEST)));
+}
+
+//comm_tx_s drivers get the next frame once they are done with one
+void test_txq_fill_tx(void)
+{
+	struct comm_tx_s tx;
+
+	memset(&tx, 0, sizeof(tx));
+	txq_init(&testTxq);
+	TEST_ASSERT_EQUAL(0, txq_fill_tx(&testTxq, &tx));
+
+	txqTestPush(TXQ_TELEMETRY, 0);
+	txqTestPush(TXQ_CONTROL, 1);
+	TEST_ASSERT_EQUAL(1, txq_fill_tx(&testTxq, &tx));
+	TEST_ASSERT_EQUAL(1, tx.inject);
+	TEST_ASSERT_EQUAL(11, tx.len);
+	TEST_ASSERT_EQUAL(TXQ_CONTROL, tx.txBuf[0]);
+
+	//Still busy:
+	TEST_ASSERT_EQUAL(0, txq_fill_tx(&testTxq, &tx));
+	tx.inject = 0;
+	TEST_ASSERT_EQUAL(1, txq_fill_tx(&testTxq, &tx));
+	TEST_ASSERT_EQUAL(TXQ_TELEMETRY, tx.txBuf[0]);
+}
+
+#ifdef ENABLE_FLEXSEA_TXQ
+
+//Routed frames don't overwrite each other anymore
+void test_txq_route_to_slave(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_USB, 0};
+	uint8_t out[PACKAGED_PAYLOAD_LEN];
+
+	txq_init(&slaveTxq[0]);
+	memset(&slaveComm[0].tx, 0, sizeof(slaveComm[0].tx));
+
+	prepare_empty_payload(board_up_id, board_sub1_id[0], payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_TEST);
+	payload_parse_str(payload, info);
+	payload[P_CMD1] = CMD_R(CMD_READ_ALL);
+	payload_parse_str(payload, info);
+	payload[P_CMD1] = CMD_W(CMD_TEST);
+	payload_parse_str(payload, info);
+
+	//The first one went to the driver, the Write passes the other Read:
+	TEST_ASSERT_EQUAL(1, slaveComm[0].tx.inject);
+	TEST_ASSERT_EQUAL(CMD_R(CMD_TEST), slaveComm[0].tx.cmd);
+	TEST_ASSERT_EQUAL(2, txq_count(&slaveTxq[0]));
+
+	slaveComm[0].tx.inject = 0;
+	txq_fill_tx(&slaveTxq[0], &slaveComm[0].tx);
+	TEST_ASSERT_EQUAL(CMD_W(CMD_TEST), slaveComm[0].tx.cmd);
+	TEST_ASSERT_GREATER_THAN(0, unpack_payload_frame(slaveComm[0].tx.txBuf, \
+							slaveComm[0].tx.len, out));
+	TEST_ASSERT_EQUAL(board_sub1_id[0], out[P_RID]);
+
+	slaveComm[0].tx.inject = 0;
+	txq_fill_tx(&slaveTxq[0], &slaveComm[0].tx);
+	TEST_ASSERT_EQUAL(CMD_R(CMD_READ_ALL), slaveComm[0].tx.cmd);
+	slaveComm[0].tx.inject = 0;
+}
+
+//Real frame length, refused frames are counted, too long isn't queued
+void test_txq_route_drop(void)
+{
+	uint8_t payload[PAYLOAD_BUF_LEN], info[2] = {PORT_USB, 0};
+	struct comm_stats_s s;
+	int i = 0;
+
+	txq_init(&slaveTxq[0]);
+	txq_set_policy(&slaveTxq[0], txq_level(CMD_R(CMD_TEST)), TXQ_DROP_NEWEST);
+	memset(&slaveComm[0].tx, 0, sizeof(slaveComm[0].tx));
+	comm_stats_reset(PORT_SUB1);
+
+	prepare_empty_payload(board_up_id, board_sub1_id[0], payload, PAYLOAD_BUF_LEN);
+	payload[P_CMDS] = 1;
+	payload[P_CMD1] = CMD_R(CMD_TEST);
+
+	//The driver holds the first one, TXQ_DEPTH wait, the last is refused:
+	for(i = 0; i < TXQ_DEPTH + 2; i++)
+	{
+		payload_parse_str(payload, info);
+	}
+	TEST_ASSERT_EQUAL(TXQ_DEPTH, txq_count(&slaveTxq[0]));
+	comm_stats_snapshot(PORT_SUB1, &s);
+	TEST_ASSERT_EQUAL(1, s.txDropped);
+
+	//Header to footer, not the whole buffer:
+	TEST_ASSERT_EQUAL(4 + PAYLOAD_BUF_LEN, slaveComm[0].tx.len);
+	TEST_ASSERT_EQUAL(FOOTER, slaveComm[0].tx.txBuf[slaveComm[0].tx.len - 1]);
+
+	//Can't be encoded: nothing queued
+	txq_init(&slaveTxq[0]);
+	memset(&payload[P_DATA1], HEADER, PAYLOAD_BUF_LEN - P_DATA1);
+	payload_parse_str(payload, info);
+	TEST_ASSERT_EQUAL(0, txq_count(&slaveTxq[0]));
+
+	txq_set_policy(&slaveTxq[0], txq_level(CMD_R(CMD_TEST)), TXQ_POLICY_DEFAULT);
+	memset(&slaveComm[0].tx, 0, sizeof(slaveComm[0].tx));
+	comm_stats_reset(PORT_SUB1);
+}
+
+#endif	//ENABLE_FLEXSEA_TXQ
+
+void test_flexsea_txq(void)
+{
+	UNITY_BEGIN();
+	RUN_TEST(test_txq_priority);
+	RUN_TEST(test_txq_drop);
+	RUN_TEST(test_txq_in_flight);
+	RUN_TEST(test_txq_level);
+	RUN_TEST(test_txq_fill_tx);
+	#ifdef ENABLE_FLEXSEA_TXQ
+	RUN_TEST(test_txq_route_to_slave);
+	RUN_TEST(test_txq_route_drop);
+	#endif	//ENABLE_FLEXSEA_TXQ
+	UNITY_END();
+}
+
+#ifdef __cplusplus
+}
+#endif